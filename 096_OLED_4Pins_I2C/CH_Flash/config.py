@@ -5,6 +5,10 @@ BASE_DIR = Path(__file__).resolve().parent
 INPUT_FONT_BIN = BASE_DIR / "CH_Font.bin"   # 字体 BIN 文件路径
 
 SERIAL_PORT = "COM7"    # 串口号
-BAUD_RATE = 115200  # 波特率
+BAUD_RATE = 115200  # 波特率（滑动窗口协议下为握手波特率）
 
-__all__ = [ 'BASE_DIR', 'INPUT_FONT_BIN', 'SERIAL_PORT', 'BAUD_RATE' ]
+# 烧录协议: "legacy" = 逐块应答（本工程及 096_OLED_4Pins_I2C_Buffer 的 Font_Programmer）
+#           "window" = 滑动窗口 + DMA 接收（仅 17-1 Font_Programmer 支持, 烧录 17-1 时改为此项）
+PROTOCOL = "legacy"
+
+__all__ = [ 'BASE_DIR', 'INPUT_FONT_BIN', 'SERIAL_PORT', 'BAUD_RATE', 'PROTOCOL' ]
@@ -7,6 +7,7 @@
 import sys
 import os
 from flash_programmer import send_font_data
+from window_uploader import upload_font
 from config import *
 
 def main():
@@ -19,12 +20,15 @@ def main():
         return
     
     print(f"准备烧录文件: {INPUT_FONT_BIN}")
-    print(f"串口: {SERIAL_PORT}, 波特率: {BAUD_RATE}")
+    print(f"串口: {SERIAL_PORT}, 波特率: {BAUD_RATE}, 协议: {PROTOCOL}")
     print("")
     
     try:
         # 开始烧录
-        send_font_data(SERIAL_PORT, BAUD_RATE, INPUT_FONT_BIN)
+        if PROTOCOL == "window":
+            upload_font(SERIAL_PORT, BAUD_RATE, INPUT_FONT_BIN)
+        else:
+            send_font_data(SERIAL_PORT, BAUD_RATE, INPUT_FONT_BIN)
         print("")
         print("=== 烧录完成 ===")
     except KeyboardInterrupt:
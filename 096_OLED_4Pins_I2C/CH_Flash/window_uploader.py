@@ -0,0 +1,171 @@
+import serial
+import time
+import struct
+import binascii
+import os
+import random
+
+
+# ================== 配置区 ==================
+BLOCK_SIZE = 256              # 必须和 MCU 的 FONT_PROGRAMMER_BUFFER_SIZE 一致
+ACK_TIMEOUT = 1.0             # 等待应答超时（秒），超时后从未确认的块重发
+MAX_RETRIES = 20              # 连续超时/NAK 次数上限
+# 故障注入（测试 MCU 重同步用，正常烧录保持为 0）
+FAULT_DELAY_PROB = 0.0        # 每帧在随机位置暂停的概率（模拟 USB 延迟）
+FAULT_DELAY_MS = 30           # 暂停时长（毫秒），超过 MCU 的 FONT_PROGRAMMER_TIMEOUT_MS 时触发重发
+FAULT_DROP_PROB = 0.0         # 每帧丢弃一个随机字节的概率
+# ===========================================
+
+
+def crc16_ccitt(data):
+    """CRC16-CCITT (0x1021, 初值 0xFFFF)，与 MCU 端 17-1 hardware/src/CRC16.c 的 CRC16_Update(CRC16_INIT, ...) 一致"""
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+def build_frames(data):
+    """切分为 256 字节块（末块补 0xFF），每帧: 序号(2) + 数据 + CRC16(2)，均为小端"""
+    frames = []
+    for seq in range((len(data) + BLOCK_SIZE - 1) // BLOCK_SIZE):
+        block = data[seq * BLOCK_SIZE:(seq + 1) * BLOCK_SIZE].ljust(BLOCK_SIZE, b"\xFF")
+        body = struct.pack("<H", seq) + block
+        frames.append(body + struct.pack("<H", crc16_ccitt(body)))
+    return frames
+
+
+def send_frame(ser, frame):
+    """发送一帧，按配置区的故障注入概率丢弃一个字节或在帧中间暂停"""
+    if random.random() < FAULT_DROP_PROB:
+        cut = random.randrange(len(frame))
+        frame = frame[:cut] + frame[cut + 1:]
+    if random.random() < FAULT_DELAY_PROB:
+        cut = random.randrange(len(frame))
+        ser.write(frame[:cut])
+        ser.flush()
+        time.sleep(FAULT_DELAY_MS / 1000)
+        frame = frame[cut:]
+    ser.write(frame)
+
+
+def wait_line(ser, prefix, timeout):
+    """等待以 prefix 开头的一行文本"""
+    start_time = time.time()
+    while time.time() - start_time < timeout:
+        line = ser.readline().decode("ascii", errors="ignore").strip()
+        if line.startswith(prefix):
+            return line
+        elif line:
+            print(f"MCU: {line}")
+    return None
+
+
+def upload_font(port, baudrate, filename):
+    """
+    滑动窗口烧录（Font_Programmer_CH 固件）:
+    以 baudrate 握手，MCU 回复 "READY <窗口> <波特率>" 后切换到高速波特率，
+    连续发送窗口内的帧，按累计 ACK 推进，收到 NAK 或超时则从指定块回退重发。
+    """
+    if not os.path.exists(filename):
+        print(f"Error: File '{filename}' not found")
+        return False
+
+    with open(filename, "rb") as f:
+        data = f.read()
+
+    frames = build_frames(data)
+    total = len(frames)
+    if total > 0xFFFF:
+        print("Error: file too large for 16-bit block numbers")
+        return False
+
+    ser = serial.Serial(port=port, baudrate=baudrate, timeout=0.5)
+    try:
+        print(f"Connected to {port} at {baudrate} baud")
+        print("Waiting for MCU ready signal...")
+        line = wait_line(ser, "READY", 5)
+        if line is None:
+            print("Timeout: No READY signal received from MCU")
+            return False
+
+        fields = line.split()
+        window = int(fields[1]) if len(fields) > 1 else 1
+        fast_baud = int(fields[2]) if len(fields) > 2 else baudrate
+        ser.baudrate = fast_baud
+        ser.timeout = ACK_TIMEOUT
+        print(f"MCU ready: window {window} frames, {fast_baud} baud")
+
+        # ---------------- 发送长度 ----------------
+        ser.write(struct.pack(">I", len(data)))
+        if ser.read(1) != b"A":
+            print("Failed to get length ACK")
+            return False
+
+        # ---------------- 滑动窗口发送 ----------------
+        print(f"File size: {len(data)} bytes, {total} blocks")
+        base = 0            # 最早未确认的块
+        next_seq = 0        # 下一个要发送的块
+        retries = 0
+        resends = 0
+        start_time = time.time()
+        last_report = 0
+
+        while base < total:
+            while next_seq < total and next_seq - base < window:
+                send_frame(ser, frames[next_seq])
+                next_seq += 1
+
+            reply = ser.read(3)
+            if len(reply) < 3:
+                retries += 1
+                if retries > MAX_RETRIES:
+                    print(f"Too many timeouts at block {base}")
+                    return False
+                resends += next_seq - base
+                next_seq = base
+                continue
+
+            kind = reply[0:1]
+            seq = reply[1] | (reply[2] << 8)
+            if kind == b"A":
+                if seq > base:
+                    base = seq
+                    retries = 0
+            elif kind == b"N":
+                retries += 1
+                if retries > MAX_RETRIES:
+                    print(f"Too many NAKs at block {seq}")
+                    return False
+                resends += next_seq - seq
+                base = next_seq = seq
+            else:
+                # 应答错位，清空后按超时处理
+                ser.reset_input_buffer()
+
+            if base - last_report >= 64 or base == total:
+                last_report = base
+                sent = min(base * BLOCK_SIZE, len(data))
+                print(f"Progress: {sent * 100 // len(data)}% ({sent}/{len(data)} bytes)")
+
+        elapsed = time.time() - start_time
+        print(f"Transferred in {elapsed:.2f} s, {len(data) / 1024 / elapsed:.1f} KB/s, "
+              f"{resends} frames resent")
+
+        # ---------------- 等待 DONE ----------------
+        if wait_line(ser, "DONE", 5) is None:
+            print("Warning: No DONE signal received (data may still be valid)")
+            return False
+
+        print("MCU: Font programming completed!")
+        return True
+
+    finally:
+        ser.close()
+
+
+# ================== 主入口 ==================
+if __name__ == "__main__":
+    PORT = "COM7"               # 修改为你的串口
+    BAUDRATE = 115200           # 握手波特率，数据阶段由 MCU 指定
+    FILENAME = "CH_Font.bin"    # 字体文件
+
+    print("=== 字体烧录工具（滑动窗口） ===")
+    upload_font(PORT, BAUDRATE, FILENAME)
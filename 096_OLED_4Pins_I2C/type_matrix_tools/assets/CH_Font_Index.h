@@ -11,6 +11,19 @@ typedef struct
 
 #define CH_FONT_COUNT 6510
 #define CH_FONT_BYTES_PER_CHAR 32
+#define CH_FONT_BASE_ADDR 0x000000
+#define CH_FONT_WIDTH 16
+#define CH_FONT_HEIGHT 16
+#define CH_FONT_CRC32 0xFFBFDE50
+
+#define CH_CACHE_SIZE 32
+
+// 汉字缓存(最近使用的字模)
+typedef struct {
+    uint16_t unicode;  // Unicode 编码
+    uint8_t data[CH_FONT_BYTES_PER_CHAR];  // 字模数据
+    uint8_t used;  // 是否已使用
+} CH_FontCache_t;
 
 static const CH_FontIndex_t OLED_CH_FontIndex[] =
 {
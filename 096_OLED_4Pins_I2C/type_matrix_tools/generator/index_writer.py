@@ -1,6 +1,20 @@
 from model.font_model import FontGlyph
 
 
+def stm32_crc32(data: bytes) -> int:
+    """STM32F1 硬件 CRC 单元算法: 多项式 0x04C11DB7, 初值 0xFFFFFFFF,
+    按小端 32 位字输入, 高位先算, 无反转无异或输出"""
+    crc = 0xFFFFFFFF
+    for i in range(0, len(data), 4):
+        crc ^= int.from_bytes(data[i:i + 4], "little")
+        for _ in range(32):
+            if crc & 0x80000000:
+                crc = ((crc << 1) ^ 0x04C11DB7) & 0xFFFFFFFF
+            else:
+                crc = (crc << 1) & 0xFFFFFFFF
+    return crc
+
+
 def write_index(filepath: str, glyphs: list[FontGlyph]):
     with open(filepath, "w", encoding="utf-8") as f:
         f.write("#ifndef __CH_FONT_INDEX_H__\n")
@@ -17,7 +31,8 @@ def write_index(filepath: str, glyphs: list[FontGlyph]):
         f.write("#define CH_FONT_BYTES_PER_CHAR 32\n")
         f.write("#define CH_FONT_BASE_ADDR 0x000000\n")
         f.write("#define CH_FONT_WIDTH 16\n")
-        f.write("#define CH_FONT_HEIGHT 16\n\n")
+        f.write("#define CH_FONT_HEIGHT 16\n")
+        f.write(f"#define CH_FONT_CRC32 0x{stm32_crc32(b''.join(g.data for g in glyphs)):08X}\n\n")
         f.write("#define CH_CACHE_SIZE 32\n\n")
 
         f.write("// 汉字缓存(最近使用的字模)\n")
@@ -1,7 +1,25 @@
 /****************************************************************************/ /**
  * @file   Soft_SPI.h
  * @brief  Software-based SPI communication driver header
- * 
+ *
+ * Bit-banged SPI master on GPIO registers (BSRR writes, IDR reads), all four
+ * SPI modes, MSB or LSB first.
+ *
+ * Soft_SPI.c is built at -O2 (.eide/files.options.yml) while the rest of
+ * the project stays at -O0. The figures below do not hold at -O0.
+ *
+ * Maximum clock at SYSCLK 72 MHz (flash 2 wait states, prefetch on), estimated
+ * from instruction counts until measured: main.c times a 4 KB
+ * W25Q64_ReadData() with the DWT cycle counter and shows cycles per byte and
+ * KB/s on line 4.
+ * - SOFT_SPI_UNROLL 1: ~11 cycles per bit, SCK ~6.5 MHz, ~0.75 MB/s in
+ *   Soft_SPI_Transfer() blocks
+ * - SOFT_SPI_UNROLL 0: ~15 cycles per bit, SCK ~4.8 MHz, ~0.55 MB/s
+ * SCK is not 50% duty: the active phase (store, MISO read, shift) is about
+ * 5 cycles, so the slave needs tCLH/tCLL <= 65 ns at full speed. For
+ * comparison, SPI1 at 18 MHz reaches ~0.6 MB/s polled and ~2.2 MB/s with
+ * DMA. Define SOFT_SPI_DELAY() to slow the clock down for slower slaves.
+ *
  * @author Maverick Pi
  * @date   2025-11-20 15:54:49
  ********************************************************************************/
@@ -10,10 +28,40 @@
 #define __SOFT_SPI_H__
 
 #include "stm32f10x.h"
+#include <stddef.h>
+
+/* Pins, all on one port */
+#define SOFT_SPI_PORT           GPIOA
+#define SOFT_SPI_PORT_CLOCK     RCC_APB2Periph_GPIOA
+#define SOFT_SPI_CS_PIN         GPIO_Pin_4
+#define SOFT_SPI_SCK_PIN        GPIO_Pin_5
+#define SOFT_SPI_MISO_PIN       GPIO_Pin_6
+#define SOFT_SPI_MISO_BIT       6           // Bit number of SOFT_SPI_MISO_PIN
+#define SOFT_SPI_MOSI_PIN       GPIO_Pin_7
+
+/* 1 = unroll the 8 bits of a byte (faster, ~200 bytes more code per mode) */
+#define SOFT_SPI_UNROLL         1
+
+/* Extra delay after every clock edge, empty for the maximum clock */
+#ifndef SOFT_SPI_DELAY
+#define SOFT_SPI_DELAY()
+#endif
+
+/* SPI modes: CPOL << 1 | CPHA */
+#define SOFT_SPI_MODE_0         0           // Clock idle low, sample on rising edge
+#define SOFT_SPI_MODE_1         1           // Clock idle low, sample on falling edge
+#define SOFT_SPI_MODE_2         2           // Clock idle high, sample on falling edge
+#define SOFT_SPI_MODE_3         3           // Clock idle high, sample on rising edge
+
+/* Bit order */
+#define SOFT_SPI_MSB_FIRST      0
+#define SOFT_SPI_LSB_FIRST      1
 
 void Soft_SPI_Init(void);
+void Soft_SPI_SetMode(uint8_t mode, uint8_t bitOrder);
 void Soft_SPI_Start(void);
 void Soft_SPI_Stop(void);
 uint8_t Soft_SPI_TransferByte(uint8_t data);
+void Soft_SPI_Transfer(const uint8_t *pTxData, uint8_t *pRxData, uint16_t size);
 
 #endif // !__SOFT_SPI_H__
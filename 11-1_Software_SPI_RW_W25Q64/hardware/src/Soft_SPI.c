@@ -1,76 +1,131 @@
 /****************************************************************************/ /**
  * @file   Soft_SPI.c
  * @brief  Software-based SPI communication driver implementation
- * 
+ *
+ * One bit costs two BSRR stores and one IDR load. The MOSI level and the
+ * clock edge that goes with it are written in the same BSRR store: the low
+ * half-word sets pins, the high half-word resets them, so no read-modify-write
+ * of ODR is needed. For each mode the clock levels are compile-time
+ * constants, so every mode gets its own straight-line transfer function.
+ *
  * @author Maverick Pi
  * @date   2025-11-20 15:55:12
  ********************************************************************************/
 
 #include "Soft_SPI.h"
 
-/**
- * @brief Control Chip Select (CS) line
- * 
- * @param bitValue 0 for active low, 1 for inactive high
- */
-void Soft_SPI_CS(uint8_t bitValue)
-{
-    GPIO_WriteBit(GPIOA, GPIO_Pin_4, (BitAction)bitValue);
-}
+/* BSRR values */
+#define SOFT_SPI_SCK_HIGH       ((uint32_t)SOFT_SPI_SCK_PIN)
+#define SOFT_SPI_SCK_LOW        ((uint32_t)SOFT_SPI_SCK_PIN << 16)
 
-/**
- * @brief Control Serial Clock (SCK) line
- * 
- * @param bitValue Clock state (0 or 1)
- */
-void Soft_SPI_SCK(uint8_t bitValue)
-{
-    GPIO_WriteBit(GPIOA, GPIO_Pin_5, (BitAction)bitValue);
-}
+/* MOSI set/reset for bit 7 of d: shift the pin into the reset half when the bit is 0 */
+#define SOFT_SPI_MOSI_BSRR(d)   ((uint32_t)SOFT_SPI_MOSI_PIN << ((~(d) >> 3) & 0x10))
 
-/**
- * @brief Control Master Out Slave In (MOSI) line
- * 
- * @param bitValue Data bit to transmit (0 or 1)
- */
-void Soft_SPI_MOSI(uint8_t bitValue)
-{
-    GPIO_WriteBit(GPIOA, GPIO_Pin_7, (BitAction)bitValue);
-}
+#define SOFT_SPI_MISO_READ()    ((SOFT_SPI_PORT->IDR >> SOFT_SPI_MISO_BIT) & 0x01)
 
-/**
- * @brief Read Master In Slave Out (MISO) line
- * 
- * @return uint8_t Received data bit (0 or 1)
+/*
+ * One bit, MSB of d first, received bit shifted in at the bottom.
+ * CPHA 0: data with the idle level, sample on the leading edge
+ * CPHA 1: data with the leading edge, sample on the trailing (idle) edge
  */
-uint8_t Soft_SPI_MISO(void)
-{
-    return GPIO_ReadInputDataBit(GPIOA, GPIO_Pin_6);
-}
+#define SOFT_SPI_BIT(d, lead, idle, cpha)                                   \
+    do {                                                                    \
+        if (cpha) {                                                         \
+            SOFT_SPI_PORT->BSRR = (lead) | SOFT_SPI_MOSI_BSRR(d);           \
+            SOFT_SPI_DELAY();                                               \
+            SOFT_SPI_PORT->BSRR = (idle);                                   \
+        } else {                                                            \
+            SOFT_SPI_PORT->BSRR = (idle) | SOFT_SPI_MOSI_BSRR(d);           \
+            SOFT_SPI_DELAY();                                               \
+            SOFT_SPI_PORT->BSRR = (lead);                                   \
+        }                                                                   \
+        SOFT_SPI_DELAY();                                                   \
+        (d) = ((d) << 1) | SOFT_SPI_MISO_READ();                            \
+    } while (0)
+
+#if SOFT_SPI_UNROLL
+#define SOFT_SPI_BYTE(d, lead, idle, cpha)                                  \
+    do {                                                                    \
+        SOFT_SPI_BIT(d, lead, idle, cpha); SOFT_SPI_BIT(d, lead, idle, cpha); \
+        SOFT_SPI_BIT(d, lead, idle, cpha); SOFT_SPI_BIT(d, lead, idle, cpha); \
+        SOFT_SPI_BIT(d, lead, idle, cpha); SOFT_SPI_BIT(d, lead, idle, cpha); \
+        SOFT_SPI_BIT(d, lead, idle, cpha); SOFT_SPI_BIT(d, lead, idle, cpha); \
+    } while (0)
+#else
+#define SOFT_SPI_BYTE(d, lead, idle, cpha)                                  \
+    do {                                                                    \
+        for (uint8_t bit = 0; bit < 8; bit++) {                             \
+            SOFT_SPI_BIT(d, lead, idle, cpha);                              \
+        }                                                                   \
+    } while (0)
+#endif
+
+/* CPHA 0 leaves SCK at the leading level after the last bit */
+#define SOFT_SPI_DEFINE_MODE(name, lead, idle, cpha)                        \
+    static uint8_t name(uint8_t data)                                       \
+    {                                                                       \
+        uint32_t d = data;                                                  \
+        SOFT_SPI_BYTE(d, lead, idle, cpha);                                 \
+        if (!(cpha)) {                                                      \
+            SOFT_SPI_DELAY();                                               \
+            SOFT_SPI_PORT->BSRR = (idle);                                   \
+        }                                                                   \
+        return (uint8_t)d;                                                  \
+    }
+
+SOFT_SPI_DEFINE_MODE(Soft_SPI_Mode0, SOFT_SPI_SCK_HIGH, SOFT_SPI_SCK_LOW, 0)
+SOFT_SPI_DEFINE_MODE(Soft_SPI_Mode1, SOFT_SPI_SCK_HIGH, SOFT_SPI_SCK_LOW, 1)
+SOFT_SPI_DEFINE_MODE(Soft_SPI_Mode2, SOFT_SPI_SCK_LOW, SOFT_SPI_SCK_HIGH, 0)
+SOFT_SPI_DEFINE_MODE(Soft_SPI_Mode3, SOFT_SPI_SCK_LOW, SOFT_SPI_SCK_HIGH, 1)
+
+static uint8_t (* const Soft_SPI_Modes[4])(uint8_t) = {
+    Soft_SPI_Mode0, Soft_SPI_Mode1, Soft_SPI_Mode2, Soft_SPI_Mode3
+};
+
+static uint8_t (*Soft_SPI_Xfer)(uint8_t) = Soft_SPI_Mode0;   // Transfer function of the current mode
+static uint8_t Soft_SPI_LSBFirst = 0;
 
 /**
  * @brief Initialize Software SPI GPIO pins and default states
+ *
+ * Default format is mode 0, MSB first.
  */
 void Soft_SPI_Init(void)
 {
-    // Enable GPIOA clock
-    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA, ENABLE);
+    // Enable GPIO clock
+    RCC_APB2PeriphClockCmd(SOFT_SPI_PORT_CLOCK, ENABLE);
 
     GPIO_InitTypeDef GPIO_InitStructure;
     // Configure CS, SCK, MOSI as output push-pull
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
-    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_4 | GPIO_Pin_5 | GPIO_Pin_7;
+    GPIO_InitStructure.GPIO_Pin = SOFT_SPI_CS_PIN | SOFT_SPI_SCK_PIN | SOFT_SPI_MOSI_PIN;
     GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-    GPIO_Init(GPIOA, &GPIO_InitStructure);
+    GPIO_Init(SOFT_SPI_PORT, &GPIO_InitStructure);
 
     // Configure MISO as input pull-up
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU;
-    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_6;
-    GPIO_Init(GPIOA, &GPIO_InitStructure);
+    GPIO_InitStructure.GPIO_Pin = SOFT_SPI_MISO_PIN;
+    GPIO_Init(SOFT_SPI_PORT, &GPIO_InitStructure);
+
+    // Set default states: CS high (inactive), SCK at the idle level
+    SOFT_SPI_PORT->BSRR = SOFT_SPI_CS_PIN;
+    Soft_SPI_SetMode(SOFT_SPI_MODE_0, SOFT_SPI_MSB_FIRST);
+}
 
-    // Set default states: CS high (inactive), SCK low (idle)
-    Soft_SPI_CS(1);
-    Soft_SPI_SCK(0);
+/**
+ * @brief Select SPI mode and bit order
+ *
+ * Must be called with CS high; SCK moves to the idle level of the new mode.
+ *
+ * @param mode SOFT_SPI_MODE_0 .. SOFT_SPI_MODE_3
+ * @param bitOrder SOFT_SPI_MSB_FIRST or SOFT_SPI_LSB_FIRST
+ */
+void Soft_SPI_SetMode(uint8_t mode, uint8_t bitOrder)
+{
+    mode &= 0x03;
+    Soft_SPI_Xfer = Soft_SPI_Modes[mode];
+    Soft_SPI_LSBFirst = bitOrder;
+    SOFT_SPI_PORT->BSRR = (mode & 0x02) ? SOFT_SPI_SCK_HIGH : SOFT_SPI_SCK_LOW;
 }
 
 /**
@@ -78,7 +133,7 @@ void Soft_SPI_Init(void)
  */
 void Soft_SPI_Start(void)
 {
-    Soft_SPI_CS(0);
+    SOFT_SPI_PORT->BRR = SOFT_SPI_CS_PIN;
 }
 
 /**
@@ -86,31 +141,51 @@ void Soft_SPI_Start(void)
  */
 void Soft_SPI_Stop(void)
 {
-    Soft_SPI_CS(1);
+    SOFT_SPI_PORT->BSRR = SOFT_SPI_CS_PIN;
+}
+
+/**
+ * @brief Reverse the bit order of a byte (RBIT on the Cortex-M3)
+ */
+static uint8_t Soft_SPI_Reverse(uint8_t b)
+{
+    return (uint8_t)(__RBIT(b) >> 24);
 }
 
 /**
  * @brief Transfer a single byte over SPI
- * 
+ *
  * @param data Byte to transmit
  * @return uint8_t Byte received during transfer
  */
 uint8_t Soft_SPI_TransferByte(uint8_t data)
 {
-    // Transfer 8 bits MSB first
-    for (int i = 0; i < 8; i++) {
-        // Output MSB on MOSI
-        Soft_SPI_MOSI(data & 0x80);
-        data <<= 1;
-        // Clock rising edge - slave samples data
-        Soft_SPI_SCK(1);
-        // Read MISO on clock high
-        if (Soft_SPI_MISO()) {
-            data |= 0x01;   // Set LSB if MISO is high
-        }
-        // Clock falling edge
-        Soft_SPI_SCK(0);
+    if (Soft_SPI_LSBFirst) {
+        return Soft_SPI_Reverse(Soft_SPI_Xfer(Soft_SPI_Reverse(data)));
     }
+    return Soft_SPI_Xfer(data);
+}
+
+/**
+ * @brief Transfer a block over SPI
+ *
+ * @param pTxData Data to transmit, or NULL to clock out 0xFF
+ * @param pRxData Buffer for received data, or NULL to discard it
+ * @param size Number of bytes to transfer
+ */
+void Soft_SPI_Transfer(const uint8_t *pTxData, uint8_t *pRxData, uint16_t size)
+{
+    uint8_t (*xfer)(uint8_t) = Soft_SPI_Xfer;
+
+    for (uint16_t i = 0; i < size; i++) {
+        uint8_t out = pTxData ? pTxData[i] : 0xFF;
+        uint8_t in;
 
-    return data;
+        if (Soft_SPI_LSBFirst) {
+            in = Soft_SPI_Reverse(xfer(Soft_SPI_Reverse(out)));
+        } else {
+            in = xfer(out);
+        }
+        if (pRxData) pRxData[i] = in;
+    }
 }
@@ -79,9 +79,7 @@ void W25Q64_PageProgram(uint32_t addr, uint8_t *dataArr, uint16_t len)
     Soft_SPI_TransferByte(addr);            // Send address byte 0
 
     // Send data bytes
-    for (uint16_t i = 0; i < len; i++) {
-        Soft_SPI_TransferByte(dataArr[i]);
-    }
+    Soft_SPI_Transfer(dataArr, NULL, len);
 
     Soft_SPI_Stop();
     W25Q64_WaitBusy();  // Wait for programming to complete
@@ -175,9 +173,12 @@ void W25Q64_ReadData(uint32_t addr, uint8_t* dataArr, uint32_t len)
     Soft_SPI_TransferByte(addr >> 8);       // Send address byte 1
     Soft_SPI_TransferByte(addr);            // Send address byte 0
 
-    // Read data bytes
-    for (uint32_t i = 0; i < len; i++) {
-        dataArr[i] = Soft_SPI_TransferByte(W25Q64_DUMMY_BYTE);
+    // Read data bytes, in chunks that fit the 16-bit transfer size
+    while (len > 0) {
+        uint16_t chunk = (len > 0x8000) ? 0x8000 : (uint16_t)len;
+        Soft_SPI_Transfer(NULL, dataArr, chunk);
+        dataArr += chunk;
+        len -= chunk;
     }
 
     Soft_SPI_Stop();
@@ -0,0 +1,21 @@
+/****************************************************************************/ /**
+ * @file   DWT.c
+ * @brief  DWT cycle counter for execution time measurement - Source File
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 23:41:09
+ ********************************************************************************/
+
+#include "DWT.h"
+
+/**
+ * @brief Enable the trace block and start the cycle counter
+ *
+ * The counter is not reset, so a second user does not disturb a
+ * measurement in progress.
+ */
+void DWT_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+}
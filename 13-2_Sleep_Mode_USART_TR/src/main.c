@@ -10,15 +10,24 @@
 #include "OLED.h"
 #include "Serial.h"
 #include "Delay.h"
+#include "W25Q64.h"
 
 int main(void)
 {
     OLED_Init();
     Serial_Init();
+    W25Q64_Init();
 
     OLED_ShowString(1, 1, "Rx:");
+    OLED_ShowString(3, 1, "MID:    DID:");
 
     uint8_t rxData;
+    uint8_t MID;    // Manufacturer ID
+    uint16_t DID;   // Device ID
+
+    W25Q64_ReadID(&MID, &DID);
+    OLED_ShowHexNum(3, 5, MID, 2);
+    OLED_ShowHexNum(3, 13, DID, 4);
 
     while (1) {
         if (Serial_GetRxFlag()) {
@@ -32,6 +41,9 @@ int main(void)
         OLED_ShowString(2, 1, "            ");
         Delay_ms(100);
 
+        // The flash is idle here: it enters deep power-down before the first sleep
+        W25Q64_Tick(200);
+
         __WFI();
     }
 }
@@ -0,0 +1,45 @@
+/****************************************************************************/ /**
+ * @file   W25Q64.h
+ * @brief  W25Q64 Flash Memory driver header
+ * 
+ * @author Maverick Pi
+ * @date   2025-11-20 21:03:28
+ ********************************************************************************/
+
+#ifndef __W25Q64_H__
+#define __W25Q64_H__
+
+#include "stm32f10x.h"
+#include "W25Q64_Ins.h"
+#include "Hard_SPI.h"
+
+// Deep power-down (0xB9) after this much idle time counted by W25Q64_Tick(),
+// 0 = only on W25Q64_PowerDown(). Ticks stop in Stop mode, so main.c powers
+// down explicitly before entering it; current figures are in 17-1's W25Q64.h.
+#define W25Q64_POWERDOWN_IDLE_MS    50
+
+// Power-down entry (tDP) and release to the next command (tRES1), maximum
+#define W25Q64_TDP_US               3
+#define W25Q64_TRES1_US             3
+
+// Power counters, in W25Q64_Tick() ms
+typedef struct {
+    uint32_t activeMs;          // Awake: standby or busy
+    uint32_t powerDownMs;       // In deep power-down
+    uint32_t powerDowns;
+    uint32_t wakeups;           // Release from power-down (0xAB) on access
+} W25Q64_PowerStats;
+
+void W25Q64_Init(void);
+void W25Q64_ReadID(uint8_t* MID, uint16_t* DID);
+void W25Q64_PageProgram(uint32_t addr, uint8_t *dataArr, uint16_t len);
+void W25Q64_EraseSector(uint32_t addr);
+void W25Q64_EraseChip(void);
+void W25Q64_EraseBlock64K(uint32_t addr);
+void W25Q64_EraseBlock32K(uint32_t addr);
+void W25Q64_ReadData(uint32_t addr, uint8_t* dataArr, uint32_t len);
+void W25Q64_PowerDown(void);
+void W25Q64_Tick(uint32_t ms);
+void W25Q64_GetPowerStats(W25Q64_PowerStats *stats);
+
+#endif // !__W25Q64_H__
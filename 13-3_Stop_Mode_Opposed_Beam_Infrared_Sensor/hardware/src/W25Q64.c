@@ -0,0 +1,270 @@
+/****************************************************************************/ /**
+ * @file   W25Q64.c
+ * @brief  W25Q64 Flash Memory driver implementation
+ * 
+ * @author Maverick Pi
+ * @date   2025-11-20 21:03:15
+ ********************************************************************************/
+
+#include "W25Q64.h"
+#include "Delay.h"
+
+static uint8_t W25Q64_Asleep = 1;       // Unknown after reset: released before the first command
+static uint32_t W25Q64_IdleMs;          // Time since the last command
+static W25Q64_PowerStats W25Q64_Power;
+
+/**
+ * @brief Release W25Q64 from deep power-down before a command
+ *
+ * Restarts the idle time. The part accepts commands tRES1 after 0xAB.
+ */
+static void W25Q64_Wake(void)
+{
+    W25Q64_IdleMs = 0;
+    if (!W25Q64_Asleep) return;
+
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_RELEASE_POWER_DOWN);
+    Hard_SPI_Stop();
+    Delay_us(W25Q64_TRES1_US);
+
+    W25Q64_Asleep = 0;
+    W25Q64_Power.wakeups++;
+}
+
+/**
+ * @brief Initialize W25Q64 Flash Memory interface
+ * 
+ * Initializes the software SPI interface used to communicate with the W25Q64
+ * and releases it from a power-down left by a previous run.
+ */
+void W25Q64_Init(void)
+{
+    Hard_SPI_Init();
+    W25Q64_Wake();
+}
+
+/**
+ * @brief Read Manufacturer ID and Device ID from W25Q64
+ * 
+ * @param MID Pointer to store Manufacturer ID (1 byte)
+ * @param DID Pointer to store Device ID (2 bytes)
+ */
+void W25Q64_ReadID(uint8_t* MID, uint16_t* DID)
+{
+    W25Q64_Wake();
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_JEDEC_ID);     // Send JEDEC ID command
+    *MID = Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);    // Read Manufacturer ID
+    *DID = Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);    // Read Device ID MSB
+    *DID <<= 8;
+    *DID |= Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);   // Read Device ID LSB
+    Hard_SPI_Stop();
+}
+
+/**
+ * @brief Send Write Enable command to W25Q64
+ * 
+ * Must be called before any write, program, or erase operation.
+ */
+void W25Q64_WriteEnable(void)
+{
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_WRITE_ENABLE);
+    Hard_SPI_Stop();
+}
+
+/**
+ * @brief Wait until W25Q64 is no longer busy
+ * 
+ * Polls the status register until the BUSY bit is cleared.
+ */
+void W25Q64_WaitBusy(void)
+{
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_READ_STATUS_REG1);
+    // Wait while BUSY bit (bit 0) is set
+    while (Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE) & 0x01);
+    Hard_SPI_Stop();
+}
+
+/**
+ * @brief Program a page (up to 256 bytes) in W25Q64
+ * 
+ * @param addr Starting address for page program (24-bit)
+ * @param dataArr Pointer to data array to program
+ * @param len Number of bytes to program (1-256)
+ */
+void W25Q64_PageProgram(uint32_t addr, uint8_t *dataArr, uint16_t len)
+{
+    W25Q64_Wake();
+
+    W25Q64_WriteEnable();   // Enable write operations
+
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_PAGE_PROGRAM);     // Send page program command
+    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
+    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
+    Hard_SPI_TransferByte(addr);            // Send address byte 0
+
+    // Send data bytes
+    for (uint16_t i = 0; i < len; i++) {
+        Hard_SPI_TransferByte(dataArr[i]);
+    }
+
+    Hard_SPI_Stop();
+    W25Q64_WaitBusy();  // Wait for programming to complete
+}
+
+/**
+ * @brief Erase a 4KB sector in W25Q64
+ * 
+ * @param addr Any address within the 4KB sector to erase
+ */
+void W25Q64_EraseSector(uint32_t addr)
+{
+    W25Q64_Wake();
+
+    W25Q64_WriteEnable();   // Enable write operations
+
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_SECTOR_ERASE);     // Send sector erase command
+    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
+    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
+    Hard_SPI_TransferByte(addr);            // Send address byte 0
+    Hard_SPI_Stop();
+
+    W25Q64_WaitBusy();  // Wait for erase to complete
+}
+
+/**
+ * @brief Erase entire W25Q64 chip
+ * 
+ * This operation may take several seconds to complete.
+ */
+void W25Q64_EraseChip(void)
+{
+    W25Q64_Wake();
+
+    W25Q64_WriteEnable();   // Enable write operations
+
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_CHIP_ERASE);   // Send chip erase command
+    Hard_SPI_Stop();
+
+    W25Q64_WaitBusy();  // Wait for chip erase to complete
+}
+
+/**
+ * @brief Erase a 64KB block in W25Q64
+ * 
+ * @param addr Any address within the 64KB block to erase
+ */
+void W25Q64_EraseBlock64K(uint32_t addr)
+{
+    W25Q64_Wake();
+
+    W25Q64_WriteEnable();   // Enable write operations
+
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_BLOCK_ERASE_64K);  // Send 64KB block erase command
+    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
+    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
+    Hard_SPI_TransferByte(addr);            // Send address byte 0
+    Hard_SPI_Stop();
+
+    W25Q64_WaitBusy();  // Wait for erase to complete
+}
+
+/**
+ * @brief Erase a 32KB block in W25Q64
+ * 
+ * @param addr Any address within the 32KB block to erase
+ */
+void W25Q64_EraseBlock32K(uint32_t addr)
+{
+    W25Q64_Wake();
+
+    W25Q64_WriteEnable();   // Enable write operations
+
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_BLOCK_ERASE_32K);  // Send 32KB block erase command
+    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
+    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
+    Hard_SPI_TransferByte(addr);            // Send address byte 0
+    Hard_SPI_Stop();
+
+    W25Q64_WaitBusy();  // Wait for erase to complete
+}
+
+/**
+ * @brief Read data from W25Q64 flash memory
+ * 
+ * @param addr Starting address to read from (24-bit)
+ * @param dataArr Pointer to buffer for storing read data
+ * @param len Number of bytes to read
+ */
+void W25Q64_ReadData(uint32_t addr, uint8_t* dataArr, uint32_t len)
+{
+    W25Q64_Wake();
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_READ_DATA);    // Send read data command
+    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
+    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
+    Hard_SPI_TransferByte(addr);            // Send address byte 0
+
+    // Read data bytes
+    for (uint32_t i = 0; i < len; i++) {
+        dataArr[i] = Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);
+    }
+
+    Hard_SPI_Stop();
+}
+
+/**
+ * @brief Put W25Q64 into deep power-down (0xB9)
+ *
+ * Every command above waits for the part to finish, so it is never busy
+ * here. The next command releases it transparently.
+ */
+void W25Q64_PowerDown(void)
+{
+    if (W25Q64_Asleep) return;
+
+    Hard_SPI_Start();
+    Hard_SPI_TransferByte(W25Q64_POWER_DOWN);
+    Hard_SPI_Stop();
+    Delay_us(W25Q64_TDP_US);
+
+    W25Q64_Asleep = 1;
+    W25Q64_Power.powerDowns++;
+}
+
+/**
+ * @brief Account elapsed time, power down after W25Q64_POWERDOWN_IDLE_MS idle
+ *
+ * @param ms Time since the previous call, from the application's own timing
+ */
+void W25Q64_Tick(uint32_t ms)
+{
+    if (W25Q64_Asleep) {
+        W25Q64_Power.powerDownMs += ms;
+        return;
+    }
+
+    W25Q64_Power.activeMs += ms;
+    W25Q64_IdleMs += ms;
+    if (W25Q64_POWERDOWN_IDLE_MS > 0 && W25Q64_IdleMs >= W25Q64_POWERDOWN_IDLE_MS) {
+        W25Q64_PowerDown();
+    }
+}
+
+/**
+ * @brief Get the power counters
+ *
+ * @param stats Destination
+ */
+void W25Q64_GetPowerStats(W25Q64_PowerStats *stats)
+{
+    *stats = W25Q64_Power;
+}
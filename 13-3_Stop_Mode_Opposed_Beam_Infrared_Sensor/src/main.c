@@ -10,13 +10,23 @@
 #include "OLED.h"
 #include "CountSensor.h"
 #include "Delay.h"
+#include "W25Q64.h"
 
 int main(void)
 {
     OLED_Init();
     CountSensor_Init();
+    W25Q64_Init();
 
     OLED_ShowString(1, 1, "Count:");
+    OLED_ShowString(3, 1, "MID:    DID:");
+
+    uint8_t MID;    // Manufacturer ID
+    uint16_t DID;   // Device ID
+
+    W25Q64_ReadID(&MID, &DID);
+    OLED_ShowHexNum(3, 5, MID, 2);
+    OLED_ShowHexNum(3, 13, DID, 4);
 
     RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE); // Enable power interface clock
 
@@ -28,6 +38,8 @@ int main(void)
         OLED_ShowString(2, 1, "           ");
         Delay_ms(100);
 
+        W25Q64_Tick(200);
+        W25Q64_PowerDown();     // SPI pins keep CS high in stop mode, the flash stays asleep
         PWR_EnterSTOPMode(PWR_Regulator_LowPower, PWR_STOPEntry_WFI); // Enter stop mode
         SystemInit();
     }
@@ -14,6 +14,7 @@ typedef struct
 #define CH_FONT_BASE_ADDR               0x000000
 #define CH_FONT_WIDTH                   16
 #define CH_FONT_HEIGHT                  16
+#define CH_FONT_CRC32                   0xFFBFDE50      // STM32 硬件 CRC, 由 type_matrix_tools 生成
 
 #define CH_CACHE_SIZE                   32
 
@@ -0,0 +1,23 @@
+/****************************************************************************/ /**
+ * @file   CRC16.h
+ * @brief  CRC-16/CCITT (polynomial 0x1021) - Header File
+ *
+ * Start with CRC16_INIT and feed the data in one or several blocks:
+ *   crc = CRC16_Update(CRC16_INIT, header, 6);
+ *   crc = CRC16_Update(crc, payload, len);
+ * The table is one entry per nibble (32 bytes of flash), two lookups per byte.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 23:58:14
+ ********************************************************************************/
+
+#ifndef __CRC16_H__
+#define __CRC16_H__
+
+#include "stm32f10x.h"
+
+#define CRC16_INIT      0xFFFF
+
+uint16_t CRC16_Update(uint16_t crc, const uint8_t *data, uint16_t len);
+
+#endif // !__CRC16_H__
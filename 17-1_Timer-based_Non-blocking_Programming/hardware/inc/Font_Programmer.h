@@ -1,7 +1,7 @@
 /****************************************************************************/ /**
  * @file   Font_Programmer.h
- * @brief  
- * 
+ * @brief  中文字库串口烧录（滑动窗口协议）
+ *
  * @author Maverick Pi
  * @date   2025-12-16 16:56:19
  ********************************************************************************/
@@ -13,8 +13,20 @@
 #include "Serial.h"
 
 #define FONT_PROGRAMMER_W25Q64_START_ADDR       0x000000
-#define FONT_PROGRAMMER_BUFFER_SIZE             256
+#define FONT_PROGRAMMER_BUFFER_SIZE             256     // 每帧数据块大小（一页）
+
+/* 滑动窗口协议（主机脚本: 096_OLED_4Pins_I2C/CH_Flash/window_uploader.py）
+ * 帧: 序号(2, 小端) + 数据(256, 末块补0xFF) + CRC16-CCITT(2, 小端, 覆盖序号和数据)
+ * 应答: 'A' + 下一期望序号(2) 累计确认; 'N' + 期望序号(2) 请求从该块重发
+ * 接收环形缓冲区可存 FONT_PROGRAMMER_SLOTS 帧, 主机窗口为 SLOTS - 1
+ * 出错后按帧内的序号和 CRC 重新对齐, 不依赖线路空闲时间 */
+#define FONT_PROGRAMMER_SLOTS                   8       // 接收环形缓冲区帧数, RAM = 8 x 260 字节
+#define FONT_PROGRAMMER_BAUDRATE                921600  // 握手后切换的波特率 (72MHz 下最高 4.5M)
+#define FONT_PROGRAMMER_TIMEOUT_MS              20      // 半帧无新数据超过此时间则请求重发
+
+/* USART1 RX DMA 通道 */
+#define FONT_PROGRAMMER_DMA_CHANNEL             DMA1_Channel5
 
 void Font_Programmer_CH(void);
 
-#endif // !__FONT_PROGRAMMER_H__
\ No newline at end of file
+#endif // !__FONT_PROGRAMMER_H__
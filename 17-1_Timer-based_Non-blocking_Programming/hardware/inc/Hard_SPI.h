@@ -10,6 +10,7 @@
 #define __HARD_SPI_H__
 
 #include "stm32f10x.h"
+#include <stdbool.h>
 
 /* SPI1 Pin Definitions */
 #define SPI1_CS_PIN     GPIO_Pin_4   // PA4 - Chip Select
@@ -17,10 +18,24 @@
 #define SPI1_MISO_PIN   GPIO_Pin_6   // PA6 - Master In Slave Out
 #define SPI1_MOSI_PIN   GPIO_Pin_7   // PA7 - Master Out Slave In
 
+/* SPI1 clock: APB2 72 MHz / 4 = 18 MHz, the SPI1 maximum on STM32F103 */
+#define SPI1_BAUDRATE_PRESCALER     SPI_BaudRatePrescaler_4
+
+/* SPI1 DMA Channel Definitions */
+#define SPI1_DMA_RX_CHANNEL     DMA1_Channel2
+#define SPI1_DMA_TX_CHANNEL     DMA1_Channel3
+#define SPI1_DMA_RX_IRQn        DMA1_Channel2_IRQn
+#define SPI1_DMA_RX_FLAGS       (DMA1_FLAG_GL2 | DMA1_FLAG_TC2 | DMA1_FLAG_HT2 | DMA1_FLAG_TE2)
+#define SPI1_DMA_TX_FLAGS       (DMA1_FLAG_GL3 | DMA1_FLAG_TC3 | DMA1_FLAG_HT3 | DMA1_FLAG_TE3)
+#define SPI1_DMA_DUMMY_BYTE     0xFF
+
+/* DMA transfer completion callback, called from the DMA interrupt */
+typedef void (*Hard_SPI_Callback)(void);
+
 void Hard_SPI_Init(void);
-void Hard_SPI_Start(void);
-void Hard_SPI_Stop(void);
 uint8_t Hard_SPI_TransferByte(uint8_t data);
-void Hard_SPI_TransferContinuous(uint8_t *pTxData, uint8_t *pRxData, uint16_t size);
+void Hard_SPI_DMA_Transfer(const uint8_t *pTxData, uint8_t *pRxData, uint16_t size);
+bool Hard_SPI_DMA_TransferAsync(const uint8_t *pTxData, uint8_t *pRxData, uint16_t size, Hard_SPI_Callback callback);
+bool Hard_SPI_DMA_IsBusy(void);
 
 #endif // !__HARD_SPI_H__
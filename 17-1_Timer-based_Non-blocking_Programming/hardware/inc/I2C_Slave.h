@@ -0,0 +1,97 @@
+/****************************************************************************/ /**
+ * @file   I2C_Slave.h
+ * @brief  I2C Slave Mode with DMA-backed Register Map - Header File
+ *
+ * The STM32 answers as a memory-mapped register device. The host writes a
+ * register pointer, then bursts reads or writes starting at that pointer.
+ *
+ * Register map layout (I2C_SLAVE_REG_SIZE bytes):
+ * - 0x00 .. I2C_SLAVE_DATA_SIZE-1             : read-only sample area (snapshots)
+ * - I2C_SLAVE_DATA_SIZE .. I2C_SLAVE_REG_SIZE-1 : host-writable control area
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 09:12:40
+ ********************************************************************************/
+
+#ifndef __I2C_SLAVE_H__
+#define __I2C_SLAVE_H__
+
+#include "stm32f10x.h"
+#include <stdbool.h>
+
+// Compile the slave in. Off by default: with I2C2 it needs DMA1 channels 4/5,
+// so Serial port 1 must use its TXE engine (SERIAL1_TX_DMA 0), USART3 must be
+// off (PB10/PB11), and Font_Programmer_CH() (channel 5) must not run while
+// the slave is up. The first two are checked at compile time.
+// tools/i2c_sim/I2C_Slave_Test.c builds it with the handlers driven on the host.
+#ifndef I2C_SLAVE_ENABLE
+#define I2C_SLAVE_ENABLE                0
+#endif
+
+// I2C Slave Instance select (1: I2C1 on PB6/PB7, 2: I2C2 on PB10/PB11)
+// I2C1 is taken by the OLED master on the remapped PB8/PB9 pins, so the
+// slave defaults to I2C2.
+#define I2C_SLAVE_INSTANCE              2
+
+#if I2C_SLAVE_INSTANCE == 1
+#define I2C_SLAVE                       I2C1
+#define I2C_SLAVE_PORT                  GPIOB
+#define I2C_SLAVE_SCL_PIN               GPIO_Pin_6
+#define I2C_SLAVE_SDA_PIN               GPIO_Pin_7
+#define I2C_SLAVE_CLOCK                 RCC_APB1Periph_I2C1
+#define I2C_SLAVE_DMA_TX_CHANNEL        DMA1_Channel6   // Shared with USART2_RX
+#define I2C_SLAVE_DMA_RX_CHANNEL        DMA1_Channel7   // Shared with USART2_TX
+#define I2C_SLAVE_EV_IRQn               I2C1_EV_IRQn
+#define I2C_SLAVE_ER_IRQn               I2C1_ER_IRQn
+#define I2C_SLAVE_EV_IRQHandler         I2C1_EV_IRQHandler
+#define I2C_SLAVE_ER_IRQHandler         I2C1_ER_IRQHandler
+#else
+#define I2C_SLAVE                       I2C2
+#define I2C_SLAVE_PORT                  GPIOB
+#define I2C_SLAVE_SCL_PIN               GPIO_Pin_10
+#define I2C_SLAVE_SDA_PIN               GPIO_Pin_11
+#define I2C_SLAVE_CLOCK                 RCC_APB1Periph_I2C2
+#define I2C_SLAVE_DMA_TX_CHANNEL        DMA1_Channel4   // Shared with USART1_TX
+#define I2C_SLAVE_DMA_RX_CHANNEL        DMA1_Channel5   // Shared with USART1_RX
+#define I2C_SLAVE_EV_IRQn               I2C2_EV_IRQn
+#define I2C_SLAVE_ER_IRQn               I2C2_ER_IRQn
+#define I2C_SLAVE_EV_IRQHandler         I2C2_EV_IRQHandler
+#define I2C_SLAVE_ER_IRQHandler         I2C2_ER_IRQHandler
+#endif
+
+#define I2C_SLAVE_GPIO_CLOCK            RCC_APB2Periph_GPIOB
+
+// Default own address (8-bit, left-aligned like the master driver addresses)
+#define I2C_SLAVE_ADDRESS               0x84
+
+// Register map size defines
+#define I2C_SLAVE_DATA_SIZE             48      // Read-only sample area
+#define I2C_SLAVE_CTRL_SIZE             16      // Host-writable control area
+#define I2C_SLAVE_REG_SIZE              (I2C_SLAVE_DATA_SIZE + I2C_SLAVE_CTRL_SIZE)
+
+// Byte returned when the host reads past the end of the register map
+#define I2C_SLAVE_PAD_BYTE              0xFF
+
+// Host write notification, called from the I2C interrupt
+typedef void (*I2C_Slave_WriteCallback)(uint8_t reg, const uint8_t *data, uint8_t len);
+
+// I2C Slave transaction statistics
+typedef struct {
+    uint32_t reads;         // Completed read transactions
+    uint32_t writes;        // Completed write transactions (with payload)
+    uint32_t rejected;      // Payload bytes aimed at the read-only area
+    uint32_t overruns;      // Bytes beyond the register map (padded / dropped)
+    uint32_t errors;        // Bus errors, overruns and unexpected events
+} I2C_Slave_Stats;
+
+// Function declaration
+void I2C_Slave_Init(uint8_t ownAddr, uint32_t speed);
+void I2C_Slave_DeInit(void);
+uint8_t* I2C_Slave_GetBackBuffer(void);
+void I2C_Slave_Publish(void);
+void I2C_Slave_ReadControl(uint8_t reg, uint8_t *data, uint8_t len);
+void I2C_Slave_SetWriteCallback(I2C_Slave_WriteCallback callback);
+bool I2C_Slave_GetWriteFlag(void);
+void I2C_Slave_GetStats(I2C_Slave_Stats *stats);
+
+#endif // !__I2C_SLAVE_H__
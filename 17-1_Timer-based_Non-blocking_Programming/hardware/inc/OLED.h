@@ -20,6 +20,8 @@
 #include "I2C_Hardware.h"
 #include "Delay.h"
 #include "W25Q64.h"
+#include "W25Q64_Verify.h"
+#include "W25Q64_Cache.h"
 #include "CH_Font_Index.h"
 
 
@@ -70,11 +72,15 @@
 #define FONT_SIZE_6             6
 #define FONT_SIZE_8             8
 
+/* 外部Flash校验区域编号 */
+#define OLED_REGION_CH_FONT     0
+
 
 /*********************************** 函数声明 ***********************************/
 
 /* 初始化函数 */
 void OLED_Init(void);
+bool OLED_FontCorrupted(void);
 
 /* 显存控制函数 */
 void OLED_Clear(void);
@@ -0,0 +1,83 @@
+/****************************************************************************/ /**
+ * @file   SPI_Bus.h
+ * @brief  SPI1 bus manager for several devices - Header File
+ *
+ * Each device has its own chip select pin, SPI mode, clock prescaler and bit
+ * order. CR1 is rewritten only when a transaction is for a different device
+ * than the previous one, so a driver talking to the same chip repeatedly pays
+ * nothing for sharing the bus.
+ *
+ * Two ways to use the bus:
+ * - Polled: SPI_Bus_Start(dev), Hard_SPI_TransferByte()/Hard_SPI_DMA_Transfer(),
+ *   SPI_Bus_Stop(). Start waits until queued transactions have finished, so
+ *   it must not be called from an interrupt, except from a transaction
+ *   callback, where the bus is guaranteed idle.
+ * - Queued: SPI_Bus_Submit(txn) from any context. The header is sent polled,
+ *   the data phase runs on DMA, the next transaction is chained from the DMA
+ *   interrupt.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 17:41:26
+ ********************************************************************************/
+
+#ifndef __SPI_BUS_H__
+#define __SPI_BUS_H__
+
+#include "stm32f10x.h"
+#include "Hard_SPI.h"
+#include <stdbool.h>
+
+// Pending transactions, power of two
+#define SPI_BUS_QUEUE_SIZE          8
+
+// Command/address bytes sent before the data phase of a transaction
+#define SPI_BUS_HEADER_MAX          8
+
+// SPI modes: CPOL << 1 | CPHA
+#define SPI_BUS_MODE_0              0       // Clock idle low, sample on rising edge
+#define SPI_BUS_MODE_1              1       // Clock idle low, sample on falling edge
+#define SPI_BUS_MODE_2              2       // Clock idle high, sample on falling edge
+#define SPI_BUS_MODE_3              3       // Clock idle high, sample on rising edge
+
+// Device on SPI1
+typedef struct {
+    GPIO_TypeDef *csPort;
+    uint16_t csPin;             // Active low chip select
+    uint8_t mode;               // SPI_BUS_MODE_x
+    uint16_t prescaler;         // SPI_BaudRatePrescaler_x (PCLK2 72 MHz / n)
+    uint16_t firstBit;          // SPI_FirstBit_MSB or SPI_FirstBit_LSB
+} SPI_Bus_Device;
+
+struct SPI_Bus_Transaction;
+typedef void (*SPI_Bus_Callback)(struct SPI_Bus_Transaction *txn);
+
+// Queued transaction, owned by the caller until its callback has run
+typedef struct SPI_Bus_Transaction {
+    SPI_Bus_Device *device;
+    uint8_t header[SPI_BUS_HEADER_MAX];
+    uint8_t headerLen;
+    const uint8_t *txData;      // NULL: clock out dummy bytes
+    uint8_t *rxData;            // NULL: discard received bytes
+    uint16_t len;               // Data phase length, 0 for header only
+    SPI_Bus_Callback callback;  // Called from the DMA interrupt after CS is raised, may be NULL
+    void *context;              // For the callback
+} SPI_Bus_Transaction;
+
+// Bus counters
+typedef struct {
+    uint32_t transactions;      // Polled and queued transactions
+    uint32_t reconfigurations;  // CR1 rewrites on device change
+    uint8_t  maxQueued;         // High-water mark of the queue
+} SPI_Bus_Stats;
+
+// Function declaration
+void SPI_Bus_Init(void);
+void SPI_Bus_AddDevice(SPI_Bus_Device *dev);
+void SPI_Bus_SetPrescaler(SPI_Bus_Device *dev, uint16_t prescaler);
+void SPI_Bus_Start(SPI_Bus_Device *dev);
+void SPI_Bus_Stop(void);
+bool SPI_Bus_Submit(SPI_Bus_Transaction *txn);
+bool SPI_Bus_IsBusy(void);
+void SPI_Bus_GetStats(SPI_Bus_Stats *stats);
+
+#endif // !__SPI_BUS_H__
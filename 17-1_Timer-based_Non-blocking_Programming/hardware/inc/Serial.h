@@ -1,7 +1,31 @@
 /****************************************************************************/ /**
  * @file   Serial.h
  * @brief  Header file for USART serial communication functions
- * 
+ *
+ * Instance-based driver for USART1/2/3. Every call takes a port handle
+ * (SERIAL1, SERIAL2, SERIAL3); each port has its own buffers, counters, baud
+ * rate and interrupt handlers. Ports are enabled at compile time: a disabled
+ * port costs no RAM, code or vector. The fixed per-port data (registers,
+ * pins, buffers) lives in a const table in flash, RAM holds only the ring
+ * indices and counters.
+ *
+ * RX goes through a single-producer/single-consumer ring buffer shared with
+ * the port's USARTx_IRQHandler: the RXNE interrupt produces, the main loop
+ * consumes. TX has two engines, selected per port by SERIALn_TX_DMA:
+ * - 0: SPSC ring drained by the TXE interrupt, one interrupt per byte
+ * - 1: two DMA buffers on the port's DMA1 channel; one is filled while the
+ *   other is on the wire, the transfer-complete interrupt starts the filled
+ *   one.
+ * The send functions of one port must be called from one context only (the
+ * main loop).
+ *
+ * The baud rate can be changed at run time up to PCLK / 16 (4.5 Mbaud for
+ * USART1 at 72 MHz, 2.25 Mbaud for USART2/3 on APB1), BRR is computed from
+ * the live bus clock. Auto-baud (USART1 only) measures a 0x55 sync byte on
+ * PA10 with TIM1 channel 3 input capture; every falling edge is copied by
+ * DMA1 channel 6, so no interrupt per edge is needed even at the highest
+ * rate. Channel 6 is shared with I2C1 TX.
+ *
  * @author Maverick Pi
  * @date   2025-10-13 14:55:41
  ********************************************************************************/
@@ -13,15 +37,98 @@
 #include <stdio.h>
 #include <stdarg.h>
 
-#define SERIAL_BAUDRATE     115200
+// Ports compiled in
+#define SERIAL_USE_USART1       1   // TX PA9,  RX PA10
+#define SERIAL_USE_USART2       0   // TX PA2,  RX PA3
+#define SERIAL_USE_USART3       0   // TX PB10, RX PB11, the pins of I2C_Slave on I2C2
 
-void Serial_Init(void);     // Initialize USART1 peripheral
-void Serial_SendByte(uint8_t b);    // Send single byte
-void Serial_SendArray(uint16_t *arr, uint16_t len);     // Send array of 16-bit values
-void Serial_SendString(char *str);  // Send null-terminated string
-void Serial_SendNumber(uint32_t num, uint8_t len);  // Send numeric value as ASCII
-void Serial_Printf(char *format, ...);  // Custom printf implementation
-uint8_t Serial_GetRxFlag(void);     // Check if new data has been received
-uint8_t Serial_GetRxData(void);     // Get the received data byte
+// Per port: rate after Serial_Init(), RX ring size, TX engine and TX buffer
+// size (ring size for the TXE engine, size of each of the two DMA buffers).
+// Ring sizes are powers of two up to 32768.
+#define SERIAL1_BAUDRATE        115200
+#define SERIAL1_RX_BUFFER_SIZE  256
+#define SERIAL1_TX_DMA          1   // DMA1 channel 4, shared with I2C2 TX (I2C_SLAVE_ENABLE)
+#define SERIAL1_TX_BUFFER_SIZE  256
+
+#define SERIAL2_BAUDRATE        9600
+#define SERIAL2_RX_BUFFER_SIZE  128
+#define SERIAL2_TX_DMA          0   // DMA1 channel 7, shared with I2C1 RX
+#define SERIAL2_TX_BUFFER_SIZE  64
+
+#define SERIAL3_BAUDRATE        115200
+#define SERIAL3_RX_BUFFER_SIZE  128
+#define SERIAL3_TX_DMA          0   // DMA1 channel 2, its handler belongs to Hard_SPI here
+#define SERIAL3_TX_BUFFER_SIZE  128
+
+// What the Send/Printf functions do when no TX space is left
+#define SERIAL_TX_WAIT          0   // Wait for the wire (dropped inside an interrupt)
+#define SERIAL_TX_DROP_BYTES    1   // Queue what fits, drop the rest
+#define SERIAL_TX_DROP_MESSAGE  2   // Queue the whole call or nothing, keeps lines intact
+#define SERIAL_TX_FULL_POLICY   SERIAL_TX_WAIT
+
+// Auto-baud: sync byte 0x55 ('U') after an idle line, falling edges at bits
+// 0, 2, 4, 6 and 8; lowest rate whose 2-bit interval fits the 16-bit timer
+#define SERIAL_AUTOBAUD_DMA_CHANNEL DMA1_Channel6
+#define SERIAL_AUTOBAUD_MIN     2400
+#define SERIAL_AUTOBAUD_SNAP_PCT    2   // Round to a standard rate this close
+
+// Serial_AutoBaudPoll() results
+#define SERIAL_AUTOBAUD_IDLE    0   // Not started, or stopped
+#define SERIAL_AUTOBAUD_RUNNING 1   // Waiting for the sync byte
+#define SERIAL_AUTOBAUD_DONE    2   // Rate measured and applied, back to idle
+
+// Printf formatting buffer
+#define SERIAL_PRINTF_SIZE      100
+
+// Overrun and line error counters
+typedef struct {
+    uint32_t rxOverruns;    // Bytes dropped, RX ring full
+    uint32_t txOverruns;    // Bytes dropped, TX ring full
+    uint32_t hwOverruns;    // USART ORE: a byte arrived before the previous was read
+    uint32_t framingErrors; // USART FE: no stop bit (wrong baud rate or a break)
+    uint32_t noiseErrors;   // USART NE: samples of one bit disagreed
+    uint32_t parityErrors;  // USART PE
+    uint32_t txDmaBlocks;   // DMA transfers started
+    uint32_t autoBaudRejects;   // Edge patterns that were not a sync byte
+} Serial_Stats;
+
+// Port handle, state is private to Serial.c
+typedef struct Serial_Port Serial_Port;
+
+#if SERIAL_USE_USART1
+extern Serial_Port Serial_Port1;
+#define SERIAL1                 (&Serial_Port1)
+#endif
+#if SERIAL_USE_USART2
+extern Serial_Port Serial_Port2;
+#define SERIAL2                 (&Serial_Port2)
+#endif
+#if SERIAL_USE_USART3
+extern Serial_Port Serial_Port3;
+#define SERIAL3                 (&Serial_Port3)
+#endif
+
+// Port printf() and putchar() write to
+#define SERIAL_STDIO            SERIAL1
+
+void Serial_Init(Serial_Port *port);    // Pins, USART, interrupts and DMA of one port
+void Serial_SendByte(Serial_Port *port, uint8_t b); // Queue single byte
+void Serial_SendArray(Serial_Port *port, const uint8_t *arr, uint16_t len); // Queue array of bytes
+void Serial_SendString(Serial_Port *port, char *str);   // Queue null-terminated string
+void Serial_SendNumber(Serial_Port *port, uint32_t num, uint8_t len);   // Queue numeric value as ASCII
+void Serial_Printf(Serial_Port *port, char *format, ...);   // Custom printf implementation
+uint16_t Serial_Write(Serial_Port *port, const uint8_t *data, uint16_t len);    // Queue what fits, never waits
+uint16_t Serial_Read(Serial_Port *port, uint8_t *data, uint16_t len);   // Take up to len received bytes
+uint16_t Serial_Available(Serial_Port *port);   // Number of received bytes waiting
+void Serial_Flush(Serial_Port *port);   // Wait until everything queued is on the wire
+void Serial_SetTxPolicy(Serial_Port *port, uint8_t policy); // SERIAL_TX_WAIT / DROP_BYTES / DROP_MESSAGE
+void Serial_GetStats(Serial_Port *port, Serial_Stats *stats);   // Copy the overrun and error counters
+uint8_t Serial_SetBaudrate(Serial_Port *port, uint32_t baudrate);   // Change the rate after the queued bytes are sent
+uint32_t Serial_GetBaudrate(Serial_Port *port);  // Actual rate from BRR and the bus clock
+void Serial_AutoBaudStart(void);    // USART1: stop receiving, wait for a sync byte
+uint8_t Serial_AutoBaudPoll(void);  // SERIAL_AUTOBAUD_x, applies the rate when measured
+void Serial_AutoBaudStop(void);     // Give up, receive at the current rate again
+uint8_t Serial_GetRxFlag(Serial_Port *port);    // Check if new data has been received
+uint8_t Serial_GetRxData(Serial_Port *port);    // Get the oldest received data byte
 
 #endif // !__SERIAL_H__
@@ -0,0 +1,115 @@
+/****************************************************************************/ /**
+ * @file   Trace.h
+ * @brief  Tokenized deferred logging - Header File
+ *
+ * TRACE_ERROR/WARN/INFO/DEBUG("fmt", args...) never format on the target.
+ * Each call site puts its format string, prefixed with "level|file|line|",
+ * in a static const array; the address of that array is the message ID the
+ * linker assigns at build time. A call only copies the ID and up to
+ * TRACE_ARGS_MAX raw 32-bit arguments into a RAM ring (about 30 cycles plus
+ * 3 per argument, safe from any interrupt); Trace_Process() in the main
+ * loop sends the ring over TRACE_PORT. tools/trace_decode reads the format
+ * strings back from the ELF image (.axf) and prints the text.
+ *
+ * Levels above TRACE_LEVEL compile to nothing: no code, no string, and the
+ * arguments are not evaluated.
+ *
+ * Arguments are converted to uint32_t: integers and chars as usual, floats
+ * with TRACE_FLOAT(x), pointers with a cast. %s takes the address of a
+ * string in flash (a literal or const array), read from the ELF by the host.
+ *
+ * Record, little-endian 32-bit words:
+ *   0xA5 | argument count | ms timestamp (2) , format address , arguments
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 20:41:07
+ ********************************************************************************/
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "stm32f10x.h"
+#include "Serial.h"
+
+#define TRACE_LEVEL_NONE        0
+#define TRACE_LEVEL_ERROR       1
+#define TRACE_LEVEL_WARN        2
+#define TRACE_LEVEL_INFO        3
+#define TRACE_LEVEL_DEBUG       4
+
+// Highest level compiled in, may be set per project in the build defines
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL             TRACE_LEVEL_INFO
+#endif
+
+#define TRACE_PORT              SERIAL1
+#define TRACE_BUFFER_WORDS      256     // Ring size in 32-bit words, power of two
+#define TRACE_ARGS_MAX          8
+#define TRACE_SYNC              0xA5
+
+// Counters
+typedef struct {
+    uint32_t records;           // Records queued
+    uint32_t dropped;           // Records lost, ring full
+    uint16_t maxUsedWords;      // High-water mark of the ring
+} Trace_Stats;
+
+// Bit pattern of a float argument, printed with %f / %e / %g
+#define TRACE_FLOAT(x)          (((union { float f; uint32_t u; }){ .f = (float)(x) }).u)
+
+#define TRACE_STR_(x)           #x
+#define TRACE_STR(x)            TRACE_STR_(x)
+#define TRACE_CAT_(a, b)        a##b
+#define TRACE_CAT(a, b)         TRACE_CAT_(a, b)
+
+// 0 for a format alone, N with 1 .. TRACE_ARGS_MAX arguments; more do not compile
+#define TRACE_MODE_(fmt, a1, a2, a3, a4, a5, a6, a7, a8, mode, ...) mode
+#define TRACE_MODE(...)         TRACE_MODE_(__VA_ARGS__, N, N, N, N, N, N, N, N, 0, _)
+
+#define TRACE_FORMAT(level, fmt) \
+    static const char Trace_Fmt[] = TRACE_STR(level) "|" __FILE__ "|" TRACE_STR(__LINE__) "|" fmt
+
+#define TRACE_WRITE_0(level, fmt) do { \
+    TRACE_FORMAT(level, fmt); \
+    Trace_Write(Trace_Fmt, 0, 0); \
+} while (0)
+
+#define TRACE_WRITE_N(level, fmt, ...) do { \
+    TRACE_FORMAT(level, fmt); \
+    const uint32_t Trace_Args[] = { __VA_ARGS__ }; \
+    Trace_Write(Trace_Fmt, Trace_Args, sizeof(Trace_Args) / sizeof(Trace_Args[0])); \
+} while (0)
+
+#define TRACE_EMIT(level, ...)  TRACE_CAT(TRACE_WRITE_, TRACE_MODE(__VA_ARGS__))(level, __VA_ARGS__)
+
+#if TRACE_LEVEL >= TRACE_LEVEL_ERROR
+#define TRACE_ERROR(...)        TRACE_EMIT(TRACE_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define TRACE_ERROR(...)        ((void)0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_WARN
+#define TRACE_WARN(...)         TRACE_EMIT(TRACE_LEVEL_WARN, __VA_ARGS__)
+#else
+#define TRACE_WARN(...)         ((void)0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_INFO
+#define TRACE_INFO(...)         TRACE_EMIT(TRACE_LEVEL_INFO, __VA_ARGS__)
+#else
+#define TRACE_INFO(...)         ((void)0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_DEBUG
+#define TRACE_DEBUG(...)        TRACE_EMIT(TRACE_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define TRACE_DEBUG(...)        ((void)0)
+#endif
+
+void Trace_Init(void);
+void Trace_Write(const char *fmt, const uint32_t *args, uint8_t count);
+void Trace_Process(void);
+void Trace_Tick(void);
+void Trace_GetStats(Trace_Stats *stats);
+
+#endif // !__TRACE_H__
@@ -12,14 +12,121 @@
 #include "stm32f10x.h"
 #include "W25Q64_Ins.h"
 #include "Hard_SPI.h"
+#include "SPI_Bus.h"
+#include "Delay.h"
+
+// Program and erase units used by the driver; every supported part has a
+// 4 KB erase and a page size that is a multiple of 256
+#define W25Q64_PAGE_SIZE            256
+#define W25Q64_SECTOR_SIZE          4096
+
+// Capacity assumed when neither SFDP nor the JEDEC ID tells (8 MB, W25Q64)
+#define W25Q64_DEFAULT_CAPACITY     0x800000
+
+// Highest capacity reachable with 3 address bytes
+#define W25Q64_3BYTE_LIMIT          0x1000000
+
+// SFDP (JESD216): signature "SFDP" and Basic Flash Parameter Table words used
+#define W25Q64_SFDP_SIGNATURE       0x50444653
+#define W25Q64_SFDP_BFPT_DWORDS     16
+
+// Transfers longer than this use SPI DMA, shorter ones stay polled
+#define W25Q64_DMA_THRESHOLD        16
+
+// W25Q64_Benchmark(): scratch sector between the FTL and FS regions, 4 KB runs
+#define W25Q64_BENCH_ADDR           0x1FF000
+#define W25Q64_BENCH_SIZE           W25Q64_SECTOR_SIZE
+
+// Read command: 1 = Fast Read (0x0B + dummy byte, up to 104 MHz) on parts
+//               that identify themselves, 0 = always Read Data (0x03, 50 MHz)
+#define W25Q64_USE_FAST_READ        1
+
+// Clock self-test: reference data is read at the safe prescaler, then
+// compared against reads at each faster candidate prescaler
+#define W25Q64_SAFE_PRESCALER       SPI_BaudRatePrescaler_16
+#define W25Q64_SELFTEST_ADDR        0x000000
+#define W25Q64_SELFTEST_LEN         64
+
+// Status register bits
+#define W25Q64_SR1_BUSY             0x01
+#define W25Q64_SR2_SUS              0x80
+
+// Minimum time between Erase/Program Resume and the next Suspend (tSUS)
+#define W25Q64_SUSPEND_HOLDOFF_US   20
+
+// Deep power-down (0xB9) after this many W25Q64_Tick() ms without access,
+// 0 = only on W25Q64_PowerDown(). Standby draws ~10 uA, power-down ~1 uA
+// (W25Q64JV typical), so the saving is roughly powerDownMs * 9 uA.
+#define W25Q64_POWERDOWN_IDLE_MS    50
+
+// Power-down entry (tDP) and release to the next command (tRES1), maximum
+#define W25Q64_TDP_US               3
+#define W25Q64_TRES1_US             3
+
+// Flash parameters discovered by W25Q64_Init() (JEDEC ID and SFDP)
+typedef struct {
+    uint8_t  manufacturerID;
+    uint16_t deviceID;
+    uint32_t capacity;          // Bytes
+    uint16_t pageSize;          // Device program page, bytes
+    uint8_t  addrBytes;         // 3, or 4 above 16 MB
+    uint8_t  sectorEraseCmd;    // 4 KB erase opcode
+    uint8_t  block32EraseCmd;   // 32 KB erase opcode, 0 = not supported
+    uint8_t  block64EraseCmd;   // 64 KB erase opcode, 0 = not supported
+    bool     fastRead;          // Reads use Fast Read (0x0B + 8 dummy clocks)
+    bool     sfdp;              // Parameters come from SFDP, else from the JEDEC ID
+} W25Q64_Geometry;
+
+// Power counters, in W25Q64_Tick() ms
+typedef struct {
+    uint32_t activeMs;          // Awake: standby or busy
+    uint32_t powerDownMs;       // In deep power-down
+    uint32_t powerDowns;
+    uint32_t wakeups;           // Release from power-down (0xAB) on access
+} W25Q64_PowerStats;
+
+// W25Q64_Benchmark() results, DWT cycles for W25Q64_BENCH_SIZE bytes
+typedef struct {
+    uint32_t readPolled;        // W25Q64_ReadData(), byte loop
+    uint32_t readDMA;           // W25Q64_ReadData(), blocking DMA
+    uint32_t readAsync;         // W25Q64_ReadDataAsync() until its callback
+    uint32_t readAsyncCpu;      // Part of readAsync not spent in the idle loop
+    uint32_t programPolled;     // W25Q64_PageProgram() x 16, byte loop
+    uint32_t programDMA;        // W25Q64_PageProgram() x 16, DMA data phase
+    uint32_t programPolledCpu;  // Part of programPolled spent shifting data out
+    uint32_t programDMACpu;     // Part of programDMA spent shifting data out
+} W25Q64_BenchResult;
+
+// Asynchronous operation in progress
+typedef enum {
+    W25Q64_OP_NONE = 0,
+    W25Q64_OP_PROGRAM,
+    W25Q64_OP_ERASE
+} W25Q64_Op;
 
 void W25Q64_Init(void);
 void W25Q64_ReadID(uint8_t* MID, uint16_t* DID);
-void W25Q64_PageProgram(uint32_t addr, uint8_t *dataArr, uint16_t len);
+void W25Q64_ReadSFDP(uint32_t addr, uint8_t *dataArr, uint16_t len);
+const W25Q64_Geometry *W25Q64_GetGeometry(void);
+void W25Q64_WriteEnable(void);
+void W25Q64_WaitBusy(void);
+uint16_t W25Q64_NegotiateClock(void);
+void W25Q64_PageProgram(uint32_t addr, const uint8_t *dataArr, uint16_t len);
+void W25Q64_Write(uint32_t addr, const uint8_t *dataArr, uint32_t len);
 void W25Q64_EraseSector(uint32_t addr);
 void W25Q64_EraseChip(void);
 void W25Q64_EraseBlock64K(uint32_t addr);
 void W25Q64_EraseBlock32K(uint32_t addr);
 void W25Q64_ReadData(uint32_t addr, uint8_t* dataArr, uint32_t len);
+bool W25Q64_ReadDataAsync(uint32_t addr, uint8_t* dataArr, uint16_t len, Hard_SPI_Callback callback);
+bool W25Q64_PageProgramAsync(uint32_t addr, const uint8_t *dataArr, uint16_t len);
+bool W25Q64_EraseSectorAsync(uint32_t addr);
+bool W25Q64_IsBusy(void);
+void W25Q64_Sync(void);
+void W25Q64_Process(void);
+void W25Q64_Tick(void);
+bool W25Q64_PowerDown(void);
+void W25Q64_GetPowerStats(W25Q64_PowerStats *stats);
+void W25Q64_Benchmark(W25Q64_BenchResult *result);
 
 #endif // !__W25Q64_H__
@@ -0,0 +1,48 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_Cache.h
+ * @brief  Line-based RAM read cache in front of W25Q64_ReadData - Header File
+ *
+ * Small random reads (lookup tables, config records) cost a full command
+ * header each. The cache keeps the last W25Q64_CACHE_LINES aligned lines
+ * and serves hits with a memcpy. The W25Q64 driver invalidates affected
+ * lines on every program and erase, so the cache never returns stale data.
+ *
+ * RAM: W25Q64_CACHE_LINES x (W25Q64_CACHE_LINE_SIZE + 8) bytes.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 16:02:17
+ ********************************************************************************/
+
+#ifndef __W25Q64_CACHE_H__
+#define __W25Q64_CACHE_H__
+
+#include <stdint.h>
+
+// Geometry (line size must be a power of two)
+#define W25Q64_CACHE_LINES          8
+#define W25Q64_CACHE_LINE_SIZE      64
+
+// Lines fetched in one transaction when a miss continues a sequential run
+#define W25Q64_CACHE_READAHEAD      2
+
+// Reads at least this long bypass the cache and go straight to DMA
+#define W25Q64_CACHE_BYPASS_LEN     (2 * W25Q64_CACHE_LINE_SIZE)
+
+// Cache counters
+typedef struct {
+    uint32_t hits;              // Line lookups served from RAM
+    uint32_t misses;            // Line lookups that read the flash
+    uint32_t readAheads;        // Lines fetched ahead of a sequential run
+    uint32_t readAheadHits;     // ... that were used before eviction
+    uint32_t bypasses;          // Large reads sent directly to the flash
+    uint32_t invalidations;     // Lines dropped by program/erase
+} W25Q64_Cache_Stats;
+
+// Function declaration
+void W25Q64_Cache_Read(uint32_t addr, uint8_t *dataArr, uint32_t len);
+void W25Q64_Cache_Invalidate(uint32_t addr, uint32_t len);
+void W25Q64_Cache_InvalidateAll(void);
+void W25Q64_Cache_GetStats(W25Q64_Cache_Stats *stats);
+void W25Q64_Cache_ResetStats(void);
+
+#endif // !__W25Q64_CACHE_H__
@@ -0,0 +1,105 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_FS.h
+ * @brief  Small power-fail-safe file system on the W25Q64 - Header File
+ *
+ * Flash map (default):
+ * - 0x000000 CJK font (CH_FONT_BASE_ADDR)
+ * - 0x100000 W25Q64_FTL region
+ * - 0x200000 W25Q64_FS: 2 metadata sectors, then data sectors
+ *
+ * The directory is a 1 KB snapshot. Every change writes a complete new
+ * snapshot into the next slot of the metadata ring (copy-on-write), the
+ * newest slot with a good CRC32 wins at mount time. File data is only ever
+ * written to sectors the committed directory does not reference, so a
+ * power cut leaves either the old or the new version of a file.
+ *
+ * Files are stored as up to W25Q64_FS_EXTENTS runs of whole sectors.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 15:20:41
+ ********************************************************************************/
+
+#ifndef __W25Q64_FS_H__
+#define __W25Q64_FS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Flash region owned by the file system (must be sector aligned)
+#define W25Q64_FS_BASE_ADDR             0x200000
+#define W25Q64_FS_SECTOR_COUNT          1024        // 4 MB including metadata
+
+#define W25Q64_FS_PAGE_SIZE             256
+#define W25Q64_FS_SECTOR_SIZE           4096
+#define W25Q64_FS_META_SECTORS          2
+#define W25Q64_FS_DATA_SECTORS          (W25Q64_FS_SECTOR_COUNT - W25Q64_FS_META_SECTORS)
+
+// Directory snapshot: 32-byte header, entries, 32-byte trailer ending in CRC32
+#define W25Q64_FS_SNAPSHOT_SIZE         1024
+#define W25Q64_FS_MAX_FILES             30
+#define W25Q64_FS_NAME_LEN              12          // Including the terminating NUL
+#define W25Q64_FS_EXTENTS               4
+
+#define W25Q64_FS_MAGIC                 0x31465357  // "WSF1"
+
+// Flash access used by the file system. NULL in Mount/Format selects the W25Q64
+typedef struct {
+    void (*read)(uint32_t addr, uint8_t *buf, uint32_t len);
+    void (*program)(uint32_t addr, const uint8_t *buf, uint16_t len);  // Within one page
+    void (*erase)(uint32_t addr);                                       // Blocking sector erase
+    bool (*eraseAsync)(uint32_t addr);                                  // Optional, may be NULL
+} W25Q64_FS_Flash;
+
+// File system status
+typedef enum {
+    W25Q64_FS_OK = 0,
+    W25Q64_FS_ERR_PARAM,        // Bad name, mode or handle
+    W25Q64_FS_ERR_NOT_MOUNTED,
+    W25Q64_FS_ERR_NO_FORMAT,    // No valid directory snapshot
+    W25Q64_FS_ERR_NOT_FOUND,
+    W25Q64_FS_ERR_BUSY,         // Another file is open for writing
+    W25Q64_FS_ERR_FULL,         // No free sector, directory entry or extent
+    W25Q64_FS_ERR_MODE          // Operation not allowed in this open mode
+} W25Q64_FS_Status;
+
+typedef enum {
+    W25Q64_FS_READ = 0,         // Existing file, seekable
+    W25Q64_FS_WRITE,            // Create or replace, visible after close
+    W25Q64_FS_APPEND            // Create or extend, visible after close
+} W25Q64_FS_Mode;
+
+// Extent: run of consecutive data sectors
+typedef struct {
+    uint16_t start;
+    uint16_t count;
+} W25Q64_FS_Extent;
+
+// Directory entry as stored on flash (32 bytes)
+typedef struct {
+    char name[W25Q64_FS_NAME_LEN];
+    uint32_t size;
+    W25Q64_FS_Extent extent[W25Q64_FS_EXTENTS];
+} W25Q64_FS_Entry;
+
+// Open file handle, owned by the caller
+typedef struct {
+    W25Q64_FS_Entry entry;      // Working copy
+    uint32_t pos;
+    uint8_t index;              // Directory slot
+    uint8_t mode;
+    bool open;
+} W25Q64_FS_File;
+
+// Function declaration
+W25Q64_FS_Status W25Q64_FS_Mount(const W25Q64_FS_Flash *flash);
+W25Q64_FS_Status W25Q64_FS_Format(const W25Q64_FS_Flash *flash);
+W25Q64_FS_Status W25Q64_FS_Open(W25Q64_FS_File *file, const char *name, W25Q64_FS_Mode mode);
+uint32_t W25Q64_FS_Read(W25Q64_FS_File *file, void *buf, uint32_t len);
+uint32_t W25Q64_FS_Write(W25Q64_FS_File *file, const void *buf, uint32_t len);
+W25Q64_FS_Status W25Q64_FS_Seek(W25Q64_FS_File *file, uint32_t offset);
+W25Q64_FS_Status W25Q64_FS_Close(W25Q64_FS_File *file);
+W25Q64_FS_Status W25Q64_FS_Remove(const char *name);
+bool W25Q64_FS_List(uint8_t *cursor, W25Q64_FS_Entry *entry);
+uint32_t W25Q64_FS_Free(void);
+
+#endif // !__W25Q64_FS_H__
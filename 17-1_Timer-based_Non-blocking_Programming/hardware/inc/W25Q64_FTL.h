@@ -0,0 +1,97 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_FTL.h
+ * @brief  Log-structured, wear-leveling flash translation layer - Header File
+ *
+ * Logical 256-byte pages are appended to the W25Q64 like a log. Rewriting a
+ * logical page never erases in place, it only invalidates the older copy.
+ *
+ * Sector layout (16 pages of 256 bytes):
+ * - Page 0     : summary (header + one entry per data slot)
+ * - Pages 1-15 : data slots
+ *
+ * Summary page:
+ * - 0x00 magic, 0x04 erase count, 0x08 ~erase count  (written after erase)
+ * - 0x0C sequence, 0x10 ~sequence                    (written when opened)
+ * - 0x20 + 4 * slot : logical page, ~logical page    (written after the data)
+ *
+ * Every summary field is programmed once from the erased state together
+ * with its complement, so a torn program is detected at mount time and
+ * the newest (sequence, slot) copy of each logical page wins.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 14:05:12
+ ********************************************************************************/
+
+#ifndef __W25Q64_FTL_H__
+#define __W25Q64_FTL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Flash region owned by the FTL (must be sector aligned)
+#define W25Q64_FTL_BASE_ADDR            0x100000
+#define W25Q64_FTL_SECTOR_COUNT         64
+
+// Geometry
+#define W25Q64_FTL_PAGE_SIZE            256
+#define W25Q64_FTL_SECTOR_SIZE          4096
+#define W25Q64_FTL_SLOTS_PER_SECTOR     (W25Q64_FTL_SECTOR_SIZE / W25Q64_FTL_PAGE_SIZE - 1)
+
+// Over-provisioning: sectors kept out of the logical capacity for GC
+#define W25Q64_FTL_SPARE_SECTORS        8
+#define W25Q64_FTL_LOGICAL_PAGES        ((W25Q64_FTL_SECTOR_COUNT - W25Q64_FTL_SPARE_SECTORS) * \
+                                         W25Q64_FTL_SLOTS_PER_SECTOR)
+
+// Foreground GC runs below this many free sectors, background GC one above
+#define W25Q64_FTL_GC_THRESHOLD         2
+
+// Static wear leveling: move cold data once erase counts drift this far apart,
+// checked at most once per W25Q64_FTL_WEAR_INTERVAL erases
+#define W25Q64_FTL_WEAR_DELTA           64
+#define W25Q64_FTL_WEAR_INTERVAL        (W25Q64_FTL_SECTOR_COUNT / 4)
+
+#define W25Q64_FTL_MAGIC                0x314C5446  // "FTL1"
+#define W25Q64_FTL_UNMAPPED             0xFFFF
+
+// Flash access used by the FTL. NULL in W25Q64_FTL_Mount() selects the W25Q64
+typedef struct {
+    void (*read)(uint32_t addr, uint8_t *buf, uint32_t len);
+    void (*program)(uint32_t addr, const uint8_t *buf, uint16_t len);  // Within one page
+    void (*erase)(uint32_t addr);                                       // Blocking sector erase
+    bool (*eraseAsync)(uint32_t addr);                                  // Optional, may be NULL
+    bool (*isBusy)(void);                                               // Async erase pending
+    void (*sync)(void);                                                 // Wait for async erase
+} W25Q64_FTL_Flash;
+
+// FTL status
+typedef enum {
+    W25Q64_FTL_OK = 0,
+    W25Q64_FTL_ERR_PARAM,       // Logical page out of range
+    W25Q64_FTL_ERR_NOT_MOUNTED,
+    W25Q64_FTL_ERR_NO_FORMAT,   // No FTL sector found, call W25Q64_FTL_Format()
+    W25Q64_FTL_ERR_NO_SPACE     // No erasable sector left (should not happen)
+} W25Q64_FTL_Status;
+
+// FTL counters
+typedef struct {
+    uint32_t hostWrites;        // Pages written by W25Q64_FTL_Write()
+    uint32_t flashPrograms;     // Data pages programmed, including GC copies
+    uint32_t relocations;       // Valid pages copied by GC
+    uint32_t erases;            // Sector erases (foreground + background)
+    uint32_t bgErases;          // Sector erases started by W25Q64_FTL_Process()
+    uint32_t gcRuns;            // Victim sectors reclaimed
+    uint32_t wearMoves;         // Victims picked by static wear leveling
+    uint32_t minErase;          // Lowest sector erase count
+    uint32_t maxErase;          // Highest sector erase count
+    uint16_t freeSectors;       // Dirty + erased sectors
+} W25Q64_FTL_Stats;
+
+// Function declaration
+W25Q64_FTL_Status W25Q64_FTL_Mount(const W25Q64_FTL_Flash *flash);
+W25Q64_FTL_Status W25Q64_FTL_Format(const W25Q64_FTL_Flash *flash);
+W25Q64_FTL_Status W25Q64_FTL_Read(uint16_t lpn, uint8_t *buf);
+W25Q64_FTL_Status W25Q64_FTL_Write(uint16_t lpn, const uint8_t *buf);
+void W25Q64_FTL_Process(void);
+void W25Q64_FTL_GetStats(W25Q64_FTL_Stats *stats);
+
+#endif // !__W25Q64_FTL_H__
@@ -14,6 +14,7 @@
 #define W25Q64_WRITE_DISABLE                0x04
 #define W25Q64_READ_STATUS_REG1             0x05
 #define W25Q64_READ_STATUS_REG2             0x35
+#define W25Q64_READ_STATUS_REG3             0x15
 #define W25Q64_WRITE_STATUS_REG             0x01
 #define W25Q64_PAGE_PROGRAM                 0x02
 #define W25Q64_SECTOR_ERASE                 0x20
@@ -37,6 +38,10 @@
 #define W25Q64_ENABLE_RESET                 0x66
 #define W25Q64_RESET                        0x99
 
+// 4-byte address mode, parts above 16 MB (W25Q256)
+#define W25Q64_ENTER_4BYTE_ADDR             0xB7
+#define W25Q64_EXIT_4BYTE_ADDR              0xE9
+
 // Dual SPI Instructions for W25Q64
 #define W25Q64_FAST_READ_DUAL_OUTPUT        0x3B
 #define W25Q64_FAST_READ_DUAL_IO            0xBB
@@ -0,0 +1,71 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_Log.h
+ * @brief  High-rate circular data logger on the W25Q64 - Header File
+ *
+ * Interrupt handlers append small records to page-sized RAM buffers. The
+ * main loop programs full pages with W25Q64_PageProgramAsync() and erases
+ * the sector ahead of the write pointer with W25Q64_EraseSectorAsync(), so
+ * neither side ever waits on the flash.
+ *
+ * Flash page layout (256 bytes):
+ * - 0x00 sequence number (increments per page, never wraps in practice)
+ * - 0x04 payload bytes used
+ * - 0x06 CRC16-CCITT over sequence, used and payload
+ * - 0x08 records: tag (1), length (1), data (length)
+ *
+ * Sustained rate (payload bytes per second, no loss):
+ * - Flash bound, typical tSE 45 ms / tPP 0.7 ms: 16 pages of 248 bytes per
+ *   56 ms, about 70 KB/s
+ * - Buffer bound, worst case tSE 400 ms: buffers x 248 bytes must cover
+ *   one erase, 8 buffers = 1984 bytes -> 4.9 KB/s guaranteed, and at the
+ *   typical erase time about 44 KB/s (e.g. 16-byte ADC+MPU6050 samples at
+ *   2 kHz = 36 KB/s including the 2-byte record header)
+ * Every record that does not fit is counted in W25Q64_Log_Stats.dropped.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 16:40:05
+ ********************************************************************************/
+
+#ifndef __W25Q64_LOG_H__
+#define __W25Q64_LOG_H__
+
+#include "stm32f10x.h"
+#include "Serial.h"
+#include <stdbool.h>
+
+// Flash region (sector aligned), after the W25Q64_FS region
+#define W25Q64_LOG_BASE_ADDR        0x600000
+#define W25Q64_LOG_SECTOR_COUNT     512         // 2 MB
+
+#define W25Q64_LOG_PAGE_SIZE        256
+#define W25Q64_LOG_SECTOR_SIZE      4096
+#define W25Q64_LOG_PAGES_PER_SECTOR (W25Q64_LOG_SECTOR_SIZE / W25Q64_LOG_PAGE_SIZE)
+#define W25Q64_LOG_HEADER_SIZE      8
+#define W25Q64_LOG_PAYLOAD_SIZE     (W25Q64_LOG_PAGE_SIZE - W25Q64_LOG_HEADER_SIZE)
+#define W25Q64_LOG_MAX_RECORD       (W25Q64_LOG_PAYLOAD_SIZE - 2)
+
+// RAM page buffers (power of two), see the rate table above
+#define W25Q64_LOG_BUFFERS          8
+
+// The erase of the next sector is started once the queue is empty, and at
+// the latest when the write pointer reaches this page of the current sector
+#define W25Q64_LOG_ERASE_DEADLINE   (W25Q64_LOG_PAGES_PER_SECTOR / 2)
+
+// Logger counters
+typedef struct {
+    uint32_t records;           // Records accepted
+    uint32_t dropped;           // Records lost because every buffer was full
+    uint32_t pages;             // Pages programmed
+    uint32_t erases;            // Sectors erased ahead
+    uint8_t  maxQueued;         // High-water mark of full buffers waiting
+} W25Q64_Log_Stats;
+
+// Function declaration
+void W25Q64_Log_Init(void);
+bool W25Q64_Log_Write(uint8_t tag, const void *data, uint8_t len);
+void W25Q64_Log_Flush(void);
+void W25Q64_Log_Process(void);
+void W25Q64_Log_Dump(Serial_Port *port);
+void W25Q64_Log_GetStats(W25Q64_Log_Stats *stats);
+
+#endif // !__W25Q64_LOG_H__
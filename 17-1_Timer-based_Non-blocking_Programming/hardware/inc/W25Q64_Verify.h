@@ -0,0 +1,56 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_Verify.h
+ * @brief  Background CRC32 check of W25Q64 content regions - Header File
+ *
+ * Each region (font image, assets) is read with W25Q64_ReadDataAsync() into
+ * one of two RAM chunks while the other chunk is pushed into the STM32 CRC
+ * unit by DMA1 Channel 1 (memory-to-memory). The CPU only starts transfers,
+ * so the check runs from the main loop without delaying start-up.
+ *
+ * The CRC is the one of the STM32F1 CRC unit: polynomial 0x04C11DB7, initial
+ * value 0xFFFFFFFF, data fed as little-endian 32-bit words, no reflection,
+ * no final XOR. Region lengths must be multiples of 4.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 17:05:32
+ ********************************************************************************/
+
+#ifndef __W25Q64_VERIFY_H__
+#define __W25Q64_VERIFY_H__
+
+#include "stm32f10x.h"
+#include <stdbool.h>
+
+// Regions checked per W25Q64_Verify_Start()
+#define W25Q64_VERIFY_MAX_REGIONS   4
+
+// Bytes per flash read, two chunks of RAM are used
+#define W25Q64_VERIFY_CHUNK_SIZE    256
+
+// DMA channel feeding the CRC unit (free on this board)
+#define W25Q64_VERIFY_DMA_CHANNEL   DMA1_Channel1
+#define W25Q64_VERIFY_DMA_FLAG_TC   DMA1_FLAG_TC1
+#define W25Q64_VERIFY_DMA_FLAGS     (DMA1_FLAG_GL1 | DMA1_FLAG_TC1 | DMA1_FLAG_HT1 | DMA1_FLAG_TE1)
+
+// Flash region with its expected CRC
+typedef struct {
+    uint32_t addr;
+    uint32_t len;               // Multiple of 4
+    uint32_t crc;
+} W25Q64_Verify_Region;
+
+// Result of one region
+typedef enum {
+    W25Q64_VERIFY_PENDING = 0,  // Not checked yet
+    W25Q64_VERIFY_OK,
+    W25Q64_VERIFY_FAILED        // Content does not match, do not use it
+} W25Q64_Verify_Status;
+
+// Function declaration
+void W25Q64_Verify_Start(const W25Q64_Verify_Region *regions, uint8_t count);
+void W25Q64_Verify_Process(void);
+W25Q64_Verify_Status W25Q64_Verify_GetStatus(uint8_t region);
+bool W25Q64_Verify_IsDone(void);
+bool W25Q64_Verify_Failed(void);
+
+#endif // !__W25Q64_VERIFY_H__
@@ -1,82 +1,185 @@
 /****************************************************************************/ /**
  * @file   Font_Programmer.c
- * @brief  
- * 
+ * @brief  中文字库串口烧录（滑动窗口协议）
+ *
+ * 串口接收由 DMA 循环写入环形缓冲区完成, CPU 只负责校验和烧录:
+ * 页编程的数据经 SPI 移出后槽位立即释放并确认, 芯片内部编程期间
+ * 下一帧继续由 DMA 接收; 扇区在写指针到达之前的空闲时间擦除。
+ *
+ * 帧错位 (丢字节、校验错误、跳号) 后不停止接收: 发送一次 NAK, 然后在
+ * 环形缓冲区中逐字节向后寻找序号在窗口内且 CRC 正确的帧。对齐只依据帧
+ * 内容, 与到达时间无关, 主机因 USB 延迟晚到的帧也能被正确识别。
+ *
  * @author Maverick Pi
  * @date   2025-12-16 16:52:05
  ********************************************************************************/
 
 #include "Font_Programmer.h"
+#include "Delay.h"
+#include "CRC16.h"
 #include <string.h>
 
+#define FONT_PROGRAMMER_FRAME_SIZE      (FONT_PROGRAMMER_BUFFER_SIZE + 4)
+#define FONT_PROGRAMMER_RING_SIZE       (FONT_PROGRAMMER_FRAME_SIZE * FONT_PROGRAMMER_SLOTS)
+#define FONT_PROGRAMMER_SECTOR_SIZE     4096
+
+static uint8_t Font_Programmer_Ring[FONT_PROGRAMMER_RING_SIZE];   // DMA 接收环形缓冲区
+static uint8_t Font_Programmer_Frame[FONT_PROGRAMMER_FRAME_SIZE]; // 跨越缓冲区末尾的帧在此拼接
+
+/**
+ * @brief 启动 USART1 RX 循环 DMA, 从环形缓冲区起点开始写入
+ */
+static void Font_Programmer_RxStart(void)
+{
+    DMA_InitTypeDef DMA_InitStructure;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    DMA_DeInit(FONT_PROGRAMMER_DMA_CHANNEL);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t) &USART1->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) Font_Programmer_Ring;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = FONT_PROGRAMMER_RING_SIZE;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(FONT_PROGRAMMER_DMA_CHANNEL, &DMA_InitStructure);
+
+    USART_DMACmd(USART1, USART_DMAReq_Rx, ENABLE);
+    DMA_Cmd(FONT_PROGRAMMER_DMA_CHANNEL, ENABLE);
+}
+
+/**
+ * @brief 发送应答: 类型 + 序号（小端）
+ */
+static void Font_Programmer_Reply(uint8_t type, uint16_t seq)
+{
+    Serial_SendByte(SERIAL1, type);
+    Serial_SendByte(SERIAL1, seq & 0xFF);
+    Serial_SendByte(SERIAL1, seq >> 8);
+}
+
+/**
+ * @brief 取环形缓冲区 tail 处的一帧, 跨越缓冲区末尾时拼接为连续数据
+ */
+static uint8_t *Font_Programmer_FrameAt(uint32_t tail)
+{
+    uint32_t first = FONT_PROGRAMMER_RING_SIZE - tail;
+
+    if (first >= FONT_PROGRAMMER_FRAME_SIZE) return &Font_Programmer_Ring[tail];
+
+    memcpy(Font_Programmer_Frame, &Font_Programmer_Ring[tail], first);
+    memcpy(Font_Programmer_Frame + first, Font_Programmer_Ring, FONT_PROGRAMMER_FRAME_SIZE - first);
+    return Font_Programmer_Frame;
+}
+
 void Font_Programmer_CH(void)
 {
     uint32_t dataLength = 0;
-    uint8_t buffer[FONT_PROGRAMMER_BUFFER_SIZE];
-    uint32_t address = FONT_PROGRAMMER_W25Q64_START_ADDR;
-    
-    Serial_Init();
+    uint32_t erased = FONT_PROGRAMMER_W25Q64_START_ADDR;   // 已擦除区域末尾
+    uint32_t tail = 0;          // 环形缓冲区中下一帧的位置
+    uint32_t idle = 0;          // 等待数据的时间（10us 单位）
+    uint16_t expected = 0;      // 下一个要烧录的块序号
+    bool hunting = false;       // 已发送 NAK, 正在逐字节寻找有效帧
+
+    Serial_Init(SERIAL1);
     // 初始化W25Q64
     W25Q64_Init();
-    
-    // 发送开始信号给PC
-    Serial_SendString("READY\r\n");
-    
+
+    // 接收改由 DMA 完成, 关闭 RXNE 中断以免中断抢读数据
+    USART_ITConfig(USART1, USART_IT_RXNE, DISABLE);
+
+    // 发送开始信号给PC: 窗口大小和切换后的波特率
+    Serial_Printf(SERIAL1, "READY %u %lu\r\n", FONT_PROGRAMMER_SLOTS - 1, (uint32_t)FONT_PROGRAMMER_BAUDRATE);
+    Serial_SetBaudrate(SERIAL1, FONT_PROGRAMMER_BAUDRATE);  // 等待当前发送完成后切换
+
     // 接收数据长度（4字节，大端格式）
     for (uint8_t i = 0; i < 4; i++) {
-        while (Serial_GetRxFlag() == 0);  // 等待数据
-        uint8_t byte = Serial_GetRxData();
+        while (USART_GetFlagStatus(USART1, USART_FLAG_RXNE) == RESET);  // 等待数据
+        uint8_t byte = USART_ReceiveData(USART1);
         dataLength = (dataLength << 8) | byte;
     }
-    
-    // 发送ACK确认长度接收成功
-    Serial_SendByte('A');
-    
-    // 计算需要接收的块数
-    uint32_t totalBlocks = dataLength / FONT_PROGRAMMER_BUFFER_SIZE;
-    uint32_t remainingBytes = dataLength % FONT_PROGRAMMER_BUFFER_SIZE;
-    
-    // 擦除需要的扇区（每个扇区4KB）
-    uint32_t sectorsToErase = (dataLength + 4095) / 4096;  // 向上取整
-    for (uint32_t i = 0; i < sectorsToErase; i++) {
-        W25Q64_EraseSector(address + i * 4096);
-    }
 
-    // ☆ 告诉 PC：我擦完了，可以发数据了
-    Serial_SendString("ERASE_DONE\r\n");
-    
-    // 接收并写入完整的数据块
-    for (uint32_t block = 0; block < totalBlocks; block++) {
-        // 接收一个数据块
-        for (uint16_t i = 0; i < FONT_PROGRAMMER_BUFFER_SIZE; i++) {
-            while (Serial_GetRxFlag() == 0);  // 等待数据
-            buffer[i] = Serial_GetRxData();
+    uint16_t totalBlocks = (dataLength + FONT_PROGRAMMER_BUFFER_SIZE - 1) / FONT_PROGRAMMER_BUFFER_SIZE;
+    uint32_t endAddr = FONT_PROGRAMMER_W25Q64_START_ADDR + dataLength;
+
+    // 先启动接收再确认, 之后的数据帧全部进入环形缓冲区
+    Font_Programmer_RxStart();
+    Serial_SendByte(SERIAL1, 'A');
+
+    while (expected < totalBlocks) {
+        uint32_t head = FONT_PROGRAMMER_RING_SIZE - DMA_GetCurrDataCounter(FONT_PROGRAMMER_DMA_CHANNEL);
+        uint32_t avail = (head + FONT_PROGRAMMER_RING_SIZE - tail) % FONT_PROGRAMMER_RING_SIZE;
+        uint32_t writeAddr = FONT_PROGRAMMER_W25Q64_START_ADDR + (uint32_t)expected * FONT_PROGRAMMER_BUFFER_SIZE;
+
+        if (avail < FONT_PROGRAMMER_FRAME_SIZE) {
+            // 空闲: 擦除写指针前方的下一个扇区
+            if (erased < endAddr && erased <= writeAddr + FONT_PROGRAMMER_SECTOR_SIZE) {
+                W25Q64_Sync();
+                W25Q64_EraseSectorAsync(erased);
+                erased += FONT_PROGRAMMER_SECTOR_SIZE;
+                continue;
+            }
+
+            // 半帧长时间没有后续数据: 丢失了字节, 请求重发, 重发的帧到达后逐字节对齐
+            if (avail > 0 && ++idle > FONT_PROGRAMMER_TIMEOUT_MS * 100) {
+                Font_Programmer_Reply('N', expected);
+                hunting = true;
+                idle = 0;
+            }
+            Delay_us(10);
+            continue;
         }
-        
-        // 写入到Flash
-        W25Q64_PageProgram(address, buffer, FONT_PROGRAMMER_BUFFER_SIZE);
-        address += FONT_PROGRAMMER_BUFFER_SIZE;
-        
-        // 发送ACK
-        Serial_SendByte('A');
-    }
-    
-    // 接收并写入剩余的数据
-    if (remainingBytes > 0) {
-        // 接收剩余数据
-        for (uint16_t i = 0; i < remainingBytes; i++) {
-            while (Serial_GetRxFlag() == 0);  // 等待数据
-            buffer[i] = Serial_GetRxData();
+        idle = 0;
+
+        uint8_t *frame = Font_Programmer_FrameAt(tail);
+        uint16_t seq = frame[0] | (frame[1] << 8);
+        uint16_t crc = frame[FONT_PROGRAMMER_FRAME_SIZE - 2] | (frame[FONT_PROGRAMMER_FRAME_SIZE - 1] << 8);
+
+        // 序号须为期望块或窗口内的重复块, 先比较序号, 逐字节寻找时很少需要算 CRC;
+        // 校验错误或跳号: 只请求一次从期望序号重发, 然后向后移一个字节继续寻找
+        if ((uint16_t)(expected - seq) >= FONT_PROGRAMMER_SLOTS ||
+            CRC16_Update(CRC16_INIT, frame, FONT_PROGRAMMER_FRAME_SIZE - 2) != crc) {
+            if (!hunting) {
+                Font_Programmer_Reply('N', expected);
+                hunting = true;
+            }
+            tail = (tail + 1) % FONT_PROGRAMMER_RING_SIZE;
+            continue;
+        }
+        hunting = false;
+
+        // 重复帧（主机超时重发）只重新确认
+        if (seq == expected) {
+            uint16_t len = (endAddr - writeAddr > FONT_PROGRAMMER_BUFFER_SIZE) ?
+                           FONT_PROGRAMMER_BUFFER_SIZE : (uint16_t)(endAddr - writeAddr);
+
+            // 写指针追上擦除位置时立即擦除
+            while (writeAddr + len > erased) {
+                W25Q64_Sync();
+                W25Q64_EraseSectorAsync(erased);
+                erased += FONT_PROGRAMMER_SECTOR_SIZE;
+            }
+
+            // 等上一页编程结束后写入, 数据移出后槽位即可复用
+            W25Q64_Sync();
+            W25Q64_PageProgramAsync(writeAddr, frame + 2, len);
+            expected++;
         }
-        
-        // 写入到Flash
-        W25Q64_PageProgram(address, buffer, remainingBytes);
-        
-        // 发送ACK
-        Serial_SendByte('A');
+
+        tail = (tail + FONT_PROGRAMMER_FRAME_SIZE) % FONT_PROGRAMMER_RING_SIZE;
+        Font_Programmer_Reply('A', expected);
     }
-    
+
+    W25Q64_Sync();
+    DMA_Cmd(FONT_PROGRAMMER_DMA_CHANNEL, DISABLE);
+    USART_DMACmd(USART1, USART_DMAReq_Rx, DISABLE);
+
     // 发送完成信号
-    Serial_SendString("DONE\r\n");
-    Serial_Printf("Font data programmed successfully! Total bytes: %lu\r\n", dataLength);
-}
\ No newline at end of file
+    Serial_SendString(SERIAL1, "DONE\r\n");
+    Serial_Printf(SERIAL1, "Font data programmed successfully! Total bytes: %lu\r\n", dataLength);
+}
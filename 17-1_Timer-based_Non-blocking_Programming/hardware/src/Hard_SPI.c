@@ -7,6 +7,30 @@
  ********************************************************************************/
 
 #include "Hard_SPI.h"
+#include "Serial.h"
+
+#if SERIAL_USE_USART3 && SERIAL3_TX_DMA
+#error "DMA1 channel 2 is SPI1 RX here, set SERIAL3_TX_DMA to 0"
+#endif
+
+/*
+ * Throughput at prescaler 4 (SCK 18 MHz, 0.44 us per byte on the wire, so
+ * no mode can exceed 2.25 MB/s):
+ * - Hard_SPI_TransferByte() loop: two flag polls and the SPL call overhead
+ *   per byte leave SCK idle between bytes, CPU busy throughout
+ * - DMA blocking: back-to-back bytes, CPU spins on one flag only
+ * - DMA async: back-to-back bytes, CPU free except one interrupt per transfer
+ * W25Q64_Benchmark() ('B' on USART1 in main.c) measures each mode with the
+ * DWT cycle counter: 4 KB W25Q64_ReadData() and 16 page programs, in bytes/s
+ * and CPU-busy fraction.
+ */
+
+static uint8_t Hard_SPI_DummyTx = SPI1_DMA_DUMMY_BYTE;  // Clocked out for receive-only transfers
+static uint8_t Hard_SPI_DummyRx;                        // Sink for transmit-only transfers
+static volatile bool Hard_SPI_DMABusy = false;          // DMA transfer in progress
+static Hard_SPI_Callback Hard_SPI_DMACallback = 0;      // Async completion callback
+
+static void Hard_SPI_DMA_Init(void);
 
 /**
  * @brief Initialize SPI1 peripheral with GPIO configuration
@@ -18,8 +42,9 @@
  * - MISO as input pull-up
  * - SPI1 in master mode, full duplex, 8-bit data
  * - CPOL=0, CPHA=1 edge, MSB first
- * - Baud rate prescaler 16
+ * - Baud rate prescaler SPI1_BAUDRATE_PRESCALER (18 MHz)
  * - Software NSS management
+ * - DMA1 channel 2 (RX) and channel 3 (TX) for bulk transfers
  */
 void Hard_SPI_Init(void)
 {
@@ -56,7 +81,7 @@ void Hard_SPI_Init(void)
         .SPI_CPOL = SPI_CPOL_Low,
         .SPI_CPHA = SPI_CPHA_1Edge,
         .SPI_NSS = SPI_NSS_Soft,
-        .SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_16,
+        .SPI_BaudRatePrescaler = SPI1_BAUDRATE_PRESCALER,
         .SPI_FirstBit = SPI_FirstBit_MSB,
         .SPI_CRCPolynomial = 7
     });
@@ -66,24 +91,53 @@ void Hard_SPI_Init(void)
 
     /* Set CS high to deselect SPI device (W25Q64) */
     GPIO_SetBits(GPIOA, SPI1_CS_PIN); // Deselect W25Q64
-}
 
-/**
- * @brief Start SPI transaction by activating chip select
- * Sets CS pin low to select the SPI slave device
- */
-void Hard_SPI_Start(void)
-{
-    GPIO_ResetBits(GPIOA, SPI1_CS_PIN); // Select W25Q64
+    Hard_SPI_DMA_Init();
 }
 
 /**
- * @brief End SPI transaction by deactivating chip select
- * Sets CS pin high to deselect the SPI slave device
+ * @brief Initialize DMA1 channel 2 (SPI1_RX) and channel 3 (SPI1_TX)
+ * 
+ * Both channels are configured once for byte transfers to/from SPI1->DR and
+ * left disabled. Memory address, increment mode and length are set per
+ * transfer. RX runs at a higher priority than TX so that the receive side is
+ * always drained before the next byte is shifted in.
  */
-void Hard_SPI_Stop(void)
+static void Hard_SPI_DMA_Init(void)
 {
-    GPIO_SetBits(GPIOA, SPI1_CS_PIN); // Deselect W25Q64
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t) &SPI1->DR;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_InitStructure.DMA_BufferSize = 1;
+
+    /* SPI1_RX: DR -> memory */
+    DMA_DeInit(SPI1_DMA_RX_CHANNEL);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) &Hard_SPI_DummyRx;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_Init(SPI1_DMA_RX_CHANNEL, &DMA_InitStructure);
+
+    /* SPI1_TX: memory -> DR */
+    DMA_DeInit(SPI1_DMA_TX_CHANNEL);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) &Hard_SPI_DummyTx;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_Init(SPI1_DMA_TX_CHANNEL, &DMA_InitStructure);
+
+    /* Completion interrupt, enabled per transfer for the async variant */
+    NVIC_InitTypeDef NVIC_InitStructure;
+    NVIC_InitStructure.NVIC_IRQChannel = SPI1_DMA_RX_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
 }
 
 /**
@@ -110,57 +164,144 @@ uint8_t Hard_SPI_TransferByte(uint8_t data)
 }
 
 /**
- * @brief Transfer multiple bytes continuously over SPI (optimized)
- * @param pTxData: Pointer to transmit data buffer
- * @param pRxData: Pointer to receive data buffer
- * @param size: Number of bytes to transfer
+ * @brief Arm both DMA channels for a full-duplex transfer
+ * @param pTxData: Data to transmit, or NULL to clock out dummy bytes
+ * @param pRxData: Buffer for received data, or NULL to discard it
+ * @param size: Number of bytes to transfer (1-65535)
  * 
- * This function implements true continuous SPI transfer by:
- * 1. Starting transmission of the first byte
- * 2. Using a pipeline approach where we send byte N while receiving byte N-1
- * 3. This reduces the idle time between bytes and provides true continuous transfer
+ * The RX channel is always armed, even for transmit-only transfers, so that
+ * RXNE never overruns and no stale byte is left in DR afterwards.
  */
-void Hard_SPI_TransferContinuous(uint8_t *pTxData, uint8_t *pRxData, uint16_t size)
+static void Hard_SPI_DMA_Start(const uint8_t *pTxData, uint8_t *pRxData, uint16_t size)
 {
-    uint16_t i = 0;
-    
-    if (size == 0) return;
-    
-    /* Send first byte */
-    if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE) != RESET)
+    Hard_SPI_DMABusy = true;
+
+    DMA_Cmd(SPI1_DMA_RX_CHANNEL, DISABLE);
+    DMA_Cmd(SPI1_DMA_TX_CHANNEL, DISABLE);
+    DMA_ClearFlag(SPI1_DMA_RX_FLAGS | SPI1_DMA_TX_FLAGS);
+
+    /* Drop any byte left over from polled transfers */
+    if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE) != RESET)
     {
-        SPI_I2S_SendData(SPI1, pTxData[i]);
+        SPI_I2S_ReceiveData(SPI1);
     }
-    i++;
-    
-    /* Continuous transfer for remaining bytes */
-    for (; i < size; i++)
+
+    /* RX: real buffer with increment, or the dummy sink without */
+    if (pRxData != 0)
     {
-        /* Wait for TXE and send next byte */
-        while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE) == RESET);
-        SPI_I2S_SendData(SPI1, pTxData[i]);
-        
-        /* Wait for RXNE and receive previous byte */
-        while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE) == RESET);
-        if (pRxData != 0)
-        {
-            pRxData[i-1] = SPI_I2S_ReceiveData(SPI1);
-        }
-        else
-        {
-            /* Discard received data if no buffer provided */
-            SPI_I2S_ReceiveData(SPI1);
-        }
+        SPI1_DMA_RX_CHANNEL->CMAR = (uint32_t) pRxData;
+        SPI1_DMA_RX_CHANNEL->CCR |= DMA_MemoryInc_Enable;
     }
-    
-    /* Receive the last byte */
-    while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE) == RESET);
-    if (pRxData != 0)
+    else
     {
-        pRxData[size-1] = SPI_I2S_ReceiveData(SPI1);
+        SPI1_DMA_RX_CHANNEL->CMAR = (uint32_t) &Hard_SPI_DummyRx;
+        SPI1_DMA_RX_CHANNEL->CCR &= ~DMA_MemoryInc_Enable;
+    }
+    DMA_SetCurrDataCounter(SPI1_DMA_RX_CHANNEL, size);
+
+    /* TX: real buffer with increment, or the dummy byte without */
+    if (pTxData != 0)
+    {
+        SPI1_DMA_TX_CHANNEL->CMAR = (uint32_t) pTxData;
+        SPI1_DMA_TX_CHANNEL->CCR |= DMA_MemoryInc_Enable;
     }
     else
     {
-        SPI_I2S_ReceiveData(SPI1);
+        SPI1_DMA_TX_CHANNEL->CMAR = (uint32_t) &Hard_SPI_DummyTx;
+        SPI1_DMA_TX_CHANNEL->CCR &= ~DMA_MemoryInc_Enable;
+    }
+    DMA_SetCurrDataCounter(SPI1_DMA_TX_CHANNEL, size);
+
+    /* RX first so the first received byte is never missed */
+    DMA_Cmd(SPI1_DMA_RX_CHANNEL, ENABLE);
+    DMA_Cmd(SPI1_DMA_TX_CHANNEL, ENABLE);
+    SPI_I2S_DMACmd(SPI1, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+}
+
+/**
+ * @brief Release both DMA channels after the RX channel completed
+ * 
+ * RX completion implies the last byte has been shifted in, so the bus is idle
+ * and the caller may raise CS immediately.
+ */
+static void Hard_SPI_DMA_Finish(void)
+{
+    SPI_I2S_DMACmd(SPI1, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+    DMA_ITConfig(SPI1_DMA_RX_CHANNEL, DMA_IT_TC, DISABLE);
+    DMA_Cmd(SPI1_DMA_RX_CHANNEL, DISABLE);
+    DMA_Cmd(SPI1_DMA_TX_CHANNEL, DISABLE);
+    DMA_ClearFlag(SPI1_DMA_RX_FLAGS | SPI1_DMA_TX_FLAGS);
+    Hard_SPI_DMABusy = false;
+}
+
+/**
+ * @brief Transfer a block over SPI using DMA (blocking)
+ * @param pTxData: Data to transmit, or NULL to clock out dummy bytes
+ * @param pRxData: Buffer for received data, or NULL to discard it
+ * @param size: Number of bytes to transfer
+ * 
+ * Bytes are moved back-to-back by DMA; the CPU only polls the RX transfer
+ * complete flag instead of TXE/RXNE for every byte. CS must already be low.
+ */
+void Hard_SPI_DMA_Transfer(const uint8_t *pTxData, uint8_t *pRxData, uint16_t size)
+{
+    if (size == 0) return;
+
+    while (Hard_SPI_DMABusy);   // Wait for a pending async transfer
+
+    Hard_SPI_DMA_Start(pTxData, pRxData, size);
+    while (DMA_GetFlagStatus(DMA1_FLAG_TC2) == RESET);
+    Hard_SPI_DMA_Finish();
+}
+
+/**
+ * @brief Start a block transfer over SPI using DMA (non-blocking)
+ * @param pTxData: Data to transmit, or NULL to clock out dummy bytes
+ * @param pRxData: Buffer for received data, or NULL to discard it
+ * @param size: Number of bytes to transfer
+ * @param callback: Called from the DMA interrupt when the transfer is done
+ * @return true if the transfer was started, false if the DMA is still busy
+ * 
+ * Buffers must stay valid until the callback runs. The callback usually
+ * raises CS and hands the data to the application.
+ */
+bool Hard_SPI_DMA_TransferAsync(const uint8_t *pTxData, uint8_t *pRxData, uint16_t size, Hard_SPI_Callback callback)
+{
+    if (size == 0 || Hard_SPI_DMABusy) return false;
+
+    Hard_SPI_DMACallback = callback;
+    Hard_SPI_DMA_Start(pTxData, pRxData, size);
+    DMA_ITConfig(SPI1_DMA_RX_CHANNEL, DMA_IT_TC, ENABLE);
+
+    return true;
+}
+
+/**
+ * @brief Check if a DMA transfer is in progress
+ * @return true while an async or blocking DMA transfer is running
+ */
+bool Hard_SPI_DMA_IsBusy(void)
+{
+    return Hard_SPI_DMABusy;
+}
+
+/**
+ * @brief DMA1 Channel 2 (SPI1_RX) interrupt handler
+ * 
+ * Completes an async transfer and invokes the registered callback.
+ */
+void DMA1_Channel2_IRQHandler(void)
+{
+    if (DMA_GetITStatus(DMA1_IT_TC2) != RESET)
+    {
+        Hard_SPI_Callback callback = Hard_SPI_DMACallback;
+
+        Hard_SPI_DMACallback = 0;
+        Hard_SPI_DMA_Finish();
+
+        if (callback != 0)
+        {
+            callback();
+        }
     }
 }
@@ -0,0 +1,432 @@
+/****************************************************************************/ /**
+ * @file   I2C_Slave.c
+ * @brief  I2C Slave Mode with DMA-backed Register Map - Source File
+ *
+ * All data bytes are moved by DMA; the CPU only sees one event interrupt per
+ * address match and one per STOP/NACK. Sample snapshots are kept in three
+ * banks (front / ready / back) so that:
+ * - the host always reads one complete, consistent sample set (front),
+ * - the application publishes a new set without ever waiting (back -> ready),
+ * - the swap to the newest set happens at the next read address match.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 09:13:05
+ ********************************************************************************/
+
+#include "I2C_Slave.h"
+#include "Serial.h"
+#include <string.h>
+
+#if I2C_SLAVE_ENABLE
+
+#if I2C_SLAVE_INSTANCE == 1
+#error "I2C1 is the OLED master (I2C_Hardware), select I2C_SLAVE_INSTANCE 2"
+#else
+#if SERIAL_USE_USART1 && SERIAL1_TX_DMA
+#error "I2C2 slave TX needs DMA1 channel 4, set SERIAL1_TX_DMA to 0"
+#endif
+#if SERIAL_USE_USART3
+#error "I2C2 slave needs PB10/PB11, set SERIAL_USE_USART3 to 0"
+#endif
+#endif
+
+// I2C Slave transaction state
+typedef enum {
+    I2C_SLAVE_STATE_IDLE = 0,
+    I2C_SLAVE_STATE_RX = 1,
+    I2C_SLAVE_STATE_TX = 2
+} I2C_Slave_State;
+
+static uint8_t I2C_Slave_Bank[3][I2C_SLAVE_REG_SIZE];       // Register map banks
+static uint8_t I2C_Slave_RxBuffer[1 + I2C_SLAVE_REG_SIZE];  // Pointer byte + payload
+
+static volatile uint8_t I2C_Slave_Front = 0;    // Bank served to the host
+static volatile uint8_t I2C_Slave_Ready = 1;    // Latest published bank
+static volatile uint8_t I2C_Slave_Back = 2;     // Bank owned by the application
+static volatile bool I2C_Slave_Fresh = false;   // Ready bank is newer than front
+
+static volatile uint8_t I2C_Slave_Pointer = 0;  // Current register pointer
+static volatile I2C_Slave_State I2C_Slave_Status = I2C_SLAVE_STATE_IDLE;
+static volatile bool I2C_Slave_WriteFlag = false;
+static I2C_Slave_WriteCallback I2C_Slave_Callback = 0;
+static I2C_Slave_Stats I2C_Slave_Statistics;
+
+static void I2C_Slave_GPIO_Init(void);
+static void I2C_Slave_DMA_Init(void);
+static void I2C_Slave_FinishReceive(void);
+static void I2C_Slave_StartReceive(void);
+static void I2C_Slave_StartTransmit(void);
+
+/**
+ * @brief Initialize I2C slave interface
+ *
+ * Configures GPIO, DMA channels and the I2C peripheral in slave mode with
+ * event and error interrupts. Data bytes never raise an interrupt: TXE/RXNE
+ * are routed to DMA and the buffer interrupt stays disabled.
+ *
+ * @param ownAddr Own slave address (7-bit, left-aligned)
+ * @param speed Expected bus speed in Hz (used for peripheral timing setup)
+ */
+void I2C_Slave_Init(uint8_t ownAddr, uint32_t speed)
+{
+    RCC_APB1PeriphClockCmd(I2C_SLAVE_CLOCK, ENABLE);
+    RCC_APB2PeriphClockCmd(I2C_SLAVE_GPIO_CLOCK, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    memset(I2C_Slave_Bank, 0, sizeof(I2C_Slave_Bank));
+    memset(&I2C_Slave_Statistics, 0, sizeof(I2C_Slave_Statistics));
+    I2C_Slave_Front = 0;
+    I2C_Slave_Ready = 1;
+    I2C_Slave_Back = 2;
+    I2C_Slave_Fresh = false;
+    I2C_Slave_Pointer = 0;
+    I2C_Slave_Status = I2C_SLAVE_STATE_IDLE;
+
+    I2C_Slave_GPIO_Init();
+    I2C_Slave_DMA_Init();
+
+    I2C_DeInit(I2C_SLAVE);
+
+    I2C_InitTypeDef I2C_InitStructure;
+    I2C_InitStructure.I2C_ClockSpeed = speed;
+    I2C_InitStructure.I2C_Mode = I2C_Mode_I2C;
+    I2C_InitStructure.I2C_DutyCycle = I2C_DutyCycle_2;
+    I2C_InitStructure.I2C_OwnAddress1 = ownAddr;
+    I2C_InitStructure.I2C_Ack = I2C_Ack_Enable;
+    I2C_InitStructure.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
+    I2C_Init(I2C_SLAVE, &I2C_InitStructure);
+
+    // Data bytes are served by DMA, only events and errors interrupt the CPU
+    I2C_DMACmd(I2C_SLAVE, ENABLE);
+    I2C_ITConfig(I2C_SLAVE, I2C_IT_EVT | I2C_IT_ERR, ENABLE);
+
+    NVIC_InitTypeDef NVIC_InitStructure;
+    NVIC_InitStructure.NVIC_IRQChannel = I2C_SLAVE_EV_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = I2C_SLAVE_ER_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+
+    I2C_Cmd(I2C_SLAVE, ENABLE);
+    I2C_AcknowledgeConfig(I2C_SLAVE, ENABLE);
+}
+
+/**
+ * @brief Initialize GPIO pins for the I2C slave
+ *
+ * SCL and SDA are configured as alternate function open-drain.
+ */
+static void I2C_Slave_GPIO_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+    GPIO_InitStructure.GPIO_Pin = I2C_SLAVE_SCL_PIN | I2C_SLAVE_SDA_PIN;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_OD;
+    GPIO_Init(I2C_SLAVE_PORT, &GPIO_InitStructure);
+}
+
+/**
+ * @brief Initialize the TX and RX DMA channels of the I2C slave
+ *
+ * Both channels are left disabled; they are armed per transaction from the
+ * address-match event with the matching memory address and length.
+ */
+static void I2C_Slave_DMA_Init(void)
+{
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t) &I2C_SLAVE->DR;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+
+    // Slave transmitter: register map -> DR
+    DMA_DeInit(I2C_SLAVE_DMA_TX_CHANNEL);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) I2C_Slave_Bank[0];
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = I2C_SLAVE_REG_SIZE;
+    DMA_Init(I2C_SLAVE_DMA_TX_CHANNEL, &DMA_InitStructure);
+
+    // Slave receiver: DR -> pointer byte + payload
+    DMA_DeInit(I2C_SLAVE_DMA_RX_CHANNEL);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) I2C_Slave_RxBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = sizeof(I2C_Slave_RxBuffer);
+    DMA_Init(I2C_SLAVE_DMA_RX_CHANNEL, &DMA_InitStructure);
+}
+
+/**
+ * @brief Deinitialize I2C slave interface
+ *
+ * Disables interrupts, DMA channels, the peripheral and its clock.
+ */
+void I2C_Slave_DeInit(void)
+{
+    NVIC_DisableIRQ(I2C_SLAVE_EV_IRQn);
+    NVIC_DisableIRQ(I2C_SLAVE_ER_IRQn);
+    DMA_Cmd(I2C_SLAVE_DMA_TX_CHANNEL, DISABLE);
+    DMA_Cmd(I2C_SLAVE_DMA_RX_CHANNEL, DISABLE);
+    I2C_Cmd(I2C_SLAVE, DISABLE);
+    I2C_DeInit(I2C_SLAVE);
+    RCC_APB1PeriphClockCmd(I2C_SLAVE_CLOCK, DISABLE);
+    I2C_Slave_Status = I2C_SLAVE_STATE_IDLE;
+}
+
+/**
+ * @brief Get the bank the application fills with the next sample set
+ *
+ * Only the first I2C_SLAVE_DATA_SIZE bytes belong to the application. The
+ * returned pointer changes after every I2C_Slave_Publish() call.
+ *
+ * @return uint8_t* Pointer to the back bank sample area
+ */
+uint8_t* I2C_Slave_GetBackBuffer(void)
+{
+    return I2C_Slave_Bank[I2C_Slave_Back];
+}
+
+/**
+ * @brief Publish the back bank as the newest sample set
+ *
+ * Swaps back and ready banks inside a short critical section; never waits
+ * for the bus. The host sees the new set from its next read transaction on,
+ * a read already in progress keeps streaming the old, unmodified bank.
+ * The new back bank is seeded with the published samples so partial updates
+ * remain possible.
+ */
+void I2C_Slave_Publish(void)
+{
+    uint8_t published;
+
+    __disable_irq();
+    published = I2C_Slave_Back;
+    I2C_Slave_Back = I2C_Slave_Ready;
+    I2C_Slave_Ready = published;
+    I2C_Slave_Fresh = true;
+    __enable_irq();
+
+    // Published bank is read-only from now on, copying from it is safe
+    memcpy(I2C_Slave_Bank[I2C_Slave_Back], I2C_Slave_Bank[published], I2C_SLAVE_DATA_SIZE);
+}
+
+/**
+ * @brief Read bytes from the host-writable control area
+ *
+ * @param reg Register address (I2C_SLAVE_DATA_SIZE .. I2C_SLAVE_REG_SIZE-1)
+ * @param data Pointer to buffer to store the register values
+ * @param len Number of bytes to read
+ */
+void I2C_Slave_ReadControl(uint8_t reg, uint8_t *data, uint8_t len)
+{
+    if (reg < I2C_SLAVE_DATA_SIZE || reg >= I2C_SLAVE_REG_SIZE) return;
+    if (len > I2C_SLAVE_REG_SIZE - reg) len = I2C_SLAVE_REG_SIZE - reg;
+
+    // Avoid tearing against a host write applied from the interrupt
+    __disable_irq();
+    memcpy(data, &I2C_Slave_Bank[I2C_Slave_Front][reg], len);
+    __enable_irq();
+}
+
+/**
+ * @brief Register a callback for host writes
+ *
+ * The callback runs in interrupt context after the STOP of a write
+ * transaction and must return quickly.
+ *
+ * @param callback Function to call, or NULL to disable
+ */
+void I2C_Slave_SetWriteCallback(I2C_Slave_WriteCallback callback)
+{
+    I2C_Slave_Callback = callback;
+}
+
+/**
+ * @brief Check if the host has written the control area
+ *
+ * @return true New host write since the last call
+ * @return false No new host write
+ */
+bool I2C_Slave_GetWriteFlag(void)
+{
+    if (I2C_Slave_WriteFlag) {
+        I2C_Slave_WriteFlag = false;    // Clear flag after reading
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Get a copy of the transaction statistics
+ *
+ * @param stats Pointer to structure to store the statistics
+ */
+void I2C_Slave_GetStats(I2C_Slave_Stats *stats)
+{
+    __disable_irq();
+    *stats = I2C_Slave_Statistics;
+    __enable_irq();
+}
+
+/**
+ * @brief Complete a pending receive transaction
+ *
+ * The first received byte is the register pointer. Following payload bytes
+ * are stored from the pointer on, the pointer auto-increments. Bytes aimed at
+ * the read-only sample area are dropped. Control bytes are written to all
+ * banks so every future snapshot carries the host configuration.
+ */
+static void I2C_Slave_FinishReceive(void)
+{
+    uint16_t count;
+    uint8_t reg;
+
+    if (I2C_Slave_Status != I2C_SLAVE_STATE_RX) return;
+
+    DMA_Cmd(I2C_SLAVE_DMA_RX_CHANNEL, DISABLE);
+    count = sizeof(I2C_Slave_RxBuffer) - DMA_GetCurrDataCounter(I2C_SLAVE_DMA_RX_CHANNEL);
+    I2C_Slave_Status = I2C_SLAVE_STATE_IDLE;
+
+    if (count == 0) return;
+
+    reg = I2C_Slave_RxBuffer[0];
+    for (uint16_t i = 1; i < count; ++i) {
+        uint16_t addr = reg + i - 1;
+
+        if (addr < I2C_SLAVE_DATA_SIZE) {
+            I2C_Slave_Statistics.rejected++;
+        } else if (addr < I2C_SLAVE_REG_SIZE) {
+            I2C_Slave_Bank[0][addr] = I2C_Slave_RxBuffer[i];
+            I2C_Slave_Bank[1][addr] = I2C_Slave_RxBuffer[i];
+            I2C_Slave_Bank[2][addr] = I2C_Slave_RxBuffer[i];
+        } else {
+            I2C_Slave_Statistics.overruns++;
+        }
+    }
+
+    I2C_Slave_Pointer = reg + count - 1;
+
+    if (count > 1) {
+        I2C_Slave_Statistics.writes++;
+        I2C_Slave_WriteFlag = true;
+        if (I2C_Slave_Callback) {
+            I2C_Slave_Callback(reg, &I2C_Slave_RxBuffer[1], count - 1);
+        }
+    }
+}
+
+/**
+ * @brief Arm the RX DMA channel for a host write transaction
+ */
+static void I2C_Slave_StartReceive(void)
+{
+    DMA_Cmd(I2C_SLAVE_DMA_RX_CHANNEL, DISABLE);
+    DMA_SetCurrDataCounter(I2C_SLAVE_DMA_RX_CHANNEL, sizeof(I2C_Slave_RxBuffer));
+    I2C_Slave_Status = I2C_SLAVE_STATE_RX;
+    DMA_Cmd(I2C_SLAVE_DMA_RX_CHANNEL, ENABLE);
+}
+
+/**
+ * @brief Arm the TX DMA channel for a host read transaction
+ *
+ * Switches to the newest published bank first, then streams the register map
+ * from the current pointer to its end. Read bursts leave the pointer
+ * unchanged so the host can poll the same block repeatedly.
+ */
+static void I2C_Slave_StartTransmit(void)
+{
+    uint8_t reg = I2C_Slave_Pointer;
+
+    if (I2C_Slave_Fresh) {
+        uint8_t tmp = I2C_Slave_Front;
+        I2C_Slave_Front = I2C_Slave_Ready;
+        I2C_Slave_Ready = tmp;
+        I2C_Slave_Fresh = false;
+    }
+
+    DMA_Cmd(I2C_SLAVE_DMA_TX_CHANNEL, DISABLE);
+    I2C_Slave_Status = I2C_SLAVE_STATE_TX;
+
+    // Pointer outside the map: pad the first byte, BTF events pad the rest
+    if (reg >= I2C_SLAVE_REG_SIZE) {
+        I2C_Slave_Statistics.overruns++;
+        I2C_SendData(I2C_SLAVE, I2C_SLAVE_PAD_BYTE);
+        return;
+    }
+
+    I2C_SLAVE_DMA_TX_CHANNEL->CMAR = (uint32_t) &I2C_Slave_Bank[I2C_Slave_Front][reg];
+    DMA_SetCurrDataCounter(I2C_SLAVE_DMA_TX_CHANNEL, I2C_SLAVE_REG_SIZE - reg);
+    DMA_Cmd(I2C_SLAVE_DMA_TX_CHANNEL, ENABLE);
+}
+
+/**
+ * @brief I2C slave event interrupt handler
+ *
+ * Handles address match (arming DMA for the transfer direction), STOP
+ * detection (completing host writes) and BTF, which only occurs when the
+ * host transfers more bytes than the register map holds.
+ */
+void I2C_SLAVE_EV_IRQHandler(void)
+{
+    // Address matched: reading SR1 then SR2 (TRA) clears ADDR
+    if (I2C_GetITStatus(I2C_SLAVE, I2C_IT_ADDR) == SET) {
+        if (I2C_GetFlagStatus(I2C_SLAVE, I2C_FLAG_TRA) == SET) {
+            // Repeated START after the pointer write: latch the pointer first
+            I2C_Slave_FinishReceive();
+            I2C_Slave_StartTransmit();
+        } else {
+            I2C_Slave_FinishReceive();
+            I2C_Slave_StartReceive();
+        }
+    }
+
+    // STOP detected: reading SR1 then writing CR1 clears STOPF
+    if (I2C_GetITStatus(I2C_SLAVE, I2C_IT_STOPF) == SET) {
+        I2C_Cmd(I2C_SLAVE, ENABLE);
+        I2C_Slave_FinishReceive();
+    }
+
+    // DMA exhausted, host keeps clocking: pad or drop to release the bus
+    if (I2C_GetITStatus(I2C_SLAVE, I2C_IT_BTF) == SET) {
+        I2C_Slave_Statistics.overruns++;
+        if (I2C_Slave_Status == I2C_SLAVE_STATE_TX) {
+            I2C_SendData(I2C_SLAVE, I2C_SLAVE_PAD_BYTE);
+        } else {
+            (void) I2C_ReceiveData(I2C_SLAVE);
+        }
+    }
+}
+
+/**
+ * @brief I2C slave error interrupt handler
+ *
+ * A NACK from the host marks the normal end of a read transaction. Bus
+ * errors, arbitration loss and overruns abort the current transfer.
+ */
+void I2C_SLAVE_ER_IRQHandler(void)
+{
+    if (I2C_GetITStatus(I2C_SLAVE, I2C_IT_AF) == SET) {
+        I2C_ClearITPendingBit(I2C_SLAVE, I2C_IT_AF);
+        if (I2C_Slave_Status == I2C_SLAVE_STATE_TX) {
+            DMA_Cmd(I2C_SLAVE_DMA_TX_CHANNEL, DISABLE);
+            I2C_Slave_Status = I2C_SLAVE_STATE_IDLE;
+            I2C_Slave_Statistics.reads++;
+        }
+    }
+
+    if (I2C_GetITStatus(I2C_SLAVE, I2C_IT_BERR) == SET ||
+        I2C_GetITStatus(I2C_SLAVE, I2C_IT_ARLO) == SET ||
+        I2C_GetITStatus(I2C_SLAVE, I2C_IT_OVR) == SET) {
+        I2C_ClearITPendingBit(I2C_SLAVE, I2C_IT_BERR | I2C_IT_ARLO | I2C_IT_OVR);
+        DMA_Cmd(I2C_SLAVE_DMA_TX_CHANNEL, DISABLE);
+        DMA_Cmd(I2C_SLAVE_DMA_RX_CHANNEL, DISABLE);
+        I2C_Slave_Status = I2C_SLAVE_STATE_IDLE;
+        I2C_Slave_Statistics.errors++;
+    }
+}
+
+#endif // I2C_SLAVE_ENABLE
@@ -26,6 +26,11 @@ static uint8_t OLED_BUFFER[8][128];     // 显示缓存数组 [页索引][列地
 static CH_FontCache_t ch_cache[CH_CACHE_SIZE];  // 中文字符缓存，采用循环替换策略
 static uint8_t cache_index = 0;         // 缓存当前写入位置索引
 
+// 需校验的外部Flash区域，下标即 W25Q64_Verify_GetStatus() 的参数
+static const W25Q64_Verify_Region OLED_FlashRegions[] = {
+    { CH_FONT_BASE_ADDR, (uint32_t)CH_FONT_COUNT * CH_FONT_BYTES_PER_CHAR, CH_FONT_CRC32 },  // OLED_REGION_CH_FONT
+};
+
 /**************************** 静态工具函数声明 ****************************/
 
 /* 硬件接口函数 */
@@ -180,9 +185,15 @@ static int16_t OLED_Find_CH_Index(uint16_t unicode)
  * 
  * @note   优先从缓存查找，缓存未命中则从外部Flash(W25Q64)读取
  *         读取后会添加到缓存以便下次快速访问
+ *         字库CRC校验失败时返回NULL，调用方显示'?'
  ******************************************************************************/
 static uint8_t* OLED_Get_CH_FontData(uint16_t unicode, uint8_t *buffer)
 {
+    // 0. 字库已损坏，不再使用任何字模（包括缓存）
+    if (W25Q64_Verify_GetStatus(OLED_REGION_CH_FONT) == W25Q64_VERIFY_FAILED) {
+        return NULL;
+    }
+
     // 1. 先在缓存中查找
     int16_t cache_idx = OLED_FindInCache(unicode);
 
@@ -197,9 +208,9 @@ static uint8_t* OLED_Get_CH_FontData(uint16_t unicode, uint8_t *buffer)
         return NULL;    // 字库中不存在该字符
     }
 
-    // 3. 从W25Q64 Flash读取字模数据
+    // 3. 从W25Q64 Flash读取字模数据 (经行缓存, 一行含相邻的两个字模)
     uint32_t fontAddr = CH_FONT_BASE_ADDR + index * CH_FONT_BYTES_PER_CHAR;
-    W25Q64_ReadData(fontAddr, buffer, CH_FONT_BYTES_PER_CHAR);
+    W25Q64_Cache_Read(fontAddr, buffer, CH_FONT_BYTES_PER_CHAR);
 
     // 4. 添加到缓存
     OLED_AddToCache(unicode, buffer);
@@ -240,6 +251,7 @@ static uint16_t UTF8_to_Unicode(const char *utf8_str)
  *         2. 发送SSD1306初始化命令序列
  *         3. 初始化外部字库Flash
  *         4. 初始化中文字符缓存
+ *         5. 启动字库CRC后台校验（不阻塞，需在主循环调用W25Q64_Verify_Process）
  ******************************************************************************/
 void OLED_Init(void)
 {
@@ -284,6 +296,20 @@ void OLED_Init(void)
     // 3. 初始化外部字库Flash和中文字符缓存
     W25Q64_Init();
     OLED_CH_Cache_Init();
+
+    // 4. 后台校验字库，结果见 OLED_FontCorrupted()
+    W25Q64_Verify_Start(OLED_FlashRegions, sizeof(OLED_FlashRegions) / sizeof(OLED_FlashRegions[0]));
+}
+
+/*******************************************************************************
+ * @brief  查询外部字库是否损坏
+ * 
+ * @return true  CRC校验失败，中文字符显示为'?'
+ * @return false 校验通过或尚未完成
+ ******************************************************************************/
+bool OLED_FontCorrupted(void)
+{
+    return W25Q64_Verify_GetStatus(OLED_REGION_CH_FONT) == W25Q64_VERIFY_FAILED;
 }
 
 /*******************************************************************************
@@ -0,0 +1,251 @@
+/****************************************************************************/ /**
+ * @file   SPI_Bus.c
+ * @brief  SPI1 bus manager for several devices - Source File
+ *
+ * Bus states:
+ * - IDLE: free, the queue is empty (it is started as soon as the bus frees)
+ * - OWNED: polled transaction between SPI_Bus_Start() and SPI_Bus_Stop()
+ * - RUNNING: queued transaction on the wire
+ * - CALLBACK: completion callback running, it may use the bus polled
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 17:41:26
+ ********************************************************************************/
+
+#include "SPI_Bus.h"
+
+#define SPI_BUS_IDLE                0
+#define SPI_BUS_OWNED               1
+#define SPI_BUS_RUNNING             2
+#define SPI_BUS_CALLBACK            3
+
+#define SPI_BUS_QUEUE_MASK          (SPI_BUS_QUEUE_SIZE - 1)
+
+#if SPI_BUS_QUEUE_SIZE & SPI_BUS_QUEUE_MASK
+#error "SPI_BUS_QUEUE_SIZE must be a power of two"
+#endif
+
+static volatile uint8_t SPI_Bus_State = SPI_BUS_IDLE;
+static uint8_t SPI_Bus_Outer;                       // State restored by SPI_Bus_Stop()
+static SPI_Bus_Device *SPI_Bus_Owner;               // Device with CS low
+static SPI_Bus_Device *SPI_Bus_Configured;          // Device whose format is in CR1
+static SPI_Bus_Transaction *SPI_Bus_Queue[SPI_BUS_QUEUE_SIZE];
+static volatile uint8_t SPI_Bus_Head;
+static volatile uint8_t SPI_Bus_Tail;
+static volatile uint8_t SPI_Bus_Count;
+static SPI_Bus_Transaction *SPI_Bus_Current;        // Queued transaction on the wire
+static bool SPI_Bus_Ready = false;
+static SPI_Bus_Stats SPI_Bus_Counters;
+
+static void SPI_Bus_Kick(void);
+
+/**
+ * @brief Initialize SPI1 and its DMA channels, once for all devices
+ */
+void SPI_Bus_Init(void)
+{
+    if (SPI_Bus_Ready) return;
+
+    Hard_SPI_Init();
+    SPI_Bus_Configured = 0;     // Force the first device to program CR1
+    SPI_Bus_Ready = true;
+}
+
+/**
+ * @brief Register a device: configure its chip select as output, deselected
+ *
+ * @param dev Device description, must stay valid while the device is in use
+ */
+void SPI_Bus_AddDevice(SPI_Bus_Device *dev)
+{
+    // GPIOA..GPIOG are 0x400 apart, their clock enables are consecutive bits
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA << (((uint32_t)dev->csPort - GPIOA_BASE) / 0x400), ENABLE);
+
+    GPIO_SetBits(dev->csPort, dev->csPin);
+    GPIO_Init(dev->csPort, &(GPIO_InitTypeDef) {
+        .GPIO_Pin = dev->csPin,
+        .GPIO_Mode = GPIO_Mode_Out_PP,
+        .GPIO_Speed = GPIO_Speed_50MHz
+    });
+}
+
+/**
+ * @brief Change the clock of a device, applied at its next transaction
+ *
+ * @param dev Registered device
+ * @param prescaler SPI_BaudRatePrescaler_2 .. SPI_BaudRatePrescaler_256
+ */
+void SPI_Bus_SetPrescaler(SPI_Bus_Device *dev, uint16_t prescaler)
+{
+    dev->prescaler = prescaler;
+    if (SPI_Bus_Configured == dev) SPI_Bus_Configured = 0;
+}
+
+/**
+ * @brief Load the format of a device into CR1 if another device used it last
+ */
+static void SPI_Bus_Apply(SPI_Bus_Device *dev)
+{
+    uint16_t cr1;
+
+    if (dev == SPI_Bus_Configured) return;
+
+    cr1 = SPI1->CR1 & ~(SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_BR | SPI_CR1_LSBFIRST | SPI_CR1_SPE);
+    if (dev->mode & 0x02) cr1 |= SPI_CR1_CPOL;
+    if (dev->mode & 0x01) cr1 |= SPI_CR1_CPHA;
+    cr1 |= (dev->prescaler & SPI_CR1_BR) | (dev->firstBit & SPI_CR1_LSBFIRST);
+
+    SPI1->CR1 = cr1;                    // Format bits change with SPE cleared
+    SPI1->CR1 = cr1 | SPI_CR1_SPE;      // SCK now idles at the new CPOL
+
+    SPI_Bus_Configured = dev;
+    SPI_Bus_Counters.reconfigurations++;
+}
+
+static void SPI_Bus_Select(SPI_Bus_Device *dev)
+{
+    SPI_Bus_Apply(dev);
+    SPI_Bus_Owner = dev;
+    GPIO_ResetBits(dev->csPort, dev->csPin);
+    SPI_Bus_Counters.transactions++;
+}
+
+static void SPI_Bus_Deselect(void)
+{
+    GPIO_SetBits(SPI_Bus_Owner->csPort, SPI_Bus_Owner->csPin);
+    SPI_Bus_Owner = 0;
+}
+
+/**
+ * @brief Begin a polled transaction: wait for the bus, select the device
+ *
+ * @param dev Registered device
+ */
+void SPI_Bus_Start(SPI_Bus_Device *dev)
+{
+    uint32_t primask;
+
+    for (;;) {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        if (SPI_Bus_State == SPI_BUS_IDLE || SPI_Bus_State == SPI_BUS_CALLBACK) break;
+        __set_PRIMASK(primask);
+    }
+
+    SPI_Bus_Outer = SPI_Bus_State;
+    SPI_Bus_State = SPI_BUS_OWNED;
+    __set_PRIMASK(primask);
+
+    SPI_Bus_Select(dev);
+}
+
+/**
+ * @brief End a polled transaction: deselect and start queued work
+ */
+void SPI_Bus_Stop(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    SPI_Bus_Deselect();
+    SPI_Bus_State = SPI_Bus_Outer;
+    __set_PRIMASK(primask);
+
+    if (SPI_Bus_State == SPI_BUS_IDLE) SPI_Bus_Kick();
+}
+
+/**
+ * @brief Data phase done (SPI DMA interrupt): finish and chain the next one
+ */
+static void SPI_Bus_DataDone(void)
+{
+    SPI_Bus_Transaction *txn = SPI_Bus_Current;
+
+    SPI_Bus_Deselect();
+    SPI_Bus_Current = 0;
+
+    SPI_Bus_State = SPI_BUS_CALLBACK;
+    if (txn->callback != 0) txn->callback(txn);
+    SPI_Bus_State = SPI_BUS_IDLE;
+
+    SPI_Bus_Kick();
+}
+
+/**
+ * @brief Start the oldest queued transaction if the bus is idle
+ */
+static void SPI_Bus_Kick(void)
+{
+    SPI_Bus_Transaction *txn;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (SPI_Bus_State != SPI_BUS_IDLE || SPI_Bus_Count == 0) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    txn = SPI_Bus_Queue[SPI_Bus_Tail];
+    SPI_Bus_Tail = (SPI_Bus_Tail + 1) & SPI_BUS_QUEUE_MASK;
+    SPI_Bus_Count--;
+    SPI_Bus_Current = txn;
+    SPI_Bus_State = SPI_BUS_RUNNING;
+    __set_PRIMASK(primask);
+
+    SPI_Bus_Select(txn->device);
+    for (uint8_t i = 0; i < txn->headerLen; i++) {
+        Hard_SPI_TransferByte(txn->header[i]);
+    }
+
+    if (txn->len == 0) {
+        SPI_Bus_DataDone();
+    } else {
+        Hard_SPI_DMA_TransferAsync(txn->txData, txn->rxData, txn->len, SPI_Bus_DataDone);
+    }
+}
+
+/**
+ * @brief Queue a transaction, started at once if the bus is idle
+ *
+ * @param txn Transaction, must not be modified until its callback has run
+ * @return true Queued
+ * @return false Queue full
+ */
+bool SPI_Bus_Submit(SPI_Bus_Transaction *txn)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (SPI_Bus_Count >= SPI_BUS_QUEUE_SIZE) {
+        __set_PRIMASK(primask);
+        return false;
+    }
+    SPI_Bus_Queue[SPI_Bus_Head] = txn;
+    SPI_Bus_Head = (SPI_Bus_Head + 1) & SPI_BUS_QUEUE_MASK;
+    SPI_Bus_Count++;
+    if (SPI_Bus_Count > SPI_Bus_Counters.maxQueued) SPI_Bus_Counters.maxQueued = SPI_Bus_Count;
+    __set_PRIMASK(primask);
+
+    SPI_Bus_Kick();
+
+    return true;
+}
+
+/**
+ * @brief Check whether the bus is in use (polled, queued or in a callback)
+ */
+bool SPI_Bus_IsBusy(void)
+{
+    return SPI_Bus_State != SPI_BUS_IDLE;
+}
+
+/**
+ * @brief Get the bus counters
+ *
+ * transactions / reconfigurations shows how often the device changes.
+ *
+ * @param stats Destination
+ */
+void SPI_Bus_GetStats(SPI_Bus_Stats *stats)
+{
+    *stats = SPI_Bus_Counters;
+}
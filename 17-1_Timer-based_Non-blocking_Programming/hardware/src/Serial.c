@@ -8,100 +8,667 @@
 
 #include "Serial.h"
 
-// Global variables for USART reception
-uint8_t Serial_RxData;  // Buffer for received data
-uint8_t Serial_RxFlag;  // Flag indicating new data received
+#if (SERIAL1_RX_BUFFER_SIZE & (SERIAL1_RX_BUFFER_SIZE - 1)) || \
+    (SERIAL2_RX_BUFFER_SIZE & (SERIAL2_RX_BUFFER_SIZE - 1)) || \
+    (SERIAL3_RX_BUFFER_SIZE & (SERIAL3_RX_BUFFER_SIZE - 1))
+#error "SERIALn_RX_BUFFER_SIZE must be powers of two"
+#endif
+#if (!SERIAL1_TX_DMA && (SERIAL1_TX_BUFFER_SIZE & (SERIAL1_TX_BUFFER_SIZE - 1))) || \
+    (!SERIAL2_TX_DMA && (SERIAL2_TX_BUFFER_SIZE & (SERIAL2_TX_BUFFER_SIZE - 1))) || \
+    (!SERIAL3_TX_DMA && (SERIAL3_TX_BUFFER_SIZE & (SERIAL3_TX_BUFFER_SIZE - 1)))
+#error "SERIALn_TX_BUFFER_SIZE must be a power of two for the TXE ring"
+#endif
+
+// Which TX engines are compiled in; with a single one the per-port test is
+// a constant and the other engine is left out
+#define SERIAL_TX_DMA_USED  ((SERIAL_USE_USART1 && SERIAL1_TX_DMA) || \
+                             (SERIAL_USE_USART2 && SERIAL2_TX_DMA) || \
+                             (SERIAL_USE_USART3 && SERIAL3_TX_DMA))
+#define SERIAL_TX_RING_USED ((SERIAL_USE_USART1 && !SERIAL1_TX_DMA) || \
+                             (SERIAL_USE_USART2 && !SERIAL2_TX_DMA) || \
+                             (SERIAL_USE_USART3 && !SERIAL3_TX_DMA))
+
+#if SERIAL_TX_DMA_USED && SERIAL_TX_RING_USED
+#define SERIAL_IS_TX_DMA(port)  ((port)->hw->txDma != 0)
+#else
+#define SERIAL_IS_TX_DMA(port)  SERIAL_TX_DMA_USED
+#endif
+
+// Copied per critical section, bounds the time interrupts are masked
+#define SERIAL_TX_DMA_CHUNK     32
+
+// Fixed per-port data, in flash
+typedef struct {
+    USART_TypeDef *usart;
+    GPIO_TypeDef *gpio;
+    uint16_t txPin;
+    uint16_t rxPin;
+    uint32_t apb1Clock;         // RCC_APB1Periph_USARTx, 0 for USART1
+    uint32_t apb2Clock;         // RCC_APB2Periph_GPIOx (| USART1)
+    uint8_t irq;
+    uint8_t txDmaIrq;
+    DMA_Channel_TypeDef *txDma; // 0: TXE interrupt ring
+    uint32_t baudrate;          // After Serial_Init()
+    uint8_t *rxBuffer;
+    uint16_t rxSize;
+    uint8_t *txBuffer;          // Ring, or the two DMA buffers back to back
+    uint16_t txSize;            // Ring size, or size of one DMA buffer
+} Serial_Hardware;
+
+// Free-running indices, masked on access; head is written by the producer only,
+// tail by the consumer only
+struct Serial_Port {
+    const Serial_Hardware *hw;
+    volatile uint16_t rxHead;   // USARTx_IRQHandler
+    volatile uint16_t rxTail;   // Main loop
+    volatile uint16_t txHead;   // TXE ring: main loop
+    volatile uint16_t txTail;   // TXE ring: USARTx_IRQHandler
+    uint16_t txDmaLen[2];       // DMA: bytes in each buffer
+    volatile uint8_t txFill;    // DMA: buffer accepting new data
+    volatile uint8_t txDmaBusy; // DMA: other buffer is on the wire
+    uint8_t txPolicy;
+    volatile Serial_Stats counters;
+};
+
+#if SERIAL_USE_USART1
+static uint8_t Serial_Rx1[SERIAL1_RX_BUFFER_SIZE];
+static uint8_t Serial_Tx1[(SERIAL1_TX_DMA ? 2 : 1) * SERIAL1_TX_BUFFER_SIZE];
+static const Serial_Hardware Serial_Hardware1 = {
+    USART1, GPIOA, GPIO_Pin_9, GPIO_Pin_10,
+    0, RCC_APB2Periph_USART1 | RCC_APB2Periph_GPIOA,
+    USART1_IRQn, DMA1_Channel4_IRQn, SERIAL1_TX_DMA ? DMA1_Channel4 : 0,
+    SERIAL1_BAUDRATE, Serial_Rx1, SERIAL1_RX_BUFFER_SIZE, Serial_Tx1, SERIAL1_TX_BUFFER_SIZE
+};
+Serial_Port Serial_Port1 = { &Serial_Hardware1, .txPolicy = SERIAL_TX_FULL_POLICY };
+#endif
+
+#if SERIAL_USE_USART2
+static uint8_t Serial_Rx2[SERIAL2_RX_BUFFER_SIZE];
+static uint8_t Serial_Tx2[(SERIAL2_TX_DMA ? 2 : 1) * SERIAL2_TX_BUFFER_SIZE];
+static const Serial_Hardware Serial_Hardware2 = {
+    USART2, GPIOA, GPIO_Pin_2, GPIO_Pin_3,
+    RCC_APB1Periph_USART2, RCC_APB2Periph_GPIOA,
+    USART2_IRQn, DMA1_Channel7_IRQn, SERIAL2_TX_DMA ? DMA1_Channel7 : 0,
+    SERIAL2_BAUDRATE, Serial_Rx2, SERIAL2_RX_BUFFER_SIZE, Serial_Tx2, SERIAL2_TX_BUFFER_SIZE
+};
+Serial_Port Serial_Port2 = { &Serial_Hardware2, .txPolicy = SERIAL_TX_FULL_POLICY };
+#endif
+
+#if SERIAL_USE_USART3
+static uint8_t Serial_Rx3[SERIAL3_RX_BUFFER_SIZE];
+static uint8_t Serial_Tx3[(SERIAL3_TX_DMA ? 2 : 1) * SERIAL3_TX_BUFFER_SIZE];
+static const Serial_Hardware Serial_Hardware3 = {
+    USART3, GPIOB, GPIO_Pin_10, GPIO_Pin_11,
+    RCC_APB1Periph_USART3, RCC_APB2Periph_GPIOB,
+    USART3_IRQn, DMA1_Channel2_IRQn, SERIAL3_TX_DMA ? DMA1_Channel2 : 0,
+    SERIAL3_BAUDRATE, Serial_Rx3, SERIAL3_RX_BUFFER_SIZE, Serial_Tx3, SERIAL3_TX_BUFFER_SIZE
+};
+Serial_Port Serial_Port3 = { &Serial_Hardware3, .txPolicy = SERIAL_TX_FULL_POLICY };
+#endif
+
+#if SERIAL_USE_USART1
+// Falling edge capture times of the sync byte, written by DMA
+#define SERIAL_AUTOBAUD_EDGES   5
+static volatile uint16_t Serial_AutoBaudEdges[SERIAL_AUTOBAUD_EDGES];
+static uint8_t Serial_AutoBaudRunning = 0;
+
+// Standard rates auto-baud rounds to
+static const uint32_t Serial_StandardRates[] = {
+    2400, 4800, 9600, 14400, 19200, 38400, 57600, 115200, 230400, 460800,
+    500000, 576000, 921600, 1000000, 1152000, 1500000, 2000000, 2250000,
+    3000000, 4000000, 4500000
+};
+#endif
 
 /**
- * @brief Initialize USART1 for serial communication
+ * @brief Initialize one USART port for serial communication
+ * 
+ * Configures the port's GPIO pins and USART peripheral for TX and RX
+ * operation at SERIALn_BAUDRATE, 8 data bits, 1 stop bit, no parity
+ * Enables the reception interrupt; transmission uses the port's DMA1
+ * channel or the TXE interrupt, enabled whenever the TX ring holds data
  * 
- * Configures GPIO pins and USART1 peripheral for TX and RX operation
- * at 9600 baud rate, 8 data bits, 1 stop bit, no parity
- * Enables USART1 reception interrupt
+ * @param port SERIAL1, SERIAL2 or SERIAL3
  */
-void Serial_Init(void)
+void Serial_Init(Serial_Port *port)
 {
-    // Enable clock for USART1 and GPIOA peripherals
-    RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1, ENABLE);
-    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA, ENABLE);
+    const Serial_Hardware *hw = port->hw;
 
-    // Configure GPIO Pin A9 as alternate function push-pull (USART1_TX)
+    // Enable clock for the USART and its GPIO port
+    RCC_APB2PeriphClockCmd(hw->apb2Clock, ENABLE);
+    if (hw->apb1Clock) RCC_APB1PeriphClockCmd(hw->apb1Clock, ENABLE);
+
+    // Configure the TX pin as alternate function push-pull
     GPIO_InitTypeDef GPIO_InitStructure;
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
-    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_9;
+    GPIO_InitStructure.GPIO_Pin = hw->txPin;
     GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-    GPIO_Init(GPIOA, &GPIO_InitStructure);
-    // Configure GPIO Pin A10 as input pull up
+    GPIO_Init(hw->gpio, &GPIO_InitStructure);
+    // Configure the RX pin as input pull up
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU;
-    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_10;
+    GPIO_InitStructure.GPIO_Pin = hw->rxPin;
     GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-    GPIO_Init(GPIOA, &GPIO_InitStructure);
+    GPIO_Init(hw->gpio, &GPIO_InitStructure);
 
-    // Configure USART1 parameters
+    // Configure USART parameters
     USART_InitTypeDef USART_InitStructure;
-    USART_InitStructure.USART_BaudRate = SERIAL_BAUDRATE;
+    USART_InitStructure.USART_BaudRate = hw->baudrate;
     USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
     USART_InitStructure.USART_Mode = USART_Mode_Tx | USART_Mode_Rx;
     USART_InitStructure.USART_Parity = USART_Parity_No;
     USART_InitStructure.USART_StopBits = USART_StopBits_1;
     USART_InitStructure.USART_WordLength = USART_WordLength_8b;
-    USART_Init(USART1, &USART_InitStructure);
+    USART_Init(hw->usart, &USART_InitStructure);
 
-    // Configure USART1 Reception Interrupt
-    USART_ITConfig(USART1, USART_IT_RXNE, ENABLE);
-    // Configure NVIC for USART1 interrupt
+    // Configure USART Reception Interrupt
+    USART_ITConfig(hw->usart, USART_IT_RXNE, ENABLE);
+    // Configure NVIC for the USART interrupt
     NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
     NVIC_InitTypeDef NVIC_InitStructure;
-    NVIC_InitStructure.NVIC_IRQChannel = USART1_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannel = hw->irq;
     NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
     NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
     NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
     NVIC_Init(&NVIC_InitStructure);
 
-    // Enable USART1 peripheral
-    USART_Cmd(USART1, ENABLE);
+    if (SERIAL_IS_TX_DMA(port)) {
+        // Configure the TX DMA channel: buffer -> DR, started per buffer
+        RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+        DMA_DeInit(hw->txDma);
+        DMA_InitTypeDef DMA_InitStructure;
+        DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&hw->usart->DR;
+        DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)hw->txBuffer;
+        DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+        DMA_InitStructure.DMA_BufferSize = 1;
+        DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+        DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+        DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+        DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+        DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+        DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+        DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+        DMA_Init(hw->txDma, &DMA_InitStructure);
+        DMA_ITConfig(hw->txDma, DMA_IT_TC, ENABLE);
+        USART_DMACmd(hw->usart, USART_DMAReq_Tx, ENABLE);
+
+        // Same priority as the USART, the two handlers never preempt each other
+        NVIC_InitStructure.NVIC_IRQChannel = hw->txDmaIrq;
+        NVIC_Init(&NVIC_InitStructure);
+    }
+
+    // Enable the USART peripheral
+    USART_Cmd(hw->usart, ENABLE);
 }
 
 /**
- * @brief Send a single byte via USART
+ * @brief Check whether the caller runs inside an interrupt handler
+ */
+static uint8_t Serial_InInterrupt(void)
+{
+    return (SCB->ICSR & SCB_ICSR_VECTACTIVE) != 0;
+}
+
+/**
+ * @brief Start DMA on the fill buffer if the channel is idle, swap buffers
  * 
- * @param b Byte to be transmitted
+ * Called with interrupts masked or from the DMA interrupt.
+ */
+static void Serial_TxDmaKick(Serial_Port *port)
+{
+    const Serial_Hardware *hw = port->hw;
+    uint8_t fill = port->txFill;
+
+    if (port->txDmaBusy || port->txDmaLen[fill] == 0) return;
+
+    DMA_Cmd(hw->txDma, DISABLE);
+    hw->txDma->CMAR = (uint32_t)&hw->txBuffer[fill * hw->txSize];
+    DMA_SetCurrDataCounter(hw->txDma, port->txDmaLen[fill]);
+    DMA_Cmd(hw->txDma, ENABLE);
+
+    port->txDmaBusy = 1;
+    port->txFill = fill ^ 1;
+    port->txDmaLen[fill ^ 1] = 0;
+    port->counters.txDmaBlocks++;
+}
+
+/**
+ * @brief Free space in the fill buffer or the TX ring
+ */
+static uint16_t Serial_TxFree(Serial_Port *port)
+{
+    if (SERIAL_IS_TX_DMA(port)) {
+        return port->hw->txSize - port->txDmaLen[port->txFill];
+    }
+    return port->hw->txSize - (uint16_t)(port->txHead - port->txTail);
+}
+
+/**
+ * @brief Append bytes to the fill buffer and start DMA if it is idle
+ * 
+ * @return uint16_t Number of bytes appended (limited by the free space)
+ */
+static uint16_t Serial_TxDmaAppend(Serial_Port *port, const uint8_t *data, uint16_t len)
+{
+    const Serial_Hardware *hw = port->hw;
+    uint32_t primask = __get_PRIMASK();
+    uint16_t n;
+
+    // The interrupt may swap buffers, so take and fill the buffer atomically
+    __disable_irq();
+    uint8_t fill = port->txFill;
+    uint8_t *buffer = &hw->txBuffer[fill * hw->txSize + port->txDmaLen[fill]];
+    n = hw->txSize - port->txDmaLen[fill];
+    if (n > len) n = len;
+    for (uint16_t i = 0; i < n; i++) {
+        buffer[i] = data[i];
+    }
+    port->txDmaLen[fill] += n;
+    Serial_TxDmaKick(port);
+    __set_PRIMASK(primask);
+
+    return n;
+}
+
+/**
+ * @brief Append bytes to the TX ring and start the TXE interrupt
+ * 
+ * @return uint16_t Number of bytes appended (limited by the free space)
  */
-void Serial_SendByte(uint8_t b)
+static uint16_t Serial_TxRingAppend(Serial_Port *port, const uint8_t *data, uint16_t len)
 {
-    // Load data into transmit data register
-    USART_SendData(USART1, b);
+    const Serial_Hardware *hw = port->hw;
+    uint16_t mask = hw->txSize - 1;
+    uint16_t head = port->txHead;
+    uint16_t n = Serial_TxFree(port);
 
-    // Wait until transmit data register is empty
-    while (USART_GetFlagStatus(USART1, USART_FLAG_TXE) == RESET);
+    if (n > len) n = len;
+    for (uint16_t i = 0; i < n; i++) {
+        hw->txBuffer[(head + i) & mask] = data[i];
+    }
+    port->txHead = head + n;
+    if (n > 0) {
+        USART_ITConfig(hw->usart, USART_IT_TXE, ENABLE);
+    }
+
+    return n;
 }
 
 /**
- * @brief Send an array of 16-bit values via USART
+ * @brief Queue bytes under a full-buffer policy
  * 
- * @param arr Pointer to the array of 16-bit values
- * @param len Number of elements in the array
+ * @param port Port to send on
+ * @param data Bytes to queue
+ * @param len Number of bytes
+ * @param policy SERIAL_TX_WAIT, SERIAL_TX_DROP_BYTES or SERIAL_TX_DROP_MESSAGE
+ * @return uint16_t Number of bytes queued
  */
-void Serial_SendArray(uint16_t *arr, uint16_t len)
+static uint16_t Serial_Queue(Serial_Port *port, const uint8_t *data, uint16_t len, uint8_t policy)
 {
-    // Iterate through array and send each element
-    for (uint16_t i = 0; i < len; ++i) {
-        Serial_SendByte(arr[i]);
+    uint16_t done = 0;
+    uint16_t limit = len;
+
+    // Waiting is impossible inside an interrupt or with interrupts masked:
+    // the drain would never run
+    if (policy == SERIAL_TX_WAIT && (Serial_InInterrupt() || __get_PRIMASK())) {
+        policy = SERIAL_TX_DROP_BYTES;
     }
+    // A message only goes out whole; longer than the buffer never fits
+    if (policy == SERIAL_TX_DROP_MESSAGE && Serial_TxFree(port) < len) {
+        limit = 0;
+    }
+
+    while (done < limit) {
+        uint16_t n;
+
+        if (SERIAL_IS_TX_DMA(port)) {
+            uint16_t chunk = len - done;
+            if (chunk > SERIAL_TX_DMA_CHUNK) chunk = SERIAL_TX_DMA_CHUNK;
+            n = Serial_TxDmaAppend(port, data + done, chunk);
+        } else {
+            n = Serial_TxRingAppend(port, data + done, limit - done);
+        }
+        done += n;
+        if (n == 0) {
+            if (policy != SERIAL_TX_WAIT) break;
+            while (Serial_TxFree(port) == 0);   // The interrupt makes room
+        }
+    }
+
+    if (done < len) {
+        port->counters.txOverruns += len - done;
+    }
+
+    return done;
 }
 
 /**
- * @brief Send a null-terminated string via USART
+ * @brief Queue bytes under the port's current policy
+ */
+static void Serial_Send(Serial_Port *port, const uint8_t *data, uint16_t len)
+{
+    Serial_Queue(port, data, len, port->txPolicy);
+}
+
+/**
+ * @brief Select what the Send/Printf functions do when no TX space is left
+ * 
+ * Control code that must never wait on the UART uses SERIAL_TX_DROP_MESSAGE.
+ * 
+ * @param port Port to configure
+ * @param policy SERIAL_TX_WAIT, SERIAL_TX_DROP_BYTES or SERIAL_TX_DROP_MESSAGE
+ */
+void Serial_SetTxPolicy(Serial_Port *port, uint8_t policy)
+{
+    port->txPolicy = policy;
+}
+
+/**
+ * @brief Queue a single byte for transmission via USART
+ * 
+ * @param port Port to send on
+ * @param b Byte to be transmitted
+ */
+void Serial_SendByte(Serial_Port *port, uint8_t b)
+{
+    Serial_Send(port, &b, 1);
+}
+
+/**
+ * @brief Queue an array of bytes via USART
+ * 
+ * @param port Port to send on
+ * @param arr Pointer to the bytes
+ * @param len Number of bytes
+ */
+void Serial_SendArray(Serial_Port *port, const uint8_t *arr, uint16_t len)
+{
+    Serial_Send(port, arr, len);
+}
+
+/**
+ * @brief Queue a null-terminated string via USART
  * 
+ * @param port Port to send on
  * @param str Pointer to the null-terminated string
  */
-void Serial_SendString(char *str)
+void Serial_SendString(Serial_Port *port, char *str)
+{
+    uint16_t len = 0;
+
+    while (str[len] != '\0') len++;
+    Serial_Send(port, (const uint8_t *)str, len);
+}
+
+/**
+ * @brief Queue as many bytes as fit, never waits
+ * 
+ * @param port Port to send on
+ * @param data Bytes to transmit
+ * @param len Number of bytes
+ * @return uint16_t Number of bytes queued, the rest is counted as overrun
+ */
+uint16_t Serial_Write(Serial_Port *port, const uint8_t *data, uint16_t len)
+{
+    return Serial_Queue(port, data, len, SERIAL_TX_DROP_BYTES);
+}
+
+/**
+ * @brief Take received bytes out of the RX ring, never waits
+ * 
+ * @param port Port to read from
+ * @param data Destination
+ * @param len Maximum number of bytes
+ * @return uint16_t Number of bytes copied
+ */
+uint16_t Serial_Read(Serial_Port *port, uint8_t *data, uint16_t len)
+{
+    const Serial_Hardware *hw = port->hw;
+    uint16_t mask = hw->rxSize - 1;
+    uint16_t tail = port->rxTail;
+    uint16_t count = port->rxHead - tail;
+
+    if (count > len) count = len;
+    for (uint16_t i = 0; i < count; i++) {
+        data[i] = hw->rxBuffer[(tail + i) & mask];
+    }
+    port->rxTail = tail + count;
+
+    return count;
+}
+
+/**
+ * @brief Number of received bytes waiting in the RX ring
+ */
+uint16_t Serial_Available(Serial_Port *port)
+{
+    return (uint16_t)(port->rxHead - port->rxTail);
+}
+
+/**
+ * @brief Wait until the TX buffers are empty and the last byte has left the wire
+ * 
+ * Call before changing the baud rate or entering a low-power mode.
+ */
+void Serial_Flush(Serial_Port *port)
+{
+    if (SERIAL_IS_TX_DMA(port)) {
+        while (port->txDmaBusy || port->txDmaLen[port->txFill] != 0);
+    } else {
+        while (port->txTail != port->txHead);
+    }
+    while (USART_GetFlagStatus(port->hw->usart, USART_FLAG_TC) == RESET);
+}
+
+/**
+ * @brief Copy the overrun and line error counters of a port
+ * 
+ * @param port Port to query
+ * @param stats Destination
+ */
+void Serial_GetStats(Serial_Port *port, Serial_Stats *stats)
+{
+    stats->rxOverruns = port->counters.rxOverruns;
+    stats->txOverruns = port->counters.txOverruns;
+    stats->hwOverruns = port->counters.hwOverruns;
+    stats->framingErrors = port->counters.framingErrors;
+    stats->noiseErrors = port->counters.noiseErrors;
+    stats->parityErrors = port->counters.parityErrors;
+    stats->txDmaBlocks = port->counters.txDmaBlocks;
+    stats->autoBaudRejects = port->counters.autoBaudRejects;
+}
+
+/**
+ * @brief Clock of the port's bus: PCLK2 for USART1, PCLK1 for USART2/3
+ */
+static uint32_t Serial_BusClock(Serial_Port *port)
+{
+    RCC_ClocksTypeDef clocks;
+
+    RCC_GetClocksFreq(&clocks);
+    return port->hw->usart == USART1 ? clocks.PCLK2_Frequency : clocks.PCLK1_Frequency;
+}
+
+/**
+ * @brief Change the baud rate once everything queued has been sent
+ * 
+ * BRR holds PCLK / baud rate in 1/16 steps (16x oversampling), rounded to
+ * the nearest step; the error is below 1% up to about PCLK / 64 and exactly
+ * 0 for PCLK / 16, / 24, / 32 ... (4.5M, 3M, 2.25M ... on USART1 at 72 MHz).
+ * 
+ * @param port Port to change
+ * @param baudrate Up to PCLK / 16
+ * @return uint8_t 1 if applied, 0 if out of range
+ */
+uint8_t Serial_SetBaudrate(Serial_Port *port, uint32_t baudrate)
+{
+    USART_TypeDef *usart = port->hw->usart;
+    uint32_t pclk = Serial_BusClock(port);
+    uint32_t brr;
+
+    if (baudrate == 0 || baudrate > pclk / 16) return 0;
+    brr = (pclk + baudrate / 2) / baudrate;
+    if (brr > 0xFFFF) return 0;
+
+    Serial_Flush(port);
+    usart->CR1 &= ~USART_CR1_UE;
+    usart->BRR = brr;
+    usart->CR1 |= USART_CR1_UE;
+    return 1;
+}
+
+/**
+ * @brief Actual baud rate, from BRR and the current bus clock
+ */
+uint32_t Serial_GetBaudrate(Serial_Port *port)
+{
+    return Serial_BusClock(port) / port->hw->usart->BRR;
+}
+
+#if SERIAL_USE_USART1
+/**
+ * @brief Arm DMA for the next SERIAL_AUTOBAUD_EDGES falling edges
+ */
+static void Serial_AutoBaudArm(void)
+{
+    DMA_Cmd(SERIAL_AUTOBAUD_DMA_CHANNEL, DISABLE);
+    DMA_SetCurrDataCounter(SERIAL_AUTOBAUD_DMA_CHANNEL, SERIAL_AUTOBAUD_EDGES);
+    TIM_ClearFlag(TIM1, TIM_FLAG_CC3 | TIM_FLAG_CC3OF);
+    DMA_Cmd(SERIAL_AUTOBAUD_DMA_CHANNEL, ENABLE);
+}
+
+/**
+ * @brief Start auto-baud detection on USART1
+ * 
+ * The receiver is switched off so the sync byte, sent at an unknown rate,
+ * does not end up in the RX ring as garbage. TX keeps working at the old
+ * rate. The host sends 0x55 after an idle gap, repeatedly until it gets an
+ * answer; Serial_AutoBaudPoll() from the main loop finishes the job.
+ */
+void Serial_AutoBaudStart(void)
+{
+    DMA_InitTypeDef DMA_InitStructure;
+
+    USART1->CR1 &= ~USART_CR1_RE;
+
+    // TIM1 free-running at the timer clock, CH3 (PA10) captures falling edges
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_TIM1, ENABLE);
+    TIM_TimeBaseInit(TIM1, &(TIM_TimeBaseInitTypeDef) {
+        .TIM_Prescaler = 0,
+        .TIM_CounterMode = TIM_CounterMode_Up,
+        .TIM_Period = 0xFFFF,
+        .TIM_ClockDivision = TIM_CKD_DIV1,
+        .TIM_RepetitionCounter = 0
+    });
+    TIM_ICInit(TIM1, &(TIM_ICInitTypeDef) {
+        .TIM_Channel = TIM_Channel_3,
+        .TIM_ICPolarity = TIM_ICPolarity_Falling,
+        .TIM_ICSelection = TIM_ICSelection_DirectTI,
+        .TIM_ICPrescaler = TIM_ICPSC_DIV1,
+        .TIM_ICFilter = 0
+    });
+
+    // DMA1 channel 6 (TIM1_CH3): CCR3 -> edge buffer on every capture
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    DMA_DeInit(SERIAL_AUTOBAUD_DMA_CHANNEL);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&TIM1->CCR3;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)Serial_AutoBaudEdges;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = SERIAL_AUTOBAUD_EDGES;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(SERIAL_AUTOBAUD_DMA_CHANNEL, &DMA_InitStructure);
+    TIM_DMACmd(TIM1, TIM_DMA_CC3, ENABLE);
+
+    Serial_AutoBaudArm();
+    TIM_Cmd(TIM1, ENABLE);
+    Serial_AutoBaudRunning = 1;
+}
+
+/**
+ * @brief Stop auto-baud detection and receive at the current rate again
+ */
+void Serial_AutoBaudStop(void)
+{
+    TIM_Cmd(TIM1, DISABLE);
+    TIM_DMACmd(TIM1, TIM_DMA_CC3, DISABLE);
+    DMA_Cmd(SERIAL_AUTOBAUD_DMA_CHANNEL, DISABLE);
+    Serial_AutoBaudRunning = 0;
+
+    USART1->CR1 |= USART_CR1_RE;
+}
+
+/**
+ * @brief Round a measured rate to a standard one within SERIAL_AUTOBAUD_SNAP_PCT
+ */
+static uint32_t Serial_AutoBaudSnap(uint32_t baudrate)
+{
+    for (uint8_t i = 0; i < sizeof(Serial_StandardRates) / sizeof(Serial_StandardRates[0]); i++) {
+        uint32_t rate = Serial_StandardRates[i];
+        uint32_t diff = baudrate > rate ? baudrate - rate : rate - baudrate;
+
+        if (diff * 100 <= rate * SERIAL_AUTOBAUD_SNAP_PCT) return rate;
+    }
+    return baudrate;
+}
+
+/**
+ * @brief Check for a measured sync byte, call from the main loop
+ * 
+ * The four intervals between the five falling edges of 0x55 are two bit
+ * times each; a capture whose intervals differ by more than 1/8 (plus two
+ * timer ticks of synchronizer jitter) was not a sync byte and is retried.
+ * Intervals are 16-bit differences, the timer may wrap between edges.
+ * 
+ * @return uint8_t SERIAL_AUTOBAUD_x
+ */
+uint8_t Serial_AutoBaudPoll(void)
 {
-    // Send each character until null terminator is reached
-    for (uint16_t i = 0; str[i] != '\0'; ++i) {
-        Serial_SendByte(str[i]);
+    RCC_ClocksTypeDef clocks;
+    uint16_t interval[SERIAL_AUTOBAUD_EDGES - 1];
+    uint32_t span = 0;
+    uint32_t timerClock;
+    uint32_t baudrate;
+
+    if (!Serial_AutoBaudRunning) return SERIAL_AUTOBAUD_IDLE;
+    if (DMA_GetCurrDataCounter(SERIAL_AUTOBAUD_DMA_CHANNEL) != 0) return SERIAL_AUTOBAUD_RUNNING;
+
+    for (uint8_t i = 0; i < SERIAL_AUTOBAUD_EDGES - 1; i++) {
+        interval[i] = Serial_AutoBaudEdges[i + 1] - Serial_AutoBaudEdges[i];
+        span += interval[i];
+    }
+    for (uint8_t i = 0; i < SERIAL_AUTOBAUD_EDGES - 1; i++) {
+        uint32_t expected = span / (SERIAL_AUTOBAUD_EDGES - 1);
+        uint32_t diff = interval[i] > expected ? interval[i] - expected : expected - interval[i];
+
+        if (diff > expected / 8 + 2) {
+            Serial_Port1.counters.autoBaudRejects++;
+            Serial_AutoBaudArm();
+            return SERIAL_AUTOBAUD_RUNNING;
+        }
+    }
+
+    // TIM1 runs at PCLK2, or twice PCLK2 when APB2 is divided
+    RCC_GetClocksFreq(&clocks);
+    timerClock = clocks.PCLK2_Frequency;
+    if (RCC->CFGR & RCC_CFGR_PPRE2_2) timerClock *= 2;
+
+    // Five falling edges of 0x55 span eight bit times
+    baudrate = Serial_AutoBaudSnap((uint32_t)(((uint64_t)timerClock * 8 + span / 2) / span));
+
+    Serial_AutoBaudStop();
+    if (baudrate < SERIAL_AUTOBAUD_MIN || !Serial_SetBaudrate(SERIAL1, baudrate)) {
+        Serial_Port1.counters.autoBaudRejects++;
+        Serial_AutoBaudStart();
+        return SERIAL_AUTOBAUD_RUNNING;
     }
+    return SERIAL_AUTOBAUD_DONE;
 }
+#endif
 
 /**
  * @brief Calculate x raised to the power of y
@@ -123,19 +690,20 @@ static uint32_t Serial_Pow(uint32_t x, uint32_t y)
 /**
  * @brief Send a numeric value as ASCII digits via USART
  * 
+ * @param port Port to send on
  * @param num Numeric value to be sent
  * @param len Number of digits to display (with leading zeros if needed)
  */
-void Serial_SendNumber(uint32_t num, uint8_t len)
+void Serial_SendNumber(Serial_Port *port, uint32_t num, uint8_t len)
 {
     // Extract and send each digit from left to right
     for (uint8_t i = 0; i < len; ++i) {
-        Serial_SendByte(num / Serial_Pow(10, len - i - 1) % 10 + '0');
+        Serial_SendByte(port, num / Serial_Pow(10, len - i - 1) % 10 + '0');
     }
 }
 
 /**
- * @brief Redirect standard library's fputc to USART
+ * @brief Redirect standard library's fputc to SERIAL_STDIO
  * 
  * @param ch Character to be sent
  * @param f File pointer (unused in this implementation)
@@ -143,67 +711,178 @@ void Serial_SendNumber(uint32_t num, uint8_t len)
  */
 int fputc(int ch, FILE *f)
 {
-    Serial_SendByte(ch);
+    Serial_SendByte(SERIAL_STDIO, ch);
     return ch;
 }
 
 /**
  * @brief Custom printf implementation using variable arguments
  * 
+ * @param port Port to send on
  * @param format Format string (same as standard printf)
  * @param ... Variable arguments to be formatted
  */
-void Serial_Printf(char *format, ...)
+void Serial_Printf(Serial_Port *port, char *format, ...)
 {
-    char str[100];
+    char str[SERIAL_PRINTF_SIZE];
     va_list arg;    // Variable argument list
     // Initialize argument list and format string
     va_start(arg, format);
-    vsprintf(str, format, arg);
+    vsnprintf(str, sizeof(str), format, arg);
     va_end(arg);
 
-    // Send the formatted string
-    Serial_SendString(str);
+    // Queue the formatted string, returns once it is in the TX buffer
+    Serial_SendString(port, str);
 }
 
 /**
  * @brief Check if new data has been received
  * 
- * @return uint8_t 1 if new data available, 0 otherwise
+ * @return uint8_t 1 if at least one byte is waiting, 0 otherwise
+ */
+uint8_t Serial_GetRxFlag(Serial_Port *port)
+{
+    return Serial_Available(port) > 0;
+}
+
+/**
+ * @brief Get the oldest received data byte
+ * 
+ * @return uint8_t Received data byte, 0 if the RX ring is empty
+ */
+uint8_t Serial_GetRxData(Serial_Port *port)
+{
+    uint8_t b = 0;
+
+    Serial_Read(port, &b, 1);
+    return b;
+}
+
+/**
+ * @brief USART interrupt work shared by all ports
+ * 
+ * RXNE: moves the received byte into the RX ring and counts the line errors
+ * flagged with it (reading DR also clears them). TXE: feeds the next byte of
+ * the TX ring, disables itself when the ring is empty.
  */
-uint8_t Serial_GetRxFlag(void)
+static void Serial_IRQHandler(Serial_Port *port)
 {
-    if (Serial_RxFlag == 1) {
-        Serial_RxFlag = 0;  // Clear flag after reading
-        return 1;
+    const Serial_Hardware *hw = port->hw;
+    USART_TypeDef *usart = hw->usart;
+    // Check if receive interrupt occurred (ORE raises it as well); skipped
+    // while RXNEIE is off so a polling or DMA receiver keeps its bytes
+    uint16_t sr = usart->SR;
+
+    if ((usart->CR1 & USART_CR1_RXNEIE) && (sr & (USART_FLAG_RXNE | USART_FLAG_ORE))) {
+        // Error flags belong to the byte in DR, which is stored anyway
+        if (sr & USART_FLAG_ORE) port->counters.hwOverruns++;
+        if (sr & USART_FLAG_FE) port->counters.framingErrors++;
+        if (sr & USART_FLAG_NE) port->counters.noiseErrors++;
+        if (sr & USART_FLAG_PE) port->counters.parityErrors++;
+        // Read received data, SR then DR clears RXNE and the error flags
+        uint8_t b = USART_ReceiveData(usart);
+        uint16_t head = port->rxHead;
+
+        if ((uint16_t)(head - port->rxTail) < hw->rxSize) {
+            hw->rxBuffer[head & (hw->rxSize - 1)] = b;
+            port->rxHead = head + 1;
+        } else {
+            port->counters.rxOverruns++;
+        }
+    }
+
+    // Transmit data register empty while the TX interrupt is enabled
+    if (!SERIAL_IS_TX_DMA(port) && USART_GetITStatus(usart, USART_IT_TXE) == SET) {
+        uint16_t tail = port->txTail;
+
+        if (tail != port->txHead) {
+            USART_SendData(usart, hw->txBuffer[tail & (hw->txSize - 1)]);
+            port->txTail = tail + 1;
+        } else {
+            USART_ITConfig(usart, USART_IT_TXE, DISABLE);
+        }
     }
-    return 0;
 }
 
+#if SERIAL_TX_DMA_USED
 /**
- * @brief Get the received data byte
+ * @brief TX DMA transfer-complete work shared by all ports
  * 
- * @return uint8_t Received data byte
+ * A TX buffer has been handed to the USART: start the buffer filled
+ * meanwhile, if any.
  */
-uint8_t Serial_GetRxData(void)
+static void Serial_TxDmaIRQHandler(Serial_Port *port)
 {
-    return Serial_RxData;
+    port->txDmaBusy = 0;
+    Serial_TxDmaKick(port);
 }
+#endif
 
+#if SERIAL_USE_USART1
 /**
  * @brief USART1 Interrupt Service Routine
- * 
- * Handles USART1 receive interrupt, stores received data and sets receive flag
  */
 void USART1_IRQHandler(void)
 {
-    // Check if receive interrupt occurred
-    if (USART_GetITStatus(USART1, USART_IT_RXNE) == SET) {
-        // Read received data
-        Serial_RxData = USART_ReceiveData(USART1);
-        // Set flag to indicate new data available
-        Serial_RxFlag = 1;
-        // Clear the interrupt pending bit
-        USART_ClearITPendingBit(USART1, USART_IT_RXNE);
+    Serial_IRQHandler(&Serial_Port1);
+}
+
+#if SERIAL1_TX_DMA
+/**
+ * @brief DMA1 Channel 4 (USART1_TX) Interrupt Service Routine
+ */
+void DMA1_Channel4_IRQHandler(void)
+{
+    if (DMA_GetITStatus(DMA1_IT_TC4) == SET) {
+        DMA_ClearITPendingBit(DMA1_IT_TC4);
+        Serial_TxDmaIRQHandler(&Serial_Port1);
+    }
+}
+#endif
+#endif
+
+#if SERIAL_USE_USART2
+/**
+ * @brief USART2 Interrupt Service Routine
+ */
+void USART2_IRQHandler(void)
+{
+    Serial_IRQHandler(&Serial_Port2);
+}
+
+#if SERIAL2_TX_DMA
+/**
+ * @brief DMA1 Channel 7 (USART2_TX) Interrupt Service Routine
+ */
+void DMA1_Channel7_IRQHandler(void)
+{
+    if (DMA_GetITStatus(DMA1_IT_TC7) == SET) {
+        DMA_ClearITPendingBit(DMA1_IT_TC7);
+        Serial_TxDmaIRQHandler(&Serial_Port2);
+    }
+}
+#endif
+#endif
+
+#if SERIAL_USE_USART3
+/**
+ * @brief USART3 Interrupt Service Routine
+ */
+void USART3_IRQHandler(void)
+{
+    Serial_IRQHandler(&Serial_Port3);
+}
+
+#if SERIAL3_TX_DMA
+/**
+ * @brief DMA1 Channel 2 (USART3_TX) Interrupt Service Routine
+ */
+void DMA1_Channel2_IRQHandler(void)
+{
+    if (DMA_GetITStatus(DMA1_IT_TC2) == SET) {
+        DMA_ClearITPendingBit(DMA1_IT_TC2);
+        Serial_TxDmaIRQHandler(&Serial_Port3);
     }
 }
+#endif
+#endif
@@ -0,0 +1,129 @@
+/****************************************************************************/ /**
+ * @file   Trace.c
+ * @brief  Tokenized deferred logging - Source File
+ *
+ * Any context may write: a record is reserved and filled with interrupts
+ * masked, which keeps records whole and in order without a lock. Only
+ * Trace_Process() (main loop) advances the tail.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 20:41:07
+ ********************************************************************************/
+
+#include "Trace.h"
+
+#define TRACE_MASK              (TRACE_BUFFER_WORDS - 1)
+#define TRACE_RECORD_WORDS_MAX  (2 + TRACE_ARGS_MAX)
+
+#if TRACE_BUFFER_WORDS & TRACE_MASK
+#error "TRACE_BUFFER_WORDS must be a power of two"
+#endif
+
+static uint32_t Trace_Buffer[TRACE_BUFFER_WORDS];
+static volatile uint16_t Trace_Head = 0;    // Writers, interrupts masked
+static volatile uint16_t Trace_Tail = 0;    // Trace_Process()
+static volatile uint32_t Trace_Ticks = 0;
+static volatile Trace_Stats Trace_Counters;
+static uint32_t Trace_DroppedReported = 0;
+
+/**
+ * @brief Empty the ring and queue a start marker
+ */
+void Trace_Init(void)
+{
+    TRACE_FORMAT(TRACE_LEVEL_INFO, "trace start, level %u");
+    uint32_t level = TRACE_LEVEL;
+
+    Trace_Head = 0;
+    Trace_Tail = 0;
+    Trace_Write(Trace_Fmt, &level, 1);
+}
+
+/**
+ * @brief Count milliseconds for the record timestamps, call from a 1 ms interrupt
+ */
+void Trace_Tick(void)
+{
+    Trace_Ticks++;
+}
+
+/**
+ * @brief Queue one record, use the TRACE_x macros instead
+ *
+ * @param fmt Format string with its "level|file|line|" prefix
+ * @param args Raw arguments
+ * @param count Number of arguments, up to TRACE_ARGS_MAX
+ */
+void Trace_Write(const char *fmt, const uint32_t *args, uint8_t count)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint16_t words = 2 + count;
+    uint16_t head;
+    uint16_t used;
+
+    __disable_irq();
+    head = Trace_Head;
+    used = (uint16_t)(head - Trace_Tail) + words;
+    if (used > TRACE_BUFFER_WORDS) {
+        Trace_Counters.dropped++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    Trace_Buffer[head & TRACE_MASK] = TRACE_SYNC | (uint32_t)count << 8 | Trace_Ticks << 16;
+    Trace_Buffer[(head + 1) & TRACE_MASK] = (uint32_t)fmt;
+    for (uint8_t i = 0; i < count; i++) {
+        Trace_Buffer[(head + 2 + i) & TRACE_MASK] = args[i];
+    }
+    Trace_Head = head + words;
+
+    Trace_Counters.records++;
+    if (used > Trace_Counters.maxUsedWords) Trace_Counters.maxUsedWords = used;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Send the queued records over TRACE_PORT, call from the main loop
+ *
+ * Records go out whole under the port's TX policy (waits while the TX
+ * buffers are full by default). Lost records are reported with a WARN
+ * record of their own.
+ */
+void Trace_Process(void)
+{
+    uint32_t record[TRACE_RECORD_WORDS_MAX];
+    uint32_t dropped = Trace_Counters.dropped;
+
+    if (dropped != Trace_DroppedReported) {
+        TRACE_FORMAT(TRACE_LEVEL_WARN, "%u trace records dropped");
+        uint32_t lost = dropped - Trace_DroppedReported;
+
+        Trace_DroppedReported = dropped;
+        Trace_Write(Trace_Fmt, &lost, 1);
+    }
+
+    while (Trace_Tail != Trace_Head) {
+        uint16_t tail = Trace_Tail;
+        uint8_t words = 2 + ((Trace_Buffer[tail & TRACE_MASK] >> 8) & 0xFF);
+
+        for (uint8_t i = 0; i < words; i++) {
+            record[i] = Trace_Buffer[(tail + i) & TRACE_MASK];
+        }
+        Trace_Tail = tail + words;
+
+        // Cortex-M3 is little-endian, the words go out as they are
+        Serial_SendArray(TRACE_PORT, (const uint8_t *)record, words * 4);
+    }
+}
+
+/**
+ * @brief Copy the counters
+ *
+ * @param stats Destination
+ */
+void Trace_GetStats(Trace_Stats *stats)
+{
+    stats->records = Trace_Counters.records;
+    stats->dropped = Trace_Counters.dropped;
+    stats->maxUsedWords = Trace_Counters.maxUsedWords;
+}
@@ -7,15 +7,352 @@
  ********************************************************************************/
 
 #include "W25Q64.h"
+#include "W25Q64_Cache.h"
+#include "DWT.h"
+#include <string.h>
+
+static Hard_SPI_Callback W25Q64_AsyncCallback = 0;    // User callback of the pending async read
+
+// W25Q64 on SPI1: CS PA4, mode 0, MSB first, clock set by W25Q64_NegotiateClock()
+static SPI_Bus_Device W25Q64_Device = {
+    GPIOA, SPI1_CS_PIN, SPI_BUS_MODE_0, W25Q64_SAFE_PRESCALER, SPI_FirstBit_MSB
+};
+// Defaults describe a W25Q64 until W25Q64_Detect() knows better
+static W25Q64_Geometry W25Q64_Info = {
+    0x00, 0x0000, W25Q64_DEFAULT_CAPACITY, W25Q64_PAGE_SIZE, 3,
+    W25Q64_SECTOR_ERASE, W25Q64_BLOCK_ERASE_32K, W25Q64_BLOCK_ERASE_64K,
+    W25Q64_USE_FAST_READ, false
+};
+static SPI_Bus_Transaction W25Q64_ReadTxn;             // Queued W25Q64_ReadDataAsync()
+static volatile bool W25Q64_ReadPending = false;
+
+// Candidate SPI clocks for the self-test, fastest first (18, 9 MHz)
+static const uint16_t W25Q64_ClockSteps[] = {
+    SPI1_BAUDRATE_PRESCALER,
+    SPI_BaudRatePrescaler_8
+};
+
+// Sector image for read-modify-write in W25Q64_Write()
+static uint8_t W25Q64_SectorBuffer[W25Q64_SECTOR_SIZE];
+
+// Longer transfers use DMA; W25Q64_Benchmark() raises it to force the byte loop
+static uint32_t W25Q64_DMAThreshold = W25Q64_DMA_THRESHOLD;
+static volatile bool W25Q64_BenchDone;
+static volatile uint32_t W25Q64_BenchEnd;       // DWT_CYCCNT in the async read callback
+
+// Asynchronous erase/program state, polled from W25Q64_Process()
+static volatile W25Q64_Op W25Q64_PendingOp = W25Q64_OP_NONE;
+static volatile uint32_t W25Q64_TickCount = 0;      // 1 ms ticks from W25Q64_Tick()
+static volatile uint8_t W25Q64_PollDue = 0;         // Status poll allowed once per tick
+static uint32_t W25Q64_ResumeTick = 0xFFFFFFFF;     // Tick of the last Resume command
+static volatile bool W25Q64_Suspended = false;      // Operation suspended for a read
+static volatile uint8_t W25Q64_SuspendRefs = 0;     // Reads holding the suspend
+static bool W25Q64_ReadHoldsSuspend = false;        // The queued async read is one of them
+
+// Deep power-down; assumed on at reset, so the first access always releases it
+static volatile bool W25Q64_PoweredDown = true;
+static volatile uint32_t W25Q64_IdleTicks = 0;      // Ticks since the last access
+static W25Q64_PowerStats W25Q64_Power;
+
+static void W25Q64_Wake(void);
+static void W25Q64_Select(void);
+static void W25Q64_Detect(void);
+static bool W25Q64_ParseSFDP(uint8_t *enter4Byte);
+static uint8_t W25Q64_BuildCommand(uint8_t cmd, uint32_t addr, uint8_t *header);
+static void W25Q64_SendCommand(uint8_t cmd, uint32_t addr);
+static uint8_t W25Q64_BuildReadHeader(uint32_t addr, uint8_t *header);
+static void W25Q64_SendReadHeader(uint32_t addr);
+static void W25Q64_PageProgramStart(uint32_t addr, const uint8_t *dataArr, uint16_t len);
+static void W25Q64_EraseSectorStart(uint32_t addr);
+static uint8_t W25Q64_ReadStatus(uint8_t cmd);
+static bool W25Q64_SuspendForRead(void);
+static void W25Q64_ResumeAfterRead(void);
+static void W25Q64_ProgramPages(uint32_t addr, const uint8_t *dataArr, uint32_t len);
 
 /**
  * @brief Initialize W25Q64 Flash Memory interface
  * 
- * Initializes the software SPI interface used to communicate with the W25Q64.
+ * Initializes the hardware SPI interface used to communicate with the W25Q64,
+ * identifies the part (capacity, erase opcodes, address width) and selects
+ * the fastest SPI clock that passes the readback self-test.
  */
 void W25Q64_Init(void)
 {
-    Hard_SPI_Init();
+    SPI_Bus_Init();
+    SPI_Bus_AddDevice(&W25Q64_Device);
+    W25Q64_Detect();
+    W25Q64_NegotiateClock();
+}
+
+/**
+ * @brief Release the flash from deep power-down if needed, restart the idle count
+ * 
+ * Release (0xAB) needs tRES1 before the next command is accepted.
+ */
+static void W25Q64_Wake(void)
+{
+    W25Q64_IdleTicks = 0;
+    if (!W25Q64_PoweredDown) return;
+
+    SPI_Bus_Start(&W25Q64_Device);
+    Hard_SPI_TransferByte(W25Q64_RELEASE_POWER_DOWN);
+    SPI_Bus_Stop();
+    Delay_us(W25Q64_TRES1_US);
+
+    W25Q64_PoweredDown = false;
+    W25Q64_Power.wakeups++;
+}
+
+/**
+ * @brief Begin a polled transaction with the W25Q64, waking it first
+ */
+static void W25Q64_Select(void)
+{
+    W25Q64_Wake();
+    SPI_Bus_Start(&W25Q64_Device);
+}
+
+/**
+ * @brief Put the flash into deep power-down (0xB9)
+ * 
+ * Called by W25Q64_Process() after W25Q64_POWERDOWN_IDLE_MS without access,
+ * or directly before entering a low-power mode. Any later access releases it.
+ * 
+ * @return true Flash is in power-down
+ * @return false An erase/program or a queued read is still pending
+ */
+bool W25Q64_PowerDown(void)
+{
+    if (W25Q64_PoweredDown) return true;
+    if (W25Q64_PendingOp != W25Q64_OP_NONE || W25Q64_ReadPending) return false;
+
+    SPI_Bus_Start(&W25Q64_Device);
+    Hard_SPI_TransferByte(W25Q64_POWER_DOWN);
+    SPI_Bus_Stop();
+    Delay_us(W25Q64_TDP_US);
+
+    W25Q64_PoweredDown = true;
+    W25Q64_Power.powerDowns++;
+
+    return true;
+}
+
+/**
+ * @brief Get the power counters
+ * 
+ * @param stats Destination
+ */
+void W25Q64_GetPowerStats(W25Q64_PowerStats *stats)
+{
+    *stats = W25Q64_Power;
+}
+
+/**
+ * @brief Identify the flash from its JEDEC ID and SFDP table
+ * 
+ * The capacity code of the JEDEC ID (2^n bytes) is the fallback when the part
+ * has no SFDP. Parts above 16 MB are switched to 4-byte addressing, all
+ * address phases of the driver follow W25Q64_Info.addrBytes. Runs at the
+ * safe prescaler, SFDP reads are limited to 50 MHz.
+ */
+static void W25Q64_Detect(void)
+{
+    uint8_t enter4Byte = 0x01;      // Without SFDP: B7, no write enable
+    uint8_t code;
+
+    W25Q64_ReadID(&W25Q64_Info.manufacturerID, &W25Q64_Info.deviceID);
+    if (W25Q64_Info.manufacturerID == 0x00 || W25Q64_Info.manufacturerID == 0xFF) {
+        return;     // No device, keep the W25Q64 defaults
+    }
+
+    code = W25Q64_Info.deviceID & 0xFF;
+    if (code >= 0x10 && code <= 0x1F) {
+        W25Q64_Info.capacity = 1UL << code;
+    }
+
+    W25Q64_Info.sfdp = W25Q64_ParseSFDP(&enter4Byte);
+
+    // Fast Read is universal on parts that report SFDP or a capacity code
+    W25Q64_Info.fastRead = W25Q64_USE_FAST_READ &&
+                           (W25Q64_Info.sfdp || (code >= 0x10 && code <= 0x1F));
+
+    if (W25Q64_Info.capacity <= W25Q64_3BYTE_LIMIT) return;
+
+    if (enter4Byte & 0x40) {
+        // Always in 4-byte mode
+    } else if (enter4Byte & 0x03) {
+        if ((enter4Byte & 0x01) == 0) W25Q64_WriteEnable();
+
+        W25Q64_Select();
+        Hard_SPI_TransferByte(W25Q64_ENTER_4BYTE_ADDR);
+        SPI_Bus_Stop();
+    } else {
+        // Bank/extended address registers only: use the lower 16 MB
+        W25Q64_Info.capacity = W25Q64_3BYTE_LIMIT;
+        return;
+    }
+    W25Q64_Info.addrBytes = 4;
+}
+
+/**
+ * @brief Read the Basic Flash Parameter Table and fill W25Q64_Info
+ * 
+ * Uses BFPT DWORD 1 (4 KB erase, address bytes), 2 (density), 8-9 (erase
+ * types), 11 (page size, JESD216A) and 16 (4-byte entry, JESD216B). Words
+ * the table does not have read as zero.
+ * 
+ * @param enter4Byte Receives BFPT DWORD 16 bits 31:24 when present
+ * @return true Table found and usable
+ * @return false No SFDP, or no 4 KB erase type
+ */
+static bool W25Q64_ParseSFDP(uint8_t *enter4Byte)
+{
+    uint8_t header[16];
+    uint8_t raw[W25Q64_SFDP_BFPT_DWORDS * 4];
+    uint32_t dw[W25Q64_SFDP_BFPT_DWORDS];   // dw[0] is DWORD 1
+    uint32_t capacity;
+    uint32_t ptr;
+    uint8_t words;
+    uint8_t sectorCmd = 0, block32Cmd = 0, block64Cmd = 0;
+
+    // SFDP header, followed by the first parameter header: the BFPT, ID 0xFF00
+    W25Q64_ReadSFDP(0, header, sizeof(header));
+    if ((header[0] | (uint32_t)header[1] << 8 | (uint32_t)header[2] << 16 |
+         (uint32_t)header[3] << 24) != W25Q64_SFDP_SIGNATURE) {
+        return false;
+    }
+    if (header[8] != 0x00 || header[15] != 0xFF || header[11] < 9) return false;
+
+    words = header[11];
+    if (words > W25Q64_SFDP_BFPT_DWORDS) words = W25Q64_SFDP_BFPT_DWORDS;
+    ptr = header[12] | (uint32_t)header[13] << 8 | (uint32_t)header[14] << 16;
+
+    W25Q64_ReadSFDP(ptr, raw, words * 4);
+    for (uint8_t i = 0; i < W25Q64_SFDP_BFPT_DWORDS; i++) {
+        dw[i] = (i < words) ? raw[i * 4] | (uint32_t)raw[i * 4 + 1] << 8 |
+                (uint32_t)raw[i * 4 + 2] << 16 | (uint32_t)raw[i * 4 + 3] << 24 : 0;
+    }
+
+    // DWORD 2: density in bits, either N-1 or 2^N
+    if (dw[1] & 0x80000000) {
+        uint32_t n = dw[1] & 0x7FFFFFFF;
+        if (n < 3 || n > 34) return false;
+        capacity = 1UL << (n - 3);
+    } else {
+        capacity = (dw[1] >> 3) + 1;
+    }
+
+    // DWORD 8-9: four erase types, 16 bits each: size 2^N, opcode
+    for (uint8_t t = 0; t < 4; t++) {
+        uint16_t type = dw[7 + t / 2] >> ((t & 1) * 16);
+        uint8_t cmd = type >> 8;
+
+        switch (type & 0xFF) {
+            case 12: sectorCmd = cmd; break;
+            case 15: block32Cmd = cmd; break;
+            case 16: block64Cmd = cmd; break;
+            default: break;
+        }
+    }
+    // DWORD 1: 4 KB erase opcode, the only erase information of early tables
+    if (sectorCmd == 0 && (dw[0] & 0x03) == 0x01) {
+        sectorCmd = (dw[0] >> 8) & 0xFF;
+    }
+    if (sectorCmd == 0) return false;   // The driver erases in 4 KB sectors
+
+    // DWORD 1 bits 18:17: 00 = 3-byte addresses only
+    if (((dw[0] >> 17) & 0x03) == 0 && capacity > W25Q64_3BYTE_LIMIT) {
+        capacity = W25Q64_3BYTE_LIMIT;
+    }
+
+    W25Q64_Info.capacity = capacity;
+    W25Q64_Info.sectorEraseCmd = sectorCmd;
+    W25Q64_Info.block32EraseCmd = block32Cmd;
+    W25Q64_Info.block64EraseCmd = block64Cmd;
+    // DWORD 11 bits 7:4: page size 2^N, 256 bytes before JESD216A
+    W25Q64_Info.pageSize = (words >= 11) ? 1U << ((dw[10] >> 4) & 0x0F) : 256;
+    if (words >= 16) *enter4Byte = dw[15] >> 24;
+
+    return true;
+}
+
+/**
+ * @brief Read from the SFDP area (0x5A)
+ * 
+ * Always 3 address bytes and 8 dummy clocks, whatever the address mode.
+ * 
+ * @param addr SFDP address
+ * @param dataArr Pointer to buffer for storing read data
+ * @param len Number of bytes to read
+ */
+void W25Q64_ReadSFDP(uint32_t addr, uint8_t *dataArr, uint16_t len)
+{
+    W25Q64_Sync();
+
+    W25Q64_Select();
+    Hard_SPI_TransferByte(W25Q64_READ_SFDP_REGISTER);
+    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
+    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
+    Hard_SPI_TransferByte(addr);            // Send address byte 0
+    Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);
+    for (uint16_t i = 0; i < len; i++) {
+        dataArr[i] = Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);
+    }
+    SPI_Bus_Stop();
+}
+
+/**
+ * @brief Get the parameters of the detected flash
+ * 
+ * @return const W25Q64_Geometry* Valid after W25Q64_Init()
+ */
+const W25Q64_Geometry *W25Q64_GetGeometry(void)
+{
+    return &W25Q64_Info;
+}
+
+/**
+ * @brief Select the fastest working SPI clock for the W25Q64
+ * 
+ * Reads the JEDEC ID and a data block at the safe prescaler as reference
+ * pattern, then steps down through W25Q64_ClockSteps until both read back
+ * identically. Nothing is written to the flash. If no device answers (ID
+ * 0x00 or 0xFF) the safe prescaler is kept.
+ * 
+ * @return uint16_t Selected SPI_BaudRatePrescaler_x value
+ */
+uint16_t W25Q64_NegotiateClock(void)
+{
+    uint8_t refData[W25Q64_SELFTEST_LEN];
+    uint8_t testData[W25Q64_SELFTEST_LEN];
+    uint8_t refMID, testMID;
+    uint16_t refDID, testDID;
+
+    // Reference pattern at the safe clock
+    SPI_Bus_SetPrescaler(&W25Q64_Device, W25Q64_SAFE_PRESCALER);
+    W25Q64_ReadID(&refMID, &refDID);
+    if (refMID == 0x00 || refMID == 0xFF) {
+        return W25Q64_SAFE_PRESCALER;   // No device, stay slow
+    }
+    W25Q64_ReadData(W25Q64_SELFTEST_ADDR, refData, W25Q64_SELFTEST_LEN);
+
+    // Step down from the fastest clock until readback matches
+    for (uint8_t i = 0; i < sizeof(W25Q64_ClockSteps) / sizeof(W25Q64_ClockSteps[0]); i++) {
+        uint16_t prescaler = W25Q64_ClockSteps[i];
+
+        SPI_Bus_SetPrescaler(&W25Q64_Device, prescaler);
+
+        W25Q64_ReadID(&testMID, &testDID);
+        W25Q64_ReadData(W25Q64_SELFTEST_ADDR, testData, W25Q64_SELFTEST_LEN);
+
+        if (testMID == refMID && testDID == refDID &&
+            memcmp(testData, refData, W25Q64_SELFTEST_LEN) == 0) {
+            return prescaler;
+        }
+    }
+
+    SPI_Bus_SetPrescaler(&W25Q64_Device, W25Q64_SAFE_PRESCALER);
+    return W25Q64_SAFE_PRESCALER;
 }
 
 /**
@@ -26,25 +363,29 @@ void W25Q64_Init(void)
  */
 void W25Q64_ReadID(uint8_t* MID, uint16_t* DID)
 {
-    Hard_SPI_Start();
+    W25Q64_Select();
     Hard_SPI_TransferByte(W25Q64_JEDEC_ID);     // Send JEDEC ID command
     *MID = Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);    // Read Manufacturer ID
     *DID = Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);    // Read Device ID MSB
     *DID <<= 8;
     *DID |= Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);   // Read Device ID LSB
-    Hard_SPI_Stop();
+    SPI_Bus_Stop();
 }
 
 /**
  * @brief Send Write Enable command to W25Q64
  * 
- * Must be called before any write, program, or erase operation.
+ * Must be called before any write, program, or erase operation. A pending
+ * asynchronous operation is completed first, the device ignores new write
+ * commands while it is busy.
  */
 void W25Q64_WriteEnable(void)
 {
-    Hard_SPI_Start();
+    W25Q64_Sync();
+
+    W25Q64_Select();
     Hard_SPI_TransferByte(W25Q64_WRITE_ENABLE);
-    Hard_SPI_Stop();
+    SPI_Bus_Stop();
 }
 
 /**
@@ -54,37 +395,143 @@ void W25Q64_WriteEnable(void)
  */
 void W25Q64_WaitBusy(void)
 {
-    Hard_SPI_Start();
+    W25Q64_Select();
     Hard_SPI_TransferByte(W25Q64_READ_STATUS_REG1);
     // Wait while BUSY bit (bit 0) is set
     while (Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE) & 0x01);
-    Hard_SPI_Stop();
+    SPI_Bus_Stop();
 }
 
 /**
  * @brief Program a page (up to 256 bytes) in W25Q64
  * 
+ * The device wraps around inside the 256-byte page if addr + len crosses a
+ * page boundary; use W25Q64_Write() for arbitrary ranges.
+ * 
+ * @param addr Starting address for page program (24-bit)
+ * @param dataArr Pointer to data array to program
+ * @param len Number of bytes to program (1-256)
+ */
+void W25Q64_PageProgram(uint32_t addr, const uint8_t *dataArr, uint16_t len)
+{
+    W25Q64_PageProgramStart(addr, dataArr, len);
+    W25Q64_WaitBusy();  // Wait for programming to complete
+}
+
+/**
+ * @brief Send a page program command and its data without waiting
+ * 
  * @param addr Starting address for page program (24-bit)
  * @param dataArr Pointer to data array to program
  * @param len Number of bytes to program (1-256)
  */
-void W25Q64_PageProgram(uint32_t addr, uint8_t *dataArr, uint16_t len)
+static void W25Q64_PageProgramStart(uint32_t addr, const uint8_t *dataArr, uint16_t len)
 {
+    W25Q64_Cache_Invalidate(addr & ~(uint32_t)(W25Q64_PAGE_SIZE - 1), W25Q64_PAGE_SIZE);
     W25Q64_WriteEnable();   // Enable write operations
 
-    Hard_SPI_Start();
-    Hard_SPI_TransferByte(W25Q64_PAGE_PROGRAM);     // Send page program command
-    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
-    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
-    Hard_SPI_TransferByte(addr);            // Send address byte 0
+    W25Q64_Select();
+    W25Q64_SendCommand(W25Q64_PAGE_PROGRAM, addr);  // Send page program command and address
 
     // Send data bytes
-    for (uint16_t i = 0; i < len; i++) {
-        Hard_SPI_TransferByte(dataArr[i]);
+    if (len > W25Q64_DMAThreshold) {
+        Hard_SPI_DMA_Transfer(dataArr, 0, len);
+    } else {
+        for (uint16_t i = 0; i < len; i++) {
+            Hard_SPI_TransferByte(dataArr[i]);
+        }
     }
 
-    Hard_SPI_Stop();
-    W25Q64_WaitBusy();  // Wait for programming to complete
+    SPI_Bus_Stop();
+}
+
+/**
+ * @brief Program an arbitrary range split on page boundaries
+ * 
+ * Pages that would only be programmed with 0xFF are skipped, they already
+ * hold that value after an erase.
+ * 
+ * @param addr Starting address (24-bit)
+ * @param dataArr Pointer to data array to program
+ * @param len Number of bytes to program
+ */
+static void W25Q64_ProgramPages(uint32_t addr, const uint8_t *dataArr, uint32_t len)
+{
+    while (len > 0) {
+        uint16_t chunk = W25Q64_PAGE_SIZE - (addr % W25Q64_PAGE_SIZE);
+        if (chunk > len) chunk = len;
+
+        for (uint16_t i = 0; i < chunk; i++) {
+            if (dataArr[i] != 0xFF) {
+                W25Q64_PageProgram(addr, dataArr, chunk);
+                break;
+            }
+        }
+
+        addr += chunk;
+        dataArr += chunk;
+        len -= chunk;
+    }
+}
+
+/**
+ * @brief Write an arbitrary range to W25Q64, erasing only when necessary
+ * 
+ * The range is processed sector by sector. For each sector the current
+ * content of the target range is read and compared:
+ * - identical: nothing is written
+ * - only 1->0 bit transitions: the range is programmed in place
+ * - any 0->1 transition: the sector is read into RAM, merged, erased and
+ *   reprogrammed (read-modify-write)
+ * Page boundaries are handled, so any offset and length is safe.
+ * 
+ * @param addr Starting address (24-bit)
+ * @param dataArr Pointer to data array to write
+ * @param len Number of bytes to write
+ */
+void W25Q64_Write(uint32_t addr, const uint8_t *dataArr, uint32_t len)
+{
+    while (len > 0) {
+        uint32_t sectorAddr = addr & ~(uint32_t)(W25Q64_SECTOR_SIZE - 1);
+        uint32_t offset = addr - sectorAddr;
+        uint32_t chunk = W25Q64_SECTOR_SIZE - offset;
+        bool changed = false;
+        bool needErase = false;
+
+        if (chunk > len) chunk = len;
+
+        // Compare the target range against the current flash content
+        W25Q64_ReadData(addr, &W25Q64_SectorBuffer[offset], chunk);
+        for (uint32_t i = 0; i < chunk; i++) {
+            uint8_t old = W25Q64_SectorBuffer[offset + i];
+            if (old != dataArr[i]) changed = true;
+            if ((old & dataArr[i]) != dataArr[i]) {
+                needErase = true;   // A 0 bit would have to become 1
+                break;
+            }
+        }
+
+        if (needErase) {
+            // Read the rest of the sector, merge, erase and reprogram
+            if (offset > 0) {
+                W25Q64_ReadData(sectorAddr, W25Q64_SectorBuffer, offset);
+            }
+            if (offset + chunk < W25Q64_SECTOR_SIZE) {
+                W25Q64_ReadData(addr + chunk, &W25Q64_SectorBuffer[offset + chunk],
+                                W25Q64_SECTOR_SIZE - offset - chunk);
+            }
+            memcpy(&W25Q64_SectorBuffer[offset], dataArr, chunk);
+
+            W25Q64_EraseSector(sectorAddr);
+            W25Q64_ProgramPages(sectorAddr, W25Q64_SectorBuffer, W25Q64_SECTOR_SIZE);
+        } else if (changed) {
+            W25Q64_ProgramPages(addr, dataArr, chunk);
+        }
+
+        addr += chunk;
+        dataArr += chunk;
+        len -= chunk;
+    }
 }
 
 /**
@@ -94,16 +541,23 @@ void W25Q64_PageProgram(uint32_t addr, uint8_t *dataArr, uint16_t len)
  */
 void W25Q64_EraseSector(uint32_t addr)
 {
-    W25Q64_WriteEnable();   // Enable write operations
+    W25Q64_EraseSectorStart(addr);
+    W25Q64_WaitBusy();  // Wait for erase to complete
+}
 
-    Hard_SPI_Start();
-    Hard_SPI_TransferByte(W25Q64_SECTOR_ERASE);     // Send sector erase command
-    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
-    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
-    Hard_SPI_TransferByte(addr);            // Send address byte 0
-    Hard_SPI_Stop();
+/**
+ * @brief Send a sector erase command without waiting
+ * 
+ * @param addr Any address within the 4KB sector to erase
+ */
+static void W25Q64_EraseSectorStart(uint32_t addr)
+{
+    W25Q64_Cache_Invalidate(addr & ~(uint32_t)(W25Q64_SECTOR_SIZE - 1), W25Q64_SECTOR_SIZE);
+    W25Q64_WriteEnable();   // Enable write operations
 
-    W25Q64_WaitBusy();  // Wait for erase to complete
+    W25Q64_Select();
+    W25Q64_SendCommand(W25Q64_Info.sectorEraseCmd, addr);   // Send sector erase command and address
+    SPI_Bus_Stop();
 }
 
 /**
@@ -113,11 +567,12 @@ void W25Q64_EraseSector(uint32_t addr)
  */
 void W25Q64_EraseChip(void)
 {
+    W25Q64_Cache_InvalidateAll();
     W25Q64_WriteEnable();   // Enable write operations
 
-    Hard_SPI_Start();
+    W25Q64_Select();
     Hard_SPI_TransferByte(W25Q64_CHIP_ERASE);   // Send chip erase command
-    Hard_SPI_Stop();
+    SPI_Bus_Stop();
 
     W25Q64_WaitBusy();  // Wait for chip erase to complete
 }
@@ -129,14 +584,19 @@ void W25Q64_EraseChip(void)
  */
 void W25Q64_EraseBlock64K(uint32_t addr)
 {
+    if (W25Q64_Info.block64EraseCmd == 0) {
+        // No 64KB erase on this part, erase its sectors
+        addr &= ~(uint32_t)0xFFFF;
+        for (uint32_t i = 0; i < 0x10000; i += W25Q64_SECTOR_SIZE) W25Q64_EraseSector(addr + i);
+        return;
+    }
+
+    W25Q64_Cache_Invalidate(addr & ~(uint32_t)0xFFFF, 0xFFFF + 1);
     W25Q64_WriteEnable();   // Enable write operations
 
-    Hard_SPI_Start();
-    Hard_SPI_TransferByte(W25Q64_BLOCK_ERASE_64K);  // Send 64KB block erase command
-    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
-    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
-    Hard_SPI_TransferByte(addr);            // Send address byte 0
-    Hard_SPI_Stop();
+    W25Q64_Select();
+    W25Q64_SendCommand(W25Q64_Info.block64EraseCmd, addr);  // Send 64KB block erase command and address
+    SPI_Bus_Stop();
 
     W25Q64_WaitBusy();  // Wait for erase to complete
 }
@@ -148,18 +608,103 @@ void W25Q64_EraseBlock64K(uint32_t addr)
  */
 void W25Q64_EraseBlock32K(uint32_t addr)
 {
+    if (W25Q64_Info.block32EraseCmd == 0) {
+        // No 32KB erase on this part, erase its sectors
+        addr &= ~(uint32_t)0x7FFF;
+        for (uint32_t i = 0; i < 0x8000; i += W25Q64_SECTOR_SIZE) W25Q64_EraseSector(addr + i);
+        return;
+    }
+
+    W25Q64_Cache_Invalidate(addr & ~(uint32_t)0x7FFF, 0x7FFF + 1);
     W25Q64_WriteEnable();   // Enable write operations
 
-    Hard_SPI_Start();
-    Hard_SPI_TransferByte(W25Q64_BLOCK_ERASE_32K);  // Send 32KB block erase command
-    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
-    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
-    Hard_SPI_TransferByte(addr);            // Send address byte 0
-    Hard_SPI_Stop();
+    W25Q64_Select();
+    W25Q64_SendCommand(W25Q64_Info.block32EraseCmd, addr);  // Send 32KB block erase command and address
+    SPI_Bus_Stop();
 
     W25Q64_WaitBusy();  // Wait for erase to complete
 }
 
+/**
+ * @brief Build a command followed by a 3- or 4-byte address
+ * 
+ * @param cmd Command byte
+ * @param addr Address, 4 bytes are sent once the part is in 4-byte mode
+ * @param header Destination, at least 5 bytes
+ * @return uint8_t Number of bytes
+ */
+static uint8_t W25Q64_BuildCommand(uint8_t cmd, uint32_t addr, uint8_t *header)
+{
+    uint8_t n = 0;
+
+    header[n++] = cmd;
+    if (W25Q64_Info.addrBytes == 4) {
+        header[n++] = addr >> 24;       // Address byte 3
+    }
+    header[n++] = addr >> 16;           // Address byte 2
+    header[n++] = addr >> 8;            // Address byte 1
+    header[n++] = addr;                 // Address byte 0
+
+    return n;
+}
+
+/**
+ * @brief Send a command and its address, CS must already be low
+ * 
+ * @param cmd Command byte
+ * @param addr Address
+ */
+static void W25Q64_SendCommand(uint8_t cmd, uint32_t addr)
+{
+    uint8_t header[5];
+    uint8_t n = W25Q64_BuildCommand(cmd, addr, header);
+
+    for (uint8_t i = 0; i < n; i++) {
+        Hard_SPI_TransferByte(header[i]);
+    }
+}
+
+/**
+ * @brief Build the command and address bytes of a read transaction
+ * 
+ * Uses Fast Read (0x0B) followed by one dummy byte when the detected part
+ * supports it, plain Read Data (0x03) otherwise.
+ * 
+ * @param addr Starting address to read from
+ * @param header Destination, at least 6 bytes
+ * @return uint8_t Number of header bytes
+ */
+static uint8_t W25Q64_BuildReadHeader(uint32_t addr, uint8_t *header)
+{
+    uint8_t n;
+
+    if (W25Q64_Info.fastRead) {
+        n = W25Q64_BuildCommand(W25Q64_FAST_READ, addr, header);
+        header[n++] = W25Q64_DUMMY_BYTE;    // 8 dummy clocks
+    } else {
+        n = W25Q64_BuildCommand(W25Q64_READ_DATA, addr, header);
+    }
+
+    return n;
+}
+
+/**
+ * @brief Send the read command and address of a read transaction
+ * 
+ * CS must already be low.
+ * 
+ * @param addr Starting address to read from
+ */
+static void W25Q64_SendReadHeader(uint32_t addr)
+{
+    uint8_t header[6];
+    uint8_t n = W25Q64_BuildReadHeader(addr, header);
+
+    for (uint8_t i = 0; i < n; i++) {
+        Hard_SPI_TransferByte(header[i]);
+    }
+}
+
 /**
  * @brief Read data from W25Q64 flash memory
  * 
@@ -169,16 +714,409 @@ void W25Q64_EraseBlock32K(uint32_t addr)
  */
 void W25Q64_ReadData(uint32_t addr, uint8_t* dataArr, uint32_t len)
 {
-    Hard_SPI_Start();
-    Hard_SPI_TransferByte(W25Q64_READ_DATA);    // Send read data command
-    Hard_SPI_TransferByte(addr >> 16);      // Send address byte 2
-    Hard_SPI_TransferByte(addr >> 8);       // Send address byte 1
-    Hard_SPI_TransferByte(addr);            // Send address byte 0
+    bool held = W25Q64_SuspendForRead();
+
+    W25Q64_Select();
+    W25Q64_SendReadHeader(addr);
 
     // Read data bytes
-    for (uint32_t i = 0; i < len; i++) {
-        dataArr[i] = Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);
+    if (len > W25Q64_DMAThreshold) {
+        // DMA counter is 16-bit, split very long reads
+        while (len > 0) {
+            uint16_t chunk = (len > 0xFFFF) ? 0xFFFF : len;
+            Hard_SPI_DMA_Transfer(0, dataArr, chunk);
+            dataArr += chunk;
+            len -= chunk;
+        }
+    } else {
+        for (uint32_t i = 0; i < len; i++) {
+            dataArr[i] = Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);
+        }
+    }
+
+    SPI_Bus_Stop();
+
+    if (held) W25Q64_ResumeAfterRead();
+}
+
+/**
+ * @brief Completion callback of the W25Q64_ReadDataAsync() transaction
+ * 
+ * Runs from the SPI DMA interrupt with CS already raised; the bus manager
+ * lets a callback use the bus, which the resume command needs.
+ */
+static void W25Q64_ReadDataAsyncDone(SPI_Bus_Transaction *txn)
+{
+    Hard_SPI_Callback callback = W25Q64_AsyncCallback;
+
+    (void)txn;
+    if (W25Q64_ReadHoldsSuspend) W25Q64_ResumeAfterRead();
+    W25Q64_ReadPending = false;
+
+    if (callback != 0) {
+        callback();
+    }
+}
+
+/**
+ * @brief Start a non-blocking read from W25Q64 flash memory
+ * 
+ * The read is queued on the SPI bus manager: command and address are sent
+ * polled, the data phase runs on DMA. A pending erase/program is suspended
+ * for the read and resumed in the completion callback. Only one read can be
+ * pending at a time.
+ * 
+ * @param addr Starting address to read from (24-bit)
+ * @param dataArr Pointer to buffer for storing read data, valid until callback
+ * @param len Number of bytes to read (1-65535)
+ * @param callback Called from the DMA interrupt once data is in dataArr
+ * @return true Read queued
+ * @return false A read is still pending, the bus queue is full or len is zero
+ */
+bool W25Q64_ReadDataAsync(uint32_t addr, uint8_t* dataArr, uint16_t len, Hard_SPI_Callback callback)
+{
+    if (len == 0 || W25Q64_ReadPending) return false;
+
+    W25Q64_Wake();      // The queued transaction bypasses W25Q64_Select()
+    W25Q64_ReadHoldsSuspend = W25Q64_SuspendForRead();
+
+    W25Q64_AsyncCallback = callback;
+    W25Q64_ReadTxn.device = &W25Q64_Device;
+    W25Q64_ReadTxn.headerLen = W25Q64_BuildReadHeader(addr, W25Q64_ReadTxn.header);
+    W25Q64_ReadTxn.txData = 0;
+    W25Q64_ReadTxn.rxData = dataArr;
+    W25Q64_ReadTxn.len = len;
+    W25Q64_ReadTxn.callback = W25Q64_ReadDataAsyncDone;
+    W25Q64_ReadPending = true;
+
+    if (!SPI_Bus_Submit(&W25Q64_ReadTxn)) {
+        W25Q64_ReadPending = false;
+        if (W25Q64_ReadHoldsSuspend) W25Q64_ResumeAfterRead();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Read a status register
+ * 
+ * @param cmd W25Q64_READ_STATUS_REG1 or W25Q64_READ_STATUS_REG2
+ * @return uint8_t Status register value
+ */
+static uint8_t W25Q64_ReadStatus(uint8_t cmd)
+{
+    uint8_t status;
+
+    W25Q64_Select();
+    Hard_SPI_TransferByte(cmd);
+    status = Hard_SPI_TransferByte(W25Q64_DUMMY_BYTE);
+    SPI_Bus_Stop();
+
+    return status;
+}
+
+/**
+ * @brief Suspend a pending erase/program so that a read can proceed
+ * 
+ * Issues Erase/Program Suspend (0x75) if the device is still busy with an
+ * asynchronous operation and waits the suspend latency (BUSY clears within
+ * tSUS, 20 us). Consecutive suspends are spaced by at least tSUS after the
+ * last resume, otherwise a stream of reads could starve the erase.
+ *
+ * An operation already suspended by another read (a queued async read) is
+ * shared: every read that gets true here holds one reference and must call
+ * W25Q64_ResumeAfterRead(); the last one resumes the device.
+ *
+ * @return true The caller holds a suspend reference
+ * @return false Nothing to suspend
+ */
+static bool W25Q64_SuspendForRead(void)
+{
+    uint32_t primask;
+
+    if (W25Q64_PendingOp == W25Q64_OP_NONE) return false;
+
+    // The async read callback drops its reference from the DMA interrupt
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (W25Q64_Suspended) {
+        W25Q64_SuspendRefs++;
+        __set_PRIMASK(primask);
+        return true;
+    }
+    __set_PRIMASK(primask);
+
+    if ((W25Q64_ReadStatus(W25Q64_READ_STATUS_REG1) & W25Q64_SR1_BUSY) == 0) {
+        W25Q64_PendingOp = W25Q64_OP_NONE;  // Finished in the meantime
+        return false;
+    }
+
+    if (W25Q64_ResumeTick == W25Q64_TickCount) {
+        Delay_us(W25Q64_SUSPEND_HOLDOFF_US);
     }
 
-    Hard_SPI_Stop();
+    W25Q64_Select();
+    Hard_SPI_TransferByte(W25Q64_ERASE_PROGRAM_SUSPEND);
+    SPI_Bus_Stop();
+
+    W25Q64_WaitBusy();  // BUSY clears once the device is suspended
+
+    // SUS stays clear if the operation completed before the suspend took effect
+    if (W25Q64_ReadStatus(W25Q64_READ_STATUS_REG2) & W25Q64_SR2_SUS) {
+        W25Q64_SuspendRefs = 1;
+        W25Q64_Suspended = true;
+        return true;
+    }
+
+    W25Q64_PendingOp = W25Q64_OP_NONE;
+    return false;
+}
+
+/**
+ * @brief Drop a reference from W25Q64_SuspendForRead(), the last one resumes
+ */
+static void W25Q64_ResumeAfterRead(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (!W25Q64_Suspended || --W25Q64_SuspendRefs > 0) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    __set_PRIMASK(primask);
+
+    W25Q64_Select();
+    Hard_SPI_TransferByte(W25Q64_ERASE_PROGRAM_RESUME);
+    SPI_Bus_Stop();
+
+    W25Q64_Suspended = false;
+    W25Q64_ResumeTick = W25Q64_TickCount;
+}
+
+/**
+ * @brief Start programming a page without waiting for completion
+ * 
+ * The data phase is shifted out immediately; the internal program time
+ * (up to 3 ms) runs in the background and is tracked by W25Q64_Process().
+ * 
+ * @param addr Starting address for page program (24-bit)
+ * @param dataArr Pointer to data array to program (may be reused on return)
+ * @param len Number of bytes to program (1-256)
+ * @return true Program started
+ * @return false Another asynchronous operation is still pending
+ */
+bool W25Q64_PageProgramAsync(uint32_t addr, const uint8_t *dataArr, uint16_t len)
+{
+    if (W25Q64_IsBusy()) return false;
+
+    W25Q64_PageProgramStart(addr, dataArr, len);
+    W25Q64_PendingOp = W25Q64_OP_PROGRAM;
+    W25Q64_PollDue = 0;
+
+    return true;
+}
+
+/**
+ * @brief Start erasing a 4KB sector without waiting for completion
+ * 
+ * The erase (up to 400 ms) runs in the background. Reads issued meanwhile
+ * suspend and resume it transparently.
+ * 
+ * @param addr Any address within the 4KB sector to erase
+ * @return true Erase started
+ * @return false Another asynchronous operation is still pending
+ */
+bool W25Q64_EraseSectorAsync(uint32_t addr)
+{
+    if (W25Q64_IsBusy()) return false;
+
+    W25Q64_EraseSectorStart(addr);
+    W25Q64_PendingOp = W25Q64_OP_ERASE;
+    W25Q64_PollDue = 0;
+
+    return true;
+}
+
+/**
+ * @brief Check if an asynchronous erase/program is still pending
+ * 
+ * Uses the state tracked by W25Q64_Process(), no SPI traffic.
+ * 
+ * @return true Operation pending, new async requests are refused
+ * @return false Device idle
+ */
+bool W25Q64_IsBusy(void)
+{
+    return W25Q64_PendingOp != W25Q64_OP_NONE;
+}
+
+/**
+ * @brief Wait until a pending asynchronous operation has completed
+ * 
+ * Blocking counterpart of W25Q64_Process(), for callers that need the device
+ * idle right now regardless of the scheduler tick. A suspended device reads
+ * BUSY = 0, so a queued read holding the suspend is let finish first (its
+ * callback resumes the operation). Must not be called from that callback.
+ */
+void W25Q64_Sync(void)
+{
+    if (W25Q64_PendingOp == W25Q64_OP_NONE) return;
+
+    while (W25Q64_ReadPending || W25Q64_Suspended);
+
+    W25Q64_WaitBusy();
+    W25Q64_PendingOp = W25Q64_OP_NONE;
+}
+
+/**
+ * @brief Track asynchronous operations, call from the main loop
+ * 
+ * Reads status register 1 at most once per W25Q64_Tick() and clears the
+ * pending operation when BUSY has dropped. Puts the idle flash into deep
+ * power-down. Never blocks.
+ */
+void W25Q64_Process(void)
+{
+#if W25Q64_POWERDOWN_IDLE_MS > 0
+    if (W25Q64_PendingOp == W25Q64_OP_NONE && !W25Q64_PoweredDown &&
+        W25Q64_IdleTicks >= W25Q64_POWERDOWN_IDLE_MS && !SPI_Bus_IsBusy()) {
+        W25Q64_PowerDown();
+        return;
+    }
+#endif
+
+    if (W25Q64_PendingOp == W25Q64_OP_NONE || !W25Q64_PollDue) return;
+    if (SPI_Bus_IsBusy()) return;       // Queued transfer owns the bus
+    if (W25Q64_Suspended) return;       // BUSY reads 0 while suspended
+
+    W25Q64_PollDue = 0;
+
+    if ((W25Q64_ReadStatus(W25Q64_READ_STATUS_REG1) & W25Q64_SR1_BUSY) == 0) {
+        W25Q64_PendingOp = W25Q64_OP_NONE;
+    }
+}
+
+/**
+ * @brief 1 ms scheduler tick, call from the timer interrupt
+ * 
+ * Only updates counters; all SPI traffic stays in W25Q64_Process().
+ */
+void W25Q64_Tick(void)
+{
+    W25Q64_TickCount++;
+    W25Q64_PollDue = 1;
+
+    W25Q64_IdleTicks++;
+    if (W25Q64_PoweredDown) {
+        W25Q64_Power.powerDownMs++;
+    } else {
+        W25Q64_Power.activeMs++;
+    }
+}
+
+/**
+ * @brief Completion callback of the benchmark's async read
+ */
+static void W25Q64_BenchReadDone(void)
+{
+    W25Q64_BenchEnd = DWT_CYCCNT;
+    W25Q64_BenchDone = true;
+}
+
+/**
+ * @brief Idle loop of the benchmark, counts iterations until the read is done
+ * 
+ * @param limit Iteration limit, for calibrating the loop
+ * @return uint32_t Iterations run
+ */
+static uint32_t W25Q64_BenchIdle(uint32_t limit)
+{
+    uint32_t n = 0;
+
+    while (!W25Q64_BenchDone && n < limit) n++;
+    return n;
+}
+
+/**
+ * @brief Time 16 page programs of the scratch sector, erased first
+ * 
+ * @param cpu Destination for the cycles spent in the command and data phase
+ * @return uint32_t Cycles until the last page is programmed
+ */
+static uint32_t W25Q64_BenchProgram(uint32_t *cpu)
+{
+    uint32_t total = 0;
+
+    *cpu = 0;
+    W25Q64_EraseSector(W25Q64_BENCH_ADDR);
+    for (uint32_t offset = 0; offset < W25Q64_BENCH_SIZE; offset += W25Q64_PAGE_SIZE) {
+        uint32_t start = DWT_CYCCNT;
+        W25Q64_PageProgramAsync(W25Q64_BENCH_ADDR + offset, &W25Q64_SectorBuffer[offset], W25Q64_PAGE_SIZE);
+        *cpu += DWT_CYCCNT - start;
+        W25Q64_Sync();
+        total += DWT_CYCCNT - start;
+    }
+
+    return total;
+}
+
+/**
+ * @brief Measure read and page program throughput, polled and DMA
+ * 
+ * Uses the DWT cycle counter. The byte loop is forced by raising the DMA
+ * threshold for the run. The async read is timed from the call to its
+ * callback; its CPU share is the total minus the idle loop iterations,
+ * calibrated beforehand, so interrupt handlers count as busy. Page programs
+ * include tPP; their CPU share is the command and data phase, the program
+ * time itself leaves the CPU free with W25Q64_PageProgramAsync().
+ * 
+ * Erases and reprograms W25Q64_BENCH_ADDR, and uses the read-modify-write
+ * sector buffer, so call it from the main loop with no W25Q64_Write() active.
+ * Timer interrupts stay enabled and are included in the figures.
+ * 
+ * @param result Destination
+ */
+void W25Q64_Benchmark(W25Q64_BenchResult *result)
+{
+    uint32_t start, idle, calibration;
+
+    DWT_Init();
+    W25Q64_Sync();
+
+    // Reads: byte loop, blocking DMA, async DMA
+    W25Q64_DMAThreshold = 0xFFFFFFFF;
+    start = DWT_CYCCNT;
+    W25Q64_ReadData(W25Q64_BENCH_ADDR, W25Q64_SectorBuffer, W25Q64_BENCH_SIZE);
+    result->readPolled = DWT_CYCCNT - start;
+
+    W25Q64_DMAThreshold = W25Q64_DMA_THRESHOLD;
+    start = DWT_CYCCNT;
+    W25Q64_ReadData(W25Q64_BENCH_ADDR, W25Q64_SectorBuffer, W25Q64_BENCH_SIZE);
+    result->readDMA = DWT_CYCCNT - start;
+
+    W25Q64_BenchDone = false;
+    start = DWT_CYCCNT;
+    W25Q64_BenchIdle(1000);
+    calibration = DWT_CYCCNT - start;       // Cycles per 1000 idle iterations
+
+    start = DWT_CYCCNT;
+    if (W25Q64_ReadDataAsync(W25Q64_BENCH_ADDR, W25Q64_SectorBuffer, W25Q64_BENCH_SIZE, W25Q64_BenchReadDone)) {
+        idle = W25Q64_BenchIdle(0xFFFFFFFF);
+        result->readAsync = W25Q64_BenchEnd - start;
+        result->readAsyncCpu = result->readAsync - (uint32_t)((uint64_t)idle * calibration / 1000);
+    } else {
+        result->readAsync = 0;
+        result->readAsyncCpu = 0;
+    }
+
+    // Page programs: byte loop, then DMA data phase; not 0xFF so every bit cell is written
+    for (uint32_t i = 0; i < W25Q64_BENCH_SIZE; i++) {
+        W25Q64_SectorBuffer[i] = (uint8_t)i;
+    }
+    W25Q64_DMAThreshold = 0xFFFFFFFF;
+    result->programPolled = W25Q64_BenchProgram(&result->programPolledCpu);
+    W25Q64_DMAThreshold = W25Q64_DMA_THRESHOLD;
+    result->programDMA = W25Q64_BenchProgram(&result->programDMACpu);
 }
@@ -0,0 +1,208 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_Cache.c
+ * @brief  Line-based RAM read cache in front of W25Q64_ReadData - Source File
+ *
+ * Fully associative, least recently used replacement. A miss on the line
+ * right after the previously accessed one is treated as a sequential run
+ * and fetches W25Q64_CACHE_READAHEAD lines with a single command, so a
+ * linear scan pays the command header once per run instead of per line.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 16:02:17
+ ********************************************************************************/
+
+#include "W25Q64_Cache.h"
+#include "W25Q64.h"
+#include <string.h>
+
+#define W25Q64_CACHE_VALID          0x01    // Tag bit 0, line addresses are aligned
+#define W25Q64_CACHE_LINE_MASK      (~(uint32_t)(W25Q64_CACHE_LINE_SIZE - 1))
+
+#if (W25Q64_CACHE_LINE_SIZE & (W25Q64_CACHE_LINE_SIZE - 1)) || W25Q64_CACHE_LINE_SIZE < 2
+#error "W25Q64_CACHE_LINE_SIZE must be a power of two"
+#endif
+
+#if W25Q64_CACHE_LINES > 8
+#error "W25Q64_Cache_Ahead holds one bit per line"
+#endif
+
+static uint8_t W25Q64_Cache_Data[W25Q64_CACHE_LINES][W25Q64_CACHE_LINE_SIZE];
+static uint32_t W25Q64_Cache_Tag[W25Q64_CACHE_LINES];      // Line address | VALID, 0 = empty
+static uint16_t W25Q64_Cache_Stamp[W25Q64_CACHE_LINES];    // Last use, for LRU
+static uint16_t W25Q64_Cache_Clock;
+static uint8_t W25Q64_Cache_Ahead;                          // Read-ahead lines not used yet
+static uint32_t W25Q64_Cache_NextLine = W25Q64_CACHE_VALID; // Never matches a line address
+static W25Q64_Cache_Stats W25Q64_Cache_Counters;
+
+/**
+ * @brief Find a cached line
+ *
+ * @return int8_t Line index, -1 on miss
+ */
+static int8_t W25Q64_Cache_Lookup(uint32_t lineAddr)
+{
+    for (uint8_t i = 0; i < W25Q64_CACHE_LINES; i++) {
+        if (W25Q64_Cache_Tag[i] == (lineAddr | W25Q64_CACHE_VALID)) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Pick the line to replace: an empty one, else the least recently used
+ */
+static uint8_t W25Q64_Cache_Victim(void)
+{
+    uint8_t victim = 0;
+    uint16_t oldest = 0;
+
+    for (uint8_t i = 0; i < W25Q64_CACHE_LINES; i++) {
+        uint16_t age = W25Q64_Cache_Clock - W25Q64_Cache_Stamp[i];
+
+        if (W25Q64_Cache_Tag[i] == 0) return i;
+        if (age >= oldest) {
+            oldest = age;
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+/**
+ * @brief Load a missing line, plus read-ahead lines on a sequential run
+ *
+ * Read-ahead lines go into the slots following the victim so the whole
+ * fetch is one W25Q64_ReadData() into contiguous RAM.
+ *
+ * @return uint8_t Index of the line holding lineAddr
+ */
+static uint8_t W25Q64_Cache_Fill(uint32_t lineAddr)
+{
+    uint8_t victim = W25Q64_Cache_Victim();
+    uint8_t count = 1;
+
+    if (lineAddr == W25Q64_Cache_NextLine) {
+        count = W25Q64_CACHE_READAHEAD;
+        if (victim + count > W25Q64_CACHE_LINES) count = W25Q64_CACHE_LINES - victim;
+    }
+
+    // A line must never be cached twice
+    for (uint8_t k = 1; k < count; k++) {
+        int8_t dup = W25Q64_Cache_Lookup(lineAddr + k * W25Q64_CACHE_LINE_SIZE);
+        if (dup >= 0) W25Q64_Cache_Tag[dup] = 0;
+    }
+
+    W25Q64_ReadData(lineAddr, W25Q64_Cache_Data[victim], (uint32_t)count * W25Q64_CACHE_LINE_SIZE);
+
+    for (uint8_t k = 0; k < count; k++) {
+        W25Q64_Cache_Tag[victim + k] = (lineAddr + k * W25Q64_CACHE_LINE_SIZE) | W25Q64_CACHE_VALID;
+        W25Q64_Cache_Stamp[victim + k] = W25Q64_Cache_Clock;
+        if (k) {
+            W25Q64_Cache_Ahead |= 1 << (victim + k);
+            W25Q64_Cache_Counters.readAheads++;
+        }
+    }
+    W25Q64_Cache_Ahead &= ~(1 << victim);
+
+    return victim;
+}
+
+/**
+ * @brief Read data through the cache
+ *
+ * Drop-in replacement for W25Q64_ReadData() for small, scattered reads.
+ *
+ * @param addr Starting address (24-bit)
+ * @param dataArr Destination buffer
+ * @param len Number of bytes to read
+ */
+void W25Q64_Cache_Read(uint32_t addr, uint8_t *dataArr, uint32_t len)
+{
+    if (len >= W25Q64_CACHE_BYPASS_LEN) {
+        W25Q64_ReadData(addr, dataArr, len);
+        W25Q64_Cache_Counters.bypasses++;
+        W25Q64_Cache_NextLine = (addr + len + W25Q64_CACHE_LINE_SIZE - 1) & W25Q64_CACHE_LINE_MASK;
+        return;
+    }
+
+    while (len > 0) {
+        uint32_t lineAddr = addr & W25Q64_CACHE_LINE_MASK;
+        uint32_t offset = addr - lineAddr;
+        uint32_t chunk = W25Q64_CACHE_LINE_SIZE - offset;
+        int8_t line = W25Q64_Cache_Lookup(lineAddr);
+
+        if (chunk > len) chunk = len;
+
+        if (line >= 0) {
+            W25Q64_Cache_Counters.hits++;
+            if (W25Q64_Cache_Ahead & (1 << line)) {
+                W25Q64_Cache_Ahead &= ~(1 << line);
+                W25Q64_Cache_Counters.readAheadHits++;
+            }
+        } else {
+            W25Q64_Cache_Counters.misses++;
+            line = W25Q64_Cache_Fill(lineAddr);
+        }
+
+        W25Q64_Cache_Stamp[line] = ++W25Q64_Cache_Clock;
+        memcpy(dataArr, &W25Q64_Cache_Data[line][offset], chunk);
+        W25Q64_Cache_NextLine = lineAddr + W25Q64_CACHE_LINE_SIZE;
+
+        addr += chunk;
+        dataArr += chunk;
+        len -= chunk;
+    }
+}
+
+/**
+ * @brief Drop every cached line overlapping a flash range
+ *
+ * Called by the W25Q64 driver before each program and erase.
+ *
+ * @param addr Starting address of the modified range
+ * @param len Length of the modified range
+ */
+void W25Q64_Cache_Invalidate(uint32_t addr, uint32_t len)
+{
+    for (uint8_t i = 0; i < W25Q64_CACHE_LINES; i++) {
+        uint32_t lineAddr = W25Q64_Cache_Tag[i] & W25Q64_CACHE_LINE_MASK;
+
+        if (W25Q64_Cache_Tag[i] == 0) continue;
+        if (lineAddr + W25Q64_CACHE_LINE_SIZE > addr && lineAddr < addr + len) {
+            W25Q64_Cache_Tag[i] = 0;
+            W25Q64_Cache_Counters.invalidations++;
+        }
+    }
+}
+
+/**
+ * @brief Drop all cached lines (chip erase)
+ */
+void W25Q64_Cache_InvalidateAll(void)
+{
+    for (uint8_t i = 0; i < W25Q64_CACHE_LINES; i++) {
+        if (W25Q64_Cache_Tag[i]) W25Q64_Cache_Counters.invalidations++;
+        W25Q64_Cache_Tag[i] = 0;
+    }
+    W25Q64_Cache_Ahead = 0;
+}
+
+/**
+ * @brief Get the cache counters
+ *
+ * Hit rate = hits / (hits + misses). Compare readAheadHits with readAheads
+ * to see whether read-ahead pays off for the access pattern.
+ *
+ * @param stats Destination
+ */
+void W25Q64_Cache_GetStats(W25Q64_Cache_Stats *stats)
+{
+    *stats = W25Q64_Cache_Counters;
+}
+
+/**
+ * @brief Clear the cache counters
+ */
+void W25Q64_Cache_ResetStats(void)
+{
+    memset(&W25Q64_Cache_Counters, 0, sizeof(W25Q64_Cache_Counters));
+}
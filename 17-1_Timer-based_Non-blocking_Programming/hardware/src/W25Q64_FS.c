@@ -0,0 +1,699 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_FS.c
+ * @brief  Small power-fail-safe file system on the W25Q64 - Source File
+ *
+ * The directory is never held in RAM. Lookups stream it from the current
+ * snapshot, a commit streams it page by page into the next slot while
+ * patching the one entry that changed. RAM use is a 256-byte page buffer,
+ * a one-bit-per-sector allocation bitmap and a few words of state (about
+ * 400 bytes with the default 4 MB region), plus 48 bytes per open handle.
+ *
+ * Data goes straight between the caller's buffer and the flash, so large
+ * reads and page programs use the SPI DMA path of the W25Q64 driver.
+ * Sectors are allocated next-fit from a rotating cursor, blank sectors are
+ * used without erasing, and the sector after the write head is erased in
+ * the background while the current one is being filled.
+ *
+ * A read handle sees the version that was committed when it was opened;
+ * close it before that file is replaced or removed.
+ *
+ * Building with W25Q64_FS_HOST defined drops the W25Q64 binding so the
+ * same file runs against the host flash simulator in tools/flash_sim.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 15:20:41
+ ********************************************************************************/
+
+#include "W25Q64_FS.h"
+#include <string.h>
+
+#ifndef W25Q64_FS_HOST
+#include "W25Q64.h"
+#include "W25Q64_Cache.h"
+#endif
+
+// Snapshot layout
+#define W25Q64_FS_OFS_MAGIC         0x000
+#define W25Q64_FS_OFS_SEQ           0x004
+#define W25Q64_FS_OFS_ENTRY         0x020
+#define W25Q64_FS_OFS_CRC           (W25Q64_FS_SNAPSHOT_SIZE - 4)
+#define W25Q64_FS_SLOTS_PER_SECTOR  (W25Q64_FS_SECTOR_SIZE / W25Q64_FS_SNAPSHOT_SIZE)
+#define W25Q64_FS_SLOTS             (W25Q64_FS_META_SECTORS * W25Q64_FS_SLOTS_PER_SECTOR)
+#define W25Q64_FS_SNAPSHOT_PAGES    (W25Q64_FS_SNAPSHOT_SIZE / W25Q64_FS_PAGE_SIZE)
+
+#define W25Q64_FS_NONE              0xFFFF
+
+// The snapshot layout relies on page-aligned 32-byte entries
+typedef char W25Q64_FS_EntrySizeCheck[(sizeof(W25Q64_FS_Entry) == 32) ? 1 : -1];
+typedef char W25Q64_FS_LayoutCheck[(W25Q64_FS_OFS_ENTRY + W25Q64_FS_MAX_FILES * 32 <= W25Q64_FS_OFS_CRC) ? 1 : -1];
+
+static const W25Q64_FS_Flash *W25Q64_FS_Dev;
+static uint8_t W25Q64_FS_Bitmap[(W25Q64_FS_DATA_SECTORS + 7) / 8];
+static uint8_t W25Q64_FS_Buffer[W25Q64_FS_PAGE_SIZE];
+static uint8_t W25Q64_FS_Slot;              // Slot of the current snapshot
+static uint32_t W25Q64_FS_Seq;              // Its sequence number
+static uint16_t W25Q64_FS_Cursor;           // Next-fit allocation start
+static uint16_t W25Q64_FS_PreErased = W25Q64_FS_NONE;
+static uint8_t W25Q64_FS_Writer = 0xFF;     // Directory slot open for writing
+static bool W25Q64_FS_Empty;                // Format: no previous snapshot to copy
+static bool W25Q64_FS_Mounted;
+
+#ifndef W25Q64_FS_HOST
+// Directory entries and partial pages hit the read cache, page reads bypass it
+static const W25Q64_FS_Flash W25Q64_FS_W25Q64 = {
+    W25Q64_Cache_Read,
+    W25Q64_PageProgram,
+    W25Q64_EraseSector,
+    W25Q64_EraseSectorAsync
+};
+#endif
+
+/**
+ * @brief Flash address of a snapshot slot
+ */
+static uint32_t W25Q64_FS_SlotAddr(uint8_t slot)
+{
+    return W25Q64_FS_BASE_ADDR + (uint32_t)slot * W25Q64_FS_SNAPSHOT_SIZE;
+}
+
+/**
+ * @brief Flash address of a data sector
+ */
+static uint32_t W25Q64_FS_DataAddr(uint16_t sector)
+{
+    return W25Q64_FS_BASE_ADDR + (uint32_t)(W25Q64_FS_META_SECTORS + sector) * W25Q64_FS_SECTOR_SIZE;
+}
+
+static bool W25Q64_FS_Used(uint16_t sector)
+{
+    return W25Q64_FS_Bitmap[sector >> 3] & (1 << (sector & 7));
+}
+
+/**
+ * @brief Mark the sectors of an entry used or free in the bitmap
+ */
+static void W25Q64_FS_MarkEntry(const W25Q64_FS_Entry *entry, bool used)
+{
+    for (uint8_t e = 0; e < W25Q64_FS_EXTENTS; e++) {
+        for (uint16_t i = 0; i < entry->extent[e].count; i++) {
+            uint16_t s = entry->extent[e].start + i;
+            if (s >= W25Q64_FS_DATA_SECTORS) break;
+            if (used) {
+                W25Q64_FS_Bitmap[s >> 3] |= 1 << (s & 7);
+            } else {
+                W25Q64_FS_Bitmap[s >> 3] &= ~(1 << (s & 7));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Update a CRC-32 (IEEE 802.3, reflected) over a buffer
+ */
+static uint32_t W25Q64_FS_CRC32(uint32_t crc, const uint8_t *data, uint16_t len)
+{
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Check that a flash range reads as all 0xFF
+ */
+static bool W25Q64_FS_Blank(uint32_t addr, uint32_t len)
+{
+    while (len > 0) {
+        uint16_t chunk = len > W25Q64_FS_PAGE_SIZE ? W25Q64_FS_PAGE_SIZE : len;
+
+        W25Q64_FS_Dev->read(addr, W25Q64_FS_Buffer, chunk);
+        for (uint16_t i = 0; i < chunk; i++) {
+            if (W25Q64_FS_Buffer[i] != 0xFF) return false;
+        }
+        addr += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+/**
+ * @brief Validate a snapshot slot
+ *
+ * @param seq Receives the sequence number if valid
+ * @return true Magic and CRC match
+ */
+static bool W25Q64_FS_SlotValid(uint8_t slot, uint32_t *seq)
+{
+    uint32_t crc = 0xFFFFFFFF, stored = 0, magic;
+    uint32_t addr = W25Q64_FS_SlotAddr(slot);
+
+    for (uint8_t p = 0; p < W25Q64_FS_SNAPSHOT_PAGES; p++) {
+        W25Q64_FS_Dev->read(addr + p * W25Q64_FS_PAGE_SIZE, W25Q64_FS_Buffer, W25Q64_FS_PAGE_SIZE);
+        if (p == 0) {
+            memcpy(&magic, &W25Q64_FS_Buffer[W25Q64_FS_OFS_MAGIC], 4);
+            memcpy(seq, &W25Q64_FS_Buffer[W25Q64_FS_OFS_SEQ], 4);
+            if (magic != W25Q64_FS_MAGIC) return false;
+        }
+        if (p == W25Q64_FS_SNAPSHOT_PAGES - 1) {
+            crc = W25Q64_FS_CRC32(crc, W25Q64_FS_Buffer, W25Q64_FS_PAGE_SIZE - 4);
+            memcpy(&stored, &W25Q64_FS_Buffer[W25Q64_FS_PAGE_SIZE - 4], 4);
+        } else {
+            crc = W25Q64_FS_CRC32(crc, W25Q64_FS_Buffer, W25Q64_FS_PAGE_SIZE);
+        }
+    }
+    return ~crc == stored;
+}
+
+/**
+ * @brief Read a directory entry from the current snapshot
+ */
+static void W25Q64_FS_ReadEntry(uint8_t index, W25Q64_FS_Entry *entry)
+{
+    W25Q64_FS_Dev->read(W25Q64_FS_SlotAddr(W25Q64_FS_Slot) + W25Q64_FS_OFS_ENTRY + index * sizeof(*entry),
+                        (uint8_t *)entry, sizeof(*entry));
+}
+
+static bool W25Q64_FS_EntryFree(const W25Q64_FS_Entry *entry)
+{
+    return (uint8_t)entry->name[0] == 0xFF || entry->name[0] == '\0';
+}
+
+/**
+ * @brief Look up a name in the current snapshot
+ *
+ * @param entry Receives the entry when found, may be NULL
+ * @param freeIndex Receives the first free slot, may be NULL
+ * @return uint8_t Directory slot, 0xFF if not found
+ */
+static uint8_t W25Q64_FS_Find(const char *name, W25Q64_FS_Entry *entry, uint8_t *freeIndex)
+{
+    W25Q64_FS_Entry e;
+
+    if (freeIndex) *freeIndex = 0xFF;
+    for (uint8_t i = 0; i < W25Q64_FS_MAX_FILES; i++) {
+        W25Q64_FS_ReadEntry(i, &e);
+        if (W25Q64_FS_EntryFree(&e)) {
+            if (freeIndex && *freeIndex == 0xFF) *freeIndex = i;
+            continue;
+        }
+        if (strncmp(e.name, name, W25Q64_FS_NAME_LEN) == 0) {
+            if (entry) *entry = e;
+            return i;
+        }
+    }
+    return 0xFF;
+}
+
+/**
+ * @brief Pick the slot for the next snapshot
+ *
+ * Slots left dirty by an interrupted commit are skipped. Entering a
+ * metadata sector erases it, the current snapshot lives in the other one.
+ */
+static uint8_t W25Q64_FS_NextSlot(void)
+{
+    uint8_t next = W25Q64_FS_Slot;
+
+    do {
+        next = (next + 1) % W25Q64_FS_SLOTS;
+        if (next % W25Q64_FS_SLOTS_PER_SECTOR == 0) {
+            W25Q64_FS_Dev->erase(W25Q64_FS_SlotAddr(next));
+            break;
+        }
+    } while (!W25Q64_FS_Blank(W25Q64_FS_SlotAddr(next), W25Q64_FS_SNAPSHOT_SIZE));
+
+    return next;
+}
+
+/**
+ * @brief Write a new snapshot with one entry replaced
+ *
+ * Copies the current snapshot page by page, so only one page of RAM is
+ * needed. The new snapshot becomes current only once its CRC is on flash.
+ *
+ * @param index Directory slot to change, 0xFF for none
+ * @param entry New contents, NULL to free the slot
+ */
+static void W25Q64_FS_Commit(uint8_t index, const W25Q64_FS_Entry *entry)
+{
+    uint8_t next = W25Q64_FS_NextSlot();
+    uint32_t seq = W25Q64_FS_Seq + 1;
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (uint8_t p = 0; p < W25Q64_FS_SNAPSHOT_PAGES; p++) {
+        uint16_t base = p * W25Q64_FS_PAGE_SIZE;
+
+        if (W25Q64_FS_Empty) {
+            memset(W25Q64_FS_Buffer, 0xFF, W25Q64_FS_PAGE_SIZE);
+        } else {
+            W25Q64_FS_Dev->read(W25Q64_FS_SlotAddr(W25Q64_FS_Slot) + base, W25Q64_FS_Buffer, W25Q64_FS_PAGE_SIZE);
+        }
+
+        if (p == 0) {
+            uint32_t magic = W25Q64_FS_MAGIC;
+            memcpy(&W25Q64_FS_Buffer[W25Q64_FS_OFS_MAGIC], &magic, 4);
+            memcpy(&W25Q64_FS_Buffer[W25Q64_FS_OFS_SEQ], &seq, 4);
+        }
+
+        if (index != 0xFF) {
+            uint16_t ofs = W25Q64_FS_OFS_ENTRY + index * sizeof(W25Q64_FS_Entry);
+            if (ofs >= base && ofs < base + W25Q64_FS_PAGE_SIZE) {
+                if (entry) {
+                    memcpy(&W25Q64_FS_Buffer[ofs - base], entry, sizeof(*entry));
+                } else {
+                    memset(&W25Q64_FS_Buffer[ofs - base], 0xFF, sizeof(W25Q64_FS_Entry));
+                }
+            }
+        }
+
+        if (p == W25Q64_FS_SNAPSHOT_PAGES - 1) {
+            crc = ~W25Q64_FS_CRC32(crc, W25Q64_FS_Buffer, W25Q64_FS_PAGE_SIZE - 4);
+            memcpy(&W25Q64_FS_Buffer[W25Q64_FS_PAGE_SIZE - 4], &crc, 4);
+        } else {
+            crc = W25Q64_FS_CRC32(crc, W25Q64_FS_Buffer, W25Q64_FS_PAGE_SIZE);
+        }
+
+        W25Q64_FS_Dev->program(W25Q64_FS_SlotAddr(next) + base, W25Q64_FS_Buffer, W25Q64_FS_PAGE_SIZE);
+    }
+
+    W25Q64_FS_Slot = next;
+    W25Q64_FS_Seq = seq;
+    W25Q64_FS_Empty = false;
+}
+
+/**
+ * @brief Flash address of a file offset
+ *
+ * @param run Receives the contiguous bytes from there to the end of the extent
+ * @return uint32_t Flash address, 0 if the offset is beyond the allocated sectors
+ */
+static uint32_t W25Q64_FS_Locate(const W25Q64_FS_Entry *entry, uint32_t pos, uint32_t *run)
+{
+    uint32_t sector = pos / W25Q64_FS_SECTOR_SIZE;
+
+    for (uint8_t e = 0; e < W25Q64_FS_EXTENTS; e++) {
+        if (sector < entry->extent[e].count) {
+            *run = (uint32_t)(entry->extent[e].count - sector) * W25Q64_FS_SECTOR_SIZE -
+                   pos % W25Q64_FS_SECTOR_SIZE;
+            return W25Q64_FS_DataAddr(entry->extent[e].start + sector) + pos % W25Q64_FS_SECTOR_SIZE;
+        }
+        sector -= entry->extent[e].count;
+    }
+    *run = 0;
+    return 0;
+}
+
+/**
+ * @brief Allocate one more sector at the end of a file
+ *
+ * Prefers the sector right after the last extent so files stay contiguous.
+ * The new sector is made blank (erased only if needed) and the one after it
+ * is erased in the background for the next call.
+ *
+ * @return true Sector added
+ * @return false No free sector or no free extent
+ */
+static bool W25Q64_FS_Grow(W25Q64_FS_Entry *entry)
+{
+    int8_t last = -1;
+    uint16_t s = W25Q64_FS_NONE;
+
+    for (uint8_t e = 0; e < W25Q64_FS_EXTENTS; e++) {
+        if (entry->extent[e].count) last = e;
+    }
+
+    if (last >= 0) {
+        uint16_t next = entry->extent[last].start + entry->extent[last].count;
+        if (next < W25Q64_FS_DATA_SECTORS && !W25Q64_FS_Used(next)) s = next;
+    }
+
+    if (s == W25Q64_FS_NONE) {
+        if (last == W25Q64_FS_EXTENTS - 1) return false;
+        for (uint16_t i = 0; i < W25Q64_FS_DATA_SECTORS; i++) {
+            uint16_t c = (W25Q64_FS_Cursor + i) % W25Q64_FS_DATA_SECTORS;
+            if (!W25Q64_FS_Used(c)) {
+                s = c;
+                break;
+            }
+        }
+        if (s == W25Q64_FS_NONE) return false;
+        last++;
+        entry->extent[last].start = s;
+        entry->extent[last].count = 0;
+    }
+
+    if (s != W25Q64_FS_PreErased && !W25Q64_FS_Blank(W25Q64_FS_DataAddr(s), W25Q64_FS_SECTOR_SIZE)) {
+        W25Q64_FS_Dev->erase(W25Q64_FS_DataAddr(s));
+    }
+    W25Q64_FS_Bitmap[s >> 3] |= 1 << (s & 7);
+    entry->extent[last].count++;
+    W25Q64_FS_Cursor = s + 1;
+
+    // Erase ahead: the next sector is the preferred candidate for the next call
+    W25Q64_FS_PreErased = W25Q64_FS_NONE;
+    s++;
+    if (s < W25Q64_FS_DATA_SECTORS && !W25Q64_FS_Used(s)) {
+        if (W25Q64_FS_Blank(W25Q64_FS_DataAddr(s), W25Q64_FS_SECTOR_SIZE)) {
+            W25Q64_FS_PreErased = s;
+        } else if (W25Q64_FS_Dev->eraseAsync && W25Q64_FS_Dev->eraseAsync(W25Q64_FS_DataAddr(s))) {
+            W25Q64_FS_PreErased = s;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Make the tail of the last sector programmable for an append
+ *
+ * Bytes past the committed size may hold data from an append that lost
+ * power before its commit. In that case the valid part of the last sector
+ * is copied to a fresh sector instead of programming over the leftovers.
+ */
+static bool W25Q64_FS_PrepareTail(W25Q64_FS_Entry *entry)
+{
+    uint32_t tail = entry->size % W25Q64_FS_SECTOR_SIZE;
+    uint32_t run, addr, oldSector;
+    int8_t last = -1;
+
+    if (tail == 0) return true;
+
+    addr = W25Q64_FS_Locate(entry, entry->size, &run);
+    if (W25Q64_FS_Blank(addr, W25Q64_FS_SECTOR_SIZE - tail)) return true;
+
+    // Drop the last sector from the extent list, then grow a fresh one
+    oldSector = addr - tail;
+    for (uint8_t e = 0; e < W25Q64_FS_EXTENTS; e++) {
+        if (entry->extent[e].count) last = e;
+    }
+    entry->extent[last].count--;
+    if (!W25Q64_FS_Grow(entry)) {
+        entry->extent[last].count++;
+        return false;
+    }
+
+    addr = W25Q64_FS_Locate(entry, entry->size - tail, &run);
+    for (uint32_t ofs = 0; ofs < tail; ofs += W25Q64_FS_PAGE_SIZE) {
+        uint16_t chunk = tail - ofs > W25Q64_FS_PAGE_SIZE ? W25Q64_FS_PAGE_SIZE : tail - ofs;
+        W25Q64_FS_Dev->read(oldSector + ofs, W25Q64_FS_Buffer, chunk);
+        W25Q64_FS_Dev->program(addr + ofs, W25Q64_FS_Buffer, chunk);
+    }
+    return true;
+}
+
+/**
+ * @brief Mount the file system: find the newest snapshot, rebuild the bitmap
+ *
+ * @param flash Flash access, NULL for the W25Q64
+ * @return W25Q64_FS_Status W25Q64_FS_OK or W25Q64_FS_ERR_NO_FORMAT
+ */
+W25Q64_FS_Status W25Q64_FS_Mount(const W25Q64_FS_Flash *flash)
+{
+    uint8_t best = 0xFF;
+    uint32_t bestSeq = 0, seq;
+    W25Q64_FS_Entry entry;
+
+#ifdef W25Q64_FS_HOST
+    if (flash == NULL) return W25Q64_FS_ERR_PARAM;
+    W25Q64_FS_Dev = flash;
+#else
+    W25Q64_FS_Dev = flash ? flash : &W25Q64_FS_W25Q64;
+#endif
+    W25Q64_FS_Mounted = false;
+    W25Q64_FS_Writer = 0xFF;
+    W25Q64_FS_PreErased = W25Q64_FS_NONE;
+    W25Q64_FS_Empty = false;
+
+    for (uint8_t slot = 0; slot < W25Q64_FS_SLOTS; slot++) {
+        if (W25Q64_FS_SlotValid(slot, &seq) && (best == 0xFF || seq > bestSeq)) {
+            best = slot;
+            bestSeq = seq;
+        }
+    }
+    if (best == 0xFF) return W25Q64_FS_ERR_NO_FORMAT;
+
+    W25Q64_FS_Slot = best;
+    W25Q64_FS_Seq = bestSeq;
+    W25Q64_FS_Cursor = (uint16_t)((bestSeq * 37) % W25Q64_FS_DATA_SECTORS);   // Spread wear across boots
+
+    memset(W25Q64_FS_Bitmap, 0, sizeof(W25Q64_FS_Bitmap));
+    for (uint8_t i = 0; i < W25Q64_FS_MAX_FILES; i++) {
+        W25Q64_FS_ReadEntry(i, &entry);
+        if (!W25Q64_FS_EntryFree(&entry)) W25Q64_FS_MarkEntry(&entry, true);
+    }
+
+    W25Q64_FS_Mounted = true;
+
+    return W25Q64_FS_OK;
+}
+
+/**
+ * @brief Create an empty file system
+ *
+ * Only the metadata sectors are erased, data sectors are erased on demand.
+ *
+ * @param flash Flash access, NULL for the W25Q64
+ * @return W25Q64_FS_Status Result of the final mount
+ */
+W25Q64_FS_Status W25Q64_FS_Format(const W25Q64_FS_Flash *flash)
+{
+#ifdef W25Q64_FS_HOST
+    if (flash == NULL) return W25Q64_FS_ERR_PARAM;
+    W25Q64_FS_Dev = flash;
+#else
+    W25Q64_FS_Dev = flash ? flash : &W25Q64_FS_W25Q64;
+#endif
+    W25Q64_FS_Mounted = false;
+
+    // Old snapshots must not outrank the new one; sector 0 is erased by the commit
+    for (uint8_t m = 1; m < W25Q64_FS_META_SECTORS; m++) {
+        W25Q64_FS_Dev->erase(W25Q64_FS_BASE_ADDR + (uint32_t)m * W25Q64_FS_SECTOR_SIZE);
+    }
+
+    W25Q64_FS_Empty = true;
+    W25Q64_FS_Slot = W25Q64_FS_SLOTS - 1;
+    W25Q64_FS_Seq = 0;
+    W25Q64_FS_Commit(0xFF, NULL);
+
+    return W25Q64_FS_Mount(flash);
+}
+
+/**
+ * @brief Open a file
+ *
+ * - W25Q64_FS_READ  : file must exist, reads and seeks the committed version
+ * - W25Q64_FS_WRITE : creates or replaces the file, starts empty
+ * - W25Q64_FS_APPEND: creates or extends the file, starts at its end
+ *
+ * Only one file can be open for writing at a time; its new contents
+ * replace the old ones atomically in W25Q64_FS_Close().
+ *
+ * @param file Handle to fill in
+ * @param name File name, 1 .. W25Q64_FS_NAME_LEN-1 characters
+ * @param mode Open mode
+ * @return W25Q64_FS_Status
+ */
+W25Q64_FS_Status W25Q64_FS_Open(W25Q64_FS_File *file, const char *name, W25Q64_FS_Mode mode)
+{
+    uint8_t index, freeIndex;
+    size_t len;
+
+    if (!W25Q64_FS_Mounted) return W25Q64_FS_ERR_NOT_MOUNTED;
+    if (file == NULL || name == NULL || mode > W25Q64_FS_APPEND) return W25Q64_FS_ERR_PARAM;
+    len = strlen(name);
+    if (len == 0 || len >= W25Q64_FS_NAME_LEN || (uint8_t)name[0] == 0xFF) return W25Q64_FS_ERR_PARAM;
+
+    memset(file, 0, sizeof(*file));
+    index = W25Q64_FS_Find(name, &file->entry, &freeIndex);
+
+    if (mode == W25Q64_FS_READ) {
+        if (index == 0xFF) return W25Q64_FS_ERR_NOT_FOUND;
+    } else {
+        if (W25Q64_FS_Writer != 0xFF) return W25Q64_FS_ERR_BUSY;
+
+        if (index == 0xFF) {
+            if (freeIndex == 0xFF) return W25Q64_FS_ERR_FULL;
+            index = freeIndex;
+            memset(&file->entry, 0, sizeof(file->entry));
+            strcpy(file->entry.name, name);
+        } else if (mode == W25Q64_FS_WRITE) {
+            file->entry.size = 0;
+            memset(file->entry.extent, 0, sizeof(file->entry.extent));
+        } else if (!W25Q64_FS_PrepareTail(&file->entry)) {
+            return W25Q64_FS_ERR_FULL;
+        }
+
+        file->pos = file->entry.size;
+        W25Q64_FS_Writer = index;
+    }
+
+    file->index = index;
+    file->mode = mode;
+    file->open = true;
+
+    return W25Q64_FS_OK;
+}
+
+/**
+ * @brief Read from a file opened with W25Q64_FS_READ
+ *
+ * @return uint32_t Bytes read, 0 at end of file
+ */
+uint32_t W25Q64_FS_Read(W25Q64_FS_File *file, void *buf, uint32_t len)
+{
+    uint8_t *dst = buf;
+    uint32_t done = 0;
+
+    if (file == NULL || !file->open || file->mode != W25Q64_FS_READ) return 0;
+    if (len > file->entry.size - file->pos) len = file->entry.size - file->pos;
+
+    while (done < len) {
+        uint32_t run;
+        uint32_t addr = W25Q64_FS_Locate(&file->entry, file->pos, &run);
+
+        if (run == 0) break;
+        if (run > len - done) run = len - done;
+
+        W25Q64_FS_Dev->read(addr, dst + done, run);
+        file->pos += run;
+        done += run;
+    }
+
+    return done;
+}
+
+/**
+ * @brief Append data to a file opened for writing
+ *
+ * @return uint32_t Bytes written, short when the file system is full
+ */
+uint32_t W25Q64_FS_Write(W25Q64_FS_File *file, const void *buf, uint32_t len)
+{
+    const uint8_t *src = buf;
+    uint32_t done = 0;
+
+    if (file == NULL || !file->open || file->mode == W25Q64_FS_READ) return 0;
+
+    while (done < len) {
+        uint32_t run, addr;
+        uint16_t chunk;
+
+        addr = W25Q64_FS_Locate(&file->entry, file->pos, &run);
+        if (run == 0) {
+            if (!W25Q64_FS_Grow(&file->entry)) break;
+            addr = W25Q64_FS_Locate(&file->entry, file->pos, &run);
+        }
+
+        chunk = W25Q64_FS_PAGE_SIZE - addr % W25Q64_FS_PAGE_SIZE;
+        if (chunk > len - done) chunk = len - done;
+
+        W25Q64_FS_Dev->program(addr, src + done, chunk);
+        file->pos += chunk;
+        done += chunk;
+    }
+
+    file->entry.size = file->pos;
+
+    return done;
+}
+
+/**
+ * @brief Move the read position of a file opened with W25Q64_FS_READ
+ *
+ * @param offset New position, 0 .. file size
+ * @return W25Q64_FS_Status
+ */
+W25Q64_FS_Status W25Q64_FS_Seek(W25Q64_FS_File *file, uint32_t offset)
+{
+    if (file == NULL || !file->open) return W25Q64_FS_ERR_PARAM;
+    if (file->mode != W25Q64_FS_READ) return W25Q64_FS_ERR_MODE;
+    if (offset > file->entry.size) return W25Q64_FS_ERR_PARAM;
+
+    file->pos = offset;
+
+    return W25Q64_FS_OK;
+}
+
+/**
+ * @brief Close a file, committing it if it was open for writing
+ *
+ * The commit is one snapshot write (4 page programs, plus a sector erase
+ * every fourth commit). Sectors of the replaced version are freed after it.
+ *
+ * @return W25Q64_FS_Status
+ */
+W25Q64_FS_Status W25Q64_FS_Close(W25Q64_FS_File *file)
+{
+    W25Q64_FS_Entry old;
+
+    if (file == NULL || !file->open) return W25Q64_FS_ERR_PARAM;
+    file->open = false;
+    if (file->mode == W25Q64_FS_READ) return W25Q64_FS_OK;
+
+    W25Q64_FS_ReadEntry(file->index, &old);
+    W25Q64_FS_Commit(file->index, &file->entry);
+
+    if (!W25Q64_FS_EntryFree(&old)) W25Q64_FS_MarkEntry(&old, false);
+    W25Q64_FS_MarkEntry(&file->entry, true);
+    W25Q64_FS_Writer = 0xFF;
+
+    return W25Q64_FS_OK;
+}
+
+/**
+ * @brief Delete a file
+ *
+ * @return W25Q64_FS_Status
+ */
+W25Q64_FS_Status W25Q64_FS_Remove(const char *name)
+{
+    W25Q64_FS_Entry entry;
+    uint8_t index;
+
+    if (!W25Q64_FS_Mounted) return W25Q64_FS_ERR_NOT_MOUNTED;
+    if (name == NULL) return W25Q64_FS_ERR_PARAM;
+
+    index = W25Q64_FS_Find(name, &entry, NULL);
+    if (index == 0xFF) return W25Q64_FS_ERR_NOT_FOUND;
+    if (index == W25Q64_FS_Writer) return W25Q64_FS_ERR_BUSY;
+
+    W25Q64_FS_Commit(index, NULL);
+    W25Q64_FS_MarkEntry(&entry, false);
+
+    return W25Q64_FS_OK;
+}
+
+/**
+ * @brief Iterate over the files in the directory
+ *
+ * @param cursor Start with 0, advanced on every call
+ * @param entry Receives the next file (name, size, extents)
+ * @return true Entry returned
+ * @return false No more files
+ */
+bool W25Q64_FS_List(uint8_t *cursor, W25Q64_FS_Entry *entry)
+{
+    if (!W25Q64_FS_Mounted || cursor == NULL || entry == NULL) return false;
+
+    while (*cursor < W25Q64_FS_MAX_FILES) {
+        W25Q64_FS_ReadEntry((*cursor)++, entry);
+        if (!W25Q64_FS_EntryFree(entry)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Free space in bytes (whole unallocated sectors)
+ */
+uint32_t W25Q64_FS_Free(void)
+{
+    uint32_t count = 0;
+
+    for (uint16_t s = 0; s < W25Q64_FS_DATA_SECTORS; s++) {
+        if (!W25Q64_FS_Used(s)) count++;
+    }
+    return count * W25Q64_FS_SECTOR_SIZE;
+}
@@ -0,0 +1,613 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_FTL.c
+ * @brief  Log-structured, wear-leveling flash translation layer - Source File
+ *
+ * Write path: the data slot is programmed first, then its summary entry.
+ * A power cut between the two leaves an unreferenced slot that GC reclaims.
+ *
+ * Garbage collection picks the full sector with the fewest valid pages,
+ * copies them to the write head and leaves the victim dirty. Dirty sectors
+ * are erased ahead of time by W25Q64_FTL_Process() so the write path
+ * normally finds an erased sector waiting.
+ *
+ * Wear leveling:
+ * - Dynamic: the erased sector with the lowest erase count is opened next
+ * - Static : every W25Q64_FTL_WEAR_INTERVAL erases, W25Q64_FTL_Process()
+ *            evicts the least worn full sector if the erase count spread
+ *            exceeds W25Q64_FTL_WEAR_DELTA
+ *
+ * RAM: 2 bytes per logical page + 12 bytes per sector (W25Q64_FTL_Sector,
+ * padded to its uint32_t alignment) + 348 bytes of buffers (about 2.7 KB with
+ * the default 64 sector region).
+ *
+ * Building with W25Q64_FTL_HOST defined drops the W25Q64 binding so the
+ * same file runs against the host flash simulator in tools/flash_sim.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 14:05:12
+ ********************************************************************************/
+
+#include "W25Q64_FTL.h"
+#include <string.h>
+
+#ifndef W25Q64_FTL_HOST
+#include "W25Q64.h"
+#endif
+
+// Summary page offsets
+#define W25Q64_FTL_OFS_MAGIC        0x00
+#define W25Q64_FTL_OFS_ERASE        0x04
+#define W25Q64_FTL_OFS_SEQ          0x0C
+#define W25Q64_FTL_OFS_ENTRY        0x20
+#define W25Q64_FTL_SUMMARY_SIZE     (W25Q64_FTL_OFS_ENTRY + 4 * W25Q64_FTL_SLOTS_PER_SECTOR)
+
+#define W25Q64_FTL_NONE             0xFF    // No sector
+
+#if W25Q64_FTL_SECTOR_COUNT >= W25Q64_FTL_NONE
+#error "W25Q64_FTL_SECTOR_COUNT must fit in a sector index byte"
+#endif
+
+// Sector state
+typedef enum {
+    W25Q64_FTL_DIRTY = 0,       // Needs an erase before reuse
+    W25Q64_FTL_ERASING,         // Background erase in progress
+    W25Q64_FTL_ERASED,          // Erased, header written, ready to open
+    W25Q64_FTL_ACTIVE,          // Current write head
+    W25Q64_FTL_FULL             // Closed, holds data
+} W25Q64_FTL_SectorState;
+
+typedef struct {
+    uint32_t eraseCount;
+    uint32_t seq;
+    uint8_t state;
+    uint8_t valid;              // Slots still holding the newest copy
+} W25Q64_FTL_Sector;
+
+static const W25Q64_FTL_Flash *W25Q64_FTL_Dev;
+static uint16_t W25Q64_FTL_Map[W25Q64_FTL_LOGICAL_PAGES];
+static W25Q64_FTL_Sector W25Q64_FTL_Sectors[W25Q64_FTL_SECTOR_COUNT];
+static uint8_t W25Q64_FTL_Summary[W25Q64_FTL_SUMMARY_SIZE];
+static uint8_t W25Q64_FTL_PageBuffer[W25Q64_FTL_PAGE_SIZE];
+static uint8_t W25Q64_FTL_Active = W25Q64_FTL_NONE;
+static uint8_t W25Q64_FTL_ActiveSlot;
+static uint8_t W25Q64_FTL_Erasing = W25Q64_FTL_NONE;
+static uint32_t W25Q64_FTL_NextSeq;
+static uint32_t W25Q64_FTL_WearCheck;      // Erase count at the last wear check
+static bool W25Q64_FTL_Mounted;
+static bool W25Q64_FTL_ColdMove;            // Static wear leveling relocation running
+static W25Q64_FTL_Stats W25Q64_FTL_Counters;
+
+#ifndef W25Q64_FTL_HOST
+/**
+ * @brief Async erase state for the W25Q64 binding
+ *
+ * @return true Erase still running
+ * @return false Device idle
+ */
+static bool W25Q64_FTL_W25Q64IsBusy(void)
+{
+    W25Q64_Process();
+    return W25Q64_IsBusy();
+}
+
+static const W25Q64_FTL_Flash W25Q64_FTL_W25Q64 = {
+    W25Q64_ReadData,
+    W25Q64_PageProgram,
+    W25Q64_EraseSector,
+    W25Q64_EraseSectorAsync,
+    W25Q64_FTL_W25Q64IsBusy,
+    W25Q64_Sync
+};
+#endif
+
+/**
+ * @brief Flash address of a sector in the FTL region
+ */
+static uint32_t W25Q64_FTL_SectorAddr(uint8_t sector)
+{
+    return W25Q64_FTL_BASE_ADDR + (uint32_t)sector * W25Q64_FTL_SECTOR_SIZE;
+}
+
+/**
+ * @brief Flash address of a physical slot (sector * slots + slot)
+ */
+static uint32_t W25Q64_FTL_SlotAddr(uint16_t phys)
+{
+    return W25Q64_FTL_SectorAddr(phys / W25Q64_FTL_SLOTS_PER_SECTOR) +
+           (uint32_t)(phys % W25Q64_FTL_SLOTS_PER_SECTOR + 1) * W25Q64_FTL_PAGE_SIZE;
+}
+
+/**
+ * @brief Load a 32-bit little-endian word from the summary buffer
+ */
+static uint32_t W25Q64_FTL_Word(uint16_t offset)
+{
+    uint32_t value;
+    memcpy(&value, &W25Q64_FTL_Summary[offset], sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Check the 32-bit value / complement pair at a summary offset
+ */
+static bool W25Q64_FTL_PairValid(uint16_t offset)
+{
+    return (W25Q64_FTL_Word(offset) ^ W25Q64_FTL_Word(offset + 4)) == 0xFFFFFFFF;
+}
+
+/**
+ * @brief Program a 32-bit value together with its complement
+ */
+static void W25Q64_FTL_ProgramPair(uint32_t addr, uint32_t value)
+{
+    uint32_t pair[2] = { value, ~value };
+    W25Q64_FTL_Dev->program(addr, (const uint8_t *)pair, sizeof(pair));
+}
+
+/**
+ * @brief Logical page stored in a summary entry
+ *
+ * @return uint16_t Logical page, W25Q64_FTL_UNMAPPED if blank or torn
+ */
+static uint16_t W25Q64_FTL_Entry(uint8_t slot)
+{
+    uint16_t pair[2];
+
+    memcpy(pair, &W25Q64_FTL_Summary[W25Q64_FTL_OFS_ENTRY + 4 * slot], sizeof(pair));
+    if ((uint16_t)(pair[0] ^ pair[1]) != 0xFFFF || pair[0] >= W25Q64_FTL_LOGICAL_PAGES) {
+        return W25Q64_FTL_UNMAPPED;
+    }
+    return pair[0];
+}
+
+/**
+ * @brief Read a sector summary page into W25Q64_FTL_Summary
+ */
+static void W25Q64_FTL_ReadSummary(uint8_t sector)
+{
+    W25Q64_FTL_Dev->read(W25Q64_FTL_SectorAddr(sector), W25Q64_FTL_Summary, W25Q64_FTL_SUMMARY_SIZE);
+}
+
+/**
+ * @brief Record a completed erase: bump the count and write the header
+ */
+static void W25Q64_FTL_FinishErase(uint8_t sector)
+{
+    W25Q64_FTL_Sector *sec = &W25Q64_FTL_Sectors[sector];
+    uint32_t header[3];
+
+    sec->eraseCount++;
+    header[0] = W25Q64_FTL_MAGIC;
+    header[1] = sec->eraseCount;
+    header[2] = ~sec->eraseCount;
+    W25Q64_FTL_Dev->program(W25Q64_FTL_SectorAddr(sector) + W25Q64_FTL_OFS_MAGIC,
+                            (const uint8_t *)header, sizeof(header));
+
+    sec->state = W25Q64_FTL_ERASED;
+    sec->valid = 0;
+}
+
+/**
+ * @brief Wait for the background erase, if any, and finish it
+ */
+static void W25Q64_FTL_SyncErase(void)
+{
+    if (W25Q64_FTL_Erasing == W25Q64_FTL_NONE) return;
+
+    W25Q64_FTL_Dev->sync();
+    W25Q64_FTL_FinishErase(W25Q64_FTL_Erasing);
+    W25Q64_FTL_Erasing = W25Q64_FTL_NONE;
+}
+
+/**
+ * @brief Erase a sector in the foreground
+ */
+static void W25Q64_FTL_EraseNow(uint8_t sector)
+{
+    W25Q64_FTL_SyncErase();
+    W25Q64_FTL_Dev->erase(W25Q64_FTL_SectorAddr(sector));
+    W25Q64_FTL_Counters.erases++;
+    W25Q64_FTL_FinishErase(sector);
+}
+
+/**
+ * @brief Count dirty, erasing and erased sectors
+ */
+static uint16_t W25Q64_FTL_FreeCount(void)
+{
+    uint16_t count = 0;
+
+    for (uint8_t s = 0; s < W25Q64_FTL_SECTOR_COUNT; s++) {
+        if (W25Q64_FTL_Sectors[s].state <= W25Q64_FTL_ERASED) count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Find the sector in a state with the lowest (or highest) erase count
+ *
+ * @return uint8_t Sector index, W25Q64_FTL_NONE if none in that state
+ */
+static uint8_t W25Q64_FTL_ByWear(uint8_t state, bool mostWorn)
+{
+    uint8_t best = W25Q64_FTL_NONE;
+
+    for (uint8_t s = 0; s < W25Q64_FTL_SECTOR_COUNT; s++) {
+        if (W25Q64_FTL_Sectors[s].state != state) continue;
+        if (best == W25Q64_FTL_NONE ||
+            (mostWorn ? W25Q64_FTL_Sectors[s].eraseCount > W25Q64_FTL_Sectors[best].eraseCount
+                      : W25Q64_FTL_Sectors[s].eraseCount < W25Q64_FTL_Sectors[best].eraseCount)) {
+            best = s;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Open an erased sector as the new write head
+ *
+ * Normally the least worn one; cold data moved by static wear leveling goes
+ * to the most worn one instead, so the freed young sector takes hot writes.
+ * Falls back to the running background erase, then to a foreground erase.
+ */
+static W25Q64_FTL_Status W25Q64_FTL_OpenSector(void)
+{
+    uint8_t s = W25Q64_FTL_ByWear(W25Q64_FTL_ERASED, W25Q64_FTL_ColdMove);
+
+    if (s == W25Q64_FTL_NONE && W25Q64_FTL_Erasing != W25Q64_FTL_NONE) {
+        s = W25Q64_FTL_Erasing;
+        W25Q64_FTL_SyncErase();
+    }
+    if (s == W25Q64_FTL_NONE) {
+        s = W25Q64_FTL_ByWear(W25Q64_FTL_DIRTY, false);
+        if (s == W25Q64_FTL_NONE) return W25Q64_FTL_ERR_NO_SPACE;
+        W25Q64_FTL_EraseNow(s);
+    }
+
+    W25Q64_FTL_ProgramPair(W25Q64_FTL_SectorAddr(s) + W25Q64_FTL_OFS_SEQ, W25Q64_FTL_NextSeq);
+    W25Q64_FTL_Sectors[s].seq = W25Q64_FTL_NextSeq++;
+    W25Q64_FTL_Sectors[s].state = W25Q64_FTL_ACTIVE;
+    W25Q64_FTL_Active = s;
+    W25Q64_FTL_ActiveSlot = 0;
+
+    return W25Q64_FTL_OK;
+}
+
+static bool W25Q64_FTL_Collect(uint8_t victim);
+
+/**
+ * @brief Pick the full sector with the fewest valid pages
+ *
+ * @return uint8_t Sector index, W25Q64_FTL_NONE if no sector would free a slot
+ */
+static uint8_t W25Q64_FTL_GreedyVictim(void)
+{
+    uint8_t best = W25Q64_FTL_NONE;
+
+    for (uint8_t s = 0; s < W25Q64_FTL_SECTOR_COUNT; s++) {
+        if (W25Q64_FTL_Sectors[s].state != W25Q64_FTL_FULL) continue;
+        if (W25Q64_FTL_Sectors[s].valid >= W25Q64_FTL_SLOTS_PER_SECTOR) continue;
+        if (best == W25Q64_FTL_NONE || W25Q64_FTL_Sectors[s].valid < W25Q64_FTL_Sectors[best].valid) {
+            best = s;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Append one logical page at the write head
+ *
+ * @param lpn Logical page
+ * @param buf Page data (W25Q64_FTL_PAGE_SIZE bytes)
+ * @param allowGC false while GC itself is relocating pages
+ */
+static W25Q64_FTL_Status W25Q64_FTL_Append(uint16_t lpn, const uint8_t *buf, bool allowGC)
+{
+    uint16_t phys, old;
+
+    while (W25Q64_FTL_Active == W25Q64_FTL_NONE || W25Q64_FTL_ActiveSlot >= W25Q64_FTL_SLOTS_PER_SECTOR) {
+        if (W25Q64_FTL_Active != W25Q64_FTL_NONE) {
+            W25Q64_FTL_Sectors[W25Q64_FTL_Active].state = W25Q64_FTL_FULL;
+            W25Q64_FTL_Active = W25Q64_FTL_NONE;
+        }
+        if (allowGC && W25Q64_FTL_FreeCount() < W25Q64_FTL_GC_THRESHOLD &&
+            W25Q64_FTL_Collect(W25Q64_FTL_GreedyVictim())) {
+            continue;   // Relocation may have opened a new write head
+        }
+        W25Q64_FTL_Status status = W25Q64_FTL_OpenSector();
+        if (status != W25Q64_FTL_OK) return status;
+    }
+
+    phys = W25Q64_FTL_Active * W25Q64_FTL_SLOTS_PER_SECTOR + W25Q64_FTL_ActiveSlot;
+
+    // Data first, then the entry that makes it visible
+    W25Q64_FTL_Dev->program(W25Q64_FTL_SlotAddr(phys), buf, W25Q64_FTL_PAGE_SIZE);
+    uint16_t entry[2] = { lpn, (uint16_t)~lpn };
+    W25Q64_FTL_Dev->program(W25Q64_FTL_SectorAddr(W25Q64_FTL_Active) + W25Q64_FTL_OFS_ENTRY +
+                            4 * W25Q64_FTL_ActiveSlot, (const uint8_t *)entry, sizeof(entry));
+    W25Q64_FTL_ActiveSlot++;
+    W25Q64_FTL_Counters.flashPrograms++;
+
+    old = W25Q64_FTL_Map[lpn];
+    if (old != W25Q64_FTL_UNMAPPED) {
+        W25Q64_FTL_Sectors[old / W25Q64_FTL_SLOTS_PER_SECTOR].valid--;
+    }
+    W25Q64_FTL_Map[lpn] = phys;
+    W25Q64_FTL_Sectors[W25Q64_FTL_Active].valid++;
+
+    return W25Q64_FTL_OK;
+}
+
+/**
+ * @brief Relocate the valid pages of a victim and mark it dirty
+ *
+ * @return true Victim reclaimed
+ * @return false No victim or no room for the relocated pages
+ */
+static bool W25Q64_FTL_Collect(uint8_t victim)
+{
+    if (victim == W25Q64_FTL_NONE) return false;
+
+    W25Q64_FTL_ReadSummary(victim);
+    for (uint8_t slot = 0; slot < W25Q64_FTL_SLOTS_PER_SECTOR && W25Q64_FTL_Sectors[victim].valid; slot++) {
+        uint16_t lpn = W25Q64_FTL_Entry(slot);
+        uint16_t phys = victim * W25Q64_FTL_SLOTS_PER_SECTOR + slot;
+
+        if (lpn == W25Q64_FTL_UNMAPPED || W25Q64_FTL_Map[lpn] != phys) continue;
+
+        W25Q64_FTL_Dev->read(W25Q64_FTL_SlotAddr(phys), W25Q64_FTL_PageBuffer, W25Q64_FTL_PAGE_SIZE);
+        if (W25Q64_FTL_Append(lpn, W25Q64_FTL_PageBuffer, false) != W25Q64_FTL_OK) return false;
+        W25Q64_FTL_Counters.relocations++;
+    }
+
+    W25Q64_FTL_Sectors[victim].state = W25Q64_FTL_DIRTY;
+    W25Q64_FTL_Counters.gcRuns++;
+
+    return true;
+}
+
+/**
+ * @brief Mount the FTL region and rebuild the logical-to-physical map
+ *
+ * The sector that was the write head before power-off is closed as it is,
+ * its unwritten slots may hold a torn program and are never reused.
+ *
+ * @param flash Flash access, NULL for the W25Q64
+ * @return W25Q64_FTL_Status W25Q64_FTL_OK or W25Q64_FTL_ERR_NO_FORMAT
+ */
+W25Q64_FTL_Status W25Q64_FTL_Mount(const W25Q64_FTL_Flash *flash)
+{
+    uint8_t order[W25Q64_FTL_SECTOR_COUNT];
+    uint8_t used = 0;
+    uint32_t maxErase = 0;
+    bool found = false;
+
+#ifdef W25Q64_FTL_HOST
+    if (flash == NULL) return W25Q64_FTL_ERR_PARAM;
+    W25Q64_FTL_Dev = flash;
+#else
+    W25Q64_FTL_Dev = flash ? flash : &W25Q64_FTL_W25Q64;
+#endif
+    W25Q64_FTL_Mounted = false;
+    W25Q64_FTL_Active = W25Q64_FTL_NONE;
+    W25Q64_FTL_Erasing = W25Q64_FTL_NONE;
+    W25Q64_FTL_NextSeq = 0;
+    W25Q64_FTL_WearCheck = 0;
+    memset(W25Q64_FTL_Map, 0xFF, sizeof(W25Q64_FTL_Map));
+    memset(&W25Q64_FTL_Counters, 0, sizeof(W25Q64_FTL_Counters));
+
+    // Pass 1: classify sectors, sort used ones by sequence
+    for (uint8_t s = 0; s < W25Q64_FTL_SECTOR_COUNT; s++) {
+        W25Q64_FTL_Sector *sec = &W25Q64_FTL_Sectors[s];
+
+        W25Q64_FTL_ReadSummary(s);
+        sec->valid = 0;
+        sec->seq = 0;
+        sec->state = W25Q64_FTL_DIRTY;
+        sec->eraseCount = 0xFFFFFFFF;   // Unknown until proven otherwise
+
+        if (W25Q64_FTL_Word(W25Q64_FTL_OFS_MAGIC) != W25Q64_FTL_MAGIC ||
+            !W25Q64_FTL_PairValid(W25Q64_FTL_OFS_ERASE)) continue;
+
+        found = true;
+        sec->eraseCount = W25Q64_FTL_Word(W25Q64_FTL_OFS_ERASE);
+        if (sec->eraseCount > maxErase) maxErase = sec->eraseCount;
+
+        if (W25Q64_FTL_Word(W25Q64_FTL_OFS_SEQ) == 0xFFFFFFFF &&
+            W25Q64_FTL_Word(W25Q64_FTL_OFS_SEQ + 4) == 0xFFFFFFFF) {
+            sec->state = W25Q64_FTL_ERASED;
+        } else if (W25Q64_FTL_PairValid(W25Q64_FTL_OFS_SEQ)) {
+            uint8_t i = used++;
+
+            sec->seq = W25Q64_FTL_Word(W25Q64_FTL_OFS_SEQ);
+            sec->state = W25Q64_FTL_FULL;
+            while (i > 0 && W25Q64_FTL_Sectors[order[i - 1]].seq > sec->seq) {
+                order[i] = order[i - 1];
+                i--;
+            }
+            order[i] = s;
+        }
+        // Torn sequence: opened but never written, reclaim as dirty
+    }
+
+    if (!found) return W25Q64_FTL_ERR_NO_FORMAT;
+
+    // Sectors whose header was lost (torn erase) inherit the worst known count
+    for (uint8_t s = 0; s < W25Q64_FTL_SECTOR_COUNT; s++) {
+        if (W25Q64_FTL_Sectors[s].eraseCount == 0xFFFFFFFF) W25Q64_FTL_Sectors[s].eraseCount = maxErase;
+    }
+
+    // Pass 2: replay the log oldest first, newer copies override older ones
+    for (uint8_t i = 0; i < used; i++) {
+        uint8_t s = order[i];
+
+        W25Q64_FTL_ReadSummary(s);
+        for (uint8_t slot = 0; slot < W25Q64_FTL_SLOTS_PER_SECTOR; slot++) {
+            uint16_t lpn = W25Q64_FTL_Entry(slot);
+            uint16_t old;
+
+            if (lpn == W25Q64_FTL_UNMAPPED) continue;
+
+            old = W25Q64_FTL_Map[lpn];
+            if (old != W25Q64_FTL_UNMAPPED) W25Q64_FTL_Sectors[old / W25Q64_FTL_SLOTS_PER_SECTOR].valid--;
+            W25Q64_FTL_Map[lpn] = s * W25Q64_FTL_SLOTS_PER_SECTOR + slot;
+            W25Q64_FTL_Sectors[s].valid++;
+        }
+        W25Q64_FTL_NextSeq = W25Q64_FTL_Sectors[s].seq + 1;
+    }
+
+    W25Q64_FTL_Mounted = true;
+
+    return W25Q64_FTL_OK;
+}
+
+/**
+ * @brief Erase the whole FTL region and mount it empty
+ *
+ * Erase counts of intact sectors are carried over. Blocking, roughly
+ * W25Q64_FTL_SECTOR_COUNT x 45 ms.
+ *
+ * @param flash Flash access, NULL for the W25Q64
+ * @return W25Q64_FTL_Status Result of the final mount
+ */
+W25Q64_FTL_Status W25Q64_FTL_Format(const W25Q64_FTL_Flash *flash)
+{
+#ifdef W25Q64_FTL_HOST
+    if (flash == NULL) return W25Q64_FTL_ERR_PARAM;
+    W25Q64_FTL_Dev = flash;
+#else
+    W25Q64_FTL_Dev = flash ? flash : &W25Q64_FTL_W25Q64;
+#endif
+    W25Q64_FTL_Mounted = false;
+    W25Q64_FTL_Erasing = W25Q64_FTL_NONE;
+    W25Q64_FTL_Dev->sync();
+
+    for (uint8_t s = 0; s < W25Q64_FTL_SECTOR_COUNT; s++) {
+        W25Q64_FTL_ReadSummary(s);
+        W25Q64_FTL_Sectors[s].eraseCount = 0;
+        if (W25Q64_FTL_Word(W25Q64_FTL_OFS_MAGIC) == W25Q64_FTL_MAGIC &&
+            W25Q64_FTL_PairValid(W25Q64_FTL_OFS_ERASE)) {
+            W25Q64_FTL_Sectors[s].eraseCount = W25Q64_FTL_Word(W25Q64_FTL_OFS_ERASE);
+        }
+        W25Q64_FTL_Dev->erase(W25Q64_FTL_SectorAddr(s));
+        W25Q64_FTL_FinishErase(s);
+    }
+
+    return W25Q64_FTL_Mount(flash);
+}
+
+/**
+ * @brief Read one logical page
+ *
+ * @param lpn Logical page (0 .. W25Q64_FTL_LOGICAL_PAGES-1)
+ * @param buf Destination, W25Q64_FTL_PAGE_SIZE bytes. Never-written pages read as 0xFF
+ * @return W25Q64_FTL_Status
+ */
+W25Q64_FTL_Status W25Q64_FTL_Read(uint16_t lpn, uint8_t *buf)
+{
+    if (!W25Q64_FTL_Mounted) return W25Q64_FTL_ERR_NOT_MOUNTED;
+    if (lpn >= W25Q64_FTL_LOGICAL_PAGES) return W25Q64_FTL_ERR_PARAM;
+
+    if (W25Q64_FTL_Map[lpn] == W25Q64_FTL_UNMAPPED) {
+        memset(buf, 0xFF, W25Q64_FTL_PAGE_SIZE);
+    } else {
+        W25Q64_FTL_Dev->read(W25Q64_FTL_SlotAddr(W25Q64_FTL_Map[lpn]), buf, W25Q64_FTL_PAGE_SIZE);
+    }
+
+    return W25Q64_FTL_OK;
+}
+
+/**
+ * @brief Write one logical page
+ *
+ * Costs one page program plus a 4-byte entry program. Runs GC in the
+ * foreground only when W25Q64_FTL_Process() has fallen behind.
+ *
+ * @param lpn Logical page (0 .. W25Q64_FTL_LOGICAL_PAGES-1)
+ * @param buf Source, W25Q64_FTL_PAGE_SIZE bytes
+ * @return W25Q64_FTL_Status
+ */
+W25Q64_FTL_Status W25Q64_FTL_Write(uint16_t lpn, const uint8_t *buf)
+{
+    W25Q64_FTL_Status status;
+
+    if (!W25Q64_FTL_Mounted) return W25Q64_FTL_ERR_NOT_MOUNTED;
+    if (lpn >= W25Q64_FTL_LOGICAL_PAGES) return W25Q64_FTL_ERR_PARAM;
+
+    status = W25Q64_FTL_Append(lpn, buf, true);
+    if (status == W25Q64_FTL_OK) W25Q64_FTL_Counters.hostWrites++;
+
+    return status;
+}
+
+/**
+ * @brief Background maintenance, call from the main loop
+ *
+ * Does at most one step per call:
+ * - finish a completed background erase
+ * - GC one victim when free sectors drop to W25Q64_FTL_GC_THRESHOLD
+ * - evict the least worn full sector when wear has drifted
+ * - start an async erase of the least worn dirty sector
+ */
+void W25Q64_FTL_Process(void)
+{
+    uint8_t s;
+
+    if (!W25Q64_FTL_Mounted) return;
+
+    if (W25Q64_FTL_Erasing != W25Q64_FTL_NONE) {
+        if (W25Q64_FTL_Dev->isBusy()) return;
+        W25Q64_FTL_FinishErase(W25Q64_FTL_Erasing);
+        W25Q64_FTL_Erasing = W25Q64_FTL_NONE;
+        return;
+    }
+
+    if (W25Q64_FTL_FreeCount() <= W25Q64_FTL_GC_THRESHOLD &&
+        W25Q64_FTL_Collect(W25Q64_FTL_GreedyVictim())) {
+        return;
+    }
+
+    s = W25Q64_FTL_ByWear(W25Q64_FTL_FULL, false);
+    if (s != W25Q64_FTL_NONE &&
+        W25Q64_FTL_Counters.erases - W25Q64_FTL_WearCheck >= W25Q64_FTL_WEAR_INTERVAL) {
+        W25Q64_FTL_Stats stats;
+
+        W25Q64_FTL_WearCheck = W25Q64_FTL_Counters.erases;
+        W25Q64_FTL_GetStats(&stats);
+        if (stats.maxErase - W25Q64_FTL_Sectors[s].eraseCount > W25Q64_FTL_WEAR_DELTA) {
+            W25Q64_FTL_ColdMove = true;
+            if (W25Q64_FTL_Collect(s)) W25Q64_FTL_Counters.wearMoves++;
+            W25Q64_FTL_ColdMove = false;
+            return;
+        }
+    }
+
+    if (W25Q64_FTL_Dev->eraseAsync == NULL) return;
+
+    s = W25Q64_FTL_ByWear(W25Q64_FTL_DIRTY, false);
+    if (s != W25Q64_FTL_NONE && W25Q64_FTL_Dev->eraseAsync(W25Q64_FTL_SectorAddr(s))) {
+        W25Q64_FTL_Sectors[s].state = W25Q64_FTL_ERASING;
+        W25Q64_FTL_Erasing = s;
+        W25Q64_FTL_Counters.erases++;
+        W25Q64_FTL_Counters.bgErases++;
+    }
+}
+
+/**
+ * @brief Get the FTL counters and current wear spread
+ *
+ * @param stats Destination
+ */
+void W25Q64_FTL_GetStats(W25Q64_FTL_Stats *stats)
+{
+    *stats = W25Q64_FTL_Counters;
+    stats->minErase = 0xFFFFFFFF;
+    stats->maxErase = 0;
+
+    for (uint8_t s = 0; s < W25Q64_FTL_SECTOR_COUNT; s++) {
+        uint32_t count = W25Q64_FTL_Sectors[s].eraseCount;
+        if (count < stats->minErase) stats->minErase = count;
+        if (count > stats->maxErase) stats->maxErase = count;
+    }
+    stats->freeSectors = W25Q64_FTL_FreeCount();
+}
@@ -0,0 +1,336 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_Log.c
+ * @brief  High-rate circular data logger on the W25Q64 - Source File
+ *
+ * Producer (any interrupt priority): W25Q64_Log_Write() copies a record
+ * into the head buffer inside a short PRIMASK section and hands the buffer
+ * over when it is full.
+ *
+ * Consumer (main loop): W25Q64_Log_Process() does at most one flash
+ * operation per call and never waits: either the erase of the sector after
+ * the current one, or the program of the oldest full buffer. The buffer is
+ * free again as soon as W25Q64_PageProgramAsync() has shifted it out.
+ *
+ * Usage: W25Q64_Init(), W25Q64_Log_Init(), then call W25Q64_Process() and
+ * W25Q64_Log_Process() from the main loop and W25Q64_Log_Write() from the
+ * sampling interrupts.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 16:40:05
+ ********************************************************************************/
+
+#include "W25Q64_Log.h"
+#include "W25Q64.h"
+#include "Serial.h"
+#include "CRC16.h"
+#include <string.h>
+
+#define W25Q64_LOG_TOTAL_PAGES      ((uint32_t)W25Q64_LOG_SECTOR_COUNT * W25Q64_LOG_PAGES_PER_SECTOR)
+#define W25Q64_LOG_BUFFER_MASK      (W25Q64_LOG_BUFFERS - 1)
+#define W25Q64_LOG_NONE             0xFFFF
+
+#if W25Q64_LOG_BUFFERS & W25Q64_LOG_BUFFER_MASK
+#error "W25Q64_LOG_BUFFERS must be a power of two"
+#endif
+
+static uint8_t W25Q64_Log_Buffer[W25Q64_LOG_BUFFERS][W25Q64_LOG_PAGE_SIZE];
+static volatile uint8_t W25Q64_Log_Head;        // Buffer being filled
+static volatile uint8_t W25Q64_Log_Tail;        // Oldest full buffer
+static volatile uint8_t W25Q64_Log_Queued;      // Full buffers waiting for the flash
+static volatile uint16_t W25Q64_Log_Fill;       // Payload bytes in the head buffer
+static volatile bool W25Q64_Log_Running;
+static uint32_t W25Q64_Log_Page;                // Next flash page (0 .. TOTAL_PAGES-1)
+static uint32_t W25Q64_Log_Seq;                 // Sequence number of that page
+static uint16_t W25Q64_Log_EraseSector = W25Q64_LOG_NONE;
+static W25Q64_Log_Stats W25Q64_Log_Counters;
+
+/**
+ * @brief CRC16-CCITT over a page: header bytes 0-5 and the used payload
+ */
+static uint16_t W25Q64_Log_CRC(const uint8_t *page, uint16_t used)
+{
+    // The CRC field itself (bytes 6-7) is skipped
+    uint16_t crc = CRC16_Update(CRC16_INIT, page, 6);
+
+    return CRC16_Update(crc, &page[W25Q64_LOG_HEADER_SIZE], used);
+}
+
+static uint32_t W25Q64_Log_PageAddr(uint32_t page)
+{
+    return W25Q64_LOG_BASE_ADDR + page * W25Q64_LOG_PAGE_SIZE;
+}
+
+static uint32_t W25Q64_Log_SectorAddr(uint16_t sector)
+{
+    return W25Q64_LOG_BASE_ADDR + (uint32_t)sector * W25Q64_LOG_SECTOR_SIZE;
+}
+
+/**
+ * @brief Hand the head buffer to the consumer, caller holds PRIMASK
+ *
+ * @return true Buffer queued, a fresh head buffer is ready
+ * @return false Every buffer is full
+ */
+static bool W25Q64_Log_CloseHead(void)
+{
+    uint8_t *page = W25Q64_Log_Buffer[W25Q64_Log_Head];
+
+    if (W25Q64_Log_Queued >= W25Q64_LOG_BUFFERS - 1) return false;
+
+    page[4] = (uint8_t)W25Q64_Log_Fill;
+    page[5] = (uint8_t)(W25Q64_Log_Fill >> 8);
+    W25Q64_Log_Head = (W25Q64_Log_Head + 1) & W25Q64_LOG_BUFFER_MASK;
+    W25Q64_Log_Fill = 0;
+    W25Q64_Log_Queued++;
+    if (W25Q64_Log_Queued > W25Q64_Log_Counters.maxQueued) W25Q64_Log_Counters.maxQueued = W25Q64_Log_Queued;
+
+    return true;
+}
+
+/**
+ * @brief Find the write position after a reset and prepare the first sector
+ *
+ * The head sector is the one whose first page carries the highest sequence
+ * number; logging resumes after its last programmed page. The sector after
+ * it is queued for the erase-ahead.
+ */
+void W25Q64_Log_Init(void)
+{
+    uint32_t seq, bestSeq = 0;
+    uint16_t head = W25Q64_LOG_NONE;
+    uint8_t page = 0;
+
+    W25Q64_Log_Running = false;
+    W25Q64_Log_Head = W25Q64_Log_Tail = W25Q64_Log_Queued = 0;
+    W25Q64_Log_Fill = 0;
+    memset(&W25Q64_Log_Counters, 0, sizeof(W25Q64_Log_Counters));
+
+    for (uint16_t s = 0; s < W25Q64_LOG_SECTOR_COUNT; s++) {
+        W25Q64_ReadData(W25Q64_Log_SectorAddr(s), (uint8_t *)&seq, sizeof(seq));
+        if (seq != 0xFFFFFFFF && (head == W25Q64_LOG_NONE || seq > bestSeq)) {
+            head = s;
+            bestSeq = seq;
+        }
+    }
+
+    if (head == W25Q64_LOG_NONE) {
+        W25Q64_Log_Page = 0;
+        W25Q64_Log_Seq = 0;
+    } else {
+        // Resume after the last page with a non-blank header, torn or not
+        for (uint8_t p = 1; p < W25Q64_LOG_PAGES_PER_SECTOR; p++) {
+            uint8_t header[W25Q64_LOG_HEADER_SIZE];
+
+            W25Q64_ReadData(W25Q64_Log_SectorAddr(head) + p * W25Q64_LOG_PAGE_SIZE, header, sizeof(header));
+            for (uint8_t i = 0; i < sizeof(header); i++) {
+                if (header[i] != 0xFF) {
+                    page = p;
+                    break;
+                }
+            }
+        }
+        W25Q64_Log_Page = ((uint32_t)head * W25Q64_LOG_PAGES_PER_SECTOR + page + 1) % W25Q64_LOG_TOTAL_PAGES;
+        W25Q64_Log_Seq = bestSeq + page + 1;
+    }
+
+    // Starting on a sector boundary: that sector holds the oldest data
+    if (W25Q64_Log_Page % W25Q64_LOG_PAGES_PER_SECTOR == 0) {
+        W25Q64_EraseSector(W25Q64_Log_PageAddr(W25Q64_Log_Page));
+    }
+    W25Q64_Log_EraseSector = (W25Q64_Log_Page / W25Q64_LOG_PAGES_PER_SECTOR + 1) % W25Q64_LOG_SECTOR_COUNT;
+    W25Q64_Log_Running = true;
+}
+
+/**
+ * @brief Append one record, callable from any interrupt
+ *
+ * Takes a few microseconds with interrupts masked (copy of len bytes).
+ *
+ * @param tag Record type chosen by the application (sensor, channel, ...)
+ * @param data Record payload
+ * @param len Payload length, up to W25Q64_LOG_MAX_RECORD
+ * @return true Record buffered
+ * @return false Dropped (all buffers full, logger stopped or too long)
+ */
+bool W25Q64_Log_Write(uint8_t tag, const void *data, uint8_t len)
+{
+    uint32_t primask;
+    bool ok = false;
+
+    if (len > W25Q64_LOG_MAX_RECORD) return false;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (W25Q64_Log_Running &&
+        (W25Q64_Log_Fill + 2 + len <= W25Q64_LOG_PAYLOAD_SIZE || W25Q64_Log_CloseHead())) {
+        uint8_t *dst = &W25Q64_Log_Buffer[W25Q64_Log_Head][W25Q64_LOG_HEADER_SIZE + W25Q64_Log_Fill];
+
+        dst[0] = tag;
+        dst[1] = len;
+        memcpy(dst + 2, data, len);
+        W25Q64_Log_Fill += 2 + len;
+        W25Q64_Log_Counters.records++;
+        ok = true;
+    } else {
+        W25Q64_Log_Counters.dropped++;
+    }
+
+    __set_PRIMASK(primask);
+
+    return ok;
+}
+
+/**
+ * @brief Program the partially filled page and wait until everything is on flash
+ *
+ * Blocking, call from the main loop only (before a dump or power-down). The
+ * head page can only be closed once a buffer is free, so the queue is
+ * drained around it. Returns with every buffer empty; records written by
+ * running producers meanwhile are flushed too, so stop them for a bounded
+ * wait.
+ */
+void W25Q64_Log_Flush(void)
+{
+    uint32_t primask;
+
+    while (W25Q64_Log_Fill > 0 || W25Q64_Log_Queued > 0) {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        if (W25Q64_Log_Fill > 0) W25Q64_Log_CloseHead();
+        __set_PRIMASK(primask);
+
+        W25Q64_Sync();
+        W25Q64_Log_Process();
+    }
+    W25Q64_Sync();
+}
+
+/**
+ * @brief Move data from RAM to flash, call from the main loop
+ *
+ * One non-blocking step per call. The erase of the next sector runs when
+ * no page is waiting, or once the write pointer reaches
+ * W25Q64_LOG_ERASE_DEADLINE so it is always done before the boundary.
+ */
+void W25Q64_Log_Process(void)
+{
+    uint8_t *page;
+    uint16_t used;
+    uint16_t crc;
+    uint8_t slot = W25Q64_Log_Page % W25Q64_LOG_PAGES_PER_SECTOR;
+
+    if (W25Q64_IsBusy()) return;
+
+    if (W25Q64_Log_EraseSector != W25Q64_LOG_NONE &&
+        (W25Q64_Log_Queued == 0 || slot >= W25Q64_LOG_ERASE_DEADLINE ||
+         W25Q64_Log_EraseSector == W25Q64_Log_Page / W25Q64_LOG_PAGES_PER_SECTOR)) {
+        if (W25Q64_EraseSectorAsync(W25Q64_Log_SectorAddr(W25Q64_Log_EraseSector))) {
+            W25Q64_Log_EraseSector = W25Q64_LOG_NONE;
+            W25Q64_Log_Counters.erases++;
+        }
+        return;
+    }
+
+    if (W25Q64_Log_Queued == 0) return;
+
+    page = W25Q64_Log_Buffer[W25Q64_Log_Tail];
+    used = page[4] | (page[5] << 8);
+    memcpy(page, &W25Q64_Log_Seq, 4);
+    crc = W25Q64_Log_CRC(page, used);
+    page[6] = (uint8_t)crc;
+    page[7] = (uint8_t)(crc >> 8);
+
+    if (!W25Q64_PageProgramAsync(W25Q64_Log_PageAddr(W25Q64_Log_Page), page, W25Q64_LOG_HEADER_SIZE + used)) {
+        return;
+    }
+
+    // Data has been shifted out, the buffer can be refilled
+    __disable_irq();
+    W25Q64_Log_Tail = (W25Q64_Log_Tail + 1) & W25Q64_LOG_BUFFER_MASK;
+    W25Q64_Log_Queued--;
+    __enable_irq();
+
+    W25Q64_Log_Seq++;
+    W25Q64_Log_Counters.pages++;
+    W25Q64_Log_Page = (W25Q64_Log_Page + 1) % W25Q64_LOG_TOTAL_PAGES;
+    if (W25Q64_Log_Page % W25Q64_LOG_PAGES_PER_SECTOR == 0) {
+        W25Q64_Log_EraseSector = (W25Q64_Log_Page / W25Q64_LOG_PAGES_PER_SECTOR + 1) % W25Q64_LOG_SECTOR_COUNT;
+    }
+}
+
+/**
+ * @brief Send one byte as two hex digits
+ */
+static void W25Q64_Log_SendHex(Serial_Port *port, uint8_t b)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    Serial_SendByte(port, hex[b >> 4]);
+    Serial_SendByte(port, hex[b & 0x0F]);
+}
+
+/**
+ * @brief Print the whole log over the serial port, oldest page first
+ *
+ * One line per record: "sequence,tag,hexdata". Pages failing their CRC
+ * are reported as "sequence,BAD". Logging is paused (records dropped)
+ * while the dump runs.
+ *
+ * @param port Serial port to print on
+ */
+void W25Q64_Log_Dump(Serial_Port *port)
+{
+    uint16_t start;
+
+    // Stop the producers first, so nothing lands in the buffers after the flush
+    W25Q64_Log_Running = false;
+    W25Q64_Log_Flush();
+    start = W25Q64_Log_Page / W25Q64_LOG_PAGES_PER_SECTOR;
+
+    // Scratch page: the flush left every buffer empty (Fill 0) and they stay empty
+    uint8_t *page = W25Q64_Log_Buffer[W25Q64_Log_Head];
+
+    for (uint16_t k = 1; k <= W25Q64_LOG_SECTOR_COUNT; k++) {
+        uint16_t sector = (start + k) % W25Q64_LOG_SECTOR_COUNT;
+
+        for (uint8_t p = 0; p < W25Q64_LOG_PAGES_PER_SECTOR; p++) {
+            uint32_t seq;
+            uint16_t used, crc;
+
+            W25Q64_ReadData(W25Q64_Log_SectorAddr(sector) + p * W25Q64_LOG_PAGE_SIZE, page, W25Q64_LOG_PAGE_SIZE);
+            memcpy(&seq, page, 4);
+            used = page[4] | (page[5] << 8);
+            crc = page[6] | (page[7] << 8);
+            if (seq == 0xFFFFFFFF) continue;
+
+            if (used > W25Q64_LOG_PAYLOAD_SIZE || W25Q64_Log_CRC(page, used) != crc) {
+                Serial_Printf(port, "%lu,BAD\r\n", (unsigned long)seq);
+                continue;
+            }
+
+            for (uint16_t i = 0; i + 2 <= used && i + 2 + page[W25Q64_LOG_HEADER_SIZE + i + 1] <= used;
+                 i += 2 + page[W25Q64_LOG_HEADER_SIZE + i + 1]) {
+                const uint8_t *rec = &page[W25Q64_LOG_HEADER_SIZE + i];
+
+                Serial_Printf(port, "%lu,%u,", (unsigned long)seq, rec[0]);
+                for (uint8_t b = 0; b < rec[1]; b++) W25Q64_Log_SendHex(port, rec[2 + b]);
+                Serial_SendString(port, "\r\n");
+            }
+        }
+    }
+
+    W25Q64_Log_Running = true;
+}
+
+/**
+ * @brief Get the logger counters
+ *
+ * @param stats Destination
+ */
+void W25Q64_Log_GetStats(W25Q64_Log_Stats *stats)
+{
+    __disable_irq();
+    *stats = W25Q64_Log_Counters;
+    __enable_irq();
+}
@@ -0,0 +1,197 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_Verify.c
+ * @brief  Background CRC32 check of W25Q64 content regions - Source File
+ *
+ * Pipeline per W25Q64_Verify_Process() call, never waiting:
+ * - retire the chunk whose CRC DMA has completed
+ * - hand the next filled chunk to the CRC DMA
+ * - start the SPI read of the next region bytes into a free chunk
+ * The SPI DMA completion interrupt marks a chunk as filled.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 17:05:32
+ ********************************************************************************/
+
+#include "W25Q64_Verify.h"
+#include "W25Q64.h"
+
+// Chunk states
+#define W25Q64_VERIFY_FREE          0
+#define W25Q64_VERIFY_READING       1
+#define W25Q64_VERIFY_FILLED        2
+#define W25Q64_VERIFY_FEEDING       3
+
+#if W25Q64_VERIFY_CHUNK_SIZE % 4
+#error "W25Q64_VERIFY_CHUNK_SIZE must be a multiple of 4"
+#endif
+
+// Word arrays: the CRC DMA reads 32-bit aligned words
+static uint32_t W25Q64_Verify_Buffer[2][W25Q64_VERIFY_CHUNK_SIZE / 4];
+static volatile uint8_t W25Q64_Verify_State[2];
+static uint16_t W25Q64_Verify_Len[2];
+static volatile uint8_t W25Q64_Verify_Reading;  // Chunk of the SPI read in flight
+static uint8_t W25Q64_Verify_Fill;              // Next chunk to read into
+static uint8_t W25Q64_Verify_Feed;              // Next chunk to feed, in read order
+
+static const W25Q64_Verify_Region *W25Q64_Verify_Regions;
+static uint8_t W25Q64_Verify_Count;
+static uint8_t W25Q64_Verify_Current;           // Region being checked
+static uint32_t W25Q64_Verify_Offset;           // Bytes of it read
+static uint32_t W25Q64_Verify_Fed;              // Bytes of it in the CRC
+static W25Q64_Verify_Status W25Q64_Verify_Result[W25Q64_VERIFY_MAX_REGIONS];
+
+/**
+ * @brief SPI read completion, called from the SPI DMA interrupt
+ */
+static void W25Q64_Verify_ReadDone(void)
+{
+    W25Q64_Verify_State[W25Q64_Verify_Reading] = W25Q64_VERIFY_FILLED;
+}
+
+/**
+ * @brief Prepare the CRC unit and its memory-to-memory DMA channel
+ */
+static void W25Q64_Verify_HardwareInit(void)
+{
+    DMA_InitTypeDef DMA_InitStructure;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_CRC | RCC_AHBPeriph_DMA1, ENABLE);
+
+    DMA_DeInit(W25Q64_VERIFY_DMA_CHANNEL);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t) &CRC->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) W25Q64_Verify_Buffer[0];
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = 1;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Enable;
+    DMA_Init(W25Q64_VERIFY_DMA_CHANNEL, &DMA_InitStructure);
+
+    CRC_ResetDR();
+}
+
+/**
+ * @brief Start checking regions in the background
+ *
+ * Returns immediately, W25Q64_Verify_Process() does the work. Call after
+ * W25Q64_Init().
+ *
+ * @param regions Region table, must stay valid until the check is done
+ * @param count Number of regions, up to W25Q64_VERIFY_MAX_REGIONS
+ */
+void W25Q64_Verify_Start(const W25Q64_Verify_Region *regions, uint8_t count)
+{
+    if (count > W25Q64_VERIFY_MAX_REGIONS) count = W25Q64_VERIFY_MAX_REGIONS;
+
+    W25Q64_Verify_HardwareInit();
+
+    W25Q64_Verify_Regions = regions;
+    W25Q64_Verify_Count = count;
+    W25Q64_Verify_Current = 0;
+    W25Q64_Verify_Offset = 0;
+    W25Q64_Verify_Fed = 0;
+    W25Q64_Verify_Fill = W25Q64_Verify_Feed = 0;
+    W25Q64_Verify_State[0] = W25Q64_Verify_State[1] = W25Q64_VERIFY_FREE;
+    for (uint8_t i = 0; i < W25Q64_VERIFY_MAX_REGIONS; i++) {
+        W25Q64_Verify_Result[i] = W25Q64_VERIFY_PENDING;
+    }
+}
+
+/**
+ * @brief Advance the check, call from the main loop
+ */
+void W25Q64_Verify_Process(void)
+{
+    const W25Q64_Verify_Region *region;
+    uint8_t feed = W25Q64_Verify_Feed;
+    uint8_t fill = W25Q64_Verify_Fill;
+
+    if (W25Q64_Verify_Current >= W25Q64_Verify_Count) return;
+    region = &W25Q64_Verify_Regions[W25Q64_Verify_Current];
+
+    // 1. Chunk consumed by the CRC unit
+    if (W25Q64_Verify_State[feed] == W25Q64_VERIFY_FEEDING &&
+        DMA_GetFlagStatus(W25Q64_VERIFY_DMA_FLAG_TC) != RESET) {
+        DMA_Cmd(W25Q64_VERIFY_DMA_CHANNEL, DISABLE);
+        DMA_ClearFlag(W25Q64_VERIFY_DMA_FLAGS);
+        W25Q64_Verify_Fed += W25Q64_Verify_Len[feed];
+        W25Q64_Verify_State[feed] = W25Q64_VERIFY_FREE;
+        W25Q64_Verify_Feed = feed ^= 1;
+    }
+
+    // 2. Region complete: compare and move to the next one
+    if (W25Q64_Verify_Fed >= region->len) {
+        W25Q64_Verify_Result[W25Q64_Verify_Current] =
+            (CRC_GetCRC() == region->crc) ? W25Q64_VERIFY_OK : W25Q64_VERIFY_FAILED;
+        W25Q64_Verify_Current++;
+        W25Q64_Verify_Offset = 0;
+        W25Q64_Verify_Fed = 0;
+        CRC_ResetDR();
+        return;
+    }
+
+    // 3. Feed the oldest filled chunk
+    if (W25Q64_Verify_State[feed] == W25Q64_VERIFY_FILLED) {
+        W25Q64_VERIFY_DMA_CHANNEL->CMAR = (uint32_t) W25Q64_Verify_Buffer[feed];
+        DMA_SetCurrDataCounter(W25Q64_VERIFY_DMA_CHANNEL, W25Q64_Verify_Len[feed] / 4);
+        W25Q64_Verify_State[feed] = W25Q64_VERIFY_FEEDING;
+        DMA_Cmd(W25Q64_VERIFY_DMA_CHANNEL, ENABLE);
+    }
+
+    // 4. Read ahead into a free chunk, retried next call if the bus is busy.
+    //    One read at a time: Reading names the chunk the callback completes
+    if (W25Q64_Verify_State[fill] == W25Q64_VERIFY_FREE &&
+        W25Q64_Verify_State[fill ^ 1] != W25Q64_VERIFY_READING &&
+        W25Q64_Verify_Offset < region->len) {
+        uint32_t n = region->len - W25Q64_Verify_Offset;
+
+        if (n > W25Q64_VERIFY_CHUNK_SIZE) n = W25Q64_VERIFY_CHUNK_SIZE;
+        W25Q64_Verify_Len[fill] = n;
+        W25Q64_Verify_Reading = fill;
+        W25Q64_Verify_State[fill] = W25Q64_VERIFY_READING;
+
+        if (W25Q64_ReadDataAsync(region->addr + W25Q64_Verify_Offset,
+                                 (uint8_t *) W25Q64_Verify_Buffer[fill], n, W25Q64_Verify_ReadDone)) {
+            W25Q64_Verify_Offset += n;
+            W25Q64_Verify_Fill = fill ^ 1;
+        } else {
+            W25Q64_Verify_State[fill] = W25Q64_VERIFY_FREE;
+        }
+    }
+}
+
+/**
+ * @brief Get the result of one region
+ *
+ * @param region Index in the table given to W25Q64_Verify_Start()
+ * @return W25Q64_Verify_Status PENDING until that region has been read completely
+ */
+W25Q64_Verify_Status W25Q64_Verify_GetStatus(uint8_t region)
+{
+    if (region >= W25Q64_VERIFY_MAX_REGIONS) return W25Q64_VERIFY_PENDING;
+
+    return W25Q64_Verify_Result[region];
+}
+
+/**
+ * @brief Check whether every region has been checked
+ */
+bool W25Q64_Verify_IsDone(void)
+{
+    return W25Q64_Verify_Current >= W25Q64_Verify_Count;
+}
+
+/**
+ * @brief Failure flag: at least one region does not match its CRC
+ */
+bool W25Q64_Verify_Failed(void)
+{
+    for (uint8_t i = 0; i < W25Q64_Verify_Count; i++) {
+        if (W25Q64_Verify_Result[i] == W25Q64_VERIFY_FAILED) return true;
+    }
+    return false;
+}
@@ -16,12 +16,23 @@
 #include "OLED.h"
 #include "Key.h"
 #include "LED.h"
+#include "Serial.h"
+#include "Trace.h"
+#include "W25Q64.h"
+#include "W25Q64_Log.h"
+
+/* 数据记录标签 */
+#define LOG_TAG_COUNTER     0   // 定时器中断中每秒记录一次计数值
+#define LOG_TAG_LED1        1   // LED1 模式切换
+#define LOG_TAG_LED2        2   // LED2 模式切换
 
 /* 全局变量，用于计数 */
 uint32_t i;
 
 /* 组合按键与 LED 控制函数 */
 void Combine_Key_LED(LED* ledList);
+/* W25Q64 读写速度与 CPU 占用测量 */
+void SPI_Benchmark(Serial_Port *port);
 
 int main(void)
 {
@@ -34,6 +45,10 @@ int main(void)
     Key_Init();
     LED_Init();
 
+    Serial_Init(SERIAL1);
+    Trace_Init();
+    W25Q64_Log_Init();      // W25Q64 已由 OLED_Init() 初始化
+
     OLED_ShowString(32, 0, FONT_SIZE_8, "LED MODE");
     OLED_ShowString(0, 16, FONT_SIZE_8, "LED1:");
     OLED_ShowString(0, 32, FONT_SIZE_8, "LED2:");
@@ -41,6 +56,17 @@ int main(void)
 
     while (1) {
         Combine_Key_LED(LED_List);
+        W25Q64_Process();
+        W25Q64_Verify_Process();
+        W25Q64_Log_Process();
+        Trace_Process();
+
+        // 串口收到 'D' 时导出全部记录, 'B' 时测量 SPI 速度 (与 Trace 共用串口, 解码工具会跳过这些文本)
+        if (Serial_GetRxFlag(SERIAL1)) {
+            uint8_t cmd = Serial_GetRxData(SERIAL1);
+            if (cmd == 'D') W25Q64_Log_Dump(SERIAL1);
+            else if (cmd == 'B') SPI_Benchmark(SERIAL1);
+        }
         OLED_ShowNum(24, 48, i, FONT_SIZE_8);
         OLED_Update();
     }
@@ -59,6 +85,8 @@ void Combine_Key_LED(LED* ledList)
         LED_STATE currentMode = ledList[0].mode;          // 获取当前模式
         currentMode = (LED_STATE)((currentMode + 1) % 5); // 切换到下一个模式
         LED_SetMode(&ledList[0], currentMode);
+        TRACE_INFO("LED1 mode %u", currentMode);
+        W25Q64_Log_Write(LOG_TAG_LED1, &(uint8_t){ currentMode }, 1);
 
         // 更新 OLED 显示
         OLED_ClearArea(80, 16, 48, 16);
@@ -75,6 +103,8 @@ void Combine_Key_LED(LED* ledList)
         LED_STATE currentMode = ledList[1].mode;
         currentMode = (LED_STATE)((currentMode + 1) % 5);
         LED_SetMode(&ledList[1], currentMode);
+        TRACE_INFO("LED2 mode %u", currentMode);
+        W25Q64_Log_Write(LOG_TAG_LED2, &(uint8_t){ currentMode }, 1);
 
         OLED_ClearArea(80, 32, 48, 16);
         switch (currentMode) {
@@ -88,13 +118,41 @@ void Combine_Key_LED(LED* ledList)
     }
 }
 
+/**
+ * @brief 测量 4KB 读取和 16 页编程的速度 (KB/s) 与 CPU 占用 (%)
+ * 
+ * 轮询和阻塞 DMA 读取期间 CPU 一直等待, 占用为 100%
+ * 
+ * @param port 输出结果的串口
+ */
+void SPI_Benchmark(Serial_Port *port)
+{
+    W25Q64_BenchResult r;
+    static const char *name[] = { "read polled", "read DMA", "read async", "program polled", "program DMA" };
+
+    W25Q64_Benchmark(&r);
+
+    uint32_t total[] = { r.readPolled, r.readDMA, r.readAsync, r.programPolled, r.programDMA };
+    uint32_t cpu[] = { r.readPolled, r.readDMA, r.readAsyncCpu, r.programPolledCpu, r.programDMACpu };
+
+    for (uint8_t k = 0; k < 5; k++) {
+        if (total[k] == 0) continue;    // 异步读取未能提交
+        Serial_Printf(port, "%s: %lu cycles, %lu KB/s, CPU %lu%%\r\n", name[k], total[k],
+                      (uint32_t)((uint64_t)W25Q64_BENCH_SIZE * SystemCoreClock / total[k] / 1000),
+                      (uint32_t)((uint64_t)cpu[k] * 100 / total[k]));
+    }
+}
+
 /* 定时器中断服务程序 */
 void TIM2_IRQHandler(void)
 {
     if (TIM_GetITStatus(TIM2, TIM_IT_Update) != RESET) {
         Key_Tick();
         LED_Tick(LED_List, 2);
+        W25Q64_Tick();
+        Trace_Tick();
         i++;
+        if (i % 1000 == 0) W25Q64_Log_Write(LOG_TAG_COUNTER, &i, sizeof(i));
         TIM_ClearITPendingBit(TIM2, TIM_IT_Update); // 清除中断标志位
     }
 }
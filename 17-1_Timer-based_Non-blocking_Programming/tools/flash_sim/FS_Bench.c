@@ -0,0 +1,293 @@
+/****************************************************************************/ /**
+ * @file   FS_Bench.c
+ * @brief  Host benchmark and power-cut test for W25Q64_FS on the flash simulator
+ *
+ * Build and run from this directory:
+ *   gcc -O2 -std=c99 -DW25Q64_FS_HOST -I. -Ihost -I../../hardware/inc -I../../system/inc \
+ *       FS_Bench.c Flash_Sim.c ../../hardware/src/W25Q64_FS.c \
+ *       ../../hardware/src/W25Q64_Cache.c -o fs_bench
+ *   ./fs_bench [power cuts, default 3000]
+ *
+ * Throughput is simulated time at the 18 MHz SPI clock with typical program
+ * and erase times, first on a blank chip, then rewriting over old data.
+ * Reads go through W25Q64_Cache as on the target, and the cache hit rate
+ * is printed per workload.
+ * The power-cut test runs random create/replace/append/remove operations,
+ * cuts power at a random flash operation, remounts and checks that every
+ * file holds either its previous or its new contents, never a mix.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 15:20:41
+ ********************************************************************************/
+
+#include "Flash_Sim.h"
+#include "W25Q64_FS.h"
+#include "W25Q64_Cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_FILES         8
+#define BENCH_MAX_SIZE      24000
+#define BENCH_CHUNK         4096
+
+/**
+ * @brief The driver calls the cache uses; program/erase invalidate like W25Q64.c
+ */
+void W25Q64_ReadData(uint32_t addr, uint8_t *dataArr, uint32_t len)
+{
+    Flash_Sim_Read(addr, dataArr, len);
+}
+
+static void Bench_Program(uint32_t addr, const uint8_t *buf, uint16_t len)
+{
+    W25Q64_Cache_Invalidate(addr, len);
+    Flash_Sim_Program(addr, buf, len);
+}
+
+static void Bench_Erase(uint32_t addr)
+{
+    W25Q64_Cache_Invalidate(addr & ~(uint32_t)(FLASH_SIM_SECTOR_SIZE - 1), FLASH_SIM_SECTOR_SIZE);
+    Flash_Sim_Erase(addr);
+}
+
+static bool Bench_EraseAsync(uint32_t addr)
+{
+    W25Q64_Cache_Invalidate(addr & ~(uint32_t)(FLASH_SIM_SECTOR_SIZE - 1), FLASH_SIM_SECTOR_SIZE);
+    return Flash_Sim_EraseAsync(addr);
+}
+
+static const W25Q64_FS_Flash Bench_Flash = {
+    W25Q64_Cache_Read,
+    Bench_Program,
+    Bench_Erase,
+    Bench_EraseAsync
+};
+
+// Expected state of each file: version 0 = absent
+typedef struct {
+    uint32_t version;
+    uint32_t size;
+} Bench_State;
+
+static Bench_State Bench_Files[BENCH_FILES];
+static uint8_t Bench_Data[BENCH_MAX_SIZE * 2];
+static uint8_t Bench_Read[BENCH_MAX_SIZE * 2];
+static uint32_t Bench_Seed = 7;
+
+static uint32_t Bench_Rand(void)
+{
+    Bench_Seed ^= Bench_Seed << 13;
+    Bench_Seed ^= Bench_Seed >> 17;
+    Bench_Seed ^= Bench_Seed << 5;
+    return Bench_Seed;
+}
+
+static void Bench_Name(char *name, int k)
+{
+    sprintf(name, "file%d.bin", k);
+}
+
+/**
+ * @brief Contents of file k at a version: a stream that appends only extend
+ */
+static void Bench_Fill(uint8_t *buf, int k, uint32_t version, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++) {
+        buf[i] = (uint8_t)(k * 29 + version * 13 + i * 7 + (i >> 8));
+    }
+}
+
+/**
+ * @brief Print and clear the cache counters of the workload just run
+ */
+static void Bench_CacheReport(const char *workload)
+{
+    W25Q64_Cache_Stats stats;
+    uint32_t lookups;
+
+    W25Q64_Cache_GetStats(&stats);
+    lookups = stats.hits + stats.misses;
+    printf("  cache %-22s hits %u/%u (%.1f%%)  read-ahead used %u/%u  bypassed %u\n", workload,
+           stats.hits, lookups, lookups ? 100.0 * stats.hits / lookups : 0.0,
+           stats.readAheadHits, stats.readAheads, stats.bypasses);
+    W25Q64_Cache_ResetStats();
+}
+
+static double Bench_Transfer(const char *name, uint32_t size, bool write)
+{
+    W25Q64_FS_File file;
+    double start = Flash_Sim_Now();
+
+    W25Q64_FS_Open(&file, name, write ? W25Q64_FS_WRITE : W25Q64_FS_READ);
+    for (uint32_t done = 0; done < size; done += BENCH_CHUNK) {
+        uint32_t n = size - done > BENCH_CHUNK ? BENCH_CHUNK : size - done;
+        if (write) {
+            W25Q64_FS_Write(&file, Bench_Data + done % BENCH_MAX_SIZE, n);
+        } else {
+            W25Q64_FS_Read(&file, Bench_Read, n);
+        }
+    }
+    W25Q64_FS_Close(&file);
+
+    return size / 1024.0 / ((Flash_Sim_Now() - start) / 1e6);
+}
+
+static void Bench_Throughput(void)
+{
+    char name[16];
+
+    Flash_Sim_Init();
+    W25Q64_Cache_InvalidateAll();
+    W25Q64_FS_Format(&Bench_Flash);
+    Bench_Fill(Bench_Data, 0, 1, BENCH_MAX_SIZE);
+    W25Q64_Cache_ResetStats();
+
+    printf("64 KB file   write %.1f KB/s (blank)  ", Bench_Transfer("fw.bin", 65536, true));
+    printf("write %.1f KB/s (rewrite)  ", Bench_Transfer("fw.bin", 65536, true));
+    printf("read %.1f KB/s\n", Bench_Transfer("fw.bin", 65536, false));
+    Bench_CacheReport("64 KB files");
+
+    double start = Flash_Sim_Now();
+    for (int i = 0; i < 100; i++) {
+        sprintf(name, "cal%d", i % 10);
+        Bench_Transfer(name, 256, true);
+    }
+    printf("256 B file   %.2f ms per create/replace (commit included)\n",
+           (Flash_Sim_Now() - start) / 1000.0 / 100);
+    Bench_CacheReport("256 B create/replace");
+
+    start = Flash_Sim_Now();
+    for (int i = 0; i < 100; i++) {
+        W25Q64_FS_File file;
+        W25Q64_FS_Open(&file, "cal3", W25Q64_FS_READ);
+        W25Q64_FS_Read(&file, Bench_Read, 256);
+        W25Q64_FS_Close(&file);
+    }
+    printf("256 B file   %.2f ms per open+read\n", (Flash_Sim_Now() - start) / 1000.0 / 100);
+    Bench_CacheReport("256 B open+read");
+    printf("free %u KB\n", W25Q64_FS_Free() / 1024);
+}
+
+/**
+ * @brief Check one file against its expected (old or new) state
+ */
+static bool Bench_Check(int k, const Bench_State *oldState, const Bench_State *newState, Bench_State *actual)
+{
+    W25Q64_FS_File file;
+    char name[16];
+    const Bench_State *states[2] = { oldState, newState };
+
+    Bench_Name(name, k);
+    if (W25Q64_FS_Open(&file, name, W25Q64_FS_READ) != W25Q64_FS_OK) {
+        for (int i = 0; i < 2; i++) {
+            if (states[i]->version == 0) {
+                *actual = *states[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t size = file.entry.size;
+    uint32_t got = W25Q64_FS_Read(&file, Bench_Read, sizeof(Bench_Read));
+    W25Q64_FS_Close(&file);
+    if (got != size) return false;
+
+    for (int i = 0; i < 2; i++) {
+        if (states[i]->version == 0 || states[i]->size != size) continue;
+        Bench_Fill(Bench_Data, k, states[i]->version, size);
+        if (memcmp(Bench_Data, Bench_Read, size) == 0) {
+            *actual = *states[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+static void Bench_PowerCuts(int cuts)
+{
+    int bad = 0, mountErrors = 0, ops = 0;
+
+    Flash_Sim_Init();
+    W25Q64_Cache_InvalidateAll();
+    W25Q64_FS_Format(&Bench_Flash);
+    memset(Bench_Files, 0, sizeof(Bench_Files));
+    W25Q64_Cache_ResetStats();
+
+    for (int cut = 0; cut < cuts; cut++) {
+        Flash_Sim_SetPowerCut(1 + Bench_Rand() % 300);
+
+        while (1) {
+            int k = Bench_Rand() % BENCH_FILES;
+            int op = Bench_Rand() % 4;
+            char name[16];
+            Bench_State next = Bench_Files[k];
+            W25Q64_FS_File file;
+
+            Bench_Name(name, k);
+            if (op == 0 && next.version) {
+                W25Q64_FS_Remove(name);
+                next.version = 0;
+                next.size = 0;
+            } else if (op == 1 && next.version && next.size < BENCH_MAX_SIZE) {
+                // Append: same version stream, longer
+                uint32_t add = Bench_Rand() % 3000 + 1;
+                Bench_Fill(Bench_Data, k, next.version, next.size + add);
+                W25Q64_FS_Open(&file, name, W25Q64_FS_APPEND);
+                W25Q64_FS_Write(&file, Bench_Data + next.size, add);
+                W25Q64_FS_Close(&file);
+                next.size += add;
+            } else {
+                next.version = Bench_Files[k].version + cut * 1000 + ops + 1;
+                next.size = Bench_Rand() % BENCH_MAX_SIZE;
+                Bench_Fill(Bench_Data, k, next.version, next.size);
+                W25Q64_FS_Open(&file, name, W25Q64_FS_WRITE);
+                for (uint32_t done = 0; done < next.size; ) {
+                    uint32_t n = Bench_Rand() % 1500 + 1;
+                    if (n > next.size - done) n = next.size - done;
+                    W25Q64_FS_Write(&file, Bench_Data + done, n);
+                    done += n;
+                }
+                W25Q64_FS_Close(&file);
+            }
+            ops++;
+
+            if (Flash_Sim_PowerLost()) {
+                Flash_Sim_PowerOn();
+                if (W25Q64_FS_Mount(&Bench_Flash) != W25Q64_FS_OK) {
+                    mountErrors++;
+                    W25Q64_FS_Format(&Bench_Flash);
+                    memset(Bench_Files, 0, sizeof(Bench_Files));
+                    break;
+                }
+                for (int f = 0; f < BENCH_FILES; f++) {
+                    Bench_State actual;
+                    const Bench_State *newState = f == k ? &next : &Bench_Files[f];
+                    if (Bench_Check(f, &Bench_Files[f], newState, &actual)) {
+                        Bench_Files[f] = actual;
+                    } else {
+                        bad++;
+                        printf("cut %d: file%d corrupted\n", cut, f);
+                    }
+                }
+                break;
+            }
+            Bench_Files[k] = next;
+        }
+    }
+
+    printf("power cuts %d  operations %d  mount errors %d  corrupted files %d  free %u KB\n",
+           cuts, ops, mountErrors, bad, W25Q64_FS_Free() / 1024);
+    Bench_CacheReport("mixed with remounts");
+}
+
+int main(int argc, char **argv)
+{
+    int cuts = argc > 1 ? atoi(argv[1]) : 3000;
+
+    Bench_Throughput();
+    Bench_PowerCuts(cuts);
+
+    return 0;
+}
@@ -0,0 +1,243 @@
+/****************************************************************************/ /**
+ * @file   Flash_Sim.c
+ * @brief  RAM-backed W25Q64 simulator for host-side benchmarks - Source File
+ *
+ * Time only advances through flash operations and Flash_Sim_Elapse(). An
+ * async erase keeps the device busy for FLASH_SIM_T_SECTOR_ERASE; a program
+ * or erase issued meanwhile waits for it (like W25Q64_WriteEnable()), a read
+ * pays the suspend/resume overhead instead (like W25Q64_ReadData()).
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 14:32:50
+ ********************************************************************************/
+
+#include "Flash_Sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FLASH_SIM_T_SUSPEND         40.0    // tSUS + resume holdoff
+
+static uint8_t *Flash_Sim_Mem;
+static double Flash_Sim_Time;
+static double Flash_Sim_BusyUntil;
+static uint32_t Flash_Sim_CutAfter;         // 0: no power cut scheduled
+static bool Flash_Sim_Dead;
+static uint32_t Flash_Sim_Seed = 12345;
+static Flash_Sim_Stats Flash_Sim_Counters;
+
+/**
+ * @brief Small LCG so torn operations are reproducible
+ */
+static uint32_t Flash_Sim_Rand(void)
+{
+    Flash_Sim_Seed = Flash_Sim_Seed * 1103515245u + 12345u;
+    return Flash_Sim_Seed >> 16;
+}
+
+/**
+ * @brief Wait for a running async erase, counting the stall
+ */
+static void Flash_Sim_WaitIdle(void)
+{
+    if (Flash_Sim_Time < Flash_Sim_BusyUntil) {
+        Flash_Sim_Counters.busyUs += Flash_Sim_BusyUntil - Flash_Sim_Time;
+        Flash_Sim_Time = Flash_Sim_BusyUntil;
+    }
+}
+
+/**
+ * @brief Account one program/erase against the scheduled power cut
+ *
+ * @return true Operation completes normally
+ * @return false Power is gone (this operation is torn if it was the last one)
+ */
+static bool Flash_Sim_PowerOk(bool *torn)
+{
+    *torn = false;
+    if (Flash_Sim_Dead) return false;
+    if (Flash_Sim_CutAfter && --Flash_Sim_CutAfter == 0) {
+        Flash_Sim_Dead = true;
+        *torn = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Allocate the array and set it to the erased state
+ */
+void Flash_Sim_Init(void)
+{
+    if (Flash_Sim_Mem == NULL) {
+        Flash_Sim_Mem = malloc(FLASH_SIM_SIZE);
+        if (Flash_Sim_Mem == NULL) {
+            fprintf(stderr, "Flash_Sim: out of memory\n");
+            exit(1);
+        }
+    }
+    memset(Flash_Sim_Mem, 0xFF, FLASH_SIM_SIZE);
+    Flash_Sim_Time = 0;
+    Flash_Sim_BusyUntil = 0;
+    Flash_Sim_CutAfter = 0;
+    Flash_Sim_Dead = false;
+    Flash_Sim_ResetStats();
+}
+
+/**
+ * @brief Read Data (any length, wraps at the end of the array)
+ */
+void Flash_Sim_Read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    double cost = (FLASH_SIM_CMD_BYTES + len) * FLASH_SIM_T_BYTE;
+
+    if (Flash_Sim_Time < Flash_Sim_BusyUntil) {
+        cost += FLASH_SIM_T_SUSPEND;
+        Flash_Sim_BusyUntil += cost;
+    }
+    Flash_Sim_Time += cost;
+
+    for (uint32_t i = 0; i < len; i++) {
+        buf[i] = Flash_Sim_Mem[(addr + i) % FLASH_SIM_SIZE];
+    }
+    Flash_Sim_Counters.readBytes += len;
+}
+
+/**
+ * @brief Page Program: bits can only go 1 -> 0, addresses wrap inside the page
+ */
+void Flash_Sim_Program(uint32_t addr, const uint8_t *buf, uint16_t len)
+{
+    uint32_t page = addr & ~(uint32_t)(FLASH_SIM_PAGE_SIZE - 1);
+    bool torn;
+
+    Flash_Sim_WaitIdle();
+    if (!Flash_Sim_PowerOk(&torn) && !torn) return;
+
+    Flash_Sim_Time += (FLASH_SIM_CMD_BYTES + len) * FLASH_SIM_T_BYTE + FLASH_SIM_T_PAGE_PROGRAM;
+    Flash_Sim_Counters.programOps++;
+    Flash_Sim_Counters.programBytes += len;
+
+    for (uint16_t i = 0; i < len; i++) {
+        uint32_t a = page + ((addr + i) & (FLASH_SIM_PAGE_SIZE - 1));
+        uint8_t value = buf[i];
+
+        if (torn) {
+            if (Flash_Sim_Rand() & 1) continue;         // Byte never reached the array
+            value |= (uint8_t)Flash_Sim_Rand();         // Some bits only half programmed
+        }
+        if (!torn && (Flash_Sim_Mem[a] & value) != value) Flash_Sim_Counters.violations++;
+        Flash_Sim_Mem[a] &= value;
+    }
+}
+
+/**
+ * @brief Sector Erase, blocking
+ */
+void Flash_Sim_Erase(uint32_t addr)
+{
+    Flash_Sim_EraseAsync(addr);
+    Flash_Sim_WaitIdle();
+}
+
+/**
+ * @brief Sector Erase, returns immediately and keeps the device busy
+ *
+ * @return true Erase started (always, a pending erase is waited for first)
+ */
+bool Flash_Sim_EraseAsync(uint32_t addr)
+{
+    uint32_t sector = (addr % FLASH_SIM_SIZE) & ~(uint32_t)(FLASH_SIM_SECTOR_SIZE - 1);
+    bool torn;
+
+    Flash_Sim_WaitIdle();
+    if (!Flash_Sim_PowerOk(&torn) && !torn) return true;
+
+    Flash_Sim_Time += FLASH_SIM_CMD_BYTES * FLASH_SIM_T_BYTE;
+    Flash_Sim_BusyUntil = Flash_Sim_Time + FLASH_SIM_T_SECTOR_ERASE;
+    Flash_Sim_Counters.eraseOps++;
+
+    if (torn) {
+        for (uint32_t i = 0; i < FLASH_SIM_SECTOR_SIZE; i++) {
+            if (Flash_Sim_Rand() & 1) Flash_Sim_Mem[sector + i] = 0xFF;
+        }
+    } else {
+        memset(&Flash_Sim_Mem[sector], 0xFF, FLASH_SIM_SECTOR_SIZE);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check the async erase
+ */
+bool Flash_Sim_IsBusy(void)
+{
+    return Flash_Sim_Time < Flash_Sim_BusyUntil;
+}
+
+/**
+ * @brief Wait for the async erase
+ */
+void Flash_Sim_Sync(void)
+{
+    Flash_Sim_WaitIdle();
+}
+
+/**
+ * @brief Let host-side time pass (CPU work, idle time between writes)
+ */
+void Flash_Sim_Elapse(double us)
+{
+    Flash_Sim_Time += us;
+}
+
+/**
+ * @brief Simulated time since Flash_Sim_Init(), microseconds
+ */
+double Flash_Sim_Now(void)
+{
+    return Flash_Sim_Time;
+}
+
+/**
+ * @brief Cut power during the Nth program/erase from now (0 disables)
+ */
+void Flash_Sim_SetPowerCut(uint32_t ops)
+{
+    Flash_Sim_CutAfter = ops;
+}
+
+/**
+ * @brief Check whether the scheduled power cut has happened
+ */
+bool Flash_Sim_PowerLost(void)
+{
+    return Flash_Sim_Dead;
+}
+
+/**
+ * @brief Restore power, the array keeps its (possibly torn) contents
+ */
+void Flash_Sim_PowerOn(void)
+{
+    Flash_Sim_Dead = false;
+    Flash_Sim_CutAfter = 0;
+    Flash_Sim_BusyUntil = Flash_Sim_Time;
+}
+
+/**
+ * @brief Get the operation counters
+ */
+void Flash_Sim_GetStats(Flash_Sim_Stats *stats)
+{
+    *stats = Flash_Sim_Counters;
+}
+
+/**
+ * @brief Clear the operation counters
+ */
+void Flash_Sim_ResetStats(void)
+{
+    memset(&Flash_Sim_Counters, 0, sizeof(Flash_Sim_Counters));
+}
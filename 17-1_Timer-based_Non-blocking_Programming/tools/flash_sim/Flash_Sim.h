@@ -0,0 +1,55 @@
+/****************************************************************************/ /**
+ * @file   Flash_Sim.h
+ * @brief  RAM-backed W25Q64 simulator for host-side benchmarks - Header File
+ *
+ * Models NOR semantics (program only clears bits, erase sets a sector to
+ * 0xFF, programs wrap inside a page) and datasheet typical timings at the
+ * 18 MHz SPI1 clock. A power cut can be scheduled after N program/erase
+ * operations: that operation is torn and every later one is dropped until
+ * Flash_Sim_PowerOn().
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 14:32:50
+ ********************************************************************************/
+
+#ifndef __FLASH_SIM_H__
+#define __FLASH_SIM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FLASH_SIM_SIZE              0x800000    // 8 MB (W25Q64)
+#define FLASH_SIM_PAGE_SIZE         256
+#define FLASH_SIM_SECTOR_SIZE       4096
+
+// Timing model, microseconds (W25Q64JV typical values)
+#define FLASH_SIM_T_PAGE_PROGRAM    700.0
+#define FLASH_SIM_T_SECTOR_ERASE    45000.0
+#define FLASH_SIM_T_BYTE            (8.0 / 18.0)    // One byte at 18 MHz
+#define FLASH_SIM_CMD_BYTES         5               // Opcode + 3 address + dummy
+
+typedef struct {
+    uint64_t readBytes;
+    uint64_t programBytes;
+    uint32_t programOps;
+    uint32_t eraseOps;
+    uint32_t violations;        // Programs that tried to set a 0 bit back to 1
+    double busyUs;              // Time the caller spent waiting on the flash
+} Flash_Sim_Stats;
+
+void Flash_Sim_Init(void);
+void Flash_Sim_Read(uint32_t addr, uint8_t *buf, uint32_t len);
+void Flash_Sim_Program(uint32_t addr, const uint8_t *buf, uint16_t len);
+void Flash_Sim_Erase(uint32_t addr);
+bool Flash_Sim_EraseAsync(uint32_t addr);
+bool Flash_Sim_IsBusy(void);
+void Flash_Sim_Sync(void);
+void Flash_Sim_Elapse(double us);
+double Flash_Sim_Now(void);
+void Flash_Sim_SetPowerCut(uint32_t ops);
+bool Flash_Sim_PowerLost(void);
+void Flash_Sim_PowerOn(void);
+void Flash_Sim_GetStats(Flash_Sim_Stats *stats);
+void Flash_Sim_ResetStats(void);
+
+#endif // !__FLASH_SIM_H__
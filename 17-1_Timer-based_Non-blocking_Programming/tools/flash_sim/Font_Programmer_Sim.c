@@ -0,0 +1,328 @@
+/****************************************************************************/ /**
+ * @file   Font_Programmer_Sim.c
+ * @brief  Host run of Font_Programmer_CH() against window_uploader.py
+ *
+ * Build and run from this directory (Linux, needs pyserial):
+ *   gcc -O2 -std=c99 -no-pie -DUSE_STDPERIPH_DRIVER -DSTM32F10X_MD \
+ *       -I../../src -I../../lib/cmsis -I../../lib/STM32F10x_StdPeriph_Driver \
+ *       -I../../lib/STM32F10x_StdPeriph_Driver/inc \
+ *       -I../../hardware/inc -I../../system/inc \
+ *       Font_Programmer_Sim.c ../../hardware/src/Font_Programmer.c ../../hardware/src/CRC16.c \
+ *       -o font_programmer_sim
+ *   ./font_programmer_sim font.bin [delay_prob delay_ms drop_prob]
+ *
+ * The real Font_Programmer.c runs with its USART1, DMA and W25Q64 calls
+ * bound to a pseudo terminal and a RAM image of the flash. window_uploader.py
+ * is started on the other end of the terminal with its fault injection
+ * constants set from the command line. Received bytes enter the DMA ring at
+ * the data phase baud rate, as the circular DMA channel would write them.
+ * -no-pie keeps the ring below 4 GB, DMA_MemoryBaseAddr is 32 bits.
+ *
+ * The flash takes real time: a page program or sector erase first shifts
+ * its command and data at 18 MHz with the CPU spinning, then keeps the chip
+ * busy for the typical tPP or tSE from Flash_Sim.h. W25Q64_Sync() spins
+ * until then while the DMA ring keeps filling. The data phase throughput is
+ * reported against the 921600 baud line rate (10 bits per byte).
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 23:05:47
+ ********************************************************************************/
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include "Font_Programmer.h"
+#include "Delay.h"
+#include "Flash_Sim.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_FLASH_SIZE      0x800000
+#define SIM_UPLOADER_DIR    "../../../096_OLED_4Pins_I2C/CH_Flash"
+
+struct Serial_Port { int unused; };
+Serial_Port Serial_Port1;
+
+static uint8_t Sim_Flash[SIM_FLASH_SIZE];
+static int Sim_Pty = -1;
+static uint8_t *Sim_Ring;
+static uint32_t Sim_RingSize;
+static uint32_t Sim_RingPos;
+static int Sim_DmaOn;
+static uint8_t Sim_Pending[4096];       // Bytes read from the terminal, not yet "on the wire"
+static uint32_t Sim_PendingLen;
+static uint32_t Sim_PendingPos;
+static double Sim_WireUs;               // Time the last byte finished arriving
+static uint32_t Sim_Naks;
+static uint8_t Sim_ReplyLeft;           // Sequence bytes still to come in the current reply
+static int Sim_LengthAcked;
+static uint32_t Sim_ProgramErrors;
+static double Sim_FlashBusyUs;          // Time the internal program/erase finishes
+static double Sim_FlashWaitUs;          // Time spent in W25Q64_Sync() waiting for it
+static double Sim_DataStartUs;          // DMA ring armed
+static double Sim_DataEndUs;            // DMA ring stopped
+
+static double Sim_NowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * @brief Move bytes from the terminal to the DMA ring at the line rate
+ */
+static void Sim_Poll(void)
+{
+    double now = Sim_NowUs();
+    double byteUs = 10e6 / FONT_PROGRAMMER_BAUDRATE;
+
+    if (!Sim_DmaOn) return;
+
+    if (Sim_PendingPos == Sim_PendingLen) {
+        ssize_t n = read(Sim_Pty, Sim_Pending, sizeof(Sim_Pending));
+        if (n <= 0) return;
+        Sim_PendingLen = n;
+        Sim_PendingPos = 0;
+        if (Sim_WireUs < now) Sim_WireUs = now;
+    }
+
+    while (Sim_PendingPos < Sim_PendingLen && Sim_WireUs + byteUs <= now) {
+        Sim_Ring[Sim_RingPos] = Sim_Pending[Sim_PendingPos++];
+        Sim_RingPos = (Sim_RingPos + 1) % Sim_RingSize;
+        Sim_WireUs += byteUs;
+    }
+}
+
+void Delay_us(uint32_t us)
+{
+    double end = Sim_NowUs() + us;
+
+    while (Sim_NowUs() < end) Sim_Poll();
+}
+
+// USART1 before the DMA starts: the length header is read polled
+FlagStatus USART_GetFlagStatus(USART_TypeDef *USARTx, uint16_t USART_FLAG)
+{
+    uint8_t b;
+
+    (void)USARTx;
+    (void)USART_FLAG;
+    if (Sim_PendingPos < Sim_PendingLen) return SET;
+    if (read(Sim_Pty, &b, 1) != 1) return RESET;
+    Sim_Pending[0] = b;
+    Sim_PendingLen = 1;
+    Sim_PendingPos = 0;
+    return SET;
+}
+
+uint16_t USART_ReceiveData(USART_TypeDef *USARTx)
+{
+    (void)USARTx;
+    return Sim_Pending[Sim_PendingPos++];
+}
+
+void USART_ITConfig(USART_TypeDef *USARTx, uint16_t USART_IT, FunctionalState NewState)
+{
+    (void)USARTx; (void)USART_IT; (void)NewState;
+}
+
+void USART_DMACmd(USART_TypeDef *USARTx, uint16_t USART_DMAReq, FunctionalState NewState)
+{
+    (void)USARTx; (void)USART_DMAReq; (void)NewState;
+}
+
+void RCC_AHBPeriphClockCmd(uint32_t RCC_AHBPeriph, FunctionalState NewState)
+{
+    (void)RCC_AHBPeriph; (void)NewState;
+}
+
+void DMA_DeInit(DMA_Channel_TypeDef *DMAy_Channelx)
+{
+    (void)DMAy_Channelx;
+}
+
+void DMA_Init(DMA_Channel_TypeDef *DMAy_Channelx, DMA_InitTypeDef *DMA_InitStruct)
+{
+    (void)DMAy_Channelx;
+    Sim_Ring = (uint8_t *)(uintptr_t)DMA_InitStruct->DMA_MemoryBaseAddr;
+    Sim_RingSize = DMA_InitStruct->DMA_BufferSize;
+    Sim_RingPos = 0;
+}
+
+void DMA_Cmd(DMA_Channel_TypeDef *DMAy_Channelx, FunctionalState NewState)
+{
+    (void)DMAy_Channelx;
+    Sim_DmaOn = (NewState == ENABLE);
+    if (Sim_DmaOn) Sim_DataStartUs = Sim_NowUs();
+    else Sim_DataEndUs = Sim_NowUs();
+}
+
+void DMA_SetCurrDataCounter(DMA_Channel_TypeDef *DMAy_Channelx, uint16_t DataNumber)
+{
+    (void)DMAy_Channelx;
+    Sim_RingPos = (Sim_RingSize - DataNumber) % Sim_RingSize;
+}
+
+uint16_t DMA_GetCurrDataCounter(DMA_Channel_TypeDef *DMAy_Channelx)
+{
+    (void)DMAy_Channelx;
+    Sim_Poll();
+    return Sim_RingSize - Sim_RingPos;
+}
+
+void Serial_Init(Serial_Port *port)
+{
+    (void)port;
+}
+
+void Serial_SendByte(Serial_Port *port, uint8_t b)
+{
+    (void)port;
+    if (Sim_ReplyLeft > 0) {
+        Sim_ReplyLeft--;
+    } else if (!Sim_LengthAcked) {
+        Sim_LengthAcked = 1;            // Lone 'A' after the length
+    } else {
+        if (b == 'N') Sim_Naks++;
+        Sim_ReplyLeft = 2;
+    }
+    if (write(Sim_Pty, &b, 1) != 1) perror("write");
+}
+
+void Serial_SendString(Serial_Port *port, char *str)
+{
+    (void)port;
+    if (write(Sim_Pty, str, strlen(str)) < 0) perror("write");
+}
+
+void Serial_Printf(Serial_Port *port, char *format, ...)
+{
+    char line[128];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    Serial_SendString(port, line);
+}
+
+uint8_t Serial_SetBaudrate(Serial_Port *port, uint32_t baudrate)
+{
+    (void)port; (void)baudrate;
+    return 1;
+}
+
+void W25Q64_Init(void)
+{
+    memset(Sim_Flash, 0x5A, sizeof(Sim_Flash));     // Not erased
+}
+
+void W25Q64_Sync(void)
+{
+    double start = Sim_NowUs();
+
+    while (Sim_NowUs() < Sim_FlashBusyUs) Sim_Poll();
+    Sim_FlashWaitUs += Sim_NowUs() - start;
+}
+
+/**
+ * @brief Spin for the SPI shift of a command, then keep the chip busy
+ */
+static bool Sim_FlashStart(uint16_t bytes, double busyUs)
+{
+    if (Sim_NowUs() < Sim_FlashBusyUs) return false;    // Like W25Q64_IsBusy()
+
+    Delay_us((uint32_t)(bytes * FLASH_SIM_T_BYTE + 0.5));
+    Sim_FlashBusyUs = Sim_NowUs() + busyUs;
+    return true;
+}
+
+bool W25Q64_EraseSectorAsync(uint32_t addr)
+{
+    if (!Sim_FlashStart(4, FLASH_SIM_T_SECTOR_ERASE)) return false;
+    memset(&Sim_Flash[addr & ~0xFFFu], 0xFF, 4096);
+    return true;
+}
+
+bool W25Q64_PageProgramAsync(uint32_t addr, const uint8_t *dataArr, uint16_t len)
+{
+    if (!Sim_FlashStart(4 + len, FLASH_SIM_T_PAGE_PROGRAM)) return false;
+    for (uint16_t i = 0; i < len; i++) {
+        if (Sim_Flash[addr + i] != 0xFF) Sim_ProgramErrors++;
+        Sim_Flash[addr + i] &= dataArr[i];
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *delayProb = argc > 2 ? argv[2] : "0";
+    const char *delayMs = argc > 3 ? argv[3] : "30";
+    const char *dropProb = argc > 4 ? argv[4] : "0";
+    char script[512];
+    struct termios tio;
+    uint8_t *font;
+    long size;
+    FILE *f;
+    int slave, status;
+    double start, data;
+    pid_t pid;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s font.bin [delay_prob delay_ms drop_prob]\n", argv[0]);
+        return 2;
+    }
+
+    f = fopen(argv[1], "rb");
+    if (f == NULL) { perror(argv[1]); return 2; }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    rewind(f);
+    font = malloc(size);
+    if (fread(font, 1, size, f) != (size_t)size) { perror(argv[1]); return 2; }
+    fclose(f);
+
+    Sim_Pty = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(Sim_Pty);
+    unlockpt(Sim_Pty);
+    slave = open(ptsname(Sim_Pty), O_RDWR | O_NOCTTY);     // Held open so early output is kept
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(Sim_Pty, F_SETFL, O_NONBLOCK);
+
+    snprintf(script, sizeof(script),
+             "import sys; sys.path.insert(0, '%s'); import window_uploader as w; "
+             "w.FAULT_DELAY_PROB = %s; w.FAULT_DELAY_MS = %s; w.FAULT_DROP_PROB = %s; "
+             "sys.exit(0 if w.upload_font('%s', 115200, '%s') else 1)",
+             SIM_UPLOADER_DIR, delayProb, delayMs, dropProb, ptsname(Sim_Pty), argv[1]);
+    pid = fork();
+    if (pid == 0) {
+        execlp("python3", "python3", "-c", script, (char *)0);
+        _exit(127);
+    }
+    usleep(500000);     // Let the uploader open the port and wait for READY
+
+    start = Sim_NowUs();
+    Font_Programmer_CH();
+    waitpid(pid, &status, 0);
+
+    printf("firmware: %.2f s, %u NAKs, %u program errors, image %s\n",
+           (Sim_NowUs() - start) / 1e6, Sim_Naks, Sim_ProgramErrors,
+           memcmp(&Sim_Flash[FONT_PROGRAMMER_W25Q64_START_ADDR], font, size) == 0 ? "matches" : "DIFFERS");
+    data = (Sim_DataEndUs - Sim_DataStartUs) / 1e6;
+    printf("data phase: %.2f s, %.1f KB/s = %.1f%% of line rate, %.2f s in W25Q64_Sync()\n",
+           data, size / data / 1000, 100.0 * size / data / (FONT_PROGRAMMER_BAUDRATE / 10.0),
+           Sim_FlashWaitUs / 1e6);
+    close(slave);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
@@ -0,0 +1,388 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_Async_Test.c
+ * @brief  Host test of the W25Q64 driver's suspend/resume bookkeeping
+ *
+ * Build and run from this directory:
+ *   gcc -O2 -std=c99 -pthread -Ihost -I../../hardware/inc -I../../system/inc \
+ *       W25Q64_Async_Test.c ../../hardware/src/W25Q64.c -o w25q64_async_test
+ *   ./w25q64_async_test
+ *
+ * The real W25Q64.c runs against a command-level model of the chip: BUSY,
+ * WEL, Erase/Program Suspend and Resume, reads and erases. A second thread
+ * plays the SPI DMA interrupt: it runs the queued transaction of
+ * W25Q64_ReadDataAsync() a little later, callback included, while the main
+ * thread keeps going. The model counts commands the chip would ignore
+ * (sent while busy or suspended) and reads issued while an operation runs.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 22:10:12
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "W25Q64.h"
+#include "W25Q64_Cache.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define CHIP_SIZE           0x10000     // Addresses wrap, the tests stay below
+#define CHIP_T_ERASE_US     2000.0
+#define CHIP_T_PROGRAM_US   700.0
+#define CHIP_T_BYTE_US      (8.0 / 18.0)
+#define DMA_DELAY_US        2000        // Queued transaction starts this late
+
+GPIO_TypeDef Host_GPIOA;
+
+// Chip model
+typedef struct {
+    uint8_t mem[CHIP_SIZE];
+    uint8_t cmd[5 + 256];
+    uint16_t count;             // Bytes since CS low
+    uint8_t op;                 // W25Q64_OP_x running or suspended
+    uint32_t opAddr;
+    double opLeftUs;
+    int wel;
+    int suspended;
+    int readWhileBusy;          // Command of this CS was a read during an operation
+    uint32_t ignored;           // Commands the device drops
+    uint32_t badReads;          // Reads while erasing/programming
+} Chip_Model;
+
+static Chip_Model Chip;
+static pthread_mutex_t Chip_Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t Bus_Lock = PTHREAD_MUTEX_INITIALIZER;
+static SPI_Bus_Transaction *volatile Bus_Queued = 0;
+static volatile int Bus_Running = 0;
+static volatile int Dma_Stop = 0;
+static pthread_t Dma_Thread;
+static volatile int Test_Done;
+static int Test_Failures = 0;
+
+static int Chip_Busy(void)
+{
+    return Chip.op != W25Q64_OP_NONE && !Chip.suspended;
+}
+
+static void Chip_Elapse(double us)
+{
+    if (!Chip_Busy()) return;
+
+    Chip.opLeftUs -= us;
+    if (Chip.opLeftUs > 0) return;
+
+    if (Chip.op == W25Q64_OP_ERASE) {
+        memset(&Chip.mem[Chip.opAddr & ~(uint32_t)(W25Q64_SECTOR_SIZE - 1) & (CHIP_SIZE - 1)],
+               0xFF, W25Q64_SECTOR_SIZE);
+    }
+    Chip.op = W25Q64_OP_NONE;
+    Chip.wel = 0;
+}
+
+static uint32_t Chip_Address(void)
+{
+    return ((uint32_t)Chip.cmd[1] << 16 | Chip.cmd[2] << 8 | Chip.cmd[3]) & (CHIP_SIZE - 1);
+}
+
+static void Chip_Select(void)
+{
+    pthread_mutex_lock(&Chip_Lock);
+    Chip.count = 0;
+    Chip.readWhileBusy = 0;
+    pthread_mutex_unlock(&Chip_Lock);
+}
+
+static uint8_t Chip_Transfer(uint8_t mosi)
+{
+    uint8_t miso = 0xFF;
+    uint16_t n;
+
+    pthread_mutex_lock(&Chip_Lock);
+    Chip_Elapse(CHIP_T_BYTE_US);
+    n = Chip.count++;
+    if (n < sizeof(Chip.cmd)) Chip.cmd[n] = mosi;
+
+    switch (Chip.cmd[0]) {
+        case W25Q64_READ_STATUS_REG1:
+            miso = (Chip_Busy() ? W25Q64_SR1_BUSY : 0) | (Chip.wel ? 0x02 : 0);
+            break;
+        case W25Q64_READ_STATUS_REG2:
+            miso = Chip.suspended ? W25Q64_SR2_SUS : 0;
+            break;
+        case W25Q64_READ_DATA:
+        case W25Q64_FAST_READ: {
+            uint16_t header = Chip.cmd[0] == W25Q64_FAST_READ ? 5 : 4;
+
+            if (n == 0 && Chip_Busy()) Chip.readWhileBusy = 1;
+            if (n >= header) miso = Chip.mem[(Chip_Address() + n - header) & (CHIP_SIZE - 1)];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&Chip_Lock);
+
+    return miso;
+}
+
+static void Chip_Deselect(void)
+{
+    uint8_t cmd = Chip.cmd[0];
+
+    pthread_mutex_lock(&Chip_Lock);
+    if (Chip.count == 0) {
+        pthread_mutex_unlock(&Chip_Lock);
+        return;
+    }
+
+    if (Chip.readWhileBusy) Chip.badReads++;
+
+    switch (cmd) {
+        case W25Q64_READ_STATUS_REG1:
+        case W25Q64_READ_STATUS_REG2:
+        case W25Q64_READ_DATA:
+        case W25Q64_FAST_READ:
+        case W25Q64_RELEASE_POWER_DOWN:
+            break;
+
+        case W25Q64_ERASE_PROGRAM_SUSPEND:
+            if (Chip_Busy()) Chip.suspended = 1;
+            break;
+
+        case W25Q64_ERASE_PROGRAM_RESUME:
+            Chip.suspended = 0;
+            break;
+
+        case W25Q64_WRITE_ENABLE:
+            if (Chip.op != W25Q64_OP_NONE) {
+                Chip.ignored++;
+            } else {
+                Chip.wel = 1;
+            }
+            break;
+
+        case W25Q64_SECTOR_ERASE:
+        case W25Q64_PAGE_PROGRAM:
+            if (Chip.op != W25Q64_OP_NONE || !Chip.wel || Chip.count < 4) {
+                Chip.ignored++;
+                break;
+            }
+            Chip.opAddr = Chip_Address();
+            if (cmd == W25Q64_SECTOR_ERASE) {
+                Chip.op = W25Q64_OP_ERASE;
+                Chip.opLeftUs = CHIP_T_ERASE_US;
+            } else {
+                for (uint16_t i = 4; i < Chip.count && i < sizeof(Chip.cmd); i++) {
+                    uint32_t a = (Chip.opAddr & ~0xFFu) | ((Chip.opAddr + i - 4) & 0xFF);
+                    Chip.mem[a & (CHIP_SIZE - 1)] &= Chip.cmd[i];
+                }
+                Chip.op = W25Q64_OP_PROGRAM;
+                Chip.opLeftUs = CHIP_T_PROGRAM_US;
+            }
+            break;
+
+        default:
+            if (Chip_Busy()) Chip.ignored++;
+            break;
+    }
+    pthread_mutex_unlock(&Chip_Lock);
+}
+
+// Platform functions used by W25Q64.c
+
+uint32_t __get_PRIMASK(void) { return 0; }
+void __set_PRIMASK(uint32_t priMask) { (void)priMask; }
+void __disable_irq(void) {}
+void DWT_Init(void) {}     // W25Q64_Benchmark() is not run here
+
+void Delay_us(uint32_t us)
+{
+    pthread_mutex_lock(&Chip_Lock);
+    Chip_Elapse(us);
+    pthread_mutex_unlock(&Chip_Lock);
+}
+
+uint8_t Hard_SPI_TransferByte(uint8_t data)
+{
+    return Chip_Transfer(data);
+}
+
+void Hard_SPI_DMA_Transfer(const uint8_t *pTxData, uint8_t *pRxData, uint16_t size)
+{
+    for (uint16_t i = 0; i < size; i++) {
+        uint8_t rx = Chip_Transfer(pTxData ? pTxData[i] : W25Q64_DUMMY_BYTE);
+        if (pRxData) pRxData[i] = rx;
+    }
+}
+
+void W25Q64_Cache_Invalidate(uint32_t addr, uint32_t len) { (void)addr; (void)len; }
+void W25Q64_Cache_InvalidateAll(void) {}
+
+void SPI_Bus_Init(void) {}
+void SPI_Bus_AddDevice(SPI_Bus_Device *dev) { (void)dev; }
+void SPI_Bus_SetPrescaler(SPI_Bus_Device *dev, uint16_t prescaler) { (void)dev; (void)prescaler; }
+
+static int Bus_InDma(void)
+{
+    return Bus_Running && pthread_equal(pthread_self(), Dma_Thread);
+}
+
+/**
+ * @brief Polled transaction: waits for queued work like the real bus manager
+ */
+void SPI_Bus_Start(SPI_Bus_Device *dev)
+{
+    (void)dev;
+    if (!Bus_InDma()) {
+        while (Bus_Queued != 0);
+        pthread_mutex_lock(&Bus_Lock);
+    }
+    Chip_Select();
+}
+
+void SPI_Bus_Stop(void)
+{
+    Chip_Deselect();
+    if (!Bus_InDma()) pthread_mutex_unlock(&Bus_Lock);
+}
+
+bool SPI_Bus_Submit(SPI_Bus_Transaction *txn)
+{
+    if (Bus_Queued != 0) return false;
+    Bus_Queued = txn;
+    return true;
+}
+
+bool SPI_Bus_IsBusy(void)
+{
+    return Bus_Queued != 0;
+}
+
+/**
+ * @brief The "DMA interrupt": run a queued transaction DMA_DELAY_US after submit
+ */
+static void *Dma_Main(void *arg)
+{
+    struct timespec delay = { 0, DMA_DELAY_US * 1000L };
+
+    (void)arg;
+    while (!Dma_Stop) {
+        SPI_Bus_Transaction *txn = Bus_Queued;
+
+        if (txn == 0) {
+            nanosleep(&(struct timespec){ 0, 100000L }, 0);
+            continue;
+        }
+        nanosleep(&delay, 0);
+
+        pthread_mutex_lock(&Bus_Lock);
+        Bus_Running = 1;
+        Chip_Select();
+        for (uint8_t i = 0; i < txn->headerLen; i++) Chip_Transfer(txn->header[i]);
+        Hard_SPI_DMA_Transfer(txn->txData, txn->rxData, txn->len);
+        Chip_Deselect();
+        if (txn->callback) txn->callback(txn);
+        Bus_Running = 0;
+        Bus_Queued = 0;
+        pthread_mutex_unlock(&Bus_Lock);
+    }
+    return 0;
+}
+
+// Tests
+
+static void Test_ReadDone(void)
+{
+    Test_Done = 1;
+}
+
+static void Test_Check(int ok, const char *what)
+{
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) Test_Failures++;
+}
+
+static int Test_Pattern(const uint8_t *buf, uint32_t addr, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        if (buf[i] != (uint8_t)((addr + i) * 7 + 3)) return 0;
+    }
+    return 1;
+}
+
+static int Test_Erased(uint32_t addr)
+{
+    for (uint32_t i = 0; i < W25Q64_SECTOR_SIZE; i++) {
+        if (Chip.mem[addr + i] != 0xFF) return 0;
+    }
+    return 1;
+}
+
+static void Test_Reset(void)
+{
+    W25Q64_Sync();
+    memset(&Chip, 0, sizeof(Chip));
+    for (uint32_t i = 0; i < CHIP_SIZE; i++) Chip.mem[i] = (uint8_t)(i * 7 + 3);
+}
+
+/**
+ * @brief Async erase, async read, Sync, then a second async erase
+ */
+static void Test_SyncAfterAsyncRead(void)
+{
+    uint8_t buf[64];
+
+    printf("erase async, read async, sync, erase async\n");
+    Test_Reset();
+    Test_Done = 0;
+
+    Test_Check(W25Q64_EraseSectorAsync(0x0000), "first erase started");
+    Test_Check(W25Q64_ReadDataAsync(0x2000, buf, sizeof(buf), Test_ReadDone), "read queued");
+    W25Q64_Sync();
+    Test_Check(Test_Done && Test_Pattern(buf, 0x2000, sizeof(buf)), "read data intact");
+    Test_Check(!Chip.suspended && Chip.op == W25Q64_OP_NONE, "first erase complete after sync");
+    Test_Check(Test_Erased(0x0000), "sector 0 erased");
+
+    Test_Check(W25Q64_EraseSectorAsync(0x1000), "second erase started");
+    Test_Check(Chip.op == W25Q64_OP_ERASE, "second erase accepted by the chip");
+    W25Q64_Sync();
+    Test_Check(Test_Erased(0x1000), "sector 1 erased");
+    Test_Check(Chip.ignored == 0 && Chip.badReads == 0, "no ignored commands, no reads while busy");
+}
+
+/**
+ * @brief A blocking read while an async read holds the erase suspended
+ */
+static void Test_BlockingReadDuringAsyncRead(void)
+{
+    uint8_t asyncBuf[64];
+    uint8_t buf[64];
+
+    printf("erase async, read async, blocking read\n");
+    Test_Reset();
+    Test_Done = 0;
+
+    Test_Check(W25Q64_EraseSectorAsync(0x0000), "erase started");
+    Test_Check(W25Q64_ReadDataAsync(0x2000, asyncBuf, sizeof(asyncBuf), Test_ReadDone), "read queued");
+    W25Q64_ReadData(0x3000, buf, sizeof(buf));
+    Test_Check(Test_Pattern(buf, 0x3000, sizeof(buf)), "blocking read data intact");
+    while (!Test_Done);
+    Test_Check(Test_Pattern(asyncBuf, 0x2000, sizeof(asyncBuf)), "async read data intact");
+    Test_Check(Chip.badReads == 0, "no reads while the erase runs");
+    Test_Check(!Chip.suspended, "erase resumed");
+    W25Q64_Sync();
+    Test_Check(Test_Erased(0x0000) && Chip.ignored == 0, "erase complete");
+}
+
+int main(void)
+{
+    pthread_create(&Dma_Thread, 0, Dma_Main, 0);
+
+    Test_SyncAfterAsyncRead();
+    Test_BlockingReadDuringAsyncRead();
+
+    Dma_Stop = 1;
+    pthread_join(Dma_Thread, 0);
+
+    printf("%s\n", Test_Failures ? "FAILED" : "passed");
+    return Test_Failures ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/****************************************************************************/ /**
+ * @file   W25Q64_Verify_Test.c
+ * @brief  Host test of the W25Q64_Verify read/feed pipeline
+ *
+ * Build and run from this directory:
+ *   gcc -O2 -std=c99 -no-pie -Ihost -I../../hardware/inc -I../../system/inc \
+ *       W25Q64_Verify_Test.c ../../hardware/src/W25Q64_Verify.c -o w25q64_verify_test
+ *   ./w25q64_verify_test
+ *
+ * The real W25Q64_Verify.c runs against a model of its hardware: the CRC
+ * unit with the STM32F1 algorithm, the memory-to-memory DMA channel and
+ * W25Q64_ReadDataAsync(). A read completes a given number of
+ * W25Q64_Verify_Process() calls after it starts, as a 256-byte SPI DMA read
+ * spans several main-loop passes on the target; until then another read is
+ * refused, as the driver does. Some runs also refuse reads for a while as if
+ * another device held the bus.
+ * -no-pie keeps the buffers below 4 GB, CMAR is 32 bits.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 23:48:16
+ ********************************************************************************/
+
+#include "W25Q64_Verify.h"
+#include "W25Q64.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_FLASH_SIZE     0x4000
+#define TEST_MAX_CALLS      100000
+
+GPIO_TypeDef Host_GPIOA;
+DMA_Channel_TypeDef Host_DMA1_Channel1;
+CRC_TypeDef Host_CRC;
+
+static uint8_t Test_Flash[TEST_FLASH_SIZE];
+static int Test_Failures;
+
+// W25Q64_ReadDataAsync() model
+static uint32_t Read_Addr;
+static uint8_t *Read_Dest;
+static uint16_t Read_Len;
+static Hard_SPI_Callback Read_Callback;
+static int Read_Left;           // Process() calls until the read completes, -1 if idle
+static int Read_Delay;          // Calls a read takes
+static int Read_BusyEvery;      // Refuse reads on every n-th call as if the bus were taken
+static uint32_t Read_Calls;
+
+// CRC DMA model
+static int Dma_Enabled;
+static int Dma_TC;
+
+/**
+ * @brief One 32-bit word through the STM32F1 CRC unit
+ */
+static uint32_t Test_CRCWord(uint32_t crc, uint32_t word)
+{
+    crc ^= word;
+    for (int i = 0; i < 32; i++) {
+        crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+    }
+    return crc;
+}
+
+static uint32_t Test_CRC(uint32_t addr, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint32_t word;
+
+    for (uint32_t i = 0; i < len; i += 4) {
+        memcpy(&word, &Test_Flash[addr + i], 4);
+        crc = Test_CRCWord(crc, word);
+    }
+    return crc;
+}
+
+uint32_t __get_PRIMASK(void) { return 0; }
+void __set_PRIMASK(uint32_t priMask) { (void)priMask; }
+void __disable_irq(void) {}
+
+void RCC_AHBPeriphClockCmd(uint32_t RCC_AHBPeriph, FunctionalState NewState)
+{
+    (void)RCC_AHBPeriph; (void)NewState;
+}
+
+void DMA_DeInit(DMA_Channel_TypeDef *DMAy_Channelx)
+{
+    memset(DMAy_Channelx, 0, sizeof(*DMAy_Channelx));
+    Dma_Enabled = Dma_TC = 0;
+}
+
+void DMA_Init(DMA_Channel_TypeDef *DMAy_Channelx, DMA_InitTypeDef *DMA_InitStruct)
+{
+    DMAy_Channelx->CPAR = DMA_InitStruct->DMA_PeripheralBaseAddr;
+    DMAy_Channelx->CMAR = DMA_InitStruct->DMA_MemoryBaseAddr;
+    DMAy_Channelx->CNDTR = DMA_InitStruct->DMA_BufferSize;
+}
+
+// Memory-to-memory runs at bus speed: the whole block is in the CRC once enabled
+void DMA_Cmd(DMA_Channel_TypeDef *DMAy_Channelx, FunctionalState NewState)
+{
+    const uint32_t *src = (const uint32_t *)(uintptr_t)DMAy_Channelx->CMAR;
+
+    if (NewState == ENABLE && !Dma_Enabled) {
+        for (uint32_t i = 0; i < DMAy_Channelx->CNDTR; i++) {
+            Host_CRC.DR = Test_CRCWord(Host_CRC.DR, src[i]);
+        }
+        DMAy_Channelx->CNDTR = 0;
+        Dma_TC = 1;
+    }
+    Dma_Enabled = (NewState == ENABLE);
+}
+
+void DMA_SetCurrDataCounter(DMA_Channel_TypeDef *DMAy_Channelx, uint16_t DataNumber)
+{
+    DMAy_Channelx->CNDTR = DataNumber;
+}
+
+FlagStatus DMA_GetFlagStatus(uint32_t DMAy_FLAG)
+{
+    return (DMAy_FLAG == DMA1_FLAG_TC1 && Dma_TC) ? SET : RESET;
+}
+
+void DMA_ClearFlag(uint32_t DMAy_FLAG)
+{
+    if (DMAy_FLAG & DMA1_FLAG_TC1) Dma_TC = 0;
+}
+
+void CRC_ResetDR(void)
+{
+    Host_CRC.DR = 0xFFFFFFFF;
+}
+
+uint32_t CRC_GetCRC(void)
+{
+    return Host_CRC.DR;
+}
+
+bool W25Q64_ReadDataAsync(uint32_t addr, uint8_t *dataArr, uint16_t len, Hard_SPI_Callback callback)
+{
+    Read_Calls++;
+    if (Read_Left >= 0) return false;
+    if (Read_BusyEvery && Read_Calls % Read_BusyEvery == 0) return false;
+
+    Read_Addr = addr;
+    Read_Dest = dataArr;
+    Read_Len = len;
+    Read_Callback = callback;
+    Read_Left = Read_Delay;
+    return true;
+}
+
+/**
+ * @brief The SPI DMA interrupt, between two Process() calls
+ */
+static void Test_ReadTick(void)
+{
+    if (Read_Left < 0) return;
+    if (Read_Left-- > 0) return;
+
+    memcpy(Read_Dest, &Test_Flash[Read_Addr], Read_Len);
+    Read_Callback();
+}
+
+static void Test_Check(int ok, const char *what)
+{
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) Test_Failures++;
+}
+
+/**
+ * @brief Check a good and a corrupted region with reads of the given latency
+ */
+static void Test_Run(int delay, int busyEvery)
+{
+    W25Q64_Verify_Region regions[3];
+    uint32_t calls = 0;
+
+    for (uint32_t i = 0; i < TEST_FLASH_SIZE; i++) Test_Flash[i] = (uint8_t)(i * 13 + 5);
+
+    // Lengths that end mid-chunk, one region with a CRC that does not match
+    regions[0] = (W25Q64_Verify_Region){ 0x0000, 0x1A4C, Test_CRC(0x0000, 0x1A4C) };
+    regions[1] = (W25Q64_Verify_Region){ 0x2000, 0x0104, Test_CRC(0x2000, 0x0104) ^ 1 };
+    regions[2] = (W25Q64_Verify_Region){ 0x3000, 0x0800, Test_CRC(0x3000, 0x0800) };
+
+    Read_Left = -1;
+    Read_Delay = delay;
+    Read_BusyEvery = busyEvery;
+    Read_Calls = 0;
+    W25Q64_Verify_Start(regions, 3);
+
+    while (!W25Q64_Verify_IsDone() && calls < TEST_MAX_CALLS) {
+        W25Q64_Verify_Process();
+        Test_ReadTick();
+        calls++;
+    }
+
+    printf("read latency %d calls%s: %u Process() calls\n",
+           delay, busyEvery ? ", bus shared" : "", calls);
+    Test_Check(W25Q64_Verify_IsDone(), "check finishes");
+    Test_Check(W25Q64_Verify_GetStatus(0) == W25Q64_VERIFY_OK, "good region reported OK");
+    Test_Check(W25Q64_Verify_GetStatus(1) == W25Q64_VERIFY_FAILED, "corrupted region reported FAILED");
+    Test_Check(W25Q64_Verify_GetStatus(2) == W25Q64_VERIFY_OK, "region after a failure reported OK");
+    Test_Check(W25Q64_Verify_Failed(), "failure flag set");
+    Test_Check(Read_Left < 0, "no read left in flight");
+}
+
+int main(void)
+{
+    Test_Run(0, 0);
+    Test_Run(1, 0);
+    Test_Run(4, 0);
+    Test_Run(9, 0);
+    Test_Run(3, 5);
+
+    printf("%s\n", Test_Failures ? "FAILED" : "passed");
+    return Test_Failures ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+/****************************************************************************/ /**
+ * @file   stm32f10x.h
+ * @brief  Host stand-in for the device header, just what the W25Q64 driver
+ *         headers and W25Q64_Verify use; the core and peripheral library
+ *         functions are provided by the test
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 22:10:12
+ ********************************************************************************/
+
+#ifndef __STM32F10x_H
+#define __STM32F10x_H
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t ODR;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef Host_GPIOA;
+#define GPIOA                       (&Host_GPIOA)
+
+#define GPIO_Pin_4                  ((uint16_t)0x0010)
+#define GPIO_Pin_5                  ((uint16_t)0x0020)
+#define GPIO_Pin_6                  ((uint16_t)0x0040)
+#define GPIO_Pin_7                  ((uint16_t)0x0080)
+
+#define SPI_BaudRatePrescaler_2     ((uint16_t)0x0000)
+#define SPI_BaudRatePrescaler_4     ((uint16_t)0x0008)
+#define SPI_BaudRatePrescaler_8     ((uint16_t)0x0010)
+#define SPI_BaudRatePrescaler_16    ((uint16_t)0x0018)
+#define SPI_BaudRatePrescaler_32    ((uint16_t)0x0020)
+#define SPI_BaudRatePrescaler_64    ((uint16_t)0x0028)
+#define SPI_BaudRatePrescaler_128   ((uint16_t)0x0030)
+#define SPI_BaudRatePrescaler_256   ((uint16_t)0x0038)
+#define SPI_FirstBit_MSB            ((uint16_t)0x0000)
+#define SPI_FirstBit_LSB            ((uint16_t)0x0080)
+
+typedef enum { RESET = 0, SET = !RESET } FlagStatus;
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+
+typedef struct {
+    volatile uint32_t CCR;
+    volatile uint32_t CNDTR;
+    volatile uint32_t CPAR;
+    volatile uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct {
+    uint32_t DMA_PeripheralBaseAddr;
+    uint32_t DMA_MemoryBaseAddr;
+    uint32_t DMA_DIR;
+    uint32_t DMA_BufferSize;
+    uint32_t DMA_PeripheralInc;
+    uint32_t DMA_MemoryInc;
+    uint32_t DMA_PeripheralDataSize;
+    uint32_t DMA_MemoryDataSize;
+    uint32_t DMA_Mode;
+    uint32_t DMA_Priority;
+    uint32_t DMA_M2M;
+} DMA_InitTypeDef;
+
+typedef struct {
+    volatile uint32_t DR;
+} CRC_TypeDef;
+
+extern DMA_Channel_TypeDef Host_DMA1_Channel1;
+extern CRC_TypeDef Host_CRC;
+#define DMA1_Channel1               (&Host_DMA1_Channel1)
+#define CRC                         (&Host_CRC)
+
+#define RCC_AHBPeriph_DMA1          ((uint32_t)0x00000001)
+#define RCC_AHBPeriph_CRC           ((uint32_t)0x00000040)
+
+#define DMA_DIR_PeripheralDST       ((uint32_t)0x00000010)
+#define DMA_PeripheralInc_Disable   ((uint32_t)0x00000000)
+#define DMA_MemoryInc_Enable        ((uint32_t)0x00000080)
+#define DMA_PeripheralDataSize_Word ((uint32_t)0x00000200)
+#define DMA_MemoryDataSize_Word     ((uint32_t)0x00000800)
+#define DMA_Mode_Normal             ((uint32_t)0x00000000)
+#define DMA_Priority_Low            ((uint32_t)0x00000000)
+#define DMA_M2M_Enable              ((uint32_t)0x00004000)
+#define DMA1_FLAG_GL1               ((uint32_t)0x00000001)
+#define DMA1_FLAG_TC1               ((uint32_t)0x00000002)
+#define DMA1_FLAG_HT1               ((uint32_t)0x00000004)
+#define DMA1_FLAG_TE1               ((uint32_t)0x00000008)
+
+void RCC_AHBPeriphClockCmd(uint32_t RCC_AHBPeriph, FunctionalState NewState);
+void DMA_DeInit(DMA_Channel_TypeDef *DMAy_Channelx);
+void DMA_Init(DMA_Channel_TypeDef *DMAy_Channelx, DMA_InitTypeDef *DMA_InitStruct);
+void DMA_Cmd(DMA_Channel_TypeDef *DMAy_Channelx, FunctionalState NewState);
+void DMA_SetCurrDataCounter(DMA_Channel_TypeDef *DMAy_Channelx, uint16_t DataNumber);
+FlagStatus DMA_GetFlagStatus(uint32_t DMAy_FLAG);
+void DMA_ClearFlag(uint32_t DMAy_FLAG);
+void CRC_ResetDR(void);
+uint32_t CRC_GetCRC(void);
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __disable_irq(void);
+
+#endif // !__STM32F10x_H
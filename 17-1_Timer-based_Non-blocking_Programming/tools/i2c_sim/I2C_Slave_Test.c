@@ -0,0 +1,358 @@
+/****************************************************************************/ /**
+ * @file   I2C_Slave_Test.c
+ * @brief  Host test of the I2C slave event handling and snapshot banks
+ *
+ * Build and run from this directory:
+ *   gcc -O2 -std=gnu99 -no-pie -DUSE_STDPERIPH_DRIVER -DSTM32F10X_MD \
+ *       -I../../src -I../../lib/cmsis -I../../lib/STM32F10x_StdPeriph_Driver \
+ *       -I../../lib/STM32F10x_StdPeriph_Driver/inc \
+ *       -I../../hardware/inc -I../../system/inc \
+ *       I2C_Slave_Test.c -o i2c_slave_test
+ *   ./i2c_slave_test
+ *
+ * I2C_Slave.c is compiled into this file with I2C_SLAVE_ENABLE 1. DMA1
+ * channels 4/5 are RAM structures and the peripheral library calls are
+ * models: the test raises ADDR (with TRA), BTF, STOPF and AF and calls the
+ * real EV/ER handlers, then moves bytes through the armed channels as the
+ * host would clock them. Serial is not linked, so its channel 4 check is
+ * turned off here. -no-pie keeps the banks below 4 GB, CMAR is 32 bits.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-19 10:24:31
+ ********************************************************************************/
+
+#define I2C_SLAVE_ENABLE    1
+
+#include "stm32f10x.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+DMA_Channel_TypeDef Host_DMA1_Channel4;
+DMA_Channel_TypeDef Host_DMA1_Channel5;
+
+#undef DMA1_Channel4
+#undef DMA1_Channel5
+#define DMA1_Channel4       (&Host_DMA1_Channel4)
+#define DMA1_Channel5       (&Host_DMA1_Channel5)
+
+// Cortex-M3 intrinsics of core_cm3.h are ARM assembly
+#define __disable_irq()
+#define __enable_irq()
+#define NVIC_DisableIRQ(irq)
+
+#include "Serial.h"
+#undef SERIAL1_TX_DMA
+#define SERIAL1_TX_DMA      0
+
+#include "../../hardware/src/I2C_Slave.c"
+
+#define BUS_EV_MASK         0xFFFF      // Low half-word of I2C_IT_* is the SR1 bit
+
+static uint32_t Bus_Pending;            // SR1 event bits raised by the host
+static int Bus_Tra;                     // SR2 TRA: slave transmits
+static int Bus_DrFull;                  // I2C_SendData() byte not yet clocked out
+static uint8_t Bus_Dr;
+static uint16_t Dma_Armed[2];           // CNDTR at arming, [0] TX, [1] RX
+static int Test_Failures = 0;
+
+static uint8_t Cb_Reg, Cb_Len;
+static int Cb_Calls;
+
+// Peripheral library models used by I2C_Slave.c
+
+static int Dma_Index(DMA_Channel_TypeDef *ch)
+{
+    return ch == I2C_SLAVE_DMA_TX_CHANNEL ? 0 : 1;
+}
+
+void DMA_DeInit(DMA_Channel_TypeDef *ch) { memset(ch, 0, sizeof(*ch)); }
+
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init)
+{
+    ch->CMAR = init->DMA_MemoryBaseAddr;
+    ch->CNDTR = init->DMA_BufferSize;
+    Dma_Armed[Dma_Index(ch)] = init->DMA_BufferSize;
+}
+
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state)
+{
+    if (state == ENABLE) ch->CCR |= 1;
+    else ch->CCR &= ~1u;
+}
+
+void DMA_SetCurrDataCounter(DMA_Channel_TypeDef *ch, uint16_t n)
+{
+    ch->CNDTR = n;
+    Dma_Armed[Dma_Index(ch)] = n;
+}
+
+uint16_t DMA_GetCurrDataCounter(DMA_Channel_TypeDef *ch) { return ch->CNDTR; }
+
+ITStatus I2C_GetITStatus(I2C_TypeDef *I2Cx, uint32_t it)
+{
+    (void)I2Cx;
+    return (Bus_Pending & it & BUS_EV_MASK) ? SET : RESET;
+}
+
+FlagStatus I2C_GetFlagStatus(I2C_TypeDef *I2Cx, uint32_t flag)
+{
+    (void)I2Cx;
+    return (flag == I2C_FLAG_TRA && Bus_Tra) ? SET : RESET;
+}
+
+void I2C_ClearITPendingBit(I2C_TypeDef *I2Cx, uint32_t it)
+{
+    (void)I2Cx;
+    Bus_Pending &= ~(it & BUS_EV_MASK);
+}
+
+void I2C_SendData(I2C_TypeDef *I2Cx, uint8_t data)
+{
+    (void)I2Cx;
+    Bus_Dr = data;
+    Bus_DrFull = 1;
+}
+
+uint8_t I2C_ReceiveData(I2C_TypeDef *I2Cx) { (void)I2Cx; return 0; }
+
+void I2C_DeInit(I2C_TypeDef *I2Cx) { (void)I2Cx; }
+void I2C_Init(I2C_TypeDef *I2Cx, I2C_InitTypeDef *init) { (void)I2Cx; (void)init; }
+void I2C_Cmd(I2C_TypeDef *I2Cx, FunctionalState state) { (void)I2Cx; (void)state; }
+void I2C_DMACmd(I2C_TypeDef *I2Cx, FunctionalState state) { (void)I2Cx; (void)state; }
+void I2C_ITConfig(I2C_TypeDef *I2Cx, uint16_t it, FunctionalState state) { (void)I2Cx; (void)it; (void)state; }
+void I2C_AcknowledgeConfig(I2C_TypeDef *I2Cx, FunctionalState state) { (void)I2Cx; (void)state; }
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *init) { (void)GPIOx; (void)init; }
+void NVIC_Init(NVIC_InitTypeDef *init) { (void)init; }
+
+// Host side of the bus
+
+static void Host_Event(uint32_t it)
+{
+    Bus_Pending |= it & BUS_EV_MASK;
+    I2C_SLAVE_EV_IRQHandler();
+    Bus_Pending &= ~((I2C_IT_ADDR | I2C_IT_STOPF | I2C_IT_BTF) & BUS_EV_MASK);
+}
+
+// START or repeated START with the own address
+static void Host_Start(int read)
+{
+    Bus_Tra = read;
+    Bus_DrFull = 0;
+    Host_Event(I2C_IT_ADDR);
+}
+
+static void Host_Send(uint8_t b)
+{
+    DMA_Channel_TypeDef *ch = I2C_SLAVE_DMA_RX_CHANNEL;
+
+    if ((ch->CCR & 1) && ch->CNDTR > 0) {
+        ((uint8_t *)(uintptr_t)ch->CMAR)[Dma_Armed[1] - ch->CNDTR] = b;
+        ch->CNDTR--;
+    } else {
+        Host_Event(I2C_IT_BTF);         // Slave drops the byte
+    }
+}
+
+static uint8_t Host_Receive(void)
+{
+    DMA_Channel_TypeDef *ch = I2C_SLAVE_DMA_TX_CHANNEL;
+    uint8_t b;
+
+    if (!Bus_DrFull && (ch->CCR & 1) && ch->CNDTR > 0) {
+        b = ((uint8_t *)(uintptr_t)ch->CMAR)[Dma_Armed[0] - ch->CNDTR];
+        ch->CNDTR--;
+        return b;
+    }
+    if (!Bus_DrFull) Host_Event(I2C_IT_BTF);    // DMA exhausted, slave pads
+    Bus_DrFull = 0;
+    return Bus_Dr;
+}
+
+// NACK of the last read byte, then STOP
+static void Host_NackStop(void)
+{
+    Bus_Pending |= I2C_IT_AF & BUS_EV_MASK;
+    I2C_SLAVE_ER_IRQHandler();
+    Host_Event(I2C_IT_STOPF);
+}
+
+static void Host_Write(uint8_t reg, const uint8_t *data, uint8_t len)
+{
+    Host_Start(0);
+    Host_Send(reg);
+    for (uint8_t i = 0; i < len; i++) Host_Send(data[i]);
+    Host_Event(I2C_IT_STOPF);
+}
+
+// Pointer write, repeated START, burst read
+static void Host_Read(uint8_t reg, uint8_t *data, uint8_t len)
+{
+    Host_Start(0);
+    Host_Send(reg);
+    Host_Start(1);
+    for (uint8_t i = 0; i < len; i++) data[i] = Host_Receive();
+    Host_NackStop();
+}
+
+// Tests
+
+static void Test_WriteDone(uint8_t reg, const uint8_t *data, uint8_t len)
+{
+    (void)data;
+    Cb_Reg = reg;
+    Cb_Len = len;
+    Cb_Calls++;
+}
+
+static void Test_Check(int ok, const char *what)
+{
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) Test_Failures++;
+}
+
+static int Test_All(const uint8_t *buf, uint8_t len, uint8_t value)
+{
+    for (uint8_t i = 0; i < len; i++) {
+        if (buf[i] != value) return 0;
+    }
+    return 1;
+}
+
+// Fill the whole sample area of the back bank and publish it
+static void Test_Publish(uint8_t value)
+{
+    memset(I2C_Slave_GetBackBuffer(), value, I2C_SLAVE_DATA_SIZE);
+    I2C_Slave_Publish();
+}
+
+static void Test_Reset(void)
+{
+    I2C_Slave_Init(I2C_SLAVE_ADDRESS, 100000);
+    I2C_Slave_SetWriteCallback(Test_WriteDone);
+    (void)I2C_Slave_GetWriteFlag();
+    Cb_Calls = 0;
+}
+
+/**
+ * @brief Host writes to the control area and to the read-only sample area
+ */
+static void Test_ControlWrite(void)
+{
+    const uint8_t cfg[3] = { 0xA1, 0xB2, 0xC3 };
+    uint8_t back[3];
+    I2C_Slave_Stats stats;
+
+    printf("control write, sample area write\n");
+    Test_Reset();
+
+    Host_Write(I2C_SLAVE_DATA_SIZE + 2, cfg, sizeof(cfg));
+    I2C_Slave_ReadControl(I2C_SLAVE_DATA_SIZE + 2, back, sizeof(back));
+    Test_Check(memcmp(back, cfg, sizeof(cfg)) == 0, "control bytes stored");
+    Test_Check(I2C_Slave_GetWriteFlag(), "write flag set");
+    Test_Check(Cb_Calls == 1 && Cb_Reg == I2C_SLAVE_DATA_SIZE + 2 && Cb_Len == 3, "callback with register and length");
+
+    Host_Write(4, cfg, 2);
+    I2C_Slave_GetStats(&stats);
+    Test_Check(stats.rejected == 2 && stats.writes == 2, "sample area bytes rejected");
+    Test_Check(Test_All(I2C_Slave_Bank[I2C_Slave_Front], I2C_SLAVE_DATA_SIZE, 0), "sample area untouched");
+}
+
+/**
+ * @brief Pointer write followed by a repeated START and a burst read
+ */
+static void Test_PointerThenBurst(void)
+{
+    const uint8_t cfg[2] = { 0x5A, 0x6B };
+    uint8_t buf[I2C_SLAVE_REG_SIZE];
+    I2C_Slave_Stats stats;
+
+    printf("pointer write, repeated START, burst read\n");
+    Test_Reset();
+    Host_Write(I2C_SLAVE_DATA_SIZE, cfg, sizeof(cfg));
+    Test_Publish(0x11);
+
+    Host_Read(8, buf, I2C_SLAVE_REG_SIZE - 8);
+    Test_Check(Test_All(buf, I2C_SLAVE_DATA_SIZE - 8, 0x11), "samples from the pointer on");
+    Test_Check(memcmp(&buf[I2C_SLAVE_DATA_SIZE - 8], cfg, sizeof(cfg)) == 0, "control area follows the samples");
+
+    // Read without a new pointer write starts at the same register
+    Host_Start(1);
+    buf[0] = Host_Receive();
+    Host_NackStop();
+    Test_Check(buf[0] == 0x11 && I2C_Slave_Pointer == 8, "read leaves the pointer unchanged");
+
+    I2C_Slave_GetStats(&stats);
+    Test_Check(stats.reads == 2 && stats.overruns == 0 && stats.errors == 0, "two reads, no overruns");
+}
+
+/**
+ * @brief Publishing during a read keeps the read on its snapshot
+ */
+static void Test_SnapshotSwap(void)
+{
+    uint8_t buf[I2C_SLAVE_DATA_SIZE];
+    uint8_t *front;
+
+    printf("publish during a read, next read sees the newest set\n");
+    Test_Reset();
+    Test_Publish(0x22);
+
+    Host_Start(0);
+    Host_Send(0);
+    Host_Start(1);
+    for (uint8_t i = 0; i < 10; i++) buf[i] = Host_Receive();
+    front = I2C_Slave_Bank[I2C_Slave_Front];
+
+    // Application publishes twice and scribbles the back bank meanwhile
+    Test_Publish(0x33);
+    Test_Publish(0x44);
+    Test_Check(I2C_Slave_GetBackBuffer() != front, "back bank is not the bank being read");
+    memset(I2C_Slave_GetBackBuffer(), 0x55, I2C_SLAVE_DATA_SIZE);
+
+    for (uint8_t i = 10; i < I2C_SLAVE_DATA_SIZE; i++) buf[i] = Host_Receive();
+    Host_NackStop();
+    Test_Check(Test_All(buf, I2C_SLAVE_DATA_SIZE, 0x22), "read in progress keeps its snapshot");
+
+    Host_Read(0, buf, I2C_SLAVE_DATA_SIZE);
+    Test_Check(Test_All(buf, I2C_SLAVE_DATA_SIZE, 0x44), "next read gets the newest published set");
+
+    Host_Read(0, buf, I2C_SLAVE_DATA_SIZE);
+    Test_Check(Test_All(buf, I2C_SLAVE_DATA_SIZE, 0x44), "unpublished back bank stays invisible");
+    Test_Check(Test_All(I2C_Slave_GetBackBuffer(), I2C_SLAVE_DATA_SIZE, 0x55), "back bank kept for partial updates");
+}
+
+/**
+ * @brief Reads running off the end of the register map are padded
+ */
+static void Test_ReadPastEnd(void)
+{
+    uint8_t buf[8];
+    I2C_Slave_Stats stats;
+
+    printf("reads past the end of the register map\n");
+    Test_Reset();
+
+    Host_Read(I2C_SLAVE_REG_SIZE - 4, buf, sizeof(buf));
+    Test_Check(Test_All(&buf[4], 4, I2C_SLAVE_PAD_BYTE), "bytes past the end padded");
+
+    Host_Read(I2C_SLAVE_REG_SIZE + 6, buf, 3);
+    Test_Check(Test_All(buf, 3, I2C_SLAVE_PAD_BYTE), "pointer outside the map padded");
+
+    I2C_Slave_GetStats(&stats);
+    Test_Check(stats.overruns == 7 && stats.reads == 2, "overruns counted");
+}
+
+int main(void)
+{
+    Test_ControlWrite();
+    Test_PointerThenBurst();
+    Test_SnapshotSwap();
+    Test_ReadPastEnd();
+
+    printf("%s\n", Test_Failures ? "FAILED" : "passed");
+    return Test_Failures ? 1 : 0;
+}
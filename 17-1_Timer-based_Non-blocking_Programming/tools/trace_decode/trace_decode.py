@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Trace 日志解码工具
+
+目标板只发送格式字符串地址和原始参数 (见 hardware/inc/Trace.h)，
+本工具从编译生成的 ELF 文件 (Keil/EIDE 的 .axf) 中按地址读回格式字符串，
+在主机端完成格式化。
+
+用法:
+    python trace_decode.py build/Target/project.axf COM5
+    python trace_decode.py build/Target/project.axf capture.bin
+    python trace_decode.py project.axf COM5 -b 921600 -r raw.bin
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+ARGS_MAX = 8
+LEVEL_NAMES = {"1": "E", "2": "W", "3": "I", "4": "D"}
+
+# printf 转换说明: 标志、宽度、精度、长度修饰、转换字符
+SPEC = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXcspfeEgG%])")
+PREFIX = re.compile(r"^([1-4])\|([^|]*)\|(\d+)\|(.*)$", re.S)
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+
+class ElfImage:
+    """只读取 ELF32 小端文件中已分配且有内容的节, 按地址查找字符串"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError(f"{path}: 不是 32 位小端 ELF 文件")
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+        self.regions = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size > 0:
+                self.regions.append((addr, data[offset:offset + size]))
+        self.cache = {}
+
+    def read_string(self, address):
+        """返回地址处以 0 结尾的字符串, 不在映像中时返回 None"""
+        if address in self.cache:
+            return self.cache[address]
+        text = None
+        for base, blob in self.regions:
+            if base <= address < base + len(blob):
+                end = blob.find(b"\x00", address - base)
+                if end >= 0:
+                    text = blob[address - base:end].decode("utf-8", "replace")
+                break
+        self.cache[address] = text
+        return text
+
+
+def parse_format(elf, address):
+    """解析格式字符串, 返回 (级别, 文件, 行号, 格式, 参数个数) 或 None"""
+    text = elf.read_string(address)
+    if text is None:
+        return None
+    m = PREFIX.match(text)
+    if m is None:
+        return None
+    level, path, line, fmt = m.groups()
+    count = sum(1 for s in SPEC.finditer(fmt) if s.group(3) != "%")
+    return LEVEL_NAMES[level], os.path.basename(path.replace("\\", "/")), int(line), fmt, count
+
+
+def render(elf, fmt, args):
+    """用原始 32 位参数在主机端完成 printf 格式化"""
+    values = iter(args)
+
+    def convert(m):
+        flags, _, conv = m.groups()
+        if conv == "%":
+            return "%"
+        raw = next(values)
+        if conv in "di":
+            return ("%" + flags + "d") % struct.unpack("<i", struct.pack("<I", raw))[0]
+        if conv in "ouxX":
+            return ("%" + flags + conv) % raw
+        if conv == "c":
+            return ("%" + flags + "c") % chr(raw & 0xFF)
+        if conv == "p":
+            return "0x%08X" % raw
+        if conv == "s":
+            s = elf.read_string(raw)
+            return ("%" + flags + "s") % (s if s is not None else "<0x%08X>" % raw)
+        # %f %e %g: 参数是 float 的位模式 (TRACE_FLOAT)
+        return ("%" + flags + conv) % struct.unpack("<f", struct.pack("<I", raw))[0]
+
+    return SPEC.sub(convert, fmt)
+
+
+class Decoder:
+    def __init__(self, elf, out=sys.stdout):
+        self.elf = elf
+        self.out = out
+        self.buf = bytearray()
+        self.time_high = 0      # 16 位毫秒时间戳回绕后的高位
+        self.last_ms = None
+        self.records = 0
+        self.skipped = 0        # 重新同步时丢弃的字节
+
+    def timestamp(self, ms):
+        if self.last_ms is not None and ms < self.last_ms:
+            self.time_high += 1 << 16
+        self.last_ms = ms
+        return self.time_high + ms
+
+    def feed(self, data):
+        self.buf += data
+        while len(self.buf) >= 8:
+            if self.buf[0] != SYNC or self.buf[1] > ARGS_MAX:
+                del self.buf[0]
+                self.skipped += 1
+                continue
+            count = self.buf[1]
+            ms, address = struct.unpack_from("<HI", self.buf, 2)
+            info = parse_format(self.elf, address)
+            if info is None or info[4] != count:
+                # 同步字节出现在数据中, 或链接后的 ELF 与固件不一致
+                del self.buf[0]
+                self.skipped += 1
+                continue
+            size = 8 + 4 * count
+            if len(self.buf) < size:
+                return
+            args = struct.unpack_from("<%dI" % count, self.buf, 8)
+            del self.buf[:size]
+            self.emit(self.timestamp(ms), info, args)
+
+    def emit(self, ms, info, args):
+        level, path, line, fmt, _ = info
+        self.records += 1
+        self.out.write("[%6d.%03d] %s %s:%d: %s\n" % (ms // 1000, ms % 1000, level, path, line,
+                                                      render(self.elf, fmt, args)))
+        self.out.flush()
+
+
+def open_source(source, baudrate):
+    if os.path.exists(source):
+        return open(source, "rb"), False
+    import serial
+    return serial.Serial(source, baudrate, timeout=0.1), True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Trace 日志解码")
+    parser.add_argument("elf", help="与目标板固件一致的 ELF 文件 (.axf / .elf)")
+    parser.add_argument("source", help="串口名或原始抓包文件")
+    parser.add_argument("-b", "--baudrate", type=int, default=115200)
+    parser.add_argument("-r", "--raw", help="同时保存原始数据到文件")
+    args = parser.parse_args()
+
+    elf = ElfImage(args.elf)
+    src, is_serial = open_source(args.source, args.baudrate)
+    raw = open(args.raw, "wb") if args.raw else None
+    decoder = Decoder(elf)
+    try:
+        while True:
+            data = src.read(4096)
+            if not data:
+                if is_serial:
+                    continue
+                break
+            if raw:
+                raw.write(data)
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        print("\n用户中断")
+    finally:
+        src.close()
+        if raw:
+            raw.close()
+        print(f"记录: {decoder.records}, 同步丢弃字节: {decoder.skipped}", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
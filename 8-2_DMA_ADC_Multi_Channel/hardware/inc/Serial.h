@@ -0,0 +1,51 @@
+/****************************************************************************/ /**
+ * @file   Serial.h
+ * @brief  Header file for USART serial communication functions
+ *
+ * USART1 transmit only, for the telemetry stream: two DMA buffers on DMA1
+ * channel 4, one is filled while the other is on the wire, the
+ * transfer-complete interrupt starts the filled one. The send functions
+ * must be called from one context only (the main loop).
+ *
+ * @author Maverick Pi
+ * @date   2025-10-13 14:55:41
+ ********************************************************************************/
+
+#ifndef __SERIAL_H__
+#define __SERIAL_H__
+
+#include "stm32f10x.h"
+#include <stdio.h>
+#include <stdarg.h>
+
+#define SERIAL_BAUDRATE     921600
+
+// Size of each of the two DMA TX buffers
+#define SERIAL_TX_DMA_BUFFER_SIZE   256
+
+// What the Send/Printf functions do when no TX space is left
+#define SERIAL_TX_WAIT          0   // Wait for the wire (dropped inside an interrupt)
+#define SERIAL_TX_DROP_BYTES    1   // Queue what fits, drop the rest
+#define SERIAL_TX_DROP_MESSAGE  2   // Queue the whole call or nothing, keeps lines intact
+#define SERIAL_TX_FULL_POLICY   SERIAL_TX_WAIT
+
+// Printf formatting buffer
+#define SERIAL_PRINTF_SIZE      100
+
+// TX counters
+typedef struct {
+    uint32_t txOverruns;    // Bytes dropped, DMA buffers full
+    uint32_t txDmaBlocks;   // DMA transfers started
+} Serial_Stats;
+
+void Serial_Init(void);     // Initialize USART1 TX and its DMA channel
+void Serial_SendByte(uint8_t b);    // Queue single byte
+void Serial_SendArray(const uint8_t *arr, uint16_t len);    // Queue array of bytes
+void Serial_SendString(char *str);  // Queue null-terminated string
+void Serial_Printf(char *format, ...);  // Custom printf implementation
+uint16_t Serial_Write(const uint8_t *data, uint16_t len);   // Queue what fits, never waits
+void Serial_Flush(void);    // Wait until everything queued is on the wire
+void Serial_SetTxPolicy(uint8_t policy);    // SERIAL_TX_WAIT / DROP_BYTES / DROP_MESSAGE
+void Serial_GetStats(Serial_Stats *stats);  // Copy the TX counters
+
+#endif // !__SERIAL_H__
@@ -0,0 +1,78 @@
+/****************************************************************************/ /**
+ * @file   Telemetry.h
+ * @brief  Binary telemetry streaming over the DMA UART - Header File
+ *
+ * Samples are published on typed channels (name, element type, element
+ * count) from interrupts or the main loop, stamped with a 1 us hardware
+ * clock (TIM2 prescaled to 1 MHz, TIM3 counting its overflows: 32 bits, no
+ * interrupts) and packed into frames. Telemetry_Process() in the main loop
+ * hands finished frames to Serial (DMA TX).
+ *
+ * Frame, little-endian:
+ *   0xA5 0x5A | type | seq | payload length (2) | payload | CRC16 (2)
+ * CRC-16/CCITT (0x1021, init 0xFFFF) over type .. payload. seq counts sent
+ * frames, a gap on the host means frames lost on the wire.
+ * - DATA   payload: t0 (4, us) then records: channel id (1), t - t0 (2, us), values
+ * - SCHEMA payload: channel count (1), per channel: id, type, count, name length, name
+ * - STATS  payload: published, dropped, frames, max latency (us), 4 bytes each
+ * SCHEMA and STATS go out at start and every TELEMETRY_INFO_INTERVAL DATA
+ * frames, so a decoder can join at any time.
+ *
+ * Batching: a DATA frame is closed when the next record does not fit, or
+ * when its first sample is TELEMETRY_MAX_LATENCY_US old. A sample is only
+ * dropped (and counted) when all TELEMETRY_FRAMES buffers are waiting for
+ * the UART.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 19:48:22
+ ********************************************************************************/
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "stm32f10x.h"
+
+// Frame buffers, power of two; one is filled while the others wait for the UART
+#define TELEMETRY_FRAMES            4
+#define TELEMETRY_FRAME_SIZE        256     // Bytes per frame including header and CRC
+
+// Oldest sample age at which a partly filled frame is sent anyway (< 65536)
+#define TELEMETRY_MAX_LATENCY_US    5000
+
+// DATA frames between SCHEMA + STATS repeats
+#define TELEMETRY_INFO_INTERVAL     64
+
+#define TELEMETRY_CHANNELS_MAX      8
+
+// Frame types
+#define TELEMETRY_FRAME_DATA        0x01
+#define TELEMETRY_FRAME_SCHEMA      0x02
+#define TELEMETRY_FRAME_STATS       0x03
+
+// Channel element types
+#define TELEMETRY_U8                0
+#define TELEMETRY_I8                1
+#define TELEMETRY_U16               2
+#define TELEMETRY_I16               3
+#define TELEMETRY_U32               4
+#define TELEMETRY_I32               5
+#define TELEMETRY_F32               6
+
+#define TELEMETRY_INVALID_CHANNEL   0xFF
+
+// Counters; published - dropped samples reached a frame
+typedef struct {
+    uint32_t published;         // Telemetry_Publish() calls
+    uint32_t dropped;           // Samples lost, all frame buffers full
+    uint32_t frames;            // DATA frames handed to Serial
+    uint32_t maxLatencyUs;      // Worst first-sample age when a frame was handed over
+} Telemetry_Stats;
+
+void Telemetry_Init(void);
+uint8_t Telemetry_AddChannel(const char *name, uint8_t type, uint8_t count);
+uint8_t Telemetry_Publish(uint8_t channel, const void *values);
+void Telemetry_Process(void);
+uint32_t Telemetry_Now(void);
+void Telemetry_GetStats(Telemetry_Stats *stats);
+
+#endif // !__TELEMETRY_H__
@@ -0,0 +1,32 @@
+/****************************************************************************/ /**
+ * @file   CRC16.c
+ * @brief  CRC-16/CCITT (polynomial 0x1021) - Source File
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 23:58:14
+ ********************************************************************************/
+
+#include "CRC16.h"
+
+// CRC of each 4-bit value shifted through the polynomial
+static const uint16_t CRC16_Table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/**
+ * @brief Update a CRC-16/CCITT with a block of data
+ *
+ * @param crc CRC so far, CRC16_INIT to start
+ * @param data Data bytes
+ * @param len Number of bytes
+ * @return uint16_t Updated CRC
+ */
+uint16_t CRC16_Update(uint16_t crc, const uint8_t *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        crc = (uint16_t)(crc << 4) ^ CRC16_Table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ CRC16_Table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
@@ -0,0 +1,320 @@
+/****************************************************************************/ /**
+ * @file   Serial.c
+ * @brief  USART serial communication implementation for STM32
+ * 
+ * @author Maverick Pi
+ * @date   2025-10-13 14:55:55
+ ********************************************************************************/
+
+#include "Serial.h"
+
+// Copied per critical section, bounds the time interrupts are masked
+#define SERIAL_TX_DMA_CHUNK     32
+
+static uint8_t Serial_TxDmaBuffer[2][SERIAL_TX_DMA_BUFFER_SIZE];
+static uint16_t Serial_TxDmaLen[2];             // Bytes in each buffer
+static volatile uint8_t Serial_TxFill = 0;      // Buffer accepting new data
+static volatile uint8_t Serial_TxDmaBusy = 0;   // Other buffer is on the wire
+
+static volatile Serial_Stats Serial_Counters;
+static uint8_t Serial_TxPolicy = SERIAL_TX_FULL_POLICY;
+
+/**
+ * @brief Initialize USART1 for transmission
+ * 
+ * Configures PA9 and USART1 for TX only at SERIAL_BAUDRATE, 8 data bits,
+ * 1 stop bit, no parity; bytes go out through DMA1 channel 4
+ */
+void Serial_Init(void)
+{
+    // Enable clock for USART1 and GPIOA peripherals
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1, ENABLE);
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA, ENABLE);
+
+    // Configure GPIO Pin A9 as alternate function push-pull (USART1_TX)
+    GPIO_InitTypeDef GPIO_InitStructure;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_9;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(GPIOA, &GPIO_InitStructure);
+
+    // Configure USART1 parameters
+    USART_InitTypeDef USART_InitStructure;
+    USART_InitStructure.USART_BaudRate = SERIAL_BAUDRATE;
+    USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    USART_InitStructure.USART_Mode = USART_Mode_Tx;
+    USART_InitStructure.USART_Parity = USART_Parity_No;
+    USART_InitStructure.USART_StopBits = USART_StopBits_1;
+    USART_InitStructure.USART_WordLength = USART_WordLength_8b;
+    USART_Init(USART1, &USART_InitStructure);
+
+    // Configure DMA1 channel 4 (USART1_TX): buffer -> DR, started per buffer
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    DMA_DeInit(DMA1_Channel4);
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)Serial_TxDmaBuffer[0];
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = 1;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel4, &DMA_InitStructure);
+    DMA_ITConfig(DMA1_Channel4, DMA_IT_TC, ENABLE);
+    USART_DMACmd(USART1, USART_DMAReq_Tx, ENABLE);
+
+    // Configure NVIC for the DMA transfer-complete interrupt
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+    NVIC_InitTypeDef NVIC_InitStructure;
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel4_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
+    NVIC_Init(&NVIC_InitStructure);
+
+    // Enable USART1 peripheral
+    USART_Cmd(USART1, ENABLE);
+}
+
+/**
+ * @brief Check whether the caller runs inside an interrupt handler
+ */
+static uint8_t Serial_InInterrupt(void)
+{
+    return (SCB->ICSR & SCB_ICSR_VECTACTIVE) != 0;
+}
+
+/**
+ * @brief Start DMA on the fill buffer if the channel is idle, swap buffers
+ * 
+ * Called with interrupts masked or from the DMA interrupt.
+ */
+static void Serial_TxDmaKick(void)
+{
+    uint8_t fill = Serial_TxFill;
+
+    if (Serial_TxDmaBusy || Serial_TxDmaLen[fill] == 0) return;
+
+    DMA_Cmd(DMA1_Channel4, DISABLE);
+    DMA1_Channel4->CMAR = (uint32_t)Serial_TxDmaBuffer[fill];
+    DMA_SetCurrDataCounter(DMA1_Channel4, Serial_TxDmaLen[fill]);
+    DMA_Cmd(DMA1_Channel4, ENABLE);
+
+    Serial_TxDmaBusy = 1;
+    Serial_TxFill = fill ^ 1;
+    Serial_TxDmaLen[fill ^ 1] = 0;
+    Serial_Counters.txDmaBlocks++;
+}
+
+/**
+ * @brief Free space in the fill buffer
+ */
+static uint16_t Serial_TxFree(void)
+{
+    return SERIAL_TX_DMA_BUFFER_SIZE - Serial_TxDmaLen[Serial_TxFill];
+}
+
+/**
+ * @brief Append bytes to the fill buffer and start DMA if it is idle
+ * 
+ * @return uint16_t Number of bytes appended (limited by the free space)
+ */
+static uint16_t Serial_TxAppend(const uint8_t *data, uint16_t len)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint16_t n;
+
+    // The interrupt may swap buffers, so take and fill the buffer atomically
+    __disable_irq();
+    uint8_t fill = Serial_TxFill;
+    n = SERIAL_TX_DMA_BUFFER_SIZE - Serial_TxDmaLen[fill];
+    if (n > len) n = len;
+    for (uint16_t i = 0; i < n; i++) {
+        Serial_TxDmaBuffer[fill][Serial_TxDmaLen[fill] + i] = data[i];
+    }
+    Serial_TxDmaLen[fill] += n;
+    Serial_TxDmaKick();
+    __set_PRIMASK(primask);
+
+    return n;
+}
+
+/**
+ * @brief Queue bytes under a full-buffer policy
+ * 
+ * @param data Bytes to queue
+ * @param len Number of bytes
+ * @param policy SERIAL_TX_WAIT, SERIAL_TX_DROP_BYTES or SERIAL_TX_DROP_MESSAGE
+ * @return uint16_t Number of bytes queued
+ */
+static uint16_t Serial_Queue(const uint8_t *data, uint16_t len, uint8_t policy)
+{
+    uint16_t done = 0;
+    uint16_t limit = len;
+
+    // Waiting is impossible inside an interrupt or with interrupts masked:
+    // the drain would never run
+    if (policy == SERIAL_TX_WAIT && (Serial_InInterrupt() || __get_PRIMASK())) {
+        policy = SERIAL_TX_DROP_BYTES;
+    }
+    // A message only goes out whole; longer than the buffer never fits
+    if (policy == SERIAL_TX_DROP_MESSAGE && Serial_TxFree() < len) {
+        limit = 0;
+    }
+
+    while (done < limit) {
+        uint16_t chunk = len - done;
+        if (chunk > SERIAL_TX_DMA_CHUNK) chunk = SERIAL_TX_DMA_CHUNK;
+        uint16_t n = Serial_TxAppend(data + done, chunk);
+        done += n;
+        if (n == 0) {
+            if (policy != SERIAL_TX_WAIT) break;
+            while (Serial_TxFree() == 0);   // The interrupt makes room
+        }
+    }
+
+    if (done < len) {
+        Serial_Counters.txOverruns += len - done;
+    }
+
+    return done;
+}
+
+/**
+ * @brief Queue bytes under the current policy
+ */
+static void Serial_Send(const uint8_t *data, uint16_t len)
+{
+    Serial_Queue(data, len, Serial_TxPolicy);
+}
+
+/**
+ * @brief Select what the Send/Printf functions do when no TX space is left
+ * 
+ * Control code that must never wait on the UART uses SERIAL_TX_DROP_MESSAGE.
+ * 
+ * @param policy SERIAL_TX_WAIT, SERIAL_TX_DROP_BYTES or SERIAL_TX_DROP_MESSAGE
+ */
+void Serial_SetTxPolicy(uint8_t policy)
+{
+    Serial_TxPolicy = policy;
+}
+
+/**
+ * @brief Queue a single byte for transmission via USART
+ * 
+ * @param b Byte to be transmitted
+ */
+void Serial_SendByte(uint8_t b)
+{
+    Serial_Send(&b, 1);
+}
+
+/**
+ * @brief Queue an array of bytes via USART
+ * 
+ * @param arr Pointer to the bytes
+ * @param len Number of bytes
+ */
+void Serial_SendArray(const uint8_t *arr, uint16_t len)
+{
+    Serial_Send(arr, len);
+}
+
+/**
+ * @brief Queue a null-terminated string via USART
+ * 
+ * @param str Pointer to the null-terminated string
+ */
+void Serial_SendString(char *str)
+{
+    uint16_t len = 0;
+
+    while (str[len] != '\0') len++;
+    Serial_Send((const uint8_t *)str, len);
+}
+
+/**
+ * @brief Queue as many bytes as fit, never waits
+ * 
+ * @param data Bytes to transmit
+ * @param len Number of bytes
+ * @return uint16_t Number of bytes queued, the rest is counted as overrun
+ */
+uint16_t Serial_Write(const uint8_t *data, uint16_t len)
+{
+    return Serial_Queue(data, len, SERIAL_TX_DROP_BYTES);
+}
+
+/**
+ * @brief Wait until both DMA buffers are empty and the last byte has left the wire
+ * 
+ * Call before entering a low-power mode.
+ */
+void Serial_Flush(void)
+{
+    while (Serial_TxDmaBusy || Serial_TxDmaLen[Serial_TxFill] != 0);
+    while (USART_GetFlagStatus(USART1, USART_FLAG_TC) == RESET);
+}
+
+/**
+ * @brief Copy the TX counters
+ * 
+ * @param stats Destination
+ */
+void Serial_GetStats(Serial_Stats *stats)
+{
+    stats->txOverruns = Serial_Counters.txOverruns;
+    stats->txDmaBlocks = Serial_Counters.txDmaBlocks;
+}
+
+/**
+ * @brief Redirect standard library's fputc to USART
+ * 
+ * @param ch Character to be sent
+ * @param f File pointer (unused in this implementation)
+ * @return int The character that was sent
+ */
+int fputc(int ch, FILE *f)
+{
+    Serial_SendByte(ch);
+    return ch;
+}
+
+/**
+ * @brief Custom printf implementation using variable arguments
+ * 
+ * @param format Format string (same as standard printf)
+ * @param ... Variable arguments to be formatted
+ */
+void Serial_Printf(char *format, ...)
+{
+    char str[SERIAL_PRINTF_SIZE];
+    va_list arg;    // Variable argument list
+    // Initialize argument list and format string
+    va_start(arg, format);
+    vsnprintf(str, sizeof(str), format, arg);
+    va_end(arg);
+
+    // Queue the formatted string, returns once it is in a DMA buffer
+    Serial_SendString(str);
+}
+
+/**
+ * @brief DMA1 Channel 4 Interrupt Service Routine
+ * 
+ * A TX buffer has been handed to the USART: start the buffer filled
+ * meanwhile, if any.
+ */
+void DMA1_Channel4_IRQHandler(void)
+{
+    if (DMA_GetITStatus(DMA1_IT_TC4) == SET) {
+        DMA_ClearITPendingBit(DMA1_IT_TC4);
+        Serial_TxDmaBusy = 0;
+        Serial_TxDmaKick();
+    }
+}
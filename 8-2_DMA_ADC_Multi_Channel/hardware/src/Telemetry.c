@@ -0,0 +1,328 @@
+/****************************************************************************/ /**
+ * @file   Telemetry.c
+ * @brief  Binary telemetry streaming over the DMA UART - Source File
+ *
+ * Frame buffers form a queue: [tail, head) are closed and wait for the UART,
+ * head is being filled while Telemetry_Open is set. Publishers (any
+ * interrupt) append under a short critical section; only the main loop
+ * closes stale frames, writes headers and CRCs, and calls Serial.
+ *
+ * At 921600 baud the UART carries about 90 KB/s: four 12-bit ADC channels
+ * at 1 kHz take 11 KB/s (3-byte record header + 8 bytes of values).
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 19:48:22
+ ********************************************************************************/
+
+#include "Telemetry.h"
+#include "Serial.h"
+#include "CRC16.h"
+#include <string.h>
+
+#define TELEMETRY_FRAME_MASK        (TELEMETRY_FRAMES - 1)
+
+#if TELEMETRY_FRAMES & TELEMETRY_FRAME_MASK
+#error "TELEMETRY_FRAMES must be a power of two"
+#endif
+
+#define TELEMETRY_SYNC0             0xA5
+#define TELEMETRY_SYNC1             0x5A
+#define TELEMETRY_HEADER_SIZE       6       // Sync, type, seq, payload length
+#define TELEMETRY_CRC_SIZE          2
+#define TELEMETRY_RECORDS_START     (TELEMETRY_HEADER_SIZE + 4)    // After t0
+#define TELEMETRY_RECORD_HEADER     3       // Channel id, time offset
+#define TELEMETRY_NAME_MAX          16
+
+typedef struct {
+    const char *name;
+    uint8_t type;
+    uint8_t count;
+    uint16_t size;              // Bytes of values per sample
+} Telemetry_Channel;
+
+static const uint8_t Telemetry_TypeSize[] = { 1, 1, 2, 2, 4, 4, 4 };
+
+static Telemetry_Channel Telemetry_Channels[TELEMETRY_CHANNELS_MAX];
+static uint8_t Telemetry_ChannelCount = 0;
+
+static uint8_t Telemetry_Frames[TELEMETRY_FRAMES][TELEMETRY_FRAME_SIZE];
+static uint16_t Telemetry_FrameLen[TELEMETRY_FRAMES];   // Bytes used, header included
+static uint32_t Telemetry_FrameT0[TELEMETRY_FRAMES];    // Time of the first sample
+static volatile uint8_t Telemetry_Head = 0;     // Frame being filled, written by publishers
+static volatile uint8_t Telemetry_Tail = 0;     // Next frame to send, written by the main loop
+static volatile uint8_t Telemetry_Open = 0;     // Head frame holds at least one record
+
+static uint8_t Telemetry_Info[TELEMETRY_FRAME_SIZE];    // SCHEMA / STATS frame
+static uint8_t Telemetry_Seq = 0;
+static uint16_t Telemetry_InfoCountdown = 1;
+static Telemetry_Stats Telemetry_Counters;
+
+static void Telemetry_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void Telemetry_Put32(uint8_t *p, uint32_t v)
+{
+    Telemetry_Put16(p, v & 0xFFFF);
+    Telemetry_Put16(p + 2, v >> 16);
+}
+
+/**
+ * @brief Start the 1 us timestamp clock
+ *
+ * TIM2 divides its clock down to 1 MHz and sends its update (overflow) as
+ * TRGO; TIM3 counts those in external clock mode 1 (ITR1 = TIM2).
+ */
+void Telemetry_Init(void)
+{
+    RCC_ClocksTypeDef clocks;
+    uint32_t timerClock;
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2 | RCC_APB1Periph_TIM3, ENABLE);
+
+    // APB1 timers run at twice PCLK1 when APB1 is divided
+    RCC_GetClocksFreq(&clocks);
+    timerClock = clocks.PCLK1_Frequency;
+    if (RCC->CFGR & RCC_CFGR_PPRE1_2) timerClock *= 2;
+
+    TIM_TimeBaseInit(TIM3, &(TIM_TimeBaseInitTypeDef) {
+        .TIM_Prescaler = 0,
+        .TIM_CounterMode = TIM_CounterMode_Up,
+        .TIM_Period = 0xFFFF,
+        .TIM_ClockDivision = TIM_CKD_DIV1,
+        .TIM_RepetitionCounter = 0
+    });
+    TIM_SelectInputTrigger(TIM3, TIM_TS_ITR1);
+    TIM_SelectSlaveMode(TIM3, TIM_SlaveMode_External1);
+
+    TIM_TimeBaseInit(TIM2, &(TIM_TimeBaseInitTypeDef) {
+        .TIM_Prescaler = timerClock / 1000000 - 1,
+        .TIM_CounterMode = TIM_CounterMode_Up,
+        .TIM_Period = 0xFFFF,
+        .TIM_ClockDivision = TIM_CKD_DIV1,
+        .TIM_RepetitionCounter = 0
+    });
+    TIM_SelectOutputTrigger(TIM2, TIM_TRGOSource_Update);
+
+    TIM_Cmd(TIM3, ENABLE);
+    TIM_Cmd(TIM2, ENABLE);
+}
+
+/**
+ * @brief Current time in microseconds, wraps after 71 minutes
+ *
+ * TIM3 counts a TIM2 overflow a few clock cycles after TIM2 has restarted
+ * at 0 (trigger resynchronization), so while TIM2 reads 0 the TIM3 value
+ * may still be the old one, 65.536 ms early. TIM2 holds 0 for one 1 us
+ * tick, which is also the longest this waits.
+ */
+uint32_t Telemetry_Now(void)
+{
+    uint16_t high, low;
+
+    // Read again if TIM2 overflowed in between or TIM3 may not have counted it yet
+    do {
+        high = TIM3->CNT;
+        low = TIM2->CNT;
+    } while (high != TIM3->CNT || low == 0);
+
+    return (uint32_t)high << 16 | low;
+}
+
+/**
+ * @brief Declare a channel, before the first Telemetry_Process()
+ *
+ * @param name Channel name for the host, up to 16 characters are sent
+ * @param type TELEMETRY_U8 .. TELEMETRY_F32
+ * @param count Elements per sample
+ * @return uint8_t Channel id for Telemetry_Publish(), TELEMETRY_INVALID_CHANNEL if
+ *         the table is full or one sample does not fit in a frame
+ */
+uint8_t Telemetry_AddChannel(const char *name, uint8_t type, uint8_t count)
+{
+    Telemetry_Channel *ch;
+    uint16_t size;
+
+    if (Telemetry_ChannelCount >= TELEMETRY_CHANNELS_MAX || type > TELEMETRY_F32 || count == 0) {
+        return TELEMETRY_INVALID_CHANNEL;
+    }
+    size = Telemetry_TypeSize[type] * count;
+    if (TELEMETRY_RECORDS_START + TELEMETRY_RECORD_HEADER + size + TELEMETRY_CRC_SIZE > TELEMETRY_FRAME_SIZE) {
+        return TELEMETRY_INVALID_CHANNEL;
+    }
+
+    ch = &Telemetry_Channels[Telemetry_ChannelCount];
+    ch->name = name;
+    ch->type = type;
+    ch->count = count;
+    ch->size = size;
+    return Telemetry_ChannelCount++;
+}
+
+/**
+ * @brief Queue the head frame for sending, called with interrupts masked
+ */
+static void Telemetry_Close(void)
+{
+    Telemetry_Head++;
+    Telemetry_Open = 0;
+}
+
+/**
+ * @brief Record one sample of a channel, safe from any interrupt
+ *
+ * @param channel Id from Telemetry_AddChannel()
+ * @param values count elements of the channel type, native byte order
+ * @return uint8_t 1 if recorded, 0 if dropped (all frame buffers full)
+ */
+uint8_t Telemetry_Publish(uint8_t channel, const void *values)
+{
+    const Telemetry_Channel *ch;
+    uint32_t now = Telemetry_Now();
+    uint32_t primask;
+    uint8_t recorded = 0;
+
+    if (channel >= Telemetry_ChannelCount) return 0;
+    ch = &Telemetry_Channels[channel];
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    Telemetry_Counters.published++;
+
+    if (Telemetry_Open) {
+        uint8_t i = Telemetry_Head & TELEMETRY_FRAME_MASK;
+        // Full, or the 16-bit time offset would overflow
+        if (Telemetry_FrameLen[i] + TELEMETRY_RECORD_HEADER + ch->size + TELEMETRY_CRC_SIZE > TELEMETRY_FRAME_SIZE ||
+            now - Telemetry_FrameT0[i] > 0xFFFF) {
+            Telemetry_Close();
+        }
+    }
+    if (!Telemetry_Open && (uint8_t)(Telemetry_Head - Telemetry_Tail) < TELEMETRY_FRAMES) {
+        uint8_t i = Telemetry_Head & TELEMETRY_FRAME_MASK;
+        Telemetry_FrameT0[i] = now;
+        Telemetry_FrameLen[i] = TELEMETRY_RECORDS_START;
+        Telemetry_Open = 1;
+    }
+
+    if (Telemetry_Open) {
+        uint8_t i = Telemetry_Head & TELEMETRY_FRAME_MASK;
+        uint8_t *p = &Telemetry_Frames[i][Telemetry_FrameLen[i]];
+
+        p[0] = channel;
+        Telemetry_Put16(p + 1, (uint16_t)(now - Telemetry_FrameT0[i]));
+        memcpy(p + TELEMETRY_RECORD_HEADER, values, ch->size);
+        Telemetry_FrameLen[i] += TELEMETRY_RECORD_HEADER + ch->size;
+        recorded = 1;
+    } else {
+        Telemetry_Counters.dropped++;
+    }
+
+    __set_PRIMASK(primask);
+    return recorded;
+}
+
+/**
+ * @brief Fill in the header and CRC of a frame and queue it on the UART
+ *
+ * @param frame Frame with its payload at TELEMETRY_HEADER_SIZE
+ * @param type TELEMETRY_FRAME_x
+ * @param payloadLen Payload length
+ */
+static void Telemetry_Send(uint8_t *frame, uint8_t type, uint16_t payloadLen)
+{
+    uint16_t len = TELEMETRY_HEADER_SIZE + payloadLen;
+
+    frame[0] = TELEMETRY_SYNC0;
+    frame[1] = TELEMETRY_SYNC1;
+    frame[2] = type;
+    frame[3] = Telemetry_Seq++;
+    Telemetry_Put16(&frame[4], payloadLen);
+    Telemetry_Put16(&frame[len], CRC16_Update(CRC16_INIT, &frame[2], len - 2));
+
+    // Waits while the DMA buffers are busy; publishers keep filling frames
+    Serial_SendArray(frame, len + TELEMETRY_CRC_SIZE);
+}
+
+/**
+ * @brief Send the channel table and the counters
+ */
+static void Telemetry_SendInfo(void)
+{
+    uint8_t *p = &Telemetry_Info[TELEMETRY_HEADER_SIZE];
+    Telemetry_Stats stats;
+
+    *p++ = Telemetry_ChannelCount;
+    for (uint8_t id = 0; id < Telemetry_ChannelCount; id++) {
+        const Telemetry_Channel *ch = &Telemetry_Channels[id];
+        uint8_t nameLen = strlen(ch->name) > TELEMETRY_NAME_MAX ? TELEMETRY_NAME_MAX : strlen(ch->name);
+
+        *p++ = id;
+        *p++ = ch->type;
+        *p++ = ch->count;
+        *p++ = nameLen;
+        memcpy(p, ch->name, nameLen);
+        p += nameLen;
+    }
+    Telemetry_Send(Telemetry_Info, TELEMETRY_FRAME_SCHEMA, p - &Telemetry_Info[TELEMETRY_HEADER_SIZE]);
+
+    Telemetry_GetStats(&stats);
+    p = &Telemetry_Info[TELEMETRY_HEADER_SIZE];
+    Telemetry_Put32(p, stats.published);
+    Telemetry_Put32(p + 4, stats.dropped);
+    Telemetry_Put32(p + 8, stats.frames);
+    Telemetry_Put32(p + 12, stats.maxLatencyUs);
+    Telemetry_Send(Telemetry_Info, TELEMETRY_FRAME_STATS, 16);
+}
+
+/**
+ * @brief Close a stale frame and send the finished ones, call from the main loop
+ *
+ * The latency bound holds as long as the main loop comes back within a
+ * fraction of TELEMETRY_MAX_LATENCY_US.
+ */
+void Telemetry_Process(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (Telemetry_Open &&
+        Telemetry_Now() - Telemetry_FrameT0[Telemetry_Head & TELEMETRY_FRAME_MASK] >= TELEMETRY_MAX_LATENCY_US) {
+        Telemetry_Close();
+    }
+    __set_PRIMASK(primask);
+
+    while (Telemetry_Tail != Telemetry_Head) {
+        uint8_t i = Telemetry_Tail & TELEMETRY_FRAME_MASK;
+        uint8_t *frame = Telemetry_Frames[i];
+        uint32_t latency = Telemetry_Now() - Telemetry_FrameT0[i];
+
+        if (--Telemetry_InfoCountdown == 0) {
+            Telemetry_InfoCountdown = TELEMETRY_INFO_INTERVAL;
+            Telemetry_SendInfo();
+        }
+
+        if (latency > Telemetry_Counters.maxLatencyUs) Telemetry_Counters.maxLatencyUs = latency;
+        Telemetry_Put32(&frame[TELEMETRY_HEADER_SIZE], Telemetry_FrameT0[i]);
+        Telemetry_Send(frame, TELEMETRY_FRAME_DATA, Telemetry_FrameLen[i] - TELEMETRY_HEADER_SIZE);
+        Telemetry_Counters.frames++;
+
+        // Serial has copied the frame, the buffer is free again
+        Telemetry_Tail++;
+    }
+}
+
+/**
+ * @brief Copy the counters
+ *
+ * @param stats Destination
+ */
+void Telemetry_GetStats(Telemetry_Stats *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    *stats = Telemetry_Counters;
+    __set_PRIMASK(primask);
+}
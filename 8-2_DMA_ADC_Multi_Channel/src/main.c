@@ -1,35 +1,67 @@
 /****************************************************************************/ /**
  * @file   main.c
  * @brief  Main application file for ADC data acquisition and display system
- * 
+ *
  * This file contains the main application code that initializes the OLED display
  * and ADC peripherals, then continuously reads and displays analog values from
  * four ADC channels on the OLED screen.
- * 
+ *
+ * The four channels are also sampled at MAIN_SAMPLE_RATE_HZ from the TIM4
+ * interrupt and streamed as telemetry frames over USART1 (see Telemetry.h
+ * and tools/telemetry/telemetry_decode.py).
+ *
  * @author Maverick Pi
  * @date   2025-09-19 21:44:22
  *******************************************************************************/
 
 #include "OLED.h"
-#include "Delay.h"
 #include "ADC.h"
+#include "Serial.h"
+#include "Telemetry.h"
+#include "Timer.h"
+
+#define MAIN_SAMPLE_RATE_HZ     1000
+#define MAIN_DISPLAY_PERIOD_US  100000
+
+static uint8_t Main_AdcChannel;
 
 int main(void)
 {
+    uint32_t lastDisplay;
+
     OLED_Init();
     AD_Init();
+    Serial_Init();
+    Telemetry_Init();
+    Main_AdcChannel = Telemetry_AddChannel("adc", TELEMETRY_U16, sizeof(AD_Value) / sizeof(AD_Value[0]));
+    Timer_Init(MAIN_SAMPLE_RATE_HZ);
 
     OLED_ShowString(1, 1, "ADC1:");
     OLED_ShowString(2, 1, "ADC2:");
     OLED_ShowString(3, 1, "ADC3:");
     OLED_ShowString(4, 1, "ADC4:");
+    lastDisplay = Telemetry_Now();
 
     while (1) {
+        Telemetry_Process();
+
         /* Update display with current ADC values for all four channels */
-        for (int i = 0; i < sizeof(AD_Value) / sizeof(AD_Value[0]); ++i) {
-            OLED_ShowNum(i + 1, 6, AD_Value[i], 5);
+        if (Telemetry_Now() - lastDisplay >= MAIN_DISPLAY_PERIOD_US) {
+            lastDisplay += MAIN_DISPLAY_PERIOD_US;
+            for (int i = 0; i < sizeof(AD_Value) / sizeof(AD_Value[0]); ++i) {
+                OLED_ShowNum(i + 1, 6, AD_Value[i], 5);
+            }
         }
+    }
+}
 
-        Delay_ms(100);
+/**
+ * @brief Take one sample of all ADC channels
+ */
+void TIM4_IRQHandler(void)
+{
+    if (TIM_GetITStatus(TIM4, TIM_IT_Update) == SET) {
+        TIM_ClearITPendingBit(TIM4, TIM_IT_Update);
+        Telemetry_Publish(Main_AdcChannel, AD_Value);
     }
 }
@@ -0,0 +1,16 @@
+/****************************************************************************/ /**
+ * @file   Timer.h
+ * @brief  Sample rate timer (TIM4 update interrupt) - Header File
+ * 
+ * @author Maverick Pi
+ * @date   2026-10-18 19:52:40
+ ********************************************************************************/
+
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#include "stm32f10x.h"
+
+void Timer_Init(uint32_t rateHz);
+
+#endif // !__TIMER_H__
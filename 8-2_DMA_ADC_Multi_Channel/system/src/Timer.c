@@ -0,0 +1,56 @@
+/****************************************************************************/ /**
+ * @file   Timer.c
+ * @brief  Sample rate timer (TIM4 update interrupt) - Source File
+ * 
+ * TIM4_IRQHandler is defined by the application.
+ * 
+ * @author Maverick Pi
+ * @date   2026-10-18 19:52:40
+ ********************************************************************************/
+
+#include "Timer.h"
+
+/**
+ * @brief Start TIM4 with an update interrupt at rateHz
+ * 
+ * @param rateHz Interrupt rate, 16 Hz .. 1 MHz (1 us resolution)
+ */
+void Timer_Init(uint32_t rateHz)
+{
+    RCC_ClocksTypeDef clocks;
+    uint32_t timerClock;
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM4, ENABLE);
+
+    TIM_InternalClockConfig(TIM4);
+
+    // APB1 timers run at twice PCLK1 when APB1 is divided
+    RCC_GetClocksFreq(&clocks);
+    timerClock = clocks.PCLK1_Frequency;
+    if (RCC->CFGR & RCC_CFGR_PPRE1_2) timerClock *= 2;
+
+    // Prescaled to a 1 MHz counter clock
+    TIM_TimeBaseInit(TIM4, &(TIM_TimeBaseInitTypeDef) {
+        .TIM_ClockDivision = TIM_CKD_DIV1,
+        .TIM_CounterMode = TIM_CounterMode_Up,
+        .TIM_Period = 1000000 / rateHz - 1,
+        .TIM_Prescaler = timerClock / 1000000 - 1,
+        .TIM_RepetitionCounter = 0
+    });
+
+    TIM_ClearFlag(TIM4, TIM_FLAG_Update);
+    TIM_ITConfig(TIM4, TIM_IT_Update, ENABLE);
+
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+
+    // Preempts the DMA1 channel 4 TX-complete interrupt, so only the short
+    // main-loop critical sections can delay a sample
+    NVIC_Init(&(NVIC_InitTypeDef) {
+        .NVIC_IRQChannel = TIM4_IRQn,
+        .NVIC_IRQChannelPreemptionPriority = 0,
+        .NVIC_IRQChannelSubPriority = 1,
+        .NVIC_IRQChannelCmd = ENABLE
+    });
+
+    TIM_Cmd(TIM4, ENABLE);
+}
@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+遥测帧解码工具
+
+从串口或原始抓包文件读取 Telemetry.h 定义的二进制帧，每个通道输出一个 CSV：
+    <前缀>_<通道名>.csv: time_us, v0, v1, ...
+
+用法:
+    python telemetry_decode.py COM5            # 串口，默认 921600
+    python telemetry_decode.py capture.bin     # 原始抓包文件
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+SYNC = b"\xA5\x5A"
+HEADER_SIZE = 6
+FRAME_DATA = 0x01
+FRAME_SCHEMA = 0x02
+FRAME_STATS = 0x03
+MAX_PAYLOAD = 256
+
+# 元素类型 -> struct 格式
+TYPE_FORMATS = ["B", "b", "H", "h", "I", "i", "f"]
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE，与固件一致"""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class Decoder:
+    def __init__(self, prefix):
+        self.prefix = prefix
+        self.buf = bytearray()
+        self.channels = {}      # id -> (name, 格式, 元素个数)
+        self.files = {}         # id -> 文件
+        self.last_seq = None
+        self.time_high = 0      # 32 位时间戳回绕后的高位
+        self.last_t0 = None
+        self.frames = 0
+        self.crc_errors = 0
+        self.seq_gaps = 0
+        self.no_schema = 0
+        self.target_stats = None
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(SYNC)
+            if start < 0:
+                # 保留最后一个字节，可能是同步头的前半
+                del self.buf[:-1]
+                return
+            del self.buf[:start]
+            if len(self.buf) < HEADER_SIZE:
+                return
+            frame_type, seq, length = struct.unpack_from("<BBH", self.buf, 2)
+            if length > MAX_PAYLOAD:
+                # 假同步头，跳过继续搜索
+                del self.buf[:1]
+                continue
+            total = HEADER_SIZE + length + 2
+            if len(self.buf) < total:
+                return
+            crc = struct.unpack_from("<H", self.buf, HEADER_SIZE + length)[0]
+            if crc16_ccitt(self.buf[2:HEADER_SIZE + length]) != crc:
+                self.crc_errors += 1
+                del self.buf[:1]
+                continue
+            payload = bytes(self.buf[HEADER_SIZE:HEADER_SIZE + length])
+            del self.buf[:total]
+            self.check_seq(seq)
+            self.handle(frame_type, payload)
+
+    def check_seq(self, seq):
+        if self.last_seq is not None and seq != (self.last_seq + 1) & 0xFF:
+            self.seq_gaps += (seq - self.last_seq - 1) & 0xFF
+        self.last_seq = seq
+
+    def handle(self, frame_type, payload):
+        self.frames += 1
+        if frame_type == FRAME_SCHEMA:
+            self.parse_schema(payload)
+        elif frame_type == FRAME_STATS:
+            self.target_stats = struct.unpack_from("<IIII", payload)
+        elif frame_type == FRAME_DATA:
+            self.parse_data(payload)
+
+    def parse_schema(self, payload):
+        count = payload[0]
+        pos = 1
+        for _ in range(count):
+            cid, ctype, ccount, name_len = payload[pos:pos + 4]
+            name = payload[pos + 4:pos + 4 + name_len].decode("ascii", "replace")
+            pos += 4 + name_len
+            if ctype >= len(TYPE_FORMATS):
+                continue
+            self.channels[cid] = (name, "<" + TYPE_FORMATS[ctype] * ccount, ccount)
+
+    def unwrap(self, t0):
+        # 固件时钟 71 分钟回绕一次
+        if self.last_t0 is not None and t0 < self.last_t0 and self.last_t0 - t0 > 0x80000000:
+            self.time_high += 1 << 32
+        self.last_t0 = t0
+        return self.time_high + t0
+
+    def parse_data(self, payload):
+        t0 = self.unwrap(struct.unpack_from("<I", payload)[0])
+        pos = 4
+        while pos + 3 <= len(payload):
+            cid, dt = struct.unpack_from("<BH", payload, pos)
+            pos += 3
+            channel = self.channels.get(cid)
+            if channel is None:
+                # 还没收到 SCHEMA，无法知道记录长度，丢弃本帧剩余部分
+                self.no_schema += 1
+                return
+            name, fmt, _ = channel
+            values = struct.unpack_from(fmt, payload, pos)
+            pos += struct.calcsize(fmt)
+            self.write(cid, name, t0 + dt, values)
+
+    def write(self, cid, name, t, values):
+        f = self.files.get(cid)
+        if f is None:
+            count = self.channels[cid][2]
+            f = open(f"{self.prefix}_{name}.csv", "w", newline="")
+            f.write("time_us," + ",".join(f"v{i}" for i in range(count)) + "\n")
+            self.files[cid] = f
+        f.write(f"{t}," + ",".join(str(v) for v in values) + "\n")
+
+    def close(self):
+        for f in self.files.values():
+            f.close()
+
+    def report(self):
+        print(f"帧: {self.frames}, CRC 错误: {self.crc_errors}, 序号缺口: {self.seq_gaps}, "
+              f"无 SCHEMA 丢弃: {self.no_schema}")
+        if self.target_stats:
+            published, dropped, frames, latency = self.target_stats
+            print(f"目标端: 发布 {published}, 丢弃 {dropped}, 帧 {frames}, 最大延迟 {latency} us")
+
+
+def open_source(source, baudrate):
+    if os.path.exists(source):
+        return open(source, "rb"), False
+    import serial
+    return serial.Serial(source, baudrate, timeout=0.1), True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="遥测帧解码为 CSV")
+    parser.add_argument("source", help="串口名或原始抓包文件")
+    parser.add_argument("-b", "--baudrate", type=int, default=921600)
+    parser.add_argument("-o", "--prefix", default="telemetry", help="CSV 文件名前缀")
+    parser.add_argument("-r", "--raw", help="同时保存原始数据到文件")
+    args = parser.parse_args()
+
+    src, is_serial = open_source(args.source, args.baudrate)
+    raw = open(args.raw, "wb") if args.raw else None
+    decoder = Decoder(args.prefix)
+    try:
+        while True:
+            data = src.read(4096)
+            if not data:
+                if is_serial:
+                    continue
+                break
+            if raw:
+                raw.write(data)
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        print("\n用户中断")
+    finally:
+        decoder.close()
+        src.close()
+        if raw:
+            raw.close()
+        decoder.report()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+/****************************************************************************/ /**
+ * @file   Modbus.h
+ * @brief  Modbus RTU slave - Header File
+ *
+ * Frames are received by DMA into a linear buffer; no interrupt per byte.
+ * End of frame (3.5 character times of silence) is found by hardware: the
+ * USART IDLE interrupt fires one character after the last byte and starts
+ * a one-pulse timer for the remaining 2.5 characters. If the DMA counter
+ * has not moved when the timer expires, the frame is complete and is
+ * handled right there in the timer interrupt, so the response starts a
+ * bounded time after the gap whatever the main loop is doing. A frame that
+ * resumes inside the gap is merged and then fails its CRC, as RTU demands.
+ *
+ * The response goes out by DMA; the USART transmission-complete interrupt
+ * releases the optional RS-485 driver enable (DE) pin and turns the
+ * receiver back on.
+ *
+ * Data model: coils, discrete inputs, holding and input registers are
+ * application arrays (bits packed LSB first). Optional callbacks refresh
+ * values before a read and apply them after a write; they run in the timer
+ * interrupt and may answer with an exception code.
+ *
+ * Function codes: 01, 02, 03, 04, 05, 06, 15, 16. Broadcasts (address 0)
+ * are executed for writes (05, 06, 15, 16) and never answered; broadcast
+ * reads are ignored, onRead is not called for them.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 21:03:36
+ ********************************************************************************/
+
+#ifndef __MODBUS_H__
+#define __MODBUS_H__
+
+#include "stm32f10x.h"
+
+// USART instance: 1, 2 or 3. USART1 is taken by Serial in this project.
+#define MODBUS_INSTANCE             2
+
+#if MODBUS_INSTANCE == 1
+#define MODBUS_USART                USART1
+#define MODBUS_USART_CLOCK_CMD      RCC_APB2PeriphClockCmd
+#define MODBUS_USART_CLOCK          RCC_APB2Periph_USART1
+#define MODBUS_GPIO                 GPIOA
+#define MODBUS_GPIO_CLOCK           RCC_APB2Periph_GPIOA
+#define MODBUS_TX_PIN               GPIO_Pin_9
+#define MODBUS_RX_PIN               GPIO_Pin_10
+#define MODBUS_DMA_RX_CHANNEL       DMA1_Channel5
+#define MODBUS_DMA_TX_CHANNEL       DMA1_Channel4
+#define MODBUS_USART_IRQn           USART1_IRQn
+#define MODBUS_USART_IRQHandler     USART1_IRQHandler
+#elif MODBUS_INSTANCE == 2
+#define MODBUS_USART                USART2
+#define MODBUS_USART_CLOCK_CMD      RCC_APB1PeriphClockCmd
+#define MODBUS_USART_CLOCK          RCC_APB1Periph_USART2
+#define MODBUS_GPIO                 GPIOA
+#define MODBUS_GPIO_CLOCK           RCC_APB2Periph_GPIOA
+#define MODBUS_TX_PIN               GPIO_Pin_2
+#define MODBUS_RX_PIN               GPIO_Pin_3
+#define MODBUS_DMA_RX_CHANNEL       DMA1_Channel6
+#define MODBUS_DMA_TX_CHANNEL       DMA1_Channel7
+#define MODBUS_USART_IRQn           USART2_IRQn
+#define MODBUS_USART_IRQHandler     USART2_IRQHandler
+#else
+#define MODBUS_USART                USART3
+#define MODBUS_USART_CLOCK_CMD      RCC_APB1PeriphClockCmd
+#define MODBUS_USART_CLOCK          RCC_APB1Periph_USART3
+#define MODBUS_GPIO                 GPIOB
+#define MODBUS_GPIO_CLOCK           RCC_APB2Periph_GPIOB
+#define MODBUS_TX_PIN               GPIO_Pin_10
+#define MODBUS_RX_PIN               GPIO_Pin_11
+#define MODBUS_DMA_RX_CHANNEL       DMA1_Channel3
+#define MODBUS_DMA_TX_CHANNEL       DMA1_Channel2
+#define MODBUS_USART_IRQn           USART3_IRQn
+#define MODBUS_USART_IRQHandler     USART3_IRQHandler
+#endif
+
+// Frame gap timer, 1 us per tick
+#define MODBUS_TIM                  TIM3
+#define MODBUS_TIM_CLOCK            RCC_APB1Periph_TIM3
+#define MODBUS_TIM_IRQn             TIM3_IRQn
+#define MODBUS_TIM_IRQHandler       TIM3_IRQHandler
+
+// Line settings; 11 bits per character: 8E1, 8O1 or 8N2
+#define MODBUS_BAUDRATE             19200
+#define MODBUS_PARITY               USART_Parity_Even
+
+// RS-485 driver enable, high while transmitting
+#define MODBUS_USE_DE               1
+#define MODBUS_DE_PORT              GPIOA
+#define MODBUS_DE_CLOCK             RCC_APB2Periph_GPIOA
+#define MODBUS_DE_PIN               GPIO_Pin_1
+
+// Largest RTU frame: address, PDU (253), CRC
+#define MODBUS_ADU_MAX              256
+
+// Tables
+#define MODBUS_COILS                0
+#define MODBUS_DISCRETE_INPUTS      1
+#define MODBUS_HOLDING_REGISTERS    2
+#define MODBUS_INPUT_REGISTERS      3
+
+// Exception codes, also returned by the callbacks
+#define MODBUS_EX_NONE                  0x00
+#define MODBUS_EX_ILLEGAL_FUNCTION      0x01
+#define MODBUS_EX_ILLEGAL_DATA_ADDRESS  0x02
+#define MODBUS_EX_ILLEGAL_DATA_VALUE    0x03
+#define MODBUS_EX_SLAVE_DEVICE_FAILURE  0x04
+
+/**
+ * Called before a read of [address, address + count) of a table, to refresh
+ * the array, or after a write to it, to apply the new values. Runs in the
+ * timer interrupt; returns MODBUS_EX_NONE or an exception code.
+ */
+typedef uint8_t (*Modbus_Callback)(uint8_t table, uint16_t address, uint16_t count);
+
+// Application data; a table with count 0 answers "illegal data address"
+typedef struct {
+    uint8_t *coils;                 // Bit n of byte n / 8 is coil n
+    uint16_t coilCount;
+    const uint8_t *discreteInputs;
+    uint16_t discreteInputCount;
+    uint16_t *holdingRegisters;
+    uint16_t holdingRegisterCount;
+    const uint16_t *inputRegisters;
+    uint16_t inputRegisterCount;
+    Modbus_Callback onRead;         // May be NULL
+    Modbus_Callback onWrite;        // May be NULL
+} Modbus_Map;
+
+// Counters
+typedef struct {
+    uint32_t frames;                // Frames for this slave with a good CRC
+    uint32_t broadcasts;            // Write broadcasts executed
+    uint32_t otherSlaves;           // Good frames for another address
+    uint32_t crcErrors;             // Bad CRC, too short, or resumed inside the gap
+    uint32_t overruns;              // Longer than MODBUS_ADU_MAX
+    uint32_t exceptions;            // Exception responses sent
+    uint32_t lastLatencyUs;         // End of gap to first response byte queued
+    uint32_t maxLatencyUs;
+    uint32_t gapUs;                 // 3.5 characters: the time before that
+} Modbus_Stats;
+
+void Modbus_Init(uint8_t address, const Modbus_Map *map);
+void Modbus_GetStats(Modbus_Stats *stats);
+
+#endif // !__MODBUS_H__
@@ -0,0 +1,522 @@
+/****************************************************************************/ /**
+ * @file   Modbus.c
+ * @brief  Modbus RTU slave - Source File
+ *
+ * Receiver states: DMA armed on the empty buffer -> IDLE interrupt starts
+ * the gap timer -> gap timer finds the DMA counter unchanged -> frame is
+ * handled with RX DMA stopped -> response by DMA with the receiver off ->
+ * TC interrupt re-arms RX DMA. Frames without a response re-arm at once.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 21:03:36
+ ********************************************************************************/
+
+#include "Modbus.h"
+#include "DWT.h"
+
+#define MODBUS_CHAR_BITS            11      // Start, 8 data, parity or second stop, stop
+#define MODBUS_RX_SIZE              (MODBUS_ADU_MAX + 1)    // A full buffer means an overrun
+
+// Function codes
+#define MODBUS_FC_READ_COILS                0x01
+#define MODBUS_FC_READ_DISCRETE_INPUTS      0x02
+#define MODBUS_FC_READ_HOLDING_REGISTERS    0x03
+#define MODBUS_FC_READ_INPUT_REGISTERS      0x04
+#define MODBUS_FC_WRITE_SINGLE_COIL         0x05
+#define MODBUS_FC_WRITE_SINGLE_REGISTER     0x06
+#define MODBUS_FC_WRITE_MULTIPLE_COILS      0x0F
+#define MODBUS_FC_WRITE_MULTIPLE_REGISTERS  0x10
+
+// CRC-16/MODBUS (reflected 0x8005, init 0xFFFF), one entry per byte value
+static const uint16_t Modbus_CRCTable[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+static uint8_t Modbus_RxBuffer[MODBUS_RX_SIZE];
+static uint8_t Modbus_TxBuffer[MODBUS_ADU_MAX];
+static uint8_t Modbus_Address;
+static const Modbus_Map *Modbus_Data;
+static volatile uint16_t Modbus_IdleCount;  // RX DMA counter when the line went idle
+static uint32_t Modbus_CyclesPerUs;
+static volatile Modbus_Stats Modbus_Counters;
+
+/**
+ * @brief CRC-16/MODBUS; over a frame including its CRC the result is 0
+ */
+static uint16_t Modbus_CRC16(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--) {
+        crc = (crc >> 8) ^ Modbus_CRCTable[(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+static uint16_t Modbus_Get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static void Modbus_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+/**
+ * @brief Receive the next frame into an empty buffer
+ */
+static void Modbus_RxArm(void)
+{
+    DMA_Cmd(MODBUS_DMA_RX_CHANNEL, DISABLE);
+    DMA_SetCurrDataCounter(MODBUS_DMA_RX_CHANNEL, MODBUS_RX_SIZE);
+    DMA_Cmd(MODBUS_DMA_RX_CHANNEL, ENABLE);
+    MODBUS_USART->CR1 |= USART_CR1_RE;
+}
+
+/**
+ * @brief Start the slave
+ *
+ * @param address Slave address, 1 .. 247
+ * @param map Application tables and callbacks, must stay valid
+ */
+void Modbus_Init(uint8_t address, const Modbus_Map *map)
+{
+    RCC_ClocksTypeDef clocks;
+    uint32_t timerClock;
+    uint32_t charUs = (MODBUS_CHAR_BITS * 1000000 + MODBUS_BAUDRATE - 1) / MODBUS_BAUDRATE;
+    // Above 19200 baud the gap is fixed at 1750 us
+    uint32_t gapUs = MODBUS_BAUDRATE > 19200 ? 1750 : (charUs * 7 + 1) / 2;
+
+    Modbus_Address = address;
+    Modbus_Data = map;
+    Modbus_Counters.gapUs = gapUs;
+
+    MODBUS_USART_CLOCK_CMD(MODBUS_USART_CLOCK, ENABLE);
+    RCC_APB2PeriphClockCmd(MODBUS_GPIO_CLOCK, ENABLE);
+    RCC_APB1PeriphClockCmd(MODBUS_TIM_CLOCK, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    GPIO_Init(MODBUS_GPIO, &(GPIO_InitTypeDef) {
+        .GPIO_Pin = MODBUS_TX_PIN,
+        .GPIO_Speed = GPIO_Speed_50MHz,
+        .GPIO_Mode = GPIO_Mode_AF_PP
+    });
+    GPIO_Init(MODBUS_GPIO, &(GPIO_InitTypeDef) {
+        .GPIO_Pin = MODBUS_RX_PIN,
+        .GPIO_Speed = GPIO_Speed_50MHz,
+        .GPIO_Mode = GPIO_Mode_IPU
+    });
+#if MODBUS_USE_DE
+    RCC_APB2PeriphClockCmd(MODBUS_DE_CLOCK, ENABLE);
+    GPIO_ResetBits(MODBUS_DE_PORT, MODBUS_DE_PIN);
+    GPIO_Init(MODBUS_DE_PORT, &(GPIO_InitTypeDef) {
+        .GPIO_Pin = MODBUS_DE_PIN,
+        .GPIO_Speed = GPIO_Speed_50MHz,
+        .GPIO_Mode = GPIO_Mode_Out_PP
+    });
+#endif
+
+    // Parity takes the ninth data bit; without it a second stop bit keeps 11 bits
+    USART_Init(MODBUS_USART, &(USART_InitTypeDef) {
+        .USART_BaudRate = MODBUS_BAUDRATE,
+        .USART_WordLength = MODBUS_PARITY == USART_Parity_No ? USART_WordLength_8b : USART_WordLength_9b,
+        .USART_StopBits = MODBUS_PARITY == USART_Parity_No ? USART_StopBits_2 : USART_StopBits_1,
+        .USART_Parity = MODBUS_PARITY,
+        .USART_Mode = USART_Mode_Rx | USART_Mode_Tx,
+        .USART_HardwareFlowControl = USART_HardwareFlowControl_None
+    });
+
+    // RX: DR -> frame buffer, re-armed per frame; TX: response -> DR
+    DMA_DeInit(MODBUS_DMA_RX_CHANNEL);
+    DMA_Init(MODBUS_DMA_RX_CHANNEL, &(DMA_InitTypeDef) {
+        .DMA_PeripheralBaseAddr = (uint32_t)&MODBUS_USART->DR,
+        .DMA_MemoryBaseAddr = (uint32_t)Modbus_RxBuffer,
+        .DMA_DIR = DMA_DIR_PeripheralSRC,
+        .DMA_BufferSize = MODBUS_RX_SIZE,
+        .DMA_PeripheralInc = DMA_PeripheralInc_Disable,
+        .DMA_MemoryInc = DMA_MemoryInc_Enable,
+        .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+        .DMA_MemoryDataSize = DMA_MemoryDataSize_Byte,
+        .DMA_Mode = DMA_Mode_Normal,
+        .DMA_Priority = DMA_Priority_High,
+        .DMA_M2M = DMA_M2M_Disable
+    });
+    DMA_DeInit(MODBUS_DMA_TX_CHANNEL);
+    DMA_Init(MODBUS_DMA_TX_CHANNEL, &(DMA_InitTypeDef) {
+        .DMA_PeripheralBaseAddr = (uint32_t)&MODBUS_USART->DR,
+        .DMA_MemoryBaseAddr = (uint32_t)Modbus_TxBuffer,
+        .DMA_DIR = DMA_DIR_PeripheralDST,
+        .DMA_BufferSize = 1,
+        .DMA_PeripheralInc = DMA_PeripheralInc_Disable,
+        .DMA_MemoryInc = DMA_MemoryInc_Enable,
+        .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+        .DMA_MemoryDataSize = DMA_MemoryDataSize_Byte,
+        .DMA_Mode = DMA_Mode_Normal,
+        .DMA_Priority = DMA_Priority_Medium,
+        .DMA_M2M = DMA_M2M_Disable
+    });
+    USART_DMACmd(MODBUS_USART, USART_DMAReq_Rx | USART_DMAReq_Tx, ENABLE);
+
+    // Gap timer: 1 MHz, one pulse of the 2.5 characters left after IDLE
+    RCC_GetClocksFreq(&clocks);
+    timerClock = clocks.PCLK1_Frequency;
+    if (RCC->CFGR & RCC_CFGR_PPRE1_2) timerClock *= 2;
+    TIM_TimeBaseInit(MODBUS_TIM, &(TIM_TimeBaseInitTypeDef) {
+        .TIM_Prescaler = timerClock / 1000000 - 1,
+        .TIM_CounterMode = TIM_CounterMode_Up,
+        .TIM_Period = gapUs > charUs ? gapUs - charUs - 1 : 0,
+        .TIM_ClockDivision = TIM_CKD_DIV1,
+        .TIM_RepetitionCounter = 0
+    });
+    TIM_SelectOnePulseMode(MODBUS_TIM, TIM_OPMode_Single);
+    TIM_UpdateRequestConfig(MODBUS_TIM, TIM_UpdateSource_Regular);
+    TIM_ClearFlag(MODBUS_TIM, TIM_FLAG_Update);
+    TIM_ITConfig(MODBUS_TIM, TIM_IT_Update, ENABLE);
+
+    // Latency is measured in CPU cycles
+    DWT_Init();
+    Modbus_CyclesPerUs = SystemCoreClock / 1000000;
+
+    // The USART (IDLE, TC) preempts the frame handling in the timer interrupt
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+    NVIC_Init(&(NVIC_InitTypeDef) {
+        .NVIC_IRQChannel = MODBUS_USART_IRQn,
+        .NVIC_IRQChannelPreemptionPriority = 1,
+        .NVIC_IRQChannelSubPriority = 0,
+        .NVIC_IRQChannelCmd = ENABLE
+    });
+    NVIC_Init(&(NVIC_InitTypeDef) {
+        .NVIC_IRQChannel = MODBUS_TIM_IRQn,
+        .NVIC_IRQChannelPreemptionPriority = 2,
+        .NVIC_IRQChannelSubPriority = 0,
+        .NVIC_IRQChannelCmd = ENABLE
+    });
+
+    USART_ITConfig(MODBUS_USART, USART_IT_IDLE, ENABLE);
+    USART_Cmd(MODBUS_USART, ENABLE);
+    Modbus_RxArm();
+}
+
+/**
+ * @brief Build an exception response
+ *
+ * Counted in Modbus_FrameEnd() once it is actually sent; a rejected
+ * broadcast builds one too but never answers.
+ */
+static uint16_t Modbus_Exception(uint8_t *rsp, uint8_t function, uint8_t code)
+{
+    rsp[0] = function | 0x80;
+    rsp[1] = code;
+    return 2;
+}
+
+/**
+ * @brief Check a range against a table and run the read or write callback
+ *
+ * @return uint8_t MODBUS_EX_NONE or an exception code
+ */
+static uint8_t Modbus_Access(Modbus_Callback callback, uint8_t table, uint16_t size,
+                             uint16_t start, uint16_t count, uint16_t countMax)
+{
+    if (count == 0 || count > countMax) return MODBUS_EX_ILLEGAL_DATA_VALUE;
+    if ((uint32_t)start + count > size) return MODBUS_EX_ILLEGAL_DATA_ADDRESS;
+    return callback ? callback(table, start, count) : MODBUS_EX_NONE;
+}
+
+static uint8_t Modbus_GetBit(const uint8_t *bits, uint16_t n)
+{
+    return (bits[n >> 3] >> (n & 7)) & 1;
+}
+
+static void Modbus_SetBit(uint8_t *bits, uint16_t n, uint8_t value)
+{
+    if (value) {
+        bits[n >> 3] |= 1 << (n & 7);
+    } else {
+        bits[n >> 3] &= ~(1 << (n & 7));
+    }
+}
+
+/**
+ * @brief Execute one request PDU
+ *
+ * @param req Request PDU: function code and data
+ * @param len PDU length
+ * @param rsp Response PDU
+ * @return uint16_t Response PDU length
+ */
+static uint16_t Modbus_Execute(const uint8_t *req, uint16_t len, uint8_t *rsp)
+{
+    const Modbus_Map *map = Modbus_Data;
+    uint8_t function = req[0];
+    uint16_t start, count;
+    uint8_t ex;
+
+    // The function code is checked before the data, as the specification orders it
+    if (!(function >= MODBUS_FC_READ_COILS && function <= MODBUS_FC_WRITE_SINGLE_REGISTER) &&
+        function != MODBUS_FC_WRITE_MULTIPLE_COILS && function != MODBUS_FC_WRITE_MULTIPLE_REGISTERS) {
+        return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_FUNCTION);
+    }
+
+    // Every supported request has at least an address and a count or value
+    if (len < 5) return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+    start = Modbus_Get16(&req[1]);
+    count = Modbus_Get16(&req[3]);
+
+    rsp[0] = function;
+    switch (function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS: {
+            uint8_t coils = function == MODBUS_FC_READ_COILS;
+            const uint8_t *bits = coils ? map->coils : map->discreteInputs;
+
+            ex = Modbus_Access(map->onRead, coils ? MODBUS_COILS : MODBUS_DISCRETE_INPUTS,
+                               coils ? map->coilCount : map->discreteInputCount, start, count, 2000);
+            if (ex) return Modbus_Exception(rsp, function, ex);
+
+            rsp[1] = (count + 7) / 8;
+            for (uint8_t i = 0; i < rsp[1]; i++) rsp[2 + i] = 0;
+            for (uint16_t i = 0; i < count; i++) {
+                if (Modbus_GetBit(bits, start + i)) rsp[2 + (i >> 3)] |= 1 << (i & 7);
+            }
+            return 2 + rsp[1];
+        }
+
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS: {
+            uint8_t holding = function == MODBUS_FC_READ_HOLDING_REGISTERS;
+            const uint16_t *regs = holding ? map->holdingRegisters : map->inputRegisters;
+
+            ex = Modbus_Access(map->onRead, holding ? MODBUS_HOLDING_REGISTERS : MODBUS_INPUT_REGISTERS,
+                               holding ? map->holdingRegisterCount : map->inputRegisterCount, start, count, 125);
+            if (ex) return Modbus_Exception(rsp, function, ex);
+
+            rsp[1] = count * 2;
+            for (uint16_t i = 0; i < count; i++) Modbus_Put16(&rsp[2 + i * 2], regs[start + i]);
+            return 2 + rsp[1];
+        }
+
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+            if (count != 0xFF00 && count != 0x0000) {
+                return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            }
+            if (start >= map->coilCount) return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            Modbus_SetBit(map->coils, start, count == 0xFF00);
+            ex = Modbus_Access(map->onWrite, MODBUS_COILS, map->coilCount, start, 1, 1);
+            if (ex) return Modbus_Exception(rsp, function, ex);
+            // Echo of the request
+            for (uint8_t i = 1; i < 5; i++) rsp[i] = req[i];
+            return 5;
+
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            if (start >= map->holdingRegisterCount) {
+                return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            }
+            map->holdingRegisters[start] = count;
+            ex = Modbus_Access(map->onWrite, MODBUS_HOLDING_REGISTERS, map->holdingRegisterCount, start, 1, 1);
+            if (ex) return Modbus_Exception(rsp, function, ex);
+            for (uint8_t i = 1; i < 5; i++) rsp[i] = req[i];
+            return 5;
+
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+            if (count == 0 || count > 1968 || len < 6 || req[5] != (count + 7) / 8 || len != 6 + req[5]) {
+                return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            }
+            if ((uint32_t)start + count > map->coilCount) {
+                return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                Modbus_SetBit(map->coils, start + i, Modbus_GetBit(&req[6], i));
+            }
+            ex = Modbus_Access(map->onWrite, MODBUS_COILS, map->coilCount, start, count, 1968);
+            if (ex) return Modbus_Exception(rsp, function, ex);
+            for (uint8_t i = 1; i < 5; i++) rsp[i] = req[i];
+            return 5;
+
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            if (count == 0 || count > 123 || len < 6 || req[5] != count * 2 || len != 6 + req[5]) {
+                return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            }
+            if ((uint32_t)start + count > map->holdingRegisterCount) {
+                return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                map->holdingRegisters[start + i] = Modbus_Get16(&req[6 + i * 2]);
+            }
+            ex = Modbus_Access(map->onWrite, MODBUS_HOLDING_REGISTERS, map->holdingRegisterCount, start, count, 123);
+            if (ex) return Modbus_Exception(rsp, function, ex);
+            for (uint8_t i = 1; i < 5; i++) rsp[i] = req[i];
+            return 5;
+
+        default:
+            return Modbus_Exception(rsp, function, MODBUS_EX_ILLEGAL_FUNCTION);
+    }
+}
+
+/**
+ * @brief Append the CRC and start sending with the receiver off
+ *
+ * @param len ADU length without CRC
+ */
+static void Modbus_Send(uint16_t len)
+{
+    uint16_t crc = Modbus_CRC16(Modbus_TxBuffer, len);
+
+    Modbus_TxBuffer[len] = crc & 0xFF;
+    Modbus_TxBuffer[len + 1] = crc >> 8;
+
+    MODBUS_USART->CR1 &= ~USART_CR1_RE;
+#if MODBUS_USE_DE
+    GPIO_SetBits(MODBUS_DE_PORT, MODBUS_DE_PIN);
+#endif
+    USART_ClearFlag(MODBUS_USART, USART_FLAG_TC);
+    DMA_Cmd(MODBUS_DMA_TX_CHANNEL, DISABLE);
+    DMA_SetCurrDataCounter(MODBUS_DMA_TX_CHANNEL, len + 2);
+    DMA_Cmd(MODBUS_DMA_TX_CHANNEL, ENABLE);
+    USART_ITConfig(MODBUS_USART, USART_IT_TC, ENABLE);
+}
+
+/**
+ * @brief Handle a complete frame, called from the gap timer interrupt
+ */
+static void Modbus_FrameEnd(void)
+{
+    uint32_t start = DWT_CYCCNT;
+    uint16_t len = MODBUS_RX_SIZE - DMA_GetCurrDataCounter(MODBUS_DMA_RX_CHANNEL);
+    uint8_t address = Modbus_RxBuffer[0];
+    uint16_t rspLen = 0;
+
+    DMA_Cmd(MODBUS_DMA_RX_CHANNEL, DISABLE);
+
+    if (len > MODBUS_ADU_MAX) {
+        Modbus_Counters.overruns++;
+    } else if (len < 4 || Modbus_CRC16(Modbus_RxBuffer, len) != 0) {
+        Modbus_Counters.crcErrors++;
+    } else if (address == Modbus_Address) {
+        Modbus_Counters.frames++;
+        rspLen = Modbus_Execute(&Modbus_RxBuffer[1], len - 3, &Modbus_TxBuffer[1]);
+    } else if (address == 0) {
+        // Broadcast: only writes are executed, never answered; reads are ignored
+        uint8_t function = Modbus_RxBuffer[1];
+
+        if (function == MODBUS_FC_WRITE_SINGLE_COIL || function == MODBUS_FC_WRITE_SINGLE_REGISTER ||
+            function == MODBUS_FC_WRITE_MULTIPLE_COILS || function == MODBUS_FC_WRITE_MULTIPLE_REGISTERS) {
+            Modbus_Execute(&Modbus_RxBuffer[1], len - 3, &Modbus_TxBuffer[1]);
+            if (!(Modbus_TxBuffer[1] & 0x80)) Modbus_Counters.broadcasts++;
+        }
+    } else {
+        Modbus_Counters.otherSlaves++;
+    }
+
+    if (rspLen == 0) {
+        Modbus_RxArm();
+        return;
+    }
+
+    if (Modbus_TxBuffer[1] & 0x80) Modbus_Counters.exceptions++;
+    Modbus_TxBuffer[0] = Modbus_Address;
+    Modbus_Send(1 + rspLen);
+
+    uint32_t latency = (DWT_CYCCNT - start) / Modbus_CyclesPerUs;
+    Modbus_Counters.lastLatencyUs = latency;
+    if (latency > Modbus_Counters.maxLatencyUs) Modbus_Counters.maxLatencyUs = latency;
+}
+
+/**
+ * @brief Copy the counters
+ *
+ * @param stats Destination
+ */
+void Modbus_GetStats(Modbus_Stats *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    stats->frames = Modbus_Counters.frames;
+    stats->broadcasts = Modbus_Counters.broadcasts;
+    stats->otherSlaves = Modbus_Counters.otherSlaves;
+    stats->crcErrors = Modbus_Counters.crcErrors;
+    stats->overruns = Modbus_Counters.overruns;
+    stats->exceptions = Modbus_Counters.exceptions;
+    stats->lastLatencyUs = Modbus_Counters.lastLatencyUs;
+    stats->maxLatencyUs = Modbus_Counters.maxLatencyUs;
+    stats->gapUs = Modbus_Counters.gapUs;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Modbus USART Interrupt Service Routine
+ *
+ * IDLE: the line has been quiet for one character, start the gap timer
+ * for the rest of the 3.5. TC: the last response byte has left the wire,
+ * release the bus and receive again.
+ */
+void MODBUS_USART_IRQHandler(void)
+{
+    uint16_t sr = MODBUS_USART->SR;
+
+    if ((sr & USART_FLAG_IDLE) && (MODBUS_USART->CR1 & USART_CR1_IDLEIE)) {
+        // SR then DR clears IDLE and the error flags; DMA has taken every byte
+        (void)MODBUS_USART->DR;
+        Modbus_IdleCount = DMA_GetCurrDataCounter(MODBUS_DMA_RX_CHANNEL);
+        MODBUS_TIM->CNT = 0;
+        TIM_Cmd(MODBUS_TIM, ENABLE);
+    }
+
+    if ((sr & USART_FLAG_TC) && (MODBUS_USART->CR1 & USART_CR1_TCIE)) {
+        USART_ITConfig(MODBUS_USART, USART_IT_TC, DISABLE);
+#if MODBUS_USE_DE
+        GPIO_ResetBits(MODBUS_DE_PORT, MODBUS_DE_PIN);
+#endif
+        Modbus_RxArm();
+    }
+}
+
+/**
+ * @brief Gap timer Interrupt Service Routine
+ *
+ * 3.5 characters since the last byte: the frame is complete unless more
+ * bytes arrived meanwhile (then the next IDLE restarts the timer).
+ */
+void MODBUS_TIM_IRQHandler(void)
+{
+    if (TIM_GetITStatus(MODBUS_TIM, TIM_IT_Update) == SET) {
+        TIM_ClearITPendingBit(MODBUS_TIM, TIM_IT_Update);
+        if (DMA_GetCurrDataCounter(MODBUS_DMA_RX_CHANNEL) == Modbus_IdleCount) {
+            Modbus_FrameEnd();
+        }
+    }
+}
@@ -9,12 +9,47 @@
 #include "stm32f10x.h"
 #include "OLED.h"
 #include "Serial.h"
+#include "Modbus.h"
+
+#define MODBUS_SLAVE_ADDRESS    1
+
+static uint16_t HoldingRegisters[8];
+static uint16_t InputRegisters[4];
+static uint8_t Coils[1];
+
+/**
+ * @brief Refresh the input registers before a Modbus read (timer interrupt)
+ */
+static uint8_t OnModbusRead(uint8_t table, uint16_t address, uint16_t count)
+{
+    Modbus_Stats stats;
+
+    if (table == MODBUS_INPUT_REGISTERS) {
+        Modbus_GetStats(&stats);
+        InputRegisters[0] = stats.frames;
+        InputRegisters[1] = stats.crcErrors;
+        InputRegisters[2] = stats.lastLatencyUs;
+        InputRegisters[3] = stats.maxLatencyUs;
+    }
+    return MODBUS_EX_NONE;
+}
+
+static const Modbus_Map ModbusMap = {
+    .coils = Coils,
+    .coilCount = 8,
+    .holdingRegisters = HoldingRegisters,
+    .holdingRegisterCount = 8,
+    .inputRegisters = InputRegisters,
+    .inputRegisterCount = 4,
+    .onRead = OnModbusRead
+};
 
 /**
  * @brief Main application entry point
  * 
  * Initializes OLED display and USART communication, then enters main loop
- * to receive data via USART and display it on OLED
+ * to receive data via USART and display it on OLED. A Modbus RTU slave runs
+ * on USART2 in the background; holding register 0 is shown on OLED
  * 
  * @return int Program status (not used in embedded context)
  */
@@ -24,8 +59,10 @@ int main(void)
 
     OLED_Init();
     Serial_Init();
+    Modbus_Init(MODBUS_SLAVE_ADDRESS, &ModbusMap);
 
     OLED_ShowString(1, 1, "RxData:");
+    OLED_ShowString(2, 1, "HR0:");
 
     while (1) {
         // Check if new data has been received
@@ -34,5 +71,6 @@ int main(void)
             Serial_SendByte(rx_data);
             OLED_ShowHexNum(1, 8, rx_data, 2);
         }
+        OLED_ShowHexNum(2, 5, HoldingRegisters[0], 4);
     }
 }
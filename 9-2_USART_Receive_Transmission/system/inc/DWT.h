@@ -0,0 +1,24 @@
+/****************************************************************************/ /**
+ * @file   DWT.h
+ * @brief  DWT cycle counter for execution time measurement - Header File
+ *
+ * One cycle is 1/72 us at 72 MHz; the 32-bit counter wraps after 59.6 s,
+ * differences of two reads stay correct across one wrap.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 23:41:09
+ ********************************************************************************/
+
+#ifndef __DWT_H__
+#define __DWT_H__
+
+#include "stm32f10x.h"
+
+// DWT registers (not in this CMSIS version of core_cm3.h)
+#define DWT_CTRL                (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT              (*(volatile uint32_t *)0xE0001004)
+#define DWT_CTRL_CYCCNTENA      0x00000001
+
+void DWT_Init(void);    // Start the cycle counter, may be called by every user
+
+#endif // !__DWT_H__
@@ -0,0 +1,109 @@
+/****************************************************************************/ /**
+ * @file   Packet.h
+ * @brief  COBS framed binary packets with CRC16 and sequence numbers - Header File
+ *
+ * Wire format, one frame:
+ *   COBS( type | seq | payload (0..PACKET_MTU bytes) | CRC16 high | CRC16 low ) 0x00
+ * COBS removes every 0x00 from the frame, so 0x00 only ever appears as the
+ * delimiter and any payload byte value is allowed. The CRC is CRC-16/GENIBUS
+ * (polynomial 0x1021, init 0xFFFF, inverted) over type, seq and payload.
+ *
+ * Encoder and decoder work in one pass without staging buffers: the encoder
+ * reads the payload straight from the caller into the wire buffer, the
+ * decoder takes the received bytes in chunks of any size (straight from the
+ * DMA buffer) and writes the decoded frame once.
+ *
+ * With PACKET_USE_ACK every DATA frame is answered with ACK (or NACK when a
+ * frame arrived damaged), the sender keeps one frame in flight and
+ * retransmits it after PACKET_ACK_TIMEOUT_MS; Packet_Tick() must then run
+ * every 1 ms from a timer interrupt.
+ *
+ * Building with PACKET_HOST defined keeps only the codec (no Serial binding),
+ * for the host fuzz program in tools/packet_fuzz.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 18:12:40
+ ********************************************************************************/
+
+#ifndef __PACKET_H__
+#define __PACKET_H__
+
+#include <stdint.h>
+
+// Largest payload of one packet
+#ifndef PACKET_MTU
+#define PACKET_MTU                  48
+#endif
+
+// 1 = acknowledged mode with retransmission, 0 = send and forget
+#define PACKET_USE_ACK              0
+#define PACKET_ACK_TIMEOUT_MS       50
+#define PACKET_RETRIES              3
+
+// Frame types
+#define PACKET_TYPE_DATA            0x01
+#define PACKET_TYPE_ACK             0x02
+#define PACKET_TYPE_NACK            0x03
+
+// Sizes: decoded frame, and encoded frame with COBS overhead and delimiter
+#define PACKET_HEADER_SIZE          2
+#define PACKET_CRC_SIZE             2
+#define PACKET_RAW_MAX              (PACKET_HEADER_SIZE + PACKET_MTU + PACKET_CRC_SIZE)
+#define PACKET_ENCODED_MAX          (PACKET_RAW_MAX + PACKET_RAW_MAX / 254 + 2)
+
+// Decoder results
+#define PACKET_DECODE_MORE          0   // Frame not complete yet
+#define PACKET_DECODE_FRAME         1   // Valid frame in decoder->message
+#define PACKET_DECODE_BAD_CRC       2   // Frame complete, CRC mismatch
+#define PACKET_DECODE_BAD_FRAME     3   // Too long, too short or broken COBS
+
+// Decoded packet; payload points into the decoder buffer and is valid until
+// the next byte is given to that decoder
+typedef struct {
+    uint8_t type;
+    uint8_t seq;
+    const uint8_t *payload;
+    uint16_t len;
+} Packet_Message;
+
+// Streaming decoder state, one per byte stream
+typedef struct {
+    uint8_t buf[PACKET_RAW_MAX];
+    uint16_t len;               // Decoded bytes so far
+    uint16_t crc;               // CRC over the decoded bytes except the last two
+    uint8_t code;               // COBS code of the current block, 0 before the first
+    uint8_t remain;             // Data bytes left in the current block
+    uint8_t error;              // Frame broken, skip to the delimiter
+    Packet_Message message;     // Filled on PACKET_DECODE_FRAME
+} Packet_Decoder;
+
+// Link counters
+typedef struct {
+    uint32_t txPackets;         // DATA frames sent (not counting retransmissions)
+    uint32_t rxPackets;         // DATA frames delivered
+    uint32_t crcErrors;
+    uint32_t framingErrors;
+    uint32_t seqGaps;           // DATA frames missing between two received ones
+    uint32_t duplicates;        // Retransmitted DATA frames received again
+    uint32_t retransmits;
+    uint32_t sendFailures;      // Frames given up after PACKET_RETRIES
+} Packet_Stats;
+
+// Codec
+uint16_t Packet_CRC16(uint16_t crc, const uint8_t *data, uint16_t len);
+uint16_t Packet_Encode(uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len, uint8_t *out);
+void Packet_DecoderReset(Packet_Decoder *dec);
+uint8_t Packet_DecoderPut(Packet_Decoder *dec, uint8_t b);
+uint16_t Packet_DecoderFeed(Packet_Decoder *dec, const uint8_t *data, uint16_t len, uint8_t *result);
+
+#ifndef PACKET_HOST
+// Link over USART1
+void Packet_Init(void);
+uint8_t Packet_Send(const uint8_t *payload, uint16_t len);
+uint8_t Packet_IsBusy(void);
+uint8_t Packet_Poll(Packet_Message *msg);
+void Packet_Tick(void);
+void Packet_GetStats(Packet_Stats *stats);
+#endif
+
+#endif // !__PACKET_H__
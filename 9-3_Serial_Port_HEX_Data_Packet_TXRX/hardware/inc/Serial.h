@@ -15,6 +15,46 @@
 
 #define SERIAL_PACKET_SIZE 64
 
+#define SERIAL_BAUDRATE         9600
+
+// Frame delimiting on receive:
+// - SERIAL_FRAMING_HEX:  0xFF + data + 0xEF, frame holds the data only; data
+//   must not contain 0xEF
+// - SERIAL_FRAMING_COBS: frame ends at 0x00 and holds the COBS encoded bytes
+//   with the 0x00, decoded by the Packet module
+#define SERIAL_FRAMING_HEX      0
+#define SERIAL_FRAMING_COBS     1
+#define SERIAL_FRAMING          SERIAL_FRAMING_COBS
+
+// Receive mode: 0 = RXNE interrupt, packet state machine runs for every byte
+//               1 = circular DMA on DMA1 channel 5, frames are found on the
+//                   USART IDLE and DMA half/full-transfer interrupts
+#define SERIAL_RX_DMA           1
+
+// Circular DMA buffer, power of two; must hold the bytes arriving while a
+// frame is held by the application (128 bytes = 1.3 ms at 1 Mbaud)
+#define SERIAL_DMA_BUFFER_SIZE  256
+
+// Complete frames waiting for the application, power of two
+#define SERIAL_FRAME_QUEUE_SIZE 8
+
+// Received frame; data points into the DMA buffer (or into Serial_RxPacket
+// if the frame wraps around the buffer end) and is valid until
+// Serial_ReleaseFrame()
+typedef struct {
+    const uint8_t *data;
+    uint16_t len;
+} Serial_Frame;
+
+// Receive counters
+typedef struct {
+    uint32_t frames;            // Frames handed to the application
+    uint32_t interrupts;        // USART IDLE + DMA HT/TC interrupts
+    uint32_t queueOverflows;    // Frames dropped, queue full
+    uint32_t tooLong;           // Frames dropped, longer than SERIAL_PACKET_SIZE
+    uint32_t overwritten;       // Frames overwritten by DMA while held
+} Serial_RxStats;
+
 extern uint8_t Serial_RxPacket[];
 extern uint16_t Serial_RxLen;
 
@@ -25,6 +65,9 @@ void Serial_SendString(char *str);  // Send null-terminated string
 void Serial_SendNumber(uint32_t num, uint8_t len);  // Send numeric value as ASCII
 void Serial_Printf(char *format, ...);  // Custom printf implementation
 uint8_t Serial_GetRxFlag(void);     // Check if new data has been received
-void Serial_SendPacket(uint8_t *txPacket, uint16_t num);  // Send a data packet with predefined structure
+void Serial_SendPacket(uint8_t *txPacket, uint16_t num);  // Send num bytes as a 0xFF ... 0xEF packet
+uint8_t Serial_GetFrame(Serial_Frame *frame);   // Zero-copy access to the oldest received frame
+uint8_t Serial_ReleaseFrame(void);      // Release it, 0 if DMA overwrote it meanwhile
+void Serial_GetRxStats(Serial_RxStats *stats);  // Copy the receive counters
 
 #endif // !__SERIAL_H__
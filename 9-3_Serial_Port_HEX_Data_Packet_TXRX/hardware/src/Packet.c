@@ -0,0 +1,459 @@
+/****************************************************************************/ /**
+ * @file   Packet.c
+ * @brief  COBS framed binary packets with CRC16 and sequence numbers - Source File
+ *
+ * COBS (Consistent Overhead Byte Stuffing): the frame is cut at every 0x00
+ * into blocks; each block is sent as a code byte (block length + 1) followed
+ * by its non-zero bytes, the 0x00 itself is implied by the next code byte.
+ * A block without a 0x00 after it is at most 254 bytes (code 0xFF). The
+ * overhead is one byte per 254, against up to 100% for SLIP escaping.
+ *
+ * The CRC is inverted before it is sent (CRC-16/GENIBUS). Without that, a
+ * frame whose CRC low byte is 0x00 still passes when COBS loses or gains that
+ * trailing 0x00, one frame in 256 (found by tools/packet_fuzz). The decoder
+ * runs the CRC two bytes behind the decoded data, so when the delimiter
+ * arrives the CRC of everything before the last two bytes is ready and the
+ * frame is never looked at twice.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 18:12:40
+ ********************************************************************************/
+
+#include "Packet.h"
+
+#ifndef PACKET_HOST
+#include "Serial.h"
+
+#if PACKET_ENCODED_MAX > SERIAL_PACKET_SIZE
+#error "SERIAL_PACKET_SIZE is too small for an encoded PACKET_MTU frame"
+#endif
+#endif
+
+#define PACKET_CRC_INIT             0xFFFF
+#define PACKET_CRC_XOROUT           0xFFFF
+
+// CRC-16/CCITT, polynomial 0x1021, one entry per value of the top byte
+static const uint16_t Packet_CRCTable[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+// COBS encoder state while writing one frame
+typedef struct {
+    uint8_t *out;
+    uint16_t pos;               // Next output byte
+    uint16_t codePos;           // Code byte of the open block
+    uint8_t code;               // Open block length + 1
+    uint16_t crc;
+} Packet_Cobs;
+
+/**
+ * @brief Update a CRC-16/CCITT with a block of data
+ * 
+ * @param crc CRC so far, 0xFFFF to start
+ * @param data Data bytes
+ * @param len Number of bytes
+ * @return uint16_t Updated CRC, inverted at the end of a frame
+ */
+uint16_t Packet_CRC16(uint16_t crc, const uint8_t *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        crc = (uint16_t)(crc << 8) ^ Packet_CRCTable[(crc >> 8) ^ data[i]];
+    }
+    return crc;
+}
+
+/**
+ * @brief Append one frame byte to the COBS output
+ */
+static void Packet_CobsPut(Packet_Cobs *cobs, uint8_t b)
+{
+    cobs->crc = (uint16_t)(cobs->crc << 8) ^ Packet_CRCTable[(cobs->crc >> 8) ^ b];
+
+    if (b != 0) {
+        cobs->out[cobs->pos++] = b;
+        cobs->code++;
+    }
+    // A 0x00 or a full block closes the block
+    if (b == 0 || cobs->code == 0xFF) {
+        cobs->out[cobs->codePos] = cobs->code;
+        cobs->codePos = cobs->pos++;
+        cobs->code = 1;
+    }
+}
+
+/**
+ * @brief Encode a frame, ready to send
+ * 
+ * The payload is read once, CRC and byte stuffing are done in the same pass.
+ * 
+ * @param type PACKET_TYPE_x
+ * @param seq Sequence number
+ * @param payload Payload bytes, may be NULL when len is 0
+ * @param len Payload length, up to PACKET_MTU
+ * @param out Output buffer of PACKET_ENCODED_MAX bytes
+ * @return uint16_t Encoded length including the 0x00 delimiter, 0 if len is too large
+ */
+uint16_t Packet_Encode(uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len, uint8_t *out)
+{
+    Packet_Cobs cobs = { out, 1, 0, 1, PACKET_CRC_INIT };
+    uint16_t crc;
+
+    if (len > PACKET_MTU) return 0;
+
+    Packet_CobsPut(&cobs, type);
+    Packet_CobsPut(&cobs, seq);
+    for (uint16_t i = 0; i < len; i++) {
+        Packet_CobsPut(&cobs, payload[i]);
+    }
+    crc = cobs.crc ^ PACKET_CRC_XOROUT;
+    Packet_CobsPut(&cobs, crc >> 8);
+    Packet_CobsPut(&cobs, crc & 0xFF);
+
+    out[cobs.codePos] = cobs.code;
+    out[cobs.pos++] = 0x00;
+    return cobs.pos;
+}
+
+/**
+ * @brief Forget any partial frame
+ * 
+ * @param dec Decoder
+ */
+void Packet_DecoderReset(Packet_Decoder *dec)
+{
+    dec->len = 0;
+    dec->crc = PACKET_CRC_INIT;
+    dec->code = 0;
+    dec->remain = 0;
+    dec->error = 0;
+}
+
+/**
+ * @brief Store one decoded frame byte
+ */
+static void Packet_DecoderEmit(Packet_Decoder *dec, uint8_t b)
+{
+    if (dec->len >= PACKET_RAW_MAX) {
+        dec->error = 1;
+        return;
+    }
+    // The last two bytes are the CRC itself, so the CRC lags two bytes behind
+    if (dec->len >= PACKET_CRC_SIZE) {
+        uint8_t lagged = dec->buf[dec->len - PACKET_CRC_SIZE];
+        dec->crc = (uint16_t)(dec->crc << 8) ^ Packet_CRCTable[(dec->crc >> 8) ^ lagged];
+    }
+    dec->buf[dec->len++] = b;
+}
+
+/**
+ * @brief Compare the CRC of a complete frame with its last two bytes
+ */
+static uint8_t Packet_DecoderCRCBad(const Packet_Decoder *dec)
+{
+    uint16_t sent = (uint16_t)(dec->buf[dec->len - 2] << 8) | dec->buf[dec->len - 1];
+    uint16_t crc = dec->crc ^ PACKET_CRC_XOROUT;
+
+    return crc != sent;
+}
+
+/**
+ * @brief Give one received byte to the decoder
+ * 
+ * Bytes before the first delimiter after power-up may be the tail of a frame
+ * and give one PACKET_DECODE_BAD_FRAME; a 0x00 0x00 sequence is ignored, so
+ * a sender may start with 0x00 to resynchronize the receiver.
+ * 
+ * @param dec Decoder
+ * @param b Received byte
+ * @return uint8_t PACKET_DECODE_x
+ */
+uint8_t Packet_DecoderPut(Packet_Decoder *dec, uint8_t b)
+{
+    uint8_t result;
+
+    if (b == 0x00) {
+        if (dec->code == 0 && !dec->error) {
+            result = PACKET_DECODE_MORE;        // Empty frame
+        } else if (dec->error || dec->remain != 0 ||
+                   dec->len < PACKET_HEADER_SIZE + PACKET_CRC_SIZE) {
+            result = PACKET_DECODE_BAD_FRAME;
+        } else if (Packet_DecoderCRCBad(dec)) {
+            result = PACKET_DECODE_BAD_CRC;
+        } else {
+            dec->message.type = dec->buf[0];
+            dec->message.seq = dec->buf[1];
+            dec->message.payload = &dec->buf[PACKET_HEADER_SIZE];
+            dec->message.len = dec->len - PACKET_HEADER_SIZE - PACKET_CRC_SIZE;
+            result = PACKET_DECODE_FRAME;
+        }
+        Packet_DecoderReset(dec);
+        return result;
+    }
+
+    if (dec->error) return PACKET_DECODE_MORE;
+
+    if (dec->remain == 0) {
+        // Code byte: the previous block ended with an implied 0x00 unless it was full
+        if (dec->code != 0 && dec->code != 0xFF) Packet_DecoderEmit(dec, 0x00);
+        dec->code = b;
+        dec->remain = b - 1;
+    } else {
+        Packet_DecoderEmit(dec, b);
+        dec->remain--;
+    }
+    return PACKET_DECODE_MORE;
+}
+
+/**
+ * @brief Give a block of received bytes to the decoder
+ * 
+ * Stops right after the byte that completed a frame, so the caller can use
+ * the message before feeding the rest.
+ * 
+ * @param dec Decoder
+ * @param data Received bytes
+ * @param len Number of bytes
+ * @param result PACKET_DECODE_x of the last byte consumed
+ * @return uint16_t Number of bytes consumed
+ */
+uint16_t Packet_DecoderFeed(Packet_Decoder *dec, const uint8_t *data, uint16_t len, uint8_t *result)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t r = Packet_DecoderPut(dec, data[i]);
+        if (r != PACKET_DECODE_MORE) {
+            *result = r;
+            return i + 1;
+        }
+    }
+    *result = PACKET_DECODE_MORE;
+    return len;
+}
+
+#ifndef PACKET_HOST
+static Packet_Decoder Packet_Rx;
+static uint8_t Packet_TxFrame[PACKET_ENCODED_MAX];     // Kept for retransmission
+static uint16_t Packet_TxLen;
+static uint8_t Packet_TxSeq = 0;        // Sequence number of the next DATA frame
+static uint8_t Packet_RxSeq;            // Sequence number of the last DATA frame received
+static uint8_t Packet_RxSeen = 0;
+static Packet_Stats Packet_Counters;
+
+#if PACKET_USE_ACK
+static uint8_t Packet_Pending = 0;      // A DATA frame waits for its ACK
+static uint8_t Packet_PendingSeq;
+static uint8_t Packet_Retries;
+static volatile uint16_t Packet_Timer;  // ms left until retransmission
+#endif
+
+/**
+ * @brief Initialize the link and USART1
+ */
+void Packet_Init(void)
+{
+    Serial_Init();
+    Packet_DecoderReset(&Packet_Rx);
+}
+
+/**
+ * @brief Send a payload as one DATA frame
+ * 
+ * @param payload Payload bytes
+ * @param len Payload length, up to PACKET_MTU
+ * @return uint8_t 1 if sent, 0 if too long or (acknowledged mode) the
+ *         previous frame is still waiting for its ACK
+ */
+uint8_t Packet_Send(const uint8_t *payload, uint16_t len)
+{
+    if (Packet_IsBusy()) return 0;
+
+    Packet_TxLen = Packet_Encode(PACKET_TYPE_DATA, Packet_TxSeq, payload, len, Packet_TxFrame);
+    if (Packet_TxLen == 0) return 0;
+
+#if PACKET_USE_ACK
+    Packet_PendingSeq = Packet_TxSeq;
+    Packet_Retries = 0;
+    Packet_Timer = PACKET_ACK_TIMEOUT_MS;
+    Packet_Pending = 1;
+#endif
+    Packet_TxSeq++;
+    Packet_Counters.txPackets++;
+    Serial_SendArray(Packet_TxFrame, Packet_TxLen);
+    return 1;
+}
+
+/**
+ * @brief Check whether a sent frame still waits for its ACK
+ * 
+ * @return uint8_t 1 if Packet_Send() would refuse a new frame
+ */
+uint8_t Packet_IsBusy(void)
+{
+#if PACKET_USE_ACK
+    return Packet_Pending;
+#else
+    return 0;
+#endif
+}
+
+#if PACKET_USE_ACK
+/**
+ * @brief Send an ACK or NACK frame
+ */
+static void Packet_SendControl(uint8_t type, uint8_t seq)
+{
+    uint8_t frame[PACKET_HEADER_SIZE + PACKET_CRC_SIZE + 2];
+    Serial_SendArray(frame, Packet_Encode(type, seq, 0, 0, frame));
+}
+
+/**
+ * @brief Send the pending frame again
+ */
+static void Packet_Retransmit(void)
+{
+    Packet_Retries++;
+    Packet_Counters.retransmits++;
+    Packet_Timer = PACKET_ACK_TIMEOUT_MS;
+    Serial_SendArray(Packet_TxFrame, Packet_TxLen);
+}
+#endif
+
+/**
+ * @brief Act on one decoder result
+ * 
+ * @return uint8_t 1 if msg now holds a new DATA payload
+ */
+static uint8_t Packet_Handle(uint8_t result, Packet_Message *msg)
+{
+    const Packet_Message *m = &Packet_Rx.message;
+
+    if (result == PACKET_DECODE_BAD_CRC || result == PACKET_DECODE_BAD_FRAME) {
+        if (result == PACKET_DECODE_BAD_CRC) {
+            Packet_Counters.crcErrors++;
+        } else {
+            Packet_Counters.framingErrors++;
+        }
+#if PACKET_USE_ACK
+        // The damaged frame's own seq cannot be trusted, ask for the next expected one
+        Packet_SendControl(PACKET_TYPE_NACK, Packet_RxSeq + 1);
+#endif
+        return 0;
+    }
+    if (result != PACKET_DECODE_FRAME) return 0;
+
+    switch (m->type) {
+        case PACKET_TYPE_DATA:
+#if PACKET_USE_ACK
+            Packet_SendControl(PACKET_TYPE_ACK, m->seq);
+#endif
+            if (Packet_RxSeen && m->seq == Packet_RxSeq) {
+                Packet_Counters.duplicates++;   // Our ACK was lost, the sender tried again
+                return 0;
+            }
+            if (Packet_RxSeen) Packet_Counters.seqGaps += (uint8_t)(m->seq - Packet_RxSeq - 1);
+            Packet_RxSeq = m->seq;
+            Packet_RxSeen = 1;
+            Packet_Counters.rxPackets++;
+            *msg = *m;
+            return 1;
+#if PACKET_USE_ACK
+        case PACKET_TYPE_ACK:
+            if (Packet_Pending && m->seq == Packet_PendingSeq) Packet_Pending = 0;
+            break;
+        case PACKET_TYPE_NACK:
+            if (Packet_Pending && m->seq == Packet_PendingSeq) Packet_Retransmit();
+            break;
+#endif
+    }
+    return 0;
+}
+
+/**
+ * @brief Process received frames and retransmission, call from the main loop
+ * 
+ * Decodes straight from the serial DMA buffer. The returned payload points
+ * into the link's decoder and is valid until the next Packet_Poll().
+ * 
+ * @param msg Receives the next DATA payload
+ * @return uint8_t 1 if a payload was received, 0 otherwise
+ */
+uint8_t Packet_Poll(Packet_Message *msg)
+{
+    Serial_Frame frame;
+
+#if PACKET_USE_ACK
+    if (Packet_Pending && Packet_Timer == 0) {
+        if (Packet_Retries < PACKET_RETRIES) {
+            Packet_Retransmit();
+        } else {
+            Packet_Pending = 0;
+            Packet_Counters.sendFailures++;
+        }
+    }
+#endif
+
+    while (Serial_GetFrame(&frame)) {
+        uint8_t result;
+
+        // A serial frame is one encoded frame up to and including its delimiter
+        Packet_DecoderFeed(&Packet_Rx, frame.data, frame.len, &result);
+        if (!Serial_ReleaseFrame()) {
+            // DMA overwrote the bytes while they were decoded
+            Packet_DecoderReset(&Packet_Rx);
+            result = PACKET_DECODE_BAD_FRAME;
+        }
+        if (Packet_Handle(result, msg)) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Retransmission timer, call every 1 ms from a timer interrupt
+ */
+void Packet_Tick(void)
+{
+#if PACKET_USE_ACK
+    if (Packet_Timer) Packet_Timer--;
+#endif
+}
+
+/**
+ * @brief Copy the link counters
+ * 
+ * @param stats Destination
+ */
+void Packet_GetStats(Packet_Stats *stats)
+{
+    *stats = Packet_Counters;
+}
+#endif
@@ -7,11 +7,32 @@
  ********************************************************************************/
 
 #include "Serial.h"
+#include <string.h>
 
 uint8_t Serial_RxPacket[SERIAL_PACKET_SIZE];
 uint16_t Serial_RxLen = 0;
 uint8_t Serial_RxFlag = 0;  // Flag indicating new data received
 
+static Serial_RxStats Serial_RxCounters;
+
+#if SERIAL_RX_DMA
+#define SERIAL_DMA_MASK         (SERIAL_DMA_BUFFER_SIZE - 1)
+#define SERIAL_QUEUE_MASK       (SERIAL_FRAME_QUEUE_SIZE - 1)
+
+#if (SERIAL_DMA_BUFFER_SIZE & SERIAL_DMA_MASK) || (SERIAL_FRAME_QUEUE_SIZE & SERIAL_QUEUE_MASK)
+#error "SERIAL_DMA_BUFFER_SIZE and SERIAL_FRAME_QUEUE_SIZE must be powers of two"
+#endif
+
+static uint8_t Serial_DmaBuffer[SERIAL_DMA_BUFFER_SIZE];
+static uint32_t Serial_DmaPos = 0;      // Absolute index of the next byte to scan
+
+// Complete frames: absolute index of the first data byte and length
+static uint32_t Serial_FrameStart[SERIAL_FRAME_QUEUE_SIZE];
+static uint16_t Serial_FrameLen[SERIAL_FRAME_QUEUE_SIZE];
+static volatile uint8_t Serial_FrameHead = 0;   // Written by the interrupts
+static volatile uint8_t Serial_FrameTail = 0;   // Written by the main loop
+#endif
+
 /**
  * @brief Initialize USART1 for serial communication
  * 
@@ -39,7 +60,7 @@ void Serial_Init(void)
 
     // Configure USART1 parameters
     USART_InitTypeDef USART_InitStructure;
-    USART_InitStructure.USART_BaudRate = 9600;
+    USART_InitStructure.USART_BaudRate = SERIAL_BAUDRATE;
     USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
     USART_InitStructure.USART_Mode = USART_Mode_Tx | USART_Mode_Rx;
     USART_InitStructure.USART_Parity = USART_Parity_No;
@@ -47,8 +68,34 @@ void Serial_Init(void)
     USART_InitStructure.USART_WordLength = USART_WordLength_8b;
     USART_Init(USART1, &USART_InitStructure);
 
+#if SERIAL_RX_DMA
+    // Configure DMA1 channel 5 (USART1_RX): DR -> circular buffer
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    DMA_DeInit(DMA1_Channel5);
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)Serial_DmaBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = SERIAL_DMA_BUFFER_SIZE;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel5, &DMA_InitStructure);
+    // Half/full transfer: scan at least twice per buffer lap on long streams
+    DMA_ITConfig(DMA1_Channel5, DMA_IT_HT | DMA_IT_TC, ENABLE);
+    USART_DMACmd(USART1, USART_DMAReq_Rx, ENABLE);
+    DMA_Cmd(DMA1_Channel5, ENABLE);
+
+    // Configure USART1 IDLE Interrupt: the line went quiet after a burst
+    USART_ITConfig(USART1, USART_IT_IDLE, ENABLE);
+#else
     // Configure USART1 Reception Interrupt
     USART_ITConfig(USART1, USART_IT_RXNE, ENABLE);
+#endif
     // Configure NVIC for USART1 interrupt
     NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
     NVIC_InitTypeDef NVIC_InitStructure;
@@ -57,6 +104,11 @@ void Serial_Init(void)
     NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
     NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
     NVIC_Init(&NVIC_InitStructure);
+#if SERIAL_RX_DMA
+    // Same priority as USART1, the two handlers never preempt each other
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel5_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+#endif
 
     // Enable USART1 peripheral
     USART_Cmd(USART1, ENABLE);
@@ -169,40 +221,234 @@ void Serial_Printf(char *format, ...)
 /**
  * @brief Check if new data has been received
  * 
+ * In DMA mode the oldest frame is copied into Serial_RxPacket; use
+ * Serial_GetFrame() to avoid the copy.
+ * 
  * @return uint8_t 1 if new data available, 0 otherwise
  */
 uint8_t Serial_GetRxFlag(void)
 {
+#if SERIAL_RX_DMA
+    Serial_Frame frame;
+
+    if (!Serial_GetFrame(&frame)) return 0;
+    if (frame.data != Serial_RxPacket) {
+        memcpy(Serial_RxPacket, frame.data, frame.len);
+    }
+    Serial_RxLen = frame.len;
+    return Serial_ReleaseFrame();
+#else
     if (Serial_RxFlag == 1) {
         Serial_RxFlag = 0;  // Clear flag after reading
         return 1;
     }
     return 0;
+#endif
 }
 
 /**
  * @brief Send a data packet with predefined structure
  * 
- * Packet structure: 0xFF header + num data bytes + 0xEF footer
+ * Packet structure: 0xFF header + num data bytes + 0xEF footer.
+ * The data must not contain 0xEF; the Packet module carries any bytes.
  * @param txPacket Pointer to the num-byte data array to be sent
  * @param num The numbers of data
  */
 void Serial_SendPacket(uint8_t *txPacket, uint16_t num)
 {
     Serial_SendByte(0xFF);
-    Serial_SendArray(txPacket, 4);
+    Serial_SendArray(txPacket, num);
     Serial_SendByte(0xEF);
 }
 
+#if SERIAL_RX_DMA
+/**
+ * @brief Number of bytes DMA has written so far, as an absolute index
+ * 
+ * Valid as long as the interrupts scan the buffer at least once per lap,
+ * which the half/full transfer interrupts guarantee.
+ */
+static uint32_t Serial_DmaWritten(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t pos;
+    uint16_t index;
+
+    __disable_irq();
+    pos = Serial_DmaPos;
+    index = SERIAL_DMA_BUFFER_SIZE - DMA_GetCurrDataCounter(DMA1_Channel5);
+    __set_PRIMASK(primask);
+
+    return pos + ((index - pos) & SERIAL_DMA_MASK);
+}
+
+/**
+ * @brief Queue a complete frame found by the scanner
+ * 
+ * @param start Absolute index of the first data byte
+ * @param len Number of data bytes
+ */
+static void Serial_PushFrame(uint32_t start, uint32_t len)
+{
+    uint8_t head = Serial_FrameHead;
+
+    if (len > SERIAL_PACKET_SIZE) {
+        Serial_RxCounters.tooLong++;
+    } else if ((uint8_t)(head - Serial_FrameTail) >= SERIAL_FRAME_QUEUE_SIZE) {
+        Serial_RxCounters.queueOverflows++;
+    } else {
+        Serial_FrameStart[head & SERIAL_QUEUE_MASK] = start;
+        Serial_FrameLen[head & SERIAL_QUEUE_MASK] = len;
+        Serial_FrameHead = head + 1;
+    }
+}
+
+/**
+ * @brief Scan the bytes DMA wrote since the last interrupt for frames
+ * 
+ * Runs from the USART1 IDLE and DMA1 channel 5 HT/TC interrupts, so there is
+ * one interrupt per burst instead of one per byte.
+ * Packet format: 0xFF (header) + data + 0xEF (footer), or COBS bytes + 0x00
+ */
+static void Serial_DmaScan(void)
+{
+    static uint8_t RxStatus = 0;    // Current state in packet reception state machine
+    static uint32_t start;          // Absolute index of the current packet data
+    uint16_t index = SERIAL_DMA_BUFFER_SIZE - DMA_GetCurrDataCounter(DMA1_Channel5);
+    uint32_t end = Serial_DmaPos + ((index - Serial_DmaPos) & SERIAL_DMA_MASK);
+
+    Serial_RxCounters.interrupts++;
+
+    for (; Serial_DmaPos != end; Serial_DmaPos++) {
+        uint8_t RxData = Serial_DmaBuffer[Serial_DmaPos & SERIAL_DMA_MASK];
+
+#if SERIAL_FRAMING == SERIAL_FRAMING_COBS
+        (void)RxStatus;
+        if (RxData == 0x00) {
+            // Frame includes its delimiter; a lone 0x00 is only a resync
+            if (Serial_DmaPos != start) Serial_PushFrame(start, Serial_DmaPos + 1 - start);
+            start = Serial_DmaPos + 1;
+        }
+#else
+        switch (RxStatus) {
+            case 0:     // Waiting for packet header
+                if (RxData == 0xFF) {
+                    RxStatus = 1;
+                    start = Serial_DmaPos + 1;
+                }
+                break;
+            case 1:     // Receiving packet data
+                if (RxData == 0xEF) {
+                    RxStatus = 0;
+                    Serial_PushFrame(start, Serial_DmaPos - start);
+                }
+                break;
+        }
+#endif
+    }
+}
+#endif
+
+/**
+ * @brief Get the oldest received frame without copying it
+ * 
+ * The data stays in the DMA buffer; only a frame that wraps around the
+ * buffer end is linearized into Serial_RxPacket. Calling again before
+ * Serial_ReleaseFrame() returns the same frame.
+ * 
+ * @param frame Receives pointer and length
+ * @return uint8_t 1 if a frame is available, 0 otherwise
+ */
+uint8_t Serial_GetFrame(Serial_Frame *frame)
+{
+#if SERIAL_RX_DMA
+    while (Serial_FrameTail != Serial_FrameHead) {
+        uint8_t i = Serial_FrameTail & SERIAL_QUEUE_MASK;
+        uint32_t start = Serial_FrameStart[i];
+        uint16_t len = Serial_FrameLen[i];
+        uint16_t offset = start & SERIAL_DMA_MASK;
+
+        if (Serial_DmaWritten() - start > SERIAL_DMA_BUFFER_SIZE) {
+            // Lapped by DMA while waiting in the queue
+            Serial_RxCounters.overwritten++;
+            Serial_FrameTail++;
+            continue;
+        }
+
+        if (offset + len <= SERIAL_DMA_BUFFER_SIZE) {
+            frame->data = &Serial_DmaBuffer[offset];
+        } else {
+            uint16_t first = SERIAL_DMA_BUFFER_SIZE - offset;
+            memcpy(Serial_RxPacket, &Serial_DmaBuffer[offset], first);
+            memcpy((uint8_t *)Serial_RxPacket + first, Serial_DmaBuffer, len - first);
+            frame->data = Serial_RxPacket;
+        }
+        frame->len = len;
+        return 1;
+    }
+    return 0;
+#else
+    if (Serial_RxFlag != 1) return 0;
+    frame->data = Serial_RxPacket;
+    frame->len = Serial_RxLen;
+    return 1;
+#endif
+}
+
+/**
+ * @brief Release the frame returned by Serial_GetFrame()
+ * 
+ * @return uint8_t 1 if the frame data was intact until now, 0 if DMA
+ *         overwrote it while it was held (the frame must be discarded)
+ */
+uint8_t Serial_ReleaseFrame(void)
+{
+#if SERIAL_RX_DMA
+    uint32_t start;
+
+    if (Serial_FrameTail == Serial_FrameHead) return 0;
+
+    start = Serial_FrameStart[Serial_FrameTail & SERIAL_QUEUE_MASK];
+    Serial_FrameTail++;
+
+    if (Serial_DmaWritten() - start > SERIAL_DMA_BUFFER_SIZE) {
+        Serial_RxCounters.overwritten++;
+        return 0;
+    }
+#else
+    if (Serial_RxFlag != 1) return 0;
+    Serial_RxFlag = 0;
+#endif
+    Serial_RxCounters.frames++;
+    return 1;
+}
+
+/**
+ * @brief Copy the receive counters
+ * 
+ * @param stats Destination
+ */
+void Serial_GetRxStats(Serial_RxStats *stats)
+{
+    *stats = Serial_RxCounters;
+}
+
 /**
  * @brief USART1 Interrupt Service Routine
  * 
  * Handles USART1 receive interrupt, implements packet-based communication protocol
- * Packet format: 0xFF (header) + data + 0xEF (footer)
+ * Packet format: 0xFF (header) + data + 0xEF (footer), or COBS bytes + 0x00
  * Sets receive flag when complete packet is received
  */
 void USART1_IRQHandler(void)
 {
+#if SERIAL_RX_DMA
+    // Line idle after a burst: SR then DR clears IDLE
+    if (USART_GetITStatus(USART1, USART_IT_IDLE) == SET) {
+        USART_ReceiveData(USART1);
+        Serial_DmaScan();
+    }
+#else
     static uint8_t RxStatus = 0;    // Current state in packet reception state machine
     static uint8_t p_RxPacket = 0;  // Current position in receive packet buffer
 
@@ -210,6 +456,22 @@ void USART1_IRQHandler(void)
     if (USART_GetITStatus(USART1, USART_IT_RXNE) == SET) {
         uint8_t RxData = USART_ReceiveData(USART1);
 
+#if SERIAL_FRAMING == SERIAL_FRAMING_COBS
+        (void)RxStatus;
+        if (Serial_RxFlag == 0 && p_RxPacket < SERIAL_PACKET_SIZE) {
+            Serial_RxPacket[p_RxPacket++] = RxData;
+        }
+        if (RxData == 0x00) {
+            // Frame includes its delimiter; a lone 0x00 is only a resync
+            if (p_RxPacket > 1 && Serial_RxPacket[p_RxPacket - 1] == 0x00) {
+                Serial_RxLen = p_RxPacket;
+                Serial_RxFlag = 1;
+            } else if (p_RxPacket == SERIAL_PACKET_SIZE) {
+                Serial_RxCounters.tooLong++;
+            }
+            p_RxPacket = 0;
+        }
+#else
         switch (RxStatus) {
             case 0:     // Waiting for packet header
                 if (RxData == 0xFF) {
@@ -227,7 +489,25 @@ void USART1_IRQHandler(void)
                 Serial_RxLen = p_RxPacket;
                 break;
         }
+#endif
 
         USART_ClearITPendingBit(USART1, USART_IT_RXNE);
     }
+#endif
+}
+
+#if SERIAL_RX_DMA
+/**
+ * @brief DMA1 Channel 5 Interrupt Service Routine
+ * 
+ * Half and full transfer of the circular buffer: scan what arrived so far,
+ * a long stream without idle gaps is never lapped unscanned.
+ */
+void DMA1_Channel5_IRQHandler(void)
+{
+    if (DMA_GetITStatus(DMA1_IT_HT5) == SET || DMA_GetITStatus(DMA1_IT_TC5) == SET) {
+        DMA_ClearITPendingBit(DMA1_IT_HT5 | DMA1_IT_TC5);
+        Serial_DmaScan();
+    }
 }
+#endif
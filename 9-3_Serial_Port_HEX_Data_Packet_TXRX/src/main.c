@@ -8,13 +8,13 @@
 
 #include "stm32f10x.h"
 #include "OLED.h"
-#include "Serial.h"
+#include "Packet.h"
 #include "Key.h"
 
 int main(void)
 {
     OLED_Init();
-    Serial_Init();
+    Packet_Init();
     Key_Init();
 
     OLED_ShowString(1, 1, "Tx Packet:");
@@ -28,12 +28,13 @@ int main(void)
             for (int i = 0; i < 4; ++i) {
                 OLED_ShowHexNum(2, i * 3 + 1, ++txPacket[i], 2);
             }
-            Serial_SendPacket(txPacket, 4);
+            Packet_Send(txPacket, 4);
         }
-        if (Serial_GetRxFlag() == 1) {
+        Packet_Message rxMessage;
+        if (Packet_Poll(&rxMessage) == 1) {
             OLED_ShowString(4, 1, "                ");
-            for (int i = 0; i < Serial_RxLen; ++i) {
-                OLED_ShowHexNum(i / 5 + 4, i % 5 * 3 + 1, Serial_RxPacket[i], 2);
+            for (int i = 0; i < rxMessage.len && i < 5; ++i) {
+                OLED_ShowHexNum(4, i * 3 + 1, rxMessage.payload[i], 2);
             }
         }
     }
@@ -0,0 +1,287 @@
+/****************************************************************************/ /**
+ * @file   Packet_Fuzz.c
+ * @brief  Host fuzz program for the Packet COBS/CRC16 codec
+ *
+ * Build and run from this directory:
+ *   gcc -O1 -g -std=c99 -fsanitize=address,undefined -DPACKET_HOST \
+ *       -I../../hardware/inc Packet_Fuzz.c ../../hardware/src/Packet.c -o packet_fuzz
+ *   ./packet_fuzz [iterations]
+ * Add -DPACKET_MTU=600 to cover COBS blocks longer than 254 bytes.
+ *
+ * Passes:
+ * - corpus: fixed edge cases (empty payload, all 0x00, all 0xFF, 0xEF, runs
+ *   around the 254-byte block limit) must encode without inner 0x00 and
+ *   decode back unchanged
+ * - stream: random frames, concatenated and fed in random chunk sizes,
+ *   must all come out in order
+ * - damage: one byte of a frame is changed, dropped or duplicated; the
+ *   decoder must reject it (CRC16 lets about 1 in 65536 through) and take
+ *   the next good frame
+ * - noise: random bytes must never overrun the decoder
+ * Exits with 1 on the first failure.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 18:40:05
+ ********************************************************************************/
+
+#include "Packet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_STREAM_FRAMES      64
+
+static uint32_t Fuzz_Seed = 1;
+static uint32_t Fuzz_Failures = 0;
+
+static uint32_t Fuzz_Rand(void)
+{
+    Fuzz_Seed ^= Fuzz_Seed << 13;
+    Fuzz_Seed ^= Fuzz_Seed >> 17;
+    Fuzz_Seed ^= Fuzz_Seed << 5;
+    return Fuzz_Seed;
+}
+
+/**
+ * @brief Random payload; biased towards 0x00, 0xFF and 0xEF half of the time
+ */
+static uint16_t Fuzz_Payload(uint8_t *buf)
+{
+    uint16_t len = Fuzz_Rand() % (PACKET_MTU + 1);
+    uint8_t biased = Fuzz_Rand() & 1;
+
+    for (uint16_t i = 0; i < len; i++) {
+        uint32_t r = Fuzz_Rand();
+        if (biased && (r & 3) == 0) {
+            static const uint8_t special[] = { 0x00, 0xFF, 0xEF, 0x01 };
+            buf[i] = special[(r >> 2) & 3];
+        } else {
+            buf[i] = (uint8_t)(r >> 8);
+        }
+    }
+    return len;
+}
+
+static void Fuzz_Fail(const char *pass, const char *what, uint32_t n)
+{
+    printf("FAIL %s: %s (case %u)\n", pass, what, (unsigned)n);
+    Fuzz_Failures++;
+}
+
+/**
+ * @brief Encode, check the wire format, decode byte by byte
+ */
+static void Fuzz_RoundTrip(const char *pass, uint32_t n, uint8_t seq,
+                           const uint8_t *payload, uint16_t len)
+{
+    static uint8_t wire[PACKET_ENCODED_MAX];
+    Packet_Decoder dec;
+    uint16_t wireLen = Packet_Encode(PACKET_TYPE_DATA, seq, payload, len, wire);
+    uint16_t used;
+    uint8_t result;
+
+    if (wireLen == 0 || wireLen > PACKET_ENCODED_MAX) {
+        Fuzz_Fail(pass, "encoded length", n);
+        return;
+    }
+    if (memchr(wire, 0x00, wireLen - 1) != NULL || wire[wireLen - 1] != 0x00) {
+        Fuzz_Fail(pass, "0x00 inside the frame", n);
+        return;
+    }
+
+    Packet_DecoderReset(&dec);
+    used = Packet_DecoderFeed(&dec, wire, wireLen, &result);
+    if (used != wireLen || result != PACKET_DECODE_FRAME) {
+        Fuzz_Fail(pass, "not decoded", n);
+    } else if (dec.message.type != PACKET_TYPE_DATA || dec.message.seq != seq ||
+               dec.message.len != len || memcmp(dec.message.payload, payload, len) != 0) {
+        Fuzz_Fail(pass, "decoded frame differs", n);
+    }
+}
+
+static void Fuzz_Corpus(void)
+{
+    static uint8_t buf[PACKET_MTU];
+    static const uint16_t runs[] = { 1, 2, 250, 251, 252, 253, 254, 255, 256, 508, 509 };
+    uint32_t n = 0;
+
+    // Known vector: CRC-16/CCITT-FALSE of "123456789" is 0x29B1
+    if (Packet_CRC16(0xFFFF, (const uint8_t *)"123456789", 9) != 0x29B1) {
+        Fuzz_Fail("corpus", "CRC check value", 0);
+    }
+
+    Fuzz_RoundTrip("corpus", n++, 0, buf, 0);
+    for (uint8_t fill = 0; fill < 4; fill++) {
+        static const uint8_t values[] = { 0x00, 0xFF, 0xEF, 0x55 };
+        memset(buf, values[fill], sizeof(buf));
+        for (uint16_t len = 1; len <= PACKET_MTU; len++) {
+            Fuzz_RoundTrip("corpus", n++, fill, buf, len);
+        }
+    }
+    // Non-zero runs around the COBS block limit, with and without a 0x00 after
+    for (uint8_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        if (runs[i] > PACKET_MTU) continue;
+        memset(buf, 0x11, runs[i]);
+        Fuzz_RoundTrip("corpus", n++, 0x22, buf, runs[i]);
+        if (runs[i] < PACKET_MTU) {
+            buf[runs[i]] = 0x00;
+            Fuzz_RoundTrip("corpus", n++, 0x22, buf, runs[i] + 1);
+        }
+    }
+    // Payload longer than the MTU is refused
+    if (Packet_Encode(PACKET_TYPE_DATA, 0, buf, PACKET_MTU + 1, buf) != 0) {
+        Fuzz_Fail("corpus", "oversize payload accepted", 0);
+    }
+    printf("corpus: %u cases\n", (unsigned)n);
+}
+
+static void Fuzz_Stream(uint32_t iterations)
+{
+    static uint8_t wire[FUZZ_STREAM_FRAMES * PACKET_ENCODED_MAX];
+    static uint8_t payloads[FUZZ_STREAM_FRAMES][PACKET_MTU];
+    static uint16_t lens[FUZZ_STREAM_FRAMES];
+    Packet_Decoder dec;
+
+    for (uint32_t n = 0; n < iterations; n++) {
+        uint32_t wireLen = 0;
+        uint32_t pos = 0;
+        uint16_t got = 0;
+
+        for (uint16_t f = 0; f < FUZZ_STREAM_FRAMES; f++) {
+            lens[f] = Fuzz_Payload(payloads[f]);
+            wireLen += Packet_Encode(PACKET_TYPE_DATA, (uint8_t)f, payloads[f], lens[f], &wire[wireLen]);
+        }
+
+        Packet_DecoderReset(&dec);
+        while (pos < wireLen) {
+            uint16_t chunk = 1 + Fuzz_Rand() % 97;
+            uint8_t result;
+
+            if (chunk > wireLen - pos) chunk = wireLen - pos;
+            while (chunk > 0) {
+                uint16_t used = Packet_DecoderFeed(&dec, &wire[pos], chunk, &result);
+                pos += used;
+                chunk -= used;
+                if (result == PACKET_DECODE_MORE) continue;
+                if (result != PACKET_DECODE_FRAME || got >= FUZZ_STREAM_FRAMES ||
+                    dec.message.seq != got || dec.message.len != lens[got] ||
+                    memcmp(dec.message.payload, payloads[got], lens[got]) != 0) {
+                    Fuzz_Fail("stream", "frame lost or changed", n);
+                    return;
+                }
+                got++;
+            }
+        }
+        if (got != FUZZ_STREAM_FRAMES) {
+            Fuzz_Fail("stream", "missing frames", n);
+            return;
+        }
+    }
+    printf("stream: %u x %u frames\n", (unsigned)iterations, FUZZ_STREAM_FRAMES);
+}
+
+static void Fuzz_Damage(uint32_t iterations)
+{
+    static uint8_t payload[PACKET_MTU];
+    static uint8_t good[PACKET_MTU];
+    static uint8_t wire[3 * PACKET_ENCODED_MAX + 1];
+    static uint8_t frame[PACKET_ENCODED_MAX];
+    Packet_Decoder dec;
+    uint32_t undetected = 0;
+    uint32_t bad[4] = { 0 };
+
+    for (uint32_t n = 0; n < iterations; n++) {
+        uint16_t len = Fuzz_Payload(payload);
+        uint16_t frameLen = Packet_Encode(PACKET_TYPE_DATA, 1, payload, len, frame);
+        uint16_t goodLen = Fuzz_Payload(good);
+        uint16_t at = Fuzz_Rand() % frameLen;
+        uint32_t wireLen = 0;
+        uint8_t action = Fuzz_Rand() % 3;
+        uint8_t sawGood = 0;
+        uint8_t result;
+
+        // Damaged frame: change, drop or duplicate one byte
+        memcpy(wire, frame, at);
+        wireLen = at;
+        if (action == 0) {
+            uint8_t b;
+            do { b = (uint8_t)Fuzz_Rand(); } while (b == frame[at]);
+            wire[wireLen++] = b;
+        } else if (action == 2) {
+            wire[wireLen++] = frame[at];
+            wire[wireLen++] = frame[at];
+        }
+        memcpy(&wire[wireLen], &frame[at + 1], frameLen - at - 1);
+        wireLen += frameLen - at - 1;
+        // A dropped or changed delimiter merges it with the next one, make sure it ends
+        wire[wireLen++] = 0x00;
+        wireLen += Packet_Encode(PACKET_TYPE_DATA, 2, good, goodLen, &wire[wireLen]);
+
+        Packet_DecoderReset(&dec);
+        for (uint32_t pos = 0; pos < wireLen; pos++) {
+            result = Packet_DecoderPut(&dec, wire[pos]);
+            if (result == PACKET_DECODE_FRAME) {
+                if (dec.message.seq == 2 && dec.message.len == goodLen &&
+                    memcmp(dec.message.payload, good, goodLen) == 0) {
+                    sawGood = 1;
+                } else if (!(dec.message.seq == 1 && dec.message.len == len &&
+                             memcmp(dec.message.payload, payload, len) == 0)) {
+                    undetected++;       // Damaged frame passed the CRC
+                }
+            } else {
+                bad[result]++;
+            }
+        }
+        if (!sawGood) {
+            Fuzz_Fail("damage", "decoder did not recover for the next frame", n);
+            return;
+        }
+    }
+    printf("damage: %u frames, %u CRC errors, %u framing errors, %u undetected\n",
+           (unsigned)iterations, (unsigned)bad[PACKET_DECODE_BAD_CRC],
+           (unsigned)bad[PACKET_DECODE_BAD_FRAME], (unsigned)undetected);
+    // Expect about iterations / 65536, allow a wide margin
+    if (undetected > iterations / 8192 + 2) {
+        Fuzz_Fail("damage", "too many damaged frames accepted", undetected);
+    }
+}
+
+static void Fuzz_Noise(uint32_t iterations)
+{
+    Packet_Decoder dec;
+    uint32_t frames = 0;
+
+    Packet_DecoderReset(&dec);
+    for (uint32_t n = 0; n < iterations * 64; n++) {
+        uint32_t r = Fuzz_Rand();
+        // Mostly non-zero bytes so that long frames hit the buffer limit
+        uint8_t b = (r & 0xF00) ? (uint8_t)(r | 1) : (uint8_t)r;
+
+        if (Packet_DecoderPut(&dec, b) == PACKET_DECODE_FRAME) {
+            frames++;
+            if (dec.message.len > PACKET_MTU) {
+                Fuzz_Fail("noise", "message longer than the MTU", n);
+                return;
+            }
+        }
+        if (dec.len > PACKET_RAW_MAX) {
+            Fuzz_Fail("noise", "decoder overrun", n);
+            return;
+        }
+    }
+    printf("noise: %u bytes, %u frames accepted\n", (unsigned)(iterations * 64), (unsigned)frames);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t iterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 20000;
+
+    printf("PACKET_MTU %u, encoded frame up to %u bytes\n", PACKET_MTU, PACKET_ENCODED_MAX);
+    Fuzz_Corpus();
+    Fuzz_Stream(iterations / 16 + 1);
+    Fuzz_Damage(iterations * 10);
+    Fuzz_Noise(iterations);
+
+    printf(Fuzz_Failures ? "FAILED\n" : "PASSED\n");
+    return Fuzz_Failures ? 1 : 0;
+}
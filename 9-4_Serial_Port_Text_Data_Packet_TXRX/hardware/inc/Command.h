@@ -0,0 +1,80 @@
+/****************************************************************************/ /**
+ * @file   Command.h
+ * @brief  Table-driven text command dispatcher - Header File
+ *
+ * Commands live in const tables sorted by name (strcmp order), registered
+ * once at start-up; lookup is a binary search per table, so a table of 64
+ * commands costs at most 6 string compares. Command_Register() refuses a
+ * table that is not sorted or has duplicate names.
+ *
+ * A line is split in place into arguments at spaces and commas; "double
+ * quotes" keep spaces inside one argument. argv[0] is the command name.
+ *
+ * Command_Execute() runs a command at once. Command_Submit() may be called
+ * from an interrupt: it only copies the line into a queue, Command_Process()
+ * runs the queued lines later from the main loop.
+ *
+ * Each command has its own counters: calls and execution time in CPU
+ * cycles from the DWT cycle counter (1 cycle = 1/72 us at 72 MHz).
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 19:05:17
+ ********************************************************************************/
+
+#ifndef __COMMAND_H__
+#define __COMMAND_H__
+
+#include "stm32f10x.h"
+
+#define COMMAND_TABLES_MAX      4   // Registered tables
+#define COMMAND_ARGS_MAX        8   // Arguments per line, including the name
+#define COMMAND_LINE_SIZE       64  // Longest line, including the terminator
+#define COMMAND_QUEUE_SIZE      4   // Lines waiting for Command_Process(), power of two
+
+// Results
+#define COMMAND_OK              0
+#define COMMAND_EMPTY           1   // Nothing but separators
+#define COMMAND_UNKNOWN         2   // No such command
+#define COMMAND_BAD_ARGS        3   // Argument count outside [minArgs, maxArgs]
+
+typedef void (*Command_Handler)(uint8_t argc, char *argv[]);
+
+// Called when a line cannot run, with the result and the command name
+typedef void (*Command_ErrorHandler)(uint8_t result, const char *name);
+
+// Table entry; argument counts exclude the name
+typedef struct {
+    const char *name;
+    Command_Handler handler;
+    uint8_t minArgs;
+    uint8_t maxArgs;
+    const char *help;
+} Command_Entry;
+
+// Per-command counters, one per table entry
+typedef struct {
+    uint32_t calls;
+    uint32_t lastCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+} Command_Stats;
+
+// Dispatcher counters
+typedef struct {
+    uint32_t executed;
+    uint32_t unknown;
+    uint32_t badArgs;
+    uint32_t queueOverflows;    // Command_Submit() lines dropped, queue full
+    uint32_t tooLong;           // Lines cut at COMMAND_LINE_SIZE - 1
+} Command_Counters;
+
+void Command_Init(Command_ErrorHandler onError);
+uint8_t Command_Register(const Command_Entry *table, Command_Stats *stats, uint16_t count);
+uint8_t Command_Execute(char *line);
+uint8_t Command_Submit(const char *line, uint16_t len);
+uint8_t Command_Process(void);
+const Command_Entry *Command_Find(const char *name, Command_Stats **stats);
+uint8_t Command_GetEntry(uint16_t index, const Command_Entry **entry, const Command_Stats **stats);
+void Command_GetCounters(Command_Counters *counters);
+
+#endif // !__COMMAND_H__
@@ -15,6 +15,42 @@
 
 #define SERIAL_PACKET_SIZE 64
 
+#define SERIAL_BAUDRATE         9600
+
+// Receive mode: 0 = RXNE interrupt, packet state machine runs for every byte
+//               1 = circular DMA on DMA1 channel 5, frames are found on the
+//                   USART IDLE and DMA half/full-transfer interrupts
+#define SERIAL_RX_DMA           1
+
+// Circular DMA buffer, power of two; must hold the bytes arriving while a
+// frame is held by the application (128 bytes = 1.3 ms at 1 Mbaud)
+#define SERIAL_DMA_BUFFER_SIZE  256
+
+// Complete frames waiting for the application, power of two
+#define SERIAL_FRAME_QUEUE_SIZE 8
+
+// Received frame text without '@' and "\r\n", not NUL-terminated; data
+// points into the DMA buffer (or into Serial_RxPacket if the frame wraps
+// around the buffer end) and is valid until Serial_ReleaseFrame()
+typedef struct {
+    const uint8_t *data;
+    uint16_t len;
+} Serial_Frame;
+
+// Receive counters
+typedef struct {
+    uint32_t frames;            // Frames handed to the application
+    uint32_t interrupts;        // USART IDLE + DMA HT/TC interrupts
+    uint32_t queueOverflows;    // Frames dropped, queue full
+    uint32_t tooLong;           // Frames dropped, longer than SERIAL_PACKET_SIZE - 1
+    uint32_t overwritten;       // Frames overwritten by DMA while held
+} Serial_RxStats;
+
+// Receives each complete frame in the receive interrupt instead of the
+// frame queue, e.g. Command_Submit(); line is not NUL-terminated and only
+// valid during the call. Returns 0 if the frame was dropped.
+typedef uint8_t (*Serial_LineHandler)(const char *line, uint16_t len);
+
 extern char Serial_RxPacket[];
 
 void Serial_Init(void);     // Initialize USART1 peripheral
@@ -25,5 +61,9 @@ void Serial_SendNumber(uint32_t num, uint8_t len);  // Send numeric value as ASC
 void Serial_Printf(char *format, ...);  // Custom printf implementation
 uint8_t Serial_GetRxFlag(void);     // Check if new data has been received
 void Serial_SendPacket(uint8_t *txPacket, uint16_t num);  // Send a data packet with predefined structure
+uint8_t Serial_GetFrame(Serial_Frame *frame);   // Zero-copy access to the oldest received frame
+uint8_t Serial_ReleaseFrame(void);      // Release it, 0 if DMA overwrote it meanwhile
+void Serial_GetRxStats(Serial_RxStats *stats);  // Copy the receive counters
+void Serial_SetLineHandler(Serial_LineHandler handler);    // Hand frames over in the interrupt, 0 = queue them
 
 #endif // !__SERIAL_H__
@@ -0,0 +1,259 @@
+/****************************************************************************/ /**
+ * @file   Command.c
+ * @brief  Table-driven text command dispatcher - Source File
+ *
+ * The deferred queue is single producer (Command_Submit(), e.g. a USART
+ * interrupt) and single consumer (Command_Process() in the main loop): the
+ * producer only writes the head, the consumer only the tail.
+ *
+ * @author Maverick Pi
+ * @date   2026-10-18 19:05:17
+ ********************************************************************************/
+
+#include "Command.h"
+#include "DWT.h"
+#include <string.h>
+
+#define COMMAND_QUEUE_MASK      (COMMAND_QUEUE_SIZE - 1)
+
+#if COMMAND_QUEUE_SIZE & COMMAND_QUEUE_MASK
+#error "COMMAND_QUEUE_SIZE must be a power of two"
+#endif
+
+typedef struct {
+    const Command_Entry *entries;
+    Command_Stats *stats;
+    uint16_t count;
+} Command_Table;
+
+static Command_Table Command_Tables[COMMAND_TABLES_MAX];
+static uint8_t Command_TableCount = 0;
+static Command_ErrorHandler Command_OnError;
+static Command_Counters Command_Totals;
+
+static char Command_Queue[COMMAND_QUEUE_SIZE][COMMAND_LINE_SIZE];
+static volatile uint8_t Command_QueueHead = 0;     // Written by the producer
+static volatile uint8_t Command_QueueTail = 0;     // Written by the consumer
+
+/**
+ * @brief Start the cycle counter and set the error callback
+ *
+ * @param onError Called for unknown commands and bad argument counts, may be NULL
+ */
+void Command_Init(Command_ErrorHandler onError)
+{
+    DWT_Init();
+
+    Command_OnError = onError;
+}
+
+/**
+ * @brief Register a command table
+ *
+ * @param table Entries sorted by name in strcmp order, must stay valid
+ * @param stats One counter set per entry, zero-initialized
+ * @param count Number of entries
+ * @return uint8_t 1 if registered, 0 if unsorted, duplicated or no table slot left
+ */
+uint8_t Command_Register(const Command_Entry *table, Command_Stats *stats, uint16_t count)
+{
+    if (Command_TableCount >= COMMAND_TABLES_MAX) return 0;
+
+    for (uint16_t i = 1; i < count; i++) {
+        if (strcmp(table[i - 1].name, table[i].name) >= 0) return 0;
+    }
+
+    Command_Tables[Command_TableCount].entries = table;
+    Command_Tables[Command_TableCount].stats = stats;
+    Command_Tables[Command_TableCount].count = count;
+    Command_TableCount++;
+    return 1;
+}
+
+/**
+ * @brief Find a command by name
+ *
+ * @param name Command name
+ * @param stats Receives its counters, may be NULL
+ * @return const Command_Entry* Entry, NULL if unknown
+ */
+const Command_Entry *Command_Find(const char *name, Command_Stats **stats)
+{
+    for (uint8_t t = 0; t < Command_TableCount; t++) {
+        const Command_Table *table = &Command_Tables[t];
+        uint16_t low = 0;
+        uint16_t high = table->count;
+
+        // Binary search in [low, high)
+        while (low < high) {
+            uint16_t mid = (low + high) / 2;
+            int cmp = strcmp(name, table->entries[mid].name);
+
+            if (cmp == 0) {
+                if (stats) *stats = &table->stats[mid];
+                return &table->entries[mid];
+            }
+            if (cmp < 0) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Split a line in place at spaces and commas
+ *
+ * @return uint8_t Number of arguments, COMMAND_ARGS_MAX + 1 if there are more
+ */
+static uint8_t Command_Tokenize(char *line, char *argv[])
+{
+    uint8_t argc = 0;
+    char *p = line;
+
+    while (*p != '\0') {
+        // Skip separators
+        while (*p == ' ' || *p == ',' || *p == '\t') p++;
+        if (*p == '\0') break;
+
+        if (argc == COMMAND_ARGS_MAX) return COMMAND_ARGS_MAX + 1;
+
+        if (*p == '"') {
+            argv[argc++] = ++p;
+            while (*p != '\0' && *p != '"') p++;
+        } else {
+            argv[argc++] = p;
+            while (*p != '\0' && *p != ' ' && *p != ',' && *p != '\t') p++;
+        }
+        if (*p != '\0') *p++ = '\0';
+    }
+    return argc;
+}
+
+/**
+ * @brief Report a line that cannot run
+ */
+static uint8_t Command_Fail(uint8_t result, const char *name)
+{
+    if (result == COMMAND_UNKNOWN) {
+        Command_Totals.unknown++;
+    } else if (result == COMMAND_BAD_ARGS) {
+        Command_Totals.badArgs++;
+    }
+    if (Command_OnError != 0) Command_OnError(result, name);
+    return result;
+}
+
+/**
+ * @brief Tokenize a line and run its command now
+ *
+ * @param line Command line, modified in place
+ * @return uint8_t COMMAND_OK or the reason it did not run
+ */
+uint8_t Command_Execute(char *line)
+{
+    char *argv[COMMAND_ARGS_MAX];
+    const Command_Entry *entry;
+    Command_Stats *stats;
+    uint8_t argc = Command_Tokenize(line, argv);
+    uint32_t start;
+    uint32_t cycles;
+
+    if (argc == 0) return COMMAND_EMPTY;
+
+    entry = Command_Find(argv[0], &stats);
+    if (entry == 0) return Command_Fail(COMMAND_UNKNOWN, argv[0]);
+    if (argc > COMMAND_ARGS_MAX || argc - 1 < entry->minArgs || argc - 1 > entry->maxArgs) {
+        return Command_Fail(COMMAND_BAD_ARGS, argv[0]);
+    }
+
+    start = DWT_CYCCNT;
+    entry->handler(argc, argv);
+    cycles = DWT_CYCCNT - start;
+
+    stats->calls++;
+    stats->lastCycles = cycles;
+    stats->totalCycles += cycles;
+    if (cycles > stats->maxCycles) stats->maxCycles = cycles;
+    Command_Totals.executed++;
+
+    return COMMAND_OK;
+}
+
+/**
+ * @brief Queue a line for Command_Process(), safe from an interrupt
+ *
+ * @param line Command text, need not be terminated
+ * @param len Text length; longer lines are cut at COMMAND_LINE_SIZE - 1
+ * @return uint8_t 1 if queued, 0 if the queue is full
+ */
+uint8_t Command_Submit(const char *line, uint16_t len)
+{
+    uint8_t head = Command_QueueHead;
+    char *slot;
+
+    if ((uint8_t)(head - Command_QueueTail) >= COMMAND_QUEUE_SIZE) {
+        Command_Totals.queueOverflows++;
+        return 0;
+    }
+    if (len > COMMAND_LINE_SIZE - 1) {
+        len = COMMAND_LINE_SIZE - 1;
+        Command_Totals.tooLong++;
+    }
+
+    slot = Command_Queue[head & COMMAND_QUEUE_MASK];
+    memcpy(slot, line, len);
+    slot[len] = '\0';
+    Command_QueueHead = head + 1;
+    return 1;
+}
+
+/**
+ * @brief Run the queued lines, call from the main loop
+ *
+ * @return uint8_t Number of lines taken from the queue
+ */
+uint8_t Command_Process(void)
+{
+    uint8_t n = 0;
+
+    while (Command_QueueTail != Command_QueueHead) {
+        Command_Execute(Command_Queue[Command_QueueTail & COMMAND_QUEUE_MASK]);
+        Command_QueueTail++;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Walk all registered commands, e.g. for a help or stats listing
+ *
+ * @param index 0 .. number of commands - 1, in table then name order
+ * @param entry Receives the entry
+ * @param stats Receives its counters
+ * @return uint8_t 1 if index exists, 0 past the last command
+ */
+uint8_t Command_GetEntry(uint16_t index, const Command_Entry **entry, const Command_Stats **stats)
+{
+    for (uint8_t t = 0; t < Command_TableCount; t++) {
+        if (index < Command_Tables[t].count) {
+            *entry = &Command_Tables[t].entries[index];
+            *stats = &Command_Tables[t].stats[index];
+            return 1;
+        }
+        index -= Command_Tables[t].count;
+    }
+    return 0;
+}
+
+/**
+ * @brief Copy the dispatcher counters
+ *
+ * @param counters Destination
+ */
+void Command_GetCounters(Command_Counters *counters)
+{
+    *counters = Command_Totals;
+}
@@ -11,38 +11,127 @@
 #include "OLED.h"
 #include "Serial.h"
 #include "LED.h"
+#include "Command.h"
 #include <string.h>
 
+/**
+ * @brief Send a reply line and show it on the OLED
+ */
+static void Main_Reply(const char *text)
+{
+    Serial_SendString((char *)text);
+    Serial_SendString("\r\n");
+    OLED_ShowString(2, 1, "                ");
+    OLED_ShowString(2, 1, (char *)text);
+}
+
+static void Cmd_Echo(uint8_t argc, char *argv[])
+{
+    for (uint8_t i = 1; i < argc; ++i) {
+        Serial_SendString(argv[i]);
+        Serial_SendString(i + 1 < argc ? " " : "\r\n");
+    }
+}
+
+static void Cmd_Help(uint8_t argc, char *argv[])
+{
+    const Command_Entry *entry;
+    const Command_Stats *stats;
+
+    for (uint16_t i = 0; Command_GetEntry(i, &entry, &stats); ++i) {
+        Serial_Printf("%s - %s\r\n", entry->name, entry->help);
+    }
+}
+
+static void Cmd_Led(uint8_t argc, char *argv[])
+{
+    if (strcmp(argv[1], "ON") == 0) {
+        LED_Control(LED_ON, GPIO_Pin_1);
+    } else if (strcmp(argv[1], "OFF") == 0) {
+        LED_Control(LED_OFF, GPIO_Pin_1);
+    } else if (strcmp(argv[1], "TOGGLE") == 0) {
+        LED_Turn(GPIO_Pin_1);
+    } else {
+        Main_Reply("ERROR_ARGUMENT");
+        return;
+    }
+    Main_Reply("LED_OK");
+}
+
+static void Cmd_LedOff(uint8_t argc, char *argv[])
+{
+    LED_Control(LED_OFF, GPIO_Pin_1);
+    Main_Reply("LED_OFF_OK");
+}
+
+static void Cmd_LedOn(uint8_t argc, char *argv[])
+{
+    LED_Control(LED_ON, GPIO_Pin_1);
+    Main_Reply("LED_ON_OK");
+}
+
+static void Cmd_LedToggle(uint8_t argc, char *argv[])
+{
+    LED_Turn(GPIO_Pin_1);
+    Main_Reply("LED_TOGGLE_OK");
+}
+
+static void Cmd_Stats(uint8_t argc, char *argv[])
+{
+    const Command_Entry *entry;
+    const Command_Stats *stats;
+    uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+
+    // name: calls, average and maximum execution time in us
+    for (uint16_t i = 0; Command_GetEntry(i, &entry, &stats); ++i) {
+        if (stats->calls == 0) continue;
+        Serial_Printf("%s: %lu calls, avg %lu us, max %lu us\r\n", entry->name,
+                      stats->calls, (uint32_t)(stats->totalCycles / stats->calls / cyclesPerUs),
+                      stats->maxCycles / cyclesPerUs);
+    }
+}
+
+// Sorted by name in strcmp order ('_' comes after the capital letters)
+static const Command_Entry Main_Commands[] = {
+    { "ECHO",       Cmd_Echo,       0, COMMAND_ARGS_MAX - 1, "Send the arguments back" },
+    { "HELP",       Cmd_Help,       0, 0, "List the commands" },
+    { "LED",        Cmd_Led,        1, 1, "LED ON|OFF|TOGGLE" },
+    { "LED_OFF",    Cmd_LedOff,     0, 0, "Turn the LED off" },
+    { "LED_ON",     Cmd_LedOn,      0, 0, "Turn the LED on" },
+    { "LED_TOGGLE", Cmd_LedToggle,  0, 0, "Toggle the LED" },
+    { "STATS",      Cmd_Stats,      0, 0, "Calls and execution time per command" },
+};
+static Command_Stats Main_CommandStats[sizeof(Main_Commands) / sizeof(Main_Commands[0])];
+
+/**
+ * @brief Unknown command or wrong number of arguments
+ */
+static void Main_CommandError(uint8_t result, const char *name)
+{
+    Main_Reply(result == COMMAND_UNKNOWN ? "ERROR_COMMAND" : "ERROR_ARGUMENT");
+}
+
 int main(void)
 {
     Key_Init();
     LED_Init();
     OLED_Init();
     Serial_Init();
+    Command_Init(Main_CommandError);
+    Command_Register(Main_Commands, Main_CommandStats, sizeof(Main_Commands) / sizeof(Main_Commands[0]));
+
+    // The receive interrupt only queues the line, the handlers run below
+    Serial_SetLineHandler(Command_Submit);
 
     OLED_ShowString(1, 1, "Tx_Packet:");
-    OLED_ShowString(3, 1, "Rx_Packet:");
+    OLED_ShowString(3, 1, "Commands:");
+
+    Command_Counters counters;
 
     while (1) {
-        if (Serial_GetRxFlag() == 1) {
-            OLED_ShowString(4, 1, "                ");
-            OLED_ShowString(4, 1, Serial_RxPacket);
-
-            if (strcmp(Serial_RxPacket, "LED_ON") == 0) {
-                LED_Control(LED_ON, GPIO_Pin_1);
-                Serial_SendString("LED_ON_OK\r\n");
-                OLED_ShowString(2, 1, "                ");
-                OLED_ShowString(2, 1, "LED_ON_OK");
-            } else if (strcmp(Serial_RxPacket, "LED_OFF") == 0) {
-                LED_Control(LED_OFF, GPIO_Pin_1);
-                Serial_SendString("LED_OFF_OK\r\n");
-                OLED_ShowString(2, 1, "                ");
-                OLED_ShowString(2, 1, "LED_OFF_OK");
-            } else {
-                Serial_SendString("ERROR_COMMAND\r\n");
-                OLED_ShowString(2, 1, "                ");
-                OLED_ShowString(2, 1, "ERROR_COMMAND");
-            }
+        if (Command_Process() > 0) {
+            Command_GetCounters(&counters);
+            OLED_ShowNum(4, 1, counters.executed, 5);
         }
     }
 }